@@ -20,6 +20,7 @@ import sys
 from version import parse_tags_and_branches
 from repo import Repo
 from code import Project
+from cache import VersionCache
 from config import STRUCT_LIST
 
 def get_project_root():
@@ -29,6 +30,9 @@ GTK_GIT_URL = 'https://gitlab.gnome.org/GNOME/gtk.git'
 BUILD_DIR = path.join(get_project_root(), 'build')
 OUTPUT_DIR = path.join(get_project_root(), 'h')
 REPO_DIR = path.join(BUILD_DIR, 'gtk')
+# What was extracted from each version, so later runs only process new versions and structs
+CACHE_DIR = path.join(BUILD_DIR, 'cache')
+JOBS = os.cpu_count() or 1
 
 logger = logging.getLogger('build.py')
 logging.basicConfig(level=logging.DEBUG)
@@ -41,12 +45,9 @@ def build():
     tags = repo.get_tags()
     branches = repo.get_branches()
     versions = parse_tags_and_branches(tags, branches)
-    project = Project(REPO_DIR, STRUCT_LIST)
-    for i, v in enumerate(versions):
-        percent = int(((i + 1) / len(versions)) * 1000) / 10
-        logger.info('[' + str(percent) + '%] Checking out ' + v.get_checkout_name())
-        repo.checkout(v.get_checkout_name())
-        project.update(v)
+    project = Project(STRUCT_LIST)
+    cache = VersionCache(CACHE_DIR)
+    project.update(repo, cache, versions, JOBS)
     project.simplify()
     project.write(OUTPUT_DIR)
 
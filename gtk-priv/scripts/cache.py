@@ -0,0 +1,56 @@
+'''
+MIT License
+
+Copyright 2020 Sophie Winter
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+'''
+
+import json
+import logging
+import os
+from os import path
+
+logger = logging.getLogger(__name__)
+
+# Bump when the format of cache entries changes, so old caches are ignored
+CACHE_FORMAT = 1
+
+class VersionCache:
+    '''
+    What has been extracted from each GTK version, kept between runs in one JSON file per version
+    A file is only used if the version's source tree hash matches the one it was written for, so moved branches and
+    re-tagged releases are processed again. Each struct is stored separately, so adding one to STRUCT_LIST only
+    requires extracting that struct.
+    '''
+    def __init__(self, cache_dir):
+        self.cache_dir = cache_dir
+        if not path.exists(self.cache_dir):
+            logger.info('Creating directory ' + self.cache_dir)
+            os.makedirs(self.cache_dir)
+
+    def _file_path(self, version):
+        return path.join(self.cache_dir, version.get_checkout_name() + '.json')
+
+    def load(self, version, tree_hash):
+        '''Returns a dict of struct names to entries, empty if nothing is cached for this exact source tree'''
+        try:
+            with open(self._file_path(version), 'r') as f:
+                data = json.load(f)
+        except (FileNotFoundError, ValueError):
+            return {}
+        if data.get('format') != CACHE_FORMAT or data.get('tree') != tree_hash:
+            return {}
+        return data['structs']
+
+    def store(self, version, tree_hash, structs):
+        file_path = self._file_path(version)
+        tmp_path = file_path + '.tmp'
+        with open(tmp_path, 'w') as f:
+            json.dump({'format': CACHE_FORMAT, 'tree': tree_hash, 'structs': structs}, f)
+        # Replaced atomically, so an interrupted run never leaves a truncated cache file behind
+        os.replace(tmp_path, file_path)
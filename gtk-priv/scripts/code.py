@@ -15,8 +15,8 @@ from datetime import datetime
 import os
 from os import path
 import re
-import mmap
 from collections import OrderedDict
+from concurrent.futures import ThreadPoolExecutor
 import tempfile
 import subprocess
 
@@ -50,16 +50,6 @@ CODE_EXTENSIONS = set(['.h', '.hpp', '.c', '.cpp', '.cc'])
 def typdef_to_struct_name(typedef):
     return '_' + typedef
 
-def get_all_source_files(search_dir):
-    result = []
-    for item in os.listdir(search_dir):
-        p = path.join(search_dir, item)
-        if path.isdir(p):
-            result += get_all_source_files(p)
-        elif path.splitext(p)[1] in CODE_EXTENSIONS:
-            result.append(p)
-    return result
-
 def remove_headers_from_dir(header_dir):
     logger.info('Clearing header files out of ' + header_dir)
     for item in os.listdir(header_dir):
@@ -70,7 +60,11 @@ def remove_headers_from_dir(header_dir):
 def struct_regex_string(struct_name):
     return r'struct\s+' + struct_name + r'\s*\{'
 
-def extract_body(file_content, struct_name):
+def struct_line_regex_string(struct_name):
+    '''A git grep extended regex for the line a struct definition starts on (the brace is often on the next line)'''
+    return r'struct[[:space:]]+' + struct_name + r'([^[:alnum:]_]|$)'
+
+def extract_body(file_content, struct_name, code_path):
     halves = re.split(struct_regex_string(struct_name), file_content)
     if len(halves) < 2:
         raise RuntimeError(struct_name + ' not declared in ' + code_path + ' (even though it was detected)')
@@ -136,22 +130,45 @@ class ResolveContext:
         self.struct = struct
         self.version = version
 
+def extract_struct(repo, rev, struct, hint_path):
+    '''
+    Finds where a struct is defined in a branch or tag, and returns what StructVersion needs as a JSON-friendly dict
+    hint_path is where the struct was found in another version, it is checked before searching the whole tree
+    '''
+    files = {}
+    if hint_path:
+        source_code = repo.read_file(rev, hint_path)
+        if source_code is not None and struct.search_regex.search(source_code):
+            files[hint_path] = source_code
+    if not files:
+        for code_path in repo.grep_files(rev, struct_line_regex_string(struct.struct_name), CODE_EXTENSIONS):
+            source_code = repo.read_file(rev, code_path)
+            if source_code is not None and struct.search_regex.search(source_code):
+                files[code_path] = source_code
+    if not files:
+        raise RuntimeError('Could not find ' + struct.typedef + ' in ' + rev)
+    if len(files) > 1:
+        raise RuntimeError(struct.typedef + ' implemented multiple places: ' + str(set(files)))
+    code_path, source_code = list(files.items())[0]
+    return {
+        'code_path': code_path,
+        'copyright_lines': sorted(set(re.findall(r'[Cc]opyright .*(?=\n)', source_code))),
+        'body': extract_body(source_code, struct.struct_name, code_path),
+    }
+
 class StructVersion:
-    def __init__(self, code_path, project, struct, version):
-        with open(code_path, 'r') as f:
-            source_code = f.read()
-        self.code_path = code_path
+    def __init__(self, extracted, project, struct, version):
+        self.code_path = extracted['code_path']
         self.first_version = version
         self.last_version = version
         self.struct_name = struct.struct_name
-        self.copyright_lines = set(re.findall(r'[Cc]opyright .*(?=\n)', source_code))
-        self.body = extract_body(source_code, self.struct_name)
+        self.copyright_lines = set(extracted['copyright_lines'])
+        self.body = extracted['body']
+        # Parsing is cheap compared to finding the struct, and the AST is resolved against the current STRUCT_LIST,
+        # so only the extracted source is cached and the AST is rebuilt each run
         self.ast = parse.parse_ast(self.body)
         self.ast.resolve(ResolveContext(project, struct, version))
 
-    def get_code_path(self):
-        return self.code_path
-
     def get_property_list(self):
         return self.ast.get_property_list('')
 
@@ -299,19 +316,13 @@ class Struct:
         self.versions = []
         self.supported_versions = []
         self.copyright_lines = set()
-        self.search_regex = re.compile(bytes(struct_regex_string(self.struct_name), 'utf-8'))
+        self.search_regex = re.compile(struct_regex_string(self.struct_name))
 
     def lookup_version(self, version):
         for i in self.versions:
             if i.is_valid_for(version):
                 return i
 
-    def get_code_path(self):
-        if self.versions:
-            return self.versions[-1].get_code_path()
-        else:
-            return None
-
     def get_ptr_type(self):
         return PtrType(CustomType(self.typedef))
 
@@ -442,17 +453,8 @@ class Struct:
         result += '#endif // ' + self.macro_name() + '\n'
         return result
 
-def file_contains_byte_regex(source_file, regex):
-    try:
-        with open(source_file) as f:
-            with mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ) as s:
-                return bool(regex.search(s))
-    except (ValueError, FileNotFoundError):
-        return False
-
 class Project:
-    def __init__(self, repo_dir, typedef_names):
-        self.repo_dir = repo_dir
+    def __init__(self, typedef_names):
         structs = [Struct(typedef) for typedef in typedef_names]
         self.typedefs = {struct.typedef: struct for struct in structs}
         self.struct_names = {struct.struct_name: struct for struct in structs}
@@ -463,25 +465,41 @@ class Project:
     def lookup_typedef(self, typedef):
         return self.typedefs.get(typedef)
 
-    def update(self, version):
-        source_files = None
-        for typedef, struct in self.typedefs.items():
-            code_path = struct.get_code_path()
-            search_regex = struct.search_regex
-            if not code_path or not file_contains_byte_regex(code_path, search_regex):
-                if source_files is None:
-                    source_files = get_all_source_files(self.repo_dir)
-                files = set()
-                for source_file in source_files:
-                    if file_contains_byte_regex(source_file, search_regex):
-                        files.add(source_file)
-                if not files:
-                    raise RuntimeError('Could not find ' + typedef + ' in ' + str(version))
-                if len(files) > 1:
-                    raise RuntimeError(typedef + ' implemented multiple places: ' + str(files))
-                code_path = list(files)[0]
-            struct_version = StructVersion(code_path, self, struct, version)
-            struct.add_version(struct_version)
+    def extract_version(self, repo, cache, version, tree_hash, cached, hints):
+        '''Extracts the structs missing from the version's cache entries and stores the result, returns all entries'''
+        rev = version.get_git_rev()
+        extracted = dict(cached)
+        for struct_name, struct in self.struct_names.items():
+            if struct_name not in extracted:
+                extracted[struct_name] = extract_struct(repo, rev, struct, hints.get(struct_name))
+        cache.store(version, tree_hash, extracted)
+        return extracted
+
+    def update(self, repo, cache, versions, jobs):
+        '''Adds all versions, only extracting structs that are not already cached for each version's source tree'''
+        with ThreadPoolExecutor(max_workers=jobs) as executor:
+            # The work is in git subprocesses, so threads are enough to run versions in parallel
+            tree_hashes = list(executor.map(lambda v: repo.get_tree_hash(v.get_git_rev()), versions))
+            entries = [cache.load(v, tree_hash) for v, tree_hash in zip(versions, tree_hashes)]
+            # A struct is usually in the same file across versions, so try the newest known file before searching
+            hints = {}
+            for cached in entries:
+                for struct_name, extracted in cached.items():
+                    hints[struct_name] = extracted['code_path']
+            todo = [i for i, cached in enumerate(entries) if any(name not in cached for name in self.struct_names)]
+            logger.info(
+                str(len(versions) - len(todo)) + ' of ' + str(len(versions)) + ' versions fully cached, ' +
+                'extracting from ' + str(len(todo)) + ' with ' + str(jobs) + ' jobs')
+            results = executor.map(
+                lambda i: self.extract_version(repo, cache, versions[i], tree_hashes[i], entries[i], hints),
+                todo)
+            for done, (i, extracted) in enumerate(zip(todo, results)):
+                percent = int(((done + 1) / len(todo)) * 1000) / 10
+                logger.info('[' + str(percent) + '%] Extracted ' + versions[i].get_checkout_name())
+                entries[i] = extracted
+        for version, extracted in zip(versions, entries):
+            for struct_name, struct in self.struct_names.items():
+                struct.add_version(StructVersion(extracted[struct_name], self, struct, version))
 
     def simplify(self):
         i = 1;
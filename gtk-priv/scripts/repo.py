@@ -56,11 +56,39 @@ class Repo:
         logger.info('Found ' + str(len(tags)) + ' git tags')
         return tags
 
-    def checkout(self, tag):
-        '''Checks out a branch or tag'''
-        # logger.info('Checking out ' + tag)
+    def get_tree_hash(self, rev):
+        '''Returns the hash of the source tree of a branch or tag, which only changes if the source does'''
         result = subprocess.run(
-            ['git', 'checkout', tag],
-            cwd=self.repo_dir,
-            capture_output=True
-            ).check_returncode()
+            ['git', 'rev-parse', rev + '^{tree}'],
+            capture_output=True,
+            encoding='utf-8',
+            cwd=self.repo_dir)
+        result.check_returncode()
+        return result.stdout.strip()
+
+    def grep_files(self, rev, regex, extensions):
+        '''Returns the paths of files with one of the given extensions that have a line matching the extended regex
+        Searches the branch or tag directly, so nothing needs to be checked out and several can be searched at once'''
+        result = subprocess.run(
+            ['git', 'grep', '-l', '-E', regex, rev, '--'] + ['*' + ext for ext in extensions],
+            capture_output=True,
+            encoding='utf-8',
+            cwd=self.repo_dir)
+        # git grep exits with 1 when nothing matched
+        if result.returncode == 1:
+            return []
+        result.check_returncode()
+        # paths are prefixed with the rev and a colon
+        return [line[len(rev) + 1:] for line in result.stdout.splitlines()]
+
+    def read_file(self, rev, file_path):
+        '''Returns the contents of a file in a branch or tag, or None if it does not exist there'''
+        result = subprocess.run(
+            ['git', 'show', rev + ':' + file_path],
+            capture_output=True,
+            encoding='utf-8',
+            errors='replace',
+            cwd=self.repo_dir)
+        if result.returncode != 0:
+            return None
+        return result.stdout
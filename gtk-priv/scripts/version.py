@@ -40,6 +40,13 @@ class Version:
     def get_checkout_name(self):
         return self.git_name
 
+    def get_git_rev(self):
+        '''A rev that can be read from without checking out (branches are only fetched, so use the remote one)'''
+        if self.released:
+            return 'refs/tags/' + self.git_name
+        else:
+            return 'refs/remotes/origin/' + self.git_name
+
     def is_supported(self):
         '''Returns if the version is one we support'''
         return (
@@ -134,21 +134,680 @@ void gtk_pip_set_app_id(GtkWindow *window, char const *app_id);
  */
 const char *gtk_pip_get_app_id(GtkWindow *window);
 
+/**
+ * gtk_pip_set_remember_size:
+ * @window: A pip surface.
+ * @remember_size: Whether to remember the size of this surface.
+ *
+ * If enabled, the size the compositor last gave a surface with the same app ID is stored in the user's cache
+ * directory and used to size the window before it is shown, so it doesn't have to be laid out again once the
+ * first configure arrives. Set the app ID before showing the window. Default is %FALSE.
+ *
+ */
+void gtk_pip_set_remember_size(GtkWindow *window, gboolean remember_size);
+
+/**
+ * gtk_pip_get_remember_size:
+ * @window: A pip surface.
+ *
+ * Returns: if the size of this surface is remembered, as set by gtk_pip_set_remember_size ()
+ */
+gboolean gtk_pip_get_remember_size(GtkWindow *window);
+
+/**
+ * gtk_pip_set_prepare_offscreen:
+ * @window: A pip surface.
+ * @prepare_offscreen: Whether to render the first buffer before the surface is mapped.
+ *
+ * If enabled, the window is rendered into a buffer when it is shown, before the pip surface is created. That buffer
+ * is attached as soon as the first configure is acknowledged (if the configured size matches), so the pip becomes
+ * visible one roundtrip after gtk_widget_show () instead of after GTK's next frame. Combine with
+ * gtk_pip_set_remember_size () to make a size match more likely. Takes effect the next time the window is shown.
+ * Default is %FALSE.
+ *
+ */
+void gtk_pip_set_prepare_offscreen(GtkWindow *window, gboolean prepare_offscreen);
+
+/**
+ * gtk_pip_get_prepare_offscreen:
+ * @window: A pip surface.
+ *
+ * Returns: if the first buffer is rendered before mapping, as set by gtk_pip_set_prepare_offscreen ()
+ */
+gboolean gtk_pip_get_prepare_offscreen(GtkWindow *window);
+
+/**
+ * GtkPipCorner:
+ * @GTK_PIP_CORNER_NONE: No preference, the compositor decides.
+ * @GTK_PIP_CORNER_TOP_LEFT: The top left corner of the output.
+ * @GTK_PIP_CORNER_TOP_RIGHT: The top right corner of the output.
+ * @GTK_PIP_CORNER_BOTTOM_LEFT: The bottom left corner of the output.
+ * @GTK_PIP_CORNER_BOTTOM_RIGHT: The bottom right corner of the output.
+ *
+ * Where a pip surface would like to be placed, see gtk_pip_set_preferred_corner ().
+ */
+typedef enum {
+    GTK_PIP_CORNER_NONE = 0,
+    GTK_PIP_CORNER_TOP_LEFT,
+    GTK_PIP_CORNER_TOP_RIGHT,
+    GTK_PIP_CORNER_BOTTOM_LEFT,
+    GTK_PIP_CORNER_BOTTOM_RIGHT,
+} GtkPipCorner;
+
+/**
+ * gtk_pip_set_preferred_corner:
+ * @window: A pip surface.
+ * @corner: The corner of the output to place the surface in.
+ *
+ * Asks the compositor to place the surface in the given corner. The compositor may ignore it, and compositors that
+ * only support version 1 of the pip protocol never see it. Sent along with the window's size before the surface is
+ * first committed, so the compositor can pick the final size and position in one go. Takes effect the next time the
+ * window is shown. Default is %GTK_PIP_CORNER_NONE.
+ *
+ */
+void gtk_pip_set_preferred_corner(GtkWindow *window, GtkPipCorner corner);
+
+/**
+ * gtk_pip_get_preferred_corner:
+ * @window: A pip surface.
+ *
+ * Returns: the corner set with gtk_pip_set_preferred_corner ().
+ */
+GtkPipCorner gtk_pip_get_preferred_corner(GtkWindow *window);
+
+/**
+ * GtkPipDismissPolicy:
+ * @GTK_PIP_DISMISS_POLICY_CLOSE: Close the window with gtk_window_close (), which destroys it unless the app handles
+ * #GtkWidget::delete-event.
+ * @GTK_PIP_DISMISS_POLICY_HIDE: Hide the window. Its widget tree is kept, so showing it again is cheap.
+ *
+ * What happens to a pip window when the compositor dismisses it, see gtk_pip_set_dismiss_policy ().
+ */
+typedef enum {
+    GTK_PIP_DISMISS_POLICY_CLOSE = 0,
+    GTK_PIP_DISMISS_POLICY_HIDE,
+} GtkPipDismissPolicy;
+
+/**
+ * gtk_pip_set_dismiss_policy:
+ * @window: A pip surface.
+ * @policy: What to do with the window when the compositor dismisses it.
+ *
+ * With %GTK_PIP_DISMISS_POLICY_HIDE, a dismissed window is hidden instead of closed. Only its Wayland objects and
+ * buffers are freed, so widgets, fonts and rendering caches are still there when the app shows it again, which is
+ * much faster than building a new window for a complex UI. Under either policy the callback set with
+ * gtk_pip_set_dismissed_callback () is then called. Default is %GTK_PIP_DISMISS_POLICY_CLOSE.
+ */
+void gtk_pip_set_dismiss_policy(GtkWindow *window, GtkPipDismissPolicy policy);
+
+/**
+ * gtk_pip_get_dismiss_policy:
+ * @window: A pip surface.
+ *
+ * Returns: the policy set with gtk_pip_set_dismiss_policy ().
+ */
+GtkPipDismissPolicy gtk_pip_get_dismiss_policy(GtkWindow *window);
+
+/**
+ * GtkPipDismissedFunc:
+ * @window: the pip window that was dismissed.
+ * @user_data: the data given to gtk_pip_set_dismissed_callback ().
+ *
+ * Called when the compositor dismisses a pip window, see gtk_pip_set_dismissed_callback ().
+ */
+typedef void (*GtkPipDismissedFunc)(GtkWindow *window, gpointer user_data);
+
+/**
+ * gtk_pip_set_dismissed_callback:
+ * @window: A pip surface.
+ * @callback: (nullable) (scope notified): called each time the compositor dismisses the window.
+ * @user_data: passed to @callback.
+ * @destroy: (nullable): called on @user_data when the callback is replaced or the window is destroyed.
+ *
+ * Lets the app know when the compositor dismisses the window, so it can for example update its own
+ * picture-in-picture toggle. The callback runs after a window with %GTK_PIP_DISMISS_POLICY_HIDE has been hidden, and
+ * before one with %GTK_PIP_DISMISS_POLICY_CLOSE is closed. It may destroy the window. Replaces any callback set
+ * before; pass %NULL to remove it.
+ */
+void gtk_pip_set_dismissed_callback(GtkWindow *window,
+                                    GtkPipDismissedFunc callback,
+                                    gpointer user_data,
+                                    GDestroyNotify destroy);
+
+/**
+ * GtkPipContentType:
+ * @GTK_PIP_CONTENT_TYPE_NONE: No particular kind of content.
+ * @GTK_PIP_CONTENT_TYPE_PHOTO: Still images.
+ * @GTK_PIP_CONTENT_TYPE_VIDEO: Video or animation.
+ * @GTK_PIP_CONTENT_TYPE_GAME: Interactive content where latency matters.
+ *
+ * What a pip surface shows, see gtk_pip_set_content_type ().
+ */
+typedef enum {
+    GTK_PIP_CONTENT_TYPE_NONE = 0,
+    GTK_PIP_CONTENT_TYPE_PHOTO,
+    GTK_PIP_CONTENT_TYPE_VIDEO,
+    GTK_PIP_CONTENT_TYPE_GAME,
+} GtkPipContentType;
+
+/**
+ * gtk_pip_set_content_type:
+ * @window: A pip surface.
+ * @content_type: What the surface shows.
+ *
+ * Tells the compositor what kind of content the surface shows (using the
+ * content-type protocol, if it is supported), so it can for example scan a
+ * video pip out directly or change the display mode for it. The hint is sent
+ * before the surface is first committed, so it applies from the first frame.
+ * Default is %GTK_PIP_CONTENT_TYPE_NONE.
+ */
+void gtk_pip_set_content_type(GtkWindow *window, GtkPipContentType content_type);
+
+/**
+ * gtk_pip_get_content_type:
+ * @window: A pip surface.
+ *
+ * Returns: the content type set with gtk_pip_set_content_type ().
+ */
+GtkPipContentType gtk_pip_get_content_type(GtkWindow *window);
+
+/**
+ * gtk_pip_set_low_latency:
+ * @window: A pip surface.
+ * @low_latency: Whether frames should be shown as soon as possible.
+ *
+ * If enabled, the compositor is told (using the tearing-control protocol, if
+ * it is supported) that it may show new frames immediately instead of waiting
+ * for the next vertical blank, at the cost of possible tearing. Useful for
+ * game streaming and other latency sensitive content. Default is %FALSE.
+ */
+void gtk_pip_set_low_latency(GtkWindow *window, gboolean low_latency);
+
+/**
+ * gtk_pip_get_low_latency:
+ * @window: A pip surface.
+ *
+ * Returns: if low latency mode is enabled, as set by gtk_pip_set_low_latency ().
+ */
+gboolean gtk_pip_get_low_latency(GtkWindow *window);
+
+/**
+ * gtk_pip_set_full_repaint:
+ * @window: A pip surface.
+ * @full_repaint: If the whole window is repainted every frame.
+ *
+ * When the compositor still holds the previous buffer, GDK draws the next frame into a new one and copies the parts of
+ * the window that were not repainted over from the previous buffer. For video and other content that changes every
+ * pixel every frame this copy is wasted memory bandwidth. In full repaint mode every frame repaints the whole window,
+ * the copy is skipped, and the previous buffer is not kept around for it. Default is %FALSE.
+ */
+void gtk_pip_set_full_repaint(GtkWindow *window, gboolean full_repaint);
+
+/**
+ * gtk_pip_get_full_repaint:
+ * @window: A pip surface.
+ *
+ * Returns: if full repaint mode is enabled, as set by gtk_pip_set_full_repaint ().
+ */
+gboolean gtk_pip_get_full_repaint(GtkWindow *window);
+
+/**
+ * gtk_pip_get_backfill_bytes:
+ * @window: A pip surface.
+ *
+ * Returns: the number of bytes GDK has copied from previous buffers into new ones for this window, see
+ * gtk_pip_set_full_repaint ().
+ */
+guint64 gtk_pip_get_backfill_bytes(GtkWindow *window);
+
+/**
+ * gtk_pip_set_buffer_pool:
+ * @window: A pip surface.
+ * @buffer_pool: If to draw into buffers from a pool.
+ *
+ * GDK creates a new shared memory buffer (with its own file descriptor, mapping and wl_shm_pool) whenever the window
+ * changes size, which during an interactive resize is every frame. With the buffer pool, the window draws into
+ * buffers from one growable pool instead. Their memory is rounded up to a size class and reused for nearby sizes, so
+ * a resize only makes syscalls when the window outgrows every free buffer. Frames that GDK would have to fill in from
+ * the previous one still use GDK's buffers, unless gtk_pip_set_full_repaint () is enabled. Pool buffers are attached
+ * by this library rather than by GDK, which relies on more of GDK's private state, so this is opt-in. Default is
+ * %FALSE.
+ */
+void gtk_pip_set_buffer_pool(GtkWindow *window, gboolean buffer_pool);
+
+/**
+ * gtk_pip_get_buffer_pool:
+ * @window: A pip surface.
+ *
+ * Returns: if the buffer pool is enabled, as set by gtk_pip_set_buffer_pool ().
+ */
+gboolean gtk_pip_get_buffer_pool(GtkWindow *window);
+
+/**
+ * GtkPipDmabufReleaseFunc:
+ * @user_data: the data given to gtk_pip_set_dmabuf_frame ().
+ *
+ * Called once the compositor no longer reads from a frame, so its dmabuf can be
+ * filled with a new one.
+ */
+typedef void (*GtkPipDmabufReleaseFunc)(gpointer user_data);
+
+/**
+ * gtk_pip_get_dmabuf_supported:
+ * @fourcc: a DRM format code, such as DRM_FORMAT_XRGB8888 from drm_fourcc.h.
+ * @modifier: a DRM format modifier, such as DRM_FORMAT_MOD_LINEAR.
+ *
+ * The first call waits for the compositor to list the formats it supports.
+ *
+ * Returns: if the compositor can import dmabufs of this format and modifier
+ * with gtk_pip_set_dmabuf_frame ().
+ */
+gboolean gtk_pip_get_dmabuf_supported(guint32 fourcc, guint64 modifier);
+
+/**
+ * gtk_pip_set_dmabuf_frame:
+ * @window: A pip surface.
+ * @width: width of the frame in pixels.
+ * @height: height of the frame in pixels.
+ * @fourcc: the DRM format code of the frame.
+ * @modifier: the DRM format modifier of the frame.
+ * @n_planes: the number of planes the format has, at most 4.
+ * @fds: (array length=n_planes): the dmabuf file descriptor of each plane. They are duplicated, so the caller
+ * still owns them and may close them once this returns.
+ * @offsets: (array length=n_planes): the offset in bytes of each plane into its dmabuf.
+ * @strides: (array length=n_planes): bytes per row of each plane.
+ * @release_func: (nullable) (scope async): called once the compositor is done with the frame.
+ * @user_data: passed to @release_func.
+ *
+ * Shows a frame the app has in a dmabuf (from a camera, decoder or screen capture) without copying it. The dmabuf is
+ * wrapped in a zwp_linux_dmabuf_v1 buffer and shown on a video subsurface in the top left corner of the window, at the
+ * window's scale factor. By default the subsurface is above everything GTK draws, so it covers any controls there;
+ * see gtk_pip_set_dmabuf_below (). Input goes through to the window. Frames are shown as soon as the compositor has
+ * imported them and do not wait for GTK to repaint, and each frame is held until the compositor releases it, which is
+ * usually once the next one is shown. If the compositor fails to import a frame, a warning is logged, @release_func is
+ * called and the previous frame stays on screen. The subsurface is removed with gtk_pip_clear_dmabuf_frame () or when
+ * the window is unmapped, and any frames still held are released then.
+ *
+ * Returns: %TRUE if the frame was sent to the compositor. %FALSE if the window is not mapped or the compositor does
+ * not support the format and modifier (see gtk_pip_get_dmabuf_supported ()), in which case @release_func is not
+ * called.
+ */
+gboolean gtk_pip_set_dmabuf_frame(GtkWindow *window,
+                                  int width,
+                                  int height,
+                                  guint32 fourcc,
+                                  guint64 modifier,
+                                  int n_planes,
+                                  const int *fds,
+                                  const guint32 *offsets,
+                                  const guint32 *strides,
+                                  GtkPipDmabufReleaseFunc release_func,
+                                  gpointer user_data);
+
+/**
+ * gtk_pip_clear_dmabuf_frame:
+ * @window: A pip surface.
+ *
+ * Removes the video subsurface created by gtk_pip_set_dmabuf_frame (), releasing every frame it still holds.
+ */
+void gtk_pip_clear_dmabuf_frame(GtkWindow *window);
+
+/**
+ * gtk_pip_set_dmabuf_below:
+ * @window: A pip surface.
+ * @below: Whether the video subsurface goes below the window.
+ *
+ * If enabled, the video subsurface of gtk_pip_set_dmabuf_frame () is placed below the window instead of above it, so
+ * widgets such as playback controls are shown on top of the video. The video only shows through where the window is
+ * transparent, so the app has to leave a hole for it, for example by making the window app-paintable and clearing it
+ * to transparent outside of its controls. While this is enabled the window is not marked opaque automatically, but
+ * any rect set with gtk_pip_set_opaque_rect () still is. Default is %FALSE.
+ */
+void gtk_pip_set_dmabuf_below(GtkWindow *window, gboolean below);
+
+/**
+ * gtk_pip_get_dmabuf_below:
+ * @window: A pip surface.
+ *
+ * Returns: if the video subsurface goes below the window, as set by gtk_pip_set_dmabuf_below ().
+ */
+gboolean gtk_pip_get_dmabuf_below(GtkWindow *window);
+
 /**
  * gtk_pip_move
  * @window: A pip surface.
  * 
- * Starts a system move
+ * Starts a system move, using the most recent input from any device on the
+ * default seat. Prefer gtk_pip_move_for_event () or gtk_window_begin_move_drag (),
+ * which use the device that started the drag.
  */
 void gtk_pip_move(GtkWindow *window);
 
 /**
- * gtk_pip_resize
- *  @window: A pip surface.
- * 
- * Starts a system resize from the given edges
+ * gtk_pip_move_for_event:
+ * @window: A pip surface.
+ * @event: the button press, touch begin or key press that starts the move.
+ *
+ * Starts a system move from the seat and device @event came from, so the
+ * compositor accepts it on multi-seat setups and after touch or tablet input.
+ * Should be called from the handler of @event.
+ */
+void gtk_pip_move_for_event(GtkWindow *window, const GdkEvent *event);
+
+/**
+ * gtk_pip_resize:
+ * @window: A pip surface.
+ * @edge: the edge or corner being dragged.
+ *
+ * Starts a system resize from the given edge, using the most recent input from
+ * any device on the default seat. Should be called in response to a button
+ * press. Until the drag ends, gtk_pip_get_resizing () returns %TRUE.
+ */
+void gtk_pip_resize(GtkWindow *window, GdkWindowEdge edge);
+
+/**
+ * gtk_pip_resize_for_event:
+ * @window: A pip surface.
+ * @edge: the edge or corner being dragged.
+ * @event: the button press, touch begin or key press that starts the resize.
+ *
+ * Like gtk_pip_resize (), but uses the seat and device @event came from, see
+ * gtk_pip_move_for_event ().
+ */
+void gtk_pip_resize_for_event(GtkWindow *window, GdkWindowEdge edge, const GdkEvent *event);
+
+/**
+ * gtk_pip_set_resize_cursor:
+ * @window: A pip surface.
+ * @edge: the edge or corner the pointer is over.
+ *
+ * Shows the resize cursor for @edge while the pointer is over @window. Call it
+ * from a motion handler whenever the edge under the pointer changes. If the
+ * compositor supports the cursor-shape protocol the compositor draws the cursor,
+ * so no cursor image has to be uploaded. Otherwise this sets the named cursor on
+ * the #GdkWindow, like GTK would.
+ */
+void gtk_pip_set_resize_cursor(GtkWindow *window, GdkWindowEdge edge);
+
+/**
+ * gtk_pip_unset_resize_cursor:
+ * @window: A pip surface.
+ *
+ * Goes back to the default cursor after gtk_pip_set_resize_cursor ().
+ */
+void gtk_pip_unset_resize_cursor(GtkWindow *window);
+
+/**
+ * gtk_pip_get_resizing:
+ * @window: A pip surface.
+ *
+ * The protocol does not say when an interactive resize ends, so it is assumed to
+ * be over once the compositor stops sending new sizes for a moment. A redraw is
+ * queued when the drag starts and ends, so apps can check this while drawing and
+ * switch to a cheaper render path (such as scaling cached content) for the drag,
+ * or enable gtk_pip_set_resize_snapshot () to have the library do that for them.
+ *
+ * Returns: if an interactive resize started with gtk_pip_resize () is in progress.
+ */
+gboolean gtk_pip_get_resizing(GtkWindow *window);
+
+/**
+ * gtk_pip_get_predicted_size:
+ * @window: A pip surface.
+ * @width: (out) (optional): location to store the predicted width.
+ * @height: (out) (optional): location to store the predicted height.
+ *
+ * During an interactive resize, the size the window is expected to have one frame
+ * from now, extrapolated from the sizes the compositor has sent so far. Apps can
+ * prepare content at this size ahead of the configure that asks for it. When not
+ * resizing, this is the current size of the window.
+ */
+void gtk_pip_get_predicted_size(GtkWindow *window, int *width, int *height);
+
+/**
+ * gtk_pip_set_resize_snapshot:
+ * @window: A pip surface.
+ * @resize_snapshot: Whether to show a scaled snapshot during interactive resizes.
+ *
+ * If enabled, the window is drawn once when an interactive resize starts, and
+ * until the resize ends every frame shows that snapshot scaled to the new size
+ * instead of drawing the window's widgets. The widgets are still laid out at
+ * each new size, and are drawn normally once the resize ends. Useful for windows
+ * that are expensive to draw. Default is %FALSE.
+ */
+void gtk_pip_set_resize_snapshot(GtkWindow *window, gboolean resize_snapshot);
+
+/**
+ * gtk_pip_get_resize_snapshot:
+ * @window: A pip surface.
+ *
+ * Returns: if resize snapshots are enabled, as set by gtk_pip_set_resize_snapshot ().
+ */
+gboolean gtk_pip_get_resize_snapshot(GtkWindow *window);
+
+/**
+ * GtkPipResizeStats:
+ * @commits: the number of sizes sent by the compositor that have been committed.
+ * @last_latency_us: time from the last size arriving to its frame being committed.
+ * @max_latency_us: the longest time from a size arriving to its frame being committed.
+ * @mean_latency_us: the mean time from a size arriving to its frame being committed.
+ *
+ * Configure-to-commit latency of an interactive resize, see gtk_pip_get_resize_stats ().
+ */
+typedef struct {
+    guint commits;
+    gint64 last_latency_us;
+    gint64 max_latency_us;
+    gint64 mean_latency_us;
+} GtkPipResizeStats;
+
+/**
+ * gtk_pip_get_resize_stats:
+ * @window: A pip surface.
+ * @stats: (out caller-allocates): location to store the stats.
+ *
+ * Gets the latency stats of the current interactive resize, or of the last one
+ * if none is in progress. All zero if the window has never been resized.
+ */
+void gtk_pip_get_resize_stats(GtkWindow *window, GtkPipResizeStats *stats);
+
+/**
+ * gtk_pip_get_preferred_scale:
+ * @window: A pip surface.
+ *
+ * If the compositor supports fractional scaling, this is the scale it would
+ * like the surface to be rendered at (for example 1.5). Otherwise this is
+ * the integer scale factor of the window. Apps that render video or other
+ * content themselves can use this to pick a buffer resolution that will not
+ * be resampled by the compositor. A redraw is queued when it changes.
+ *
+ * Returns: the preferred scale of the surface.
+ */
+double gtk_pip_get_preferred_scale(GtkWindow *window);
+
+/**
+ * gtk_pip_get_preferred_buffer_size:
+ * @window: A pip surface.
+ * @width: (out) (optional): location to store the width in buffer pixels.
+ * @height: (out) (optional): location to store the height in buffer pixels.
+ *
+ * The current size of the window multiplied by gtk_pip_get_preferred_scale ().
+ */
+void gtk_pip_get_preferred_buffer_size(GtkWindow *window, int *width, int *height);
+
+/**
+ * gtk_pip_get_monitor:
+ * @window: A pip surface.
+ *
+ * The compositor decides where pip surfaces are placed, so this is the only
+ * way to know which monitor one ended up on.
+ *
+ * Returns: (transfer none) (nullable): the monitor the surface most recently
+ * entered, or %NULL if it is not mapped or has not entered a monitor yet.
+ */
+GdkMonitor *gtk_pip_get_monitor(GtkWindow *window);
+
+/**
+ * gtk_pip_set_opaque_rect:
+ * @window: A pip surface.
+ * @rect: (nullable): the part of the window, in window coordinates, that is fully opaque, or %NULL.
+ *
+ * Tells the compositor that @rect is covered by fully opaque content (such as
+ * a video frame), so it does not need to blend what is behind it. Any part
+ * outside the window is ignored.
+ *
+ * By default (or when @rect is %NULL) the whole window is marked opaque if
+ * its CSS background color is fully opaque, it is not app-paintable, its
+ * opacity is 1 and gtk_pip_set_dmabuf_below () is not enabled (the video
+ * shows through the window then). Otherwise no part of it is marked opaque.
+ * A @rect that is set is always used, even with gtk_pip_set_dmabuf_below ().
+ */
+void gtk_pip_set_opaque_rect(GtkWindow *window, const GdkRectangle *rect);
+
+/**
+ * gtk_pip_set_input_rect:
+ * @window: A pip surface.
+ * @rect: (nullable): the part of the window, in window coordinates, that accepts input, or %NULL.
+ *
+ * Limits pointer and touch input to @rect (for example a control bar).
+ * Events outside of it go to whatever is below the pip, and do not wake
+ * the app up. If @rect is %NULL (the default) the whole window accepts input.
+ */
+void gtk_pip_set_input_rect(GtkWindow *window, const GdkRectangle *rect);
+
+/**
+ * GtkPipFrameFormat:
+ * @GTK_PIP_FRAME_FORMAT_I420: A Y plane followed by half width, half height U and V planes.
+ * @GTK_PIP_FRAME_FORMAT_NV12: A Y plane followed by a half width, half height plane of interleaved U and V samples.
+ *
+ * YUV layouts accepted by gtk_pip_frame_convert (). Colors are interpreted
+ * as BT.601 limited range.
+ */
+typedef enum {
+    GTK_PIP_FRAME_FORMAT_I420 = 0,
+    GTK_PIP_FRAME_FORMAT_NV12,
+} GtkPipFrameFormat;
+
+/**
+ * GtkPipFrameScale:
+ * @GTK_PIP_FRAME_SCALE_BILINEAR: Interpolate between the nearest source pixels. Best for upscaling and small downscales.
+ * @GTK_PIP_FRAME_SCALE_BOX: Average every source pixel covered by a destination pixel. Best for large downscales.
+ *
+ * How gtk_pip_frame_convert () scales frames to the size of the destination.
+ */
+typedef enum {
+    GTK_PIP_FRAME_SCALE_BILINEAR = 0,
+    GTK_PIP_FRAME_SCALE_BOX,
+} GtkPipFrameScale;
+
+/**
+ * gtk_pip_frame_convert:
+ * @format: the layout of the source frame.
+ * @planes: (array): the source planes; Y, U, V for I420 or Y, UV for NV12.
+ * @strides: (array): bytes per row of each plane.
+ * @width: width of the source frame in pixels.
+ * @height: height of the source frame in pixels.
+ * @scale: how to scale the frame to the size of @dest.
+ * @dest: a %CAIRO_FORMAT_RGB24 or %CAIRO_FORMAT_ARGB32 image surface.
+ *
+ * Converts a YUV video frame to RGB and scales it to fill @dest in a single
+ * pass. The fastest kernel the CPU supports (AVX2, SSE2, NEON or plain C) is
+ * picked at runtime. To skip an extra copy, @dest can be the image returned
+ * by cairo_surface_map_to_image () on the target of the #cairo_t a pip
+ * window is drawing with.
+ *
+ * Returns: %TRUE on success, %FALSE if the arguments are invalid.
+ */
+gboolean gtk_pip_frame_convert(GtkPipFrameFormat format,
+                               const guint8 *const *planes,
+                               const int *strides,
+                               int width,
+                               int height,
+                               GtkPipFrameScale scale,
+                               cairo_surface_t *dest);
+
+/**
+ * GtkPipGroup:
+ *
+ * A set of pip windows that are shown, hidden and destroyed together. Showing
+ * a group maps every window with a single Wayland roundtrip, instead of one
+ * roundtrip per window. Useful for apps that show many pip windows at once.
+ *
+ * A group only batches mapping and unmapping. Each window keeps its own
+ * buffers (see gtk_pip_set_buffer_pool ()) and frame callbacks, so windows
+ * in a group are drawn and presented independently of each other.
+ */
+typedef struct _GtkPipGroup GtkPipGroup;
+
+/**
+ * gtk_pip_group_new: (skip)
+ *
+ * Returns: a new empty #GtkPipGroup. Free with gtk_pip_group_free ().
+ */
+GtkPipGroup *gtk_pip_group_new();
+
+/**
+ * gtk_pip_group_free: (skip)
+ * @group: A #GtkPipGroup.
+ *
+ * Frees the group. Windows in the group are not affected.
+ */
+void gtk_pip_group_free(GtkPipGroup *group);
+
+/**
+ * gtk_pip_group_add_window: (skip)
+ * @group: A #GtkPipGroup.
+ * @window: A #GtkWindow.
+ *
+ * Adds @window to @group. If @window has not yet been set up with
+ * gtk_pip_init_for_window (), that is done here, so the same rules apply (it
+ * must not be realized yet). Windows are removed from the group automatically
+ * when they are destroyed.
+ */
+void gtk_pip_group_add_window(GtkPipGroup *group, GtkWindow *window);
+
+/**
+ * gtk_pip_group_get_n_windows: (skip)
+ * @group: A #GtkPipGroup.
+ *
+ * Returns: the number of windows in @group.
+ */
+guint gtk_pip_group_get_n_windows(GtkPipGroup *group);
+
+/**
+ * gtk_pip_group_get_window: (skip)
+ * @group: A #GtkPipGroup.
+ * @index: The index of the window, in the order they were added.
+ *
+ * Returns: (transfer none): the window at @index.
+ */
+GtkWindow *gtk_pip_group_get_window(GtkPipGroup *group, guint index);
+
+/**
+ * gtk_pip_group_show_all: (skip)
+ * @group: A #GtkPipGroup.
+ *
+ * Calls gtk_widget_show_all () on every window in @group, and blocks for a
+ * single Wayland roundtrip once all of them have been mapped.
+ */
+void gtk_pip_group_show_all(GtkPipGroup *group);
+
+/**
+ * gtk_pip_group_hide_all: (skip)
+ * @group: A #GtkPipGroup.
+ *
+ * Hides every window in @group, and flushes the resulting requests once.
+ */
+void gtk_pip_group_hide_all(GtkPipGroup *group);
+
+/**
+ * gtk_pip_group_destroy_all: (skip)
+ * @group: A #GtkPipGroup.
+ *
+ * Destroys every window in @group, and flushes the resulting requests once.
+ * The group itself is left empty and must still be freed.
  */
-// void gtk_pip_resize(GtkWindow *window, GdkWindowEdge edge);
+void gtk_pip_group_destroy_all(GtkPipGroup *group);
 
 G_END_DECLS
 
@@ -13,8 +13,10 @@
 #include "gtk-wayland.h"
 #include "custom-shell-surface.h"
 #include "simple-conversions.h"
+#include "gtk-priv-access.h"
 #include "pip-surface.h"
 #include "xdg-toplevel-surface.h"
+#include "frame-convert.h"
 
 #include <gdk/gdkwayland.h>
 
@@ -123,12 +125,103 @@ gtk_pip_get_app_id(GtkWindow *window)
     return pip_surface_get_app_id(pip_surface); // NULL-safe
 }
 
+void gtk_pip_set_remember_size(GtkWindow *window, gboolean remember_size)
+{
+    PipSurface *pip_surface = gtk_window_get_pip_surface(window);
+    if (!pip_surface)
+        return; // Error message already shown in gtk_window_get_pip_surface
+    pip_surface_set_remember_size(pip_surface, remember_size);
+}
+
+gboolean gtk_pip_get_remember_size(GtkWindow *window)
+{
+    PipSurface *pip_surface = gtk_window_get_pip_surface(window);
+    if (!pip_surface)
+        return FALSE; // Error message already shown in gtk_window_get_pip_surface
+    return pip_surface_get_remember_size(pip_surface);
+}
+
+void gtk_pip_set_prepare_offscreen(GtkWindow *window, gboolean prepare_offscreen)
+{
+    PipSurface *pip_surface = gtk_window_get_pip_surface(window);
+    if (!pip_surface)
+        return; // Error message already shown in gtk_window_get_pip_surface
+    pip_surface_set_prepare_offscreen(pip_surface, prepare_offscreen);
+}
+
+gboolean gtk_pip_get_prepare_offscreen(GtkWindow *window)
+{
+    PipSurface *pip_surface = gtk_window_get_pip_surface(window);
+    if (!pip_surface)
+        return FALSE; // Error message already shown in gtk_window_get_pip_surface
+    return pip_surface_get_prepare_offscreen(pip_surface);
+}
+
+void gtk_pip_set_preferred_corner(GtkWindow *window, GtkPipCorner corner)
+{
+    PipSurface *pip_surface = gtk_window_get_pip_surface(window);
+    if (!pip_surface)
+        return; // Error message already shown in gtk_window_get_pip_surface
+    pip_surface_set_preferred_corner(pip_surface, corner);
+}
+
+GtkPipCorner gtk_pip_get_preferred_corner(GtkWindow *window)
+{
+    PipSurface *pip_surface = gtk_window_get_pip_surface(window);
+    if (!pip_surface)
+        return GTK_PIP_CORNER_NONE; // Error message already shown in gtk_window_get_pip_surface
+    return pip_surface_get_preferred_corner(pip_surface);
+}
+
+void gtk_pip_set_dismiss_policy(GtkWindow *window, GtkPipDismissPolicy policy)
+{
+    PipSurface *pip_surface = gtk_window_get_pip_surface(window);
+    if (!pip_surface)
+        return; // Error message already shown in gtk_window_get_pip_surface
+    pip_surface_set_dismiss_policy(pip_surface, policy);
+}
+
+GtkPipDismissPolicy gtk_pip_get_dismiss_policy(GtkWindow *window)
+{
+    PipSurface *pip_surface = gtk_window_get_pip_surface(window);
+    if (!pip_surface)
+        return GTK_PIP_DISMISS_POLICY_CLOSE; // Error message already shown in gtk_window_get_pip_surface
+    return pip_surface_get_dismiss_policy(pip_surface);
+}
+
+void gtk_pip_set_dismissed_callback(GtkWindow *window,
+                                    GtkPipDismissedFunc callback,
+                                    gpointer user_data,
+                                    GDestroyNotify destroy)
+{
+    PipSurface *pip_surface = gtk_window_get_pip_surface(window);
+    if (!pip_surface)
+    {
+        // Error message already shown in gtk_window_get_pip_surface
+        if (destroy)
+            destroy(user_data);
+        return;
+    }
+    pip_surface_set_dismissed_callback(pip_surface, callback, user_data, destroy);
+}
+
 void gtk_pip_move(GtkWindow *window)
 {
     PipSurface *pip_surface = gtk_window_get_pip_surface(window);
     if (!pip_surface)
         return; // Error message already shown in gtk_window_get_pip_surface
-    return pip_surface_move(pip_surface);
+    return pip_surface_move(pip_surface, NULL, 0);
+}
+
+void gtk_pip_move_for_event(GtkWindow *window, const GdkEvent *event)
+{
+    g_return_if_fail(event);
+    PipSurface *pip_surface = gtk_window_get_pip_surface(window);
+    if (!pip_surface)
+        return; // Error message already shown in gtk_window_get_pip_surface
+    GdkSeat *seat;
+    uint32_t serial = gdk_event_get_priv_serial(event, &seat);
+    pip_surface_move(pip_surface, seat, serial);
 }
 
 void gtk_pip_resize(GtkWindow *window, GdkWindowEdge edge)
@@ -136,5 +229,302 @@ void gtk_pip_resize(GtkWindow *window, GdkWindowEdge edge)
     PipSurface *pip_surface = gtk_window_get_pip_surface(window);
     if (!pip_surface)
         return; // Error message already shown in gtk_window_get_pip_surface
-    return pip_surface_resize(pip_surface, edge);
+    return pip_surface_resize(pip_surface, edge, NULL, 0);
+}
+
+void gtk_pip_resize_for_event(GtkWindow *window, GdkWindowEdge edge, const GdkEvent *event)
+{
+    g_return_if_fail(event);
+    PipSurface *pip_surface = gtk_window_get_pip_surface(window);
+    if (!pip_surface)
+        return; // Error message already shown in gtk_window_get_pip_surface
+    GdkSeat *seat;
+    uint32_t serial = gdk_event_get_priv_serial(event, &seat);
+    pip_surface_resize(pip_surface, edge, seat, serial);
+}
+
+void gtk_pip_set_content_type(GtkWindow *window, GtkPipContentType content_type)
+{
+    PipSurface *pip_surface = gtk_window_get_pip_surface(window);
+    if (!pip_surface)
+        return; // Error message already shown in gtk_window_get_pip_surface
+    pip_surface_set_content_type(pip_surface, content_type);
+}
+
+GtkPipContentType gtk_pip_get_content_type(GtkWindow *window)
+{
+    PipSurface *pip_surface = gtk_window_get_pip_surface(window);
+    if (!pip_surface)
+        return GTK_PIP_CONTENT_TYPE_NONE; // Error message already shown in gtk_window_get_pip_surface
+    return pip_surface_get_content_type(pip_surface);
+}
+
+void gtk_pip_set_low_latency(GtkWindow *window, gboolean low_latency)
+{
+    PipSurface *pip_surface = gtk_window_get_pip_surface(window);
+    if (!pip_surface)
+        return; // Error message already shown in gtk_window_get_pip_surface
+    pip_surface_set_low_latency(pip_surface, low_latency);
+}
+
+gboolean gtk_pip_get_low_latency(GtkWindow *window)
+{
+    PipSurface *pip_surface = gtk_window_get_pip_surface(window);
+    if (!pip_surface)
+        return FALSE; // Error message already shown in gtk_window_get_pip_surface
+    return pip_surface_get_low_latency(pip_surface);
+}
+
+void gtk_pip_set_full_repaint(GtkWindow *window, gboolean full_repaint)
+{
+    PipSurface *pip_surface = gtk_window_get_pip_surface(window);
+    if (!pip_surface)
+        return; // Error message already shown in gtk_window_get_pip_surface
+    pip_surface_set_full_repaint(pip_surface, full_repaint);
+}
+
+gboolean gtk_pip_get_full_repaint(GtkWindow *window)
+{
+    PipSurface *pip_surface = gtk_window_get_pip_surface(window);
+    if (!pip_surface)
+        return FALSE; // Error message already shown in gtk_window_get_pip_surface
+    return pip_surface_get_full_repaint(pip_surface);
+}
+
+guint64 gtk_pip_get_backfill_bytes(GtkWindow *window)
+{
+    PipSurface *pip_surface = gtk_window_get_pip_surface(window);
+    if (!pip_surface)
+        return 0; // Error message already shown in gtk_window_get_pip_surface
+    return pip_surface_get_backfill_bytes(pip_surface);
+}
+
+void gtk_pip_set_buffer_pool(GtkWindow *window, gboolean buffer_pool)
+{
+    PipSurface *pip_surface = gtk_window_get_pip_surface(window);
+    if (!pip_surface)
+        return; // Error message already shown in gtk_window_get_pip_surface
+    pip_surface_set_use_buffer_pool(pip_surface, buffer_pool);
+}
+
+gboolean gtk_pip_get_buffer_pool(GtkWindow *window)
+{
+    PipSurface *pip_surface = gtk_window_get_pip_surface(window);
+    if (!pip_surface)
+        return FALSE; // Error message already shown in gtk_window_get_pip_surface
+    return pip_surface_get_use_buffer_pool(pip_surface);
+}
+
+gboolean gtk_pip_get_dmabuf_supported(guint32 fourcc, guint64 modifier)
+{
+    if (!GDK_IS_WAYLAND_DISPLAY(gdk_display_get_default()))
+        return FALSE;
+    gtk_wayland_init_if_needed();
+    return gtk_wayland_get_dmabuf_format_supported(fourcc, modifier);
+}
+
+gboolean gtk_pip_set_dmabuf_frame(GtkWindow *window,
+                                  int width,
+                                  int height,
+                                  guint32 fourcc,
+                                  guint64 modifier,
+                                  int n_planes,
+                                  const int *fds,
+                                  const guint32 *offsets,
+                                  const guint32 *strides,
+                                  GtkPipDmabufReleaseFunc release_func,
+                                  gpointer user_data)
+{
+    PipSurface *pip_surface = gtk_window_get_pip_surface(window);
+    if (!pip_surface)
+        return FALSE; // Error message already shown in gtk_window_get_pip_surface
+    return pip_surface_set_dmabuf_frame(pip_surface,
+                                        width,
+                                        height,
+                                        fourcc,
+                                        modifier,
+                                        n_planes,
+                                        fds,
+                                        offsets,
+                                        strides,
+                                        release_func,
+                                        user_data);
+}
+
+void gtk_pip_clear_dmabuf_frame(GtkWindow *window)
+{
+    PipSurface *pip_surface = gtk_window_get_pip_surface(window);
+    if (!pip_surface)
+        return; // Error message already shown in gtk_window_get_pip_surface
+    pip_surface_clear_dmabuf_frame(pip_surface);
+}
+
+void gtk_pip_set_dmabuf_below(GtkWindow *window, gboolean below)
+{
+    PipSurface *pip_surface = gtk_window_get_pip_surface(window);
+    if (!pip_surface)
+        return; // Error message already shown in gtk_window_get_pip_surface
+    pip_surface_set_dmabuf_below(pip_surface, below);
+}
+
+gboolean gtk_pip_get_dmabuf_below(GtkWindow *window)
+{
+    PipSurface *pip_surface = gtk_window_get_pip_surface(window);
+    if (!pip_surface)
+        return FALSE; // Error message already shown in gtk_window_get_pip_surface
+    return pip_surface_get_dmabuf_below(pip_surface);
+}
+
+void gtk_pip_set_resize_cursor(GtkWindow *window, GdkWindowEdge edge)
+{
+    PipSurface *pip_surface = gtk_window_get_pip_surface(window);
+    if (!pip_surface)
+        return; // Error message already shown in gtk_window_get_pip_surface
+    pip_surface_set_resize_cursor(pip_surface, edge);
+}
+
+void gtk_pip_unset_resize_cursor(GtkWindow *window)
+{
+    PipSurface *pip_surface = gtk_window_get_pip_surface(window);
+    if (!pip_surface)
+        return; // Error message already shown in gtk_window_get_pip_surface
+    pip_surface_unset_resize_cursor(pip_surface);
+}
+
+gboolean gtk_pip_get_resizing(GtkWindow *window)
+{
+    PipSurface *pip_surface = gtk_window_get_pip_surface(window);
+    if (!pip_surface)
+        return FALSE; // Error message already shown in gtk_window_get_pip_surface
+    return pip_surface_get_resizing(pip_surface);
+}
+
+void gtk_pip_set_resize_snapshot(GtkWindow *window, gboolean resize_snapshot)
+{
+    PipSurface *pip_surface = gtk_window_get_pip_surface(window);
+    if (!pip_surface)
+        return; // Error message already shown in gtk_window_get_pip_surface
+    pip_surface_set_resize_snapshot(pip_surface, resize_snapshot);
+}
+
+gboolean gtk_pip_get_resize_snapshot(GtkWindow *window)
+{
+    PipSurface *pip_surface = gtk_window_get_pip_surface(window);
+    if (!pip_surface)
+        return FALSE; // Error message already shown in gtk_window_get_pip_surface
+    return pip_surface_get_resize_snapshot(pip_surface);
+}
+
+void gtk_pip_get_predicted_size(GtkWindow *window, int *width, int *height)
+{
+    PipSurface *pip_surface = gtk_window_get_pip_surface(window);
+    if (!pip_surface)
+    {
+        // Error message already shown in gtk_window_get_pip_surface
+        if (width)
+            *width = 0;
+        if (height)
+            *height = 0;
+        return;
+    }
+    pip_surface_get_predicted_size(pip_surface, width, height);
+}
+
+void gtk_pip_get_resize_stats(GtkWindow *window, GtkPipResizeStats *stats)
+{
+    g_return_if_fail(stats);
+    PipSurface *pip_surface = gtk_window_get_pip_surface(window);
+    if (!pip_surface)
+    {
+        *stats = (GtkPipResizeStats){0}; // Error message already shown in gtk_window_get_pip_surface
+        return;
+    }
+    pip_surface_get_resize_stats(pip_surface, stats);
+}
+
+double
+gtk_pip_get_preferred_scale(GtkWindow *window)
+{
+    PipSurface *pip_surface = gtk_window_get_pip_surface(window);
+    if (!pip_surface)
+        return 1.0; // Error message already shown in gtk_window_get_pip_surface
+    return pip_surface_get_preferred_scale(pip_surface);
+}
+
+void gtk_pip_get_preferred_buffer_size(GtkWindow *window, int *width, int *height)
+{
+    PipSurface *pip_surface = gtk_window_get_pip_surface(window);
+    if (!pip_surface)
+    {
+        // Error message already shown in gtk_window_get_pip_surface
+        if (width)
+            *width = 0;
+        if (height)
+            *height = 0;
+        return;
+    }
+    pip_surface_get_preferred_buffer_size(pip_surface, width, height);
+}
+
+GdkMonitor *
+gtk_pip_get_monitor(GtkWindow *window)
+{
+    PipSurface *pip_surface = gtk_window_get_pip_surface(window);
+    if (!pip_surface)
+        return NULL; // Error message already shown in gtk_window_get_pip_surface
+    return pip_surface_get_monitor(pip_surface);
+}
+
+void gtk_pip_set_opaque_rect(GtkWindow *window, const GdkRectangle *rect)
+{
+    PipSurface *pip_surface = gtk_window_get_pip_surface(window);
+    if (!pip_surface)
+        return; // Error message already shown in gtk_window_get_pip_surface
+    pip_surface_set_opaque_rect(pip_surface, rect);
+}
+
+void gtk_pip_set_input_rect(GtkWindow *window, const GdkRectangle *rect)
+{
+    PipSurface *pip_surface = gtk_window_get_pip_surface(window);
+    if (!pip_surface)
+        return; // Error message already shown in gtk_window_get_pip_surface
+    pip_surface_set_input_rect(pip_surface, rect);
+}
+
+gboolean
+gtk_pip_frame_convert(GtkPipFrameFormat format,
+                      const guint8 *const *planes,
+                      const int *strides,
+                      int width,
+                      int height,
+                      GtkPipFrameScale scale,
+                      cairo_surface_t *dest)
+{
+    g_return_val_if_fail(planes, FALSE);
+    g_return_val_if_fail(strides, FALSE);
+    g_return_val_if_fail(dest, FALSE);
+    g_return_val_if_fail(cairo_surface_get_type(dest) == CAIRO_SURFACE_TYPE_IMAGE, FALSE);
+    cairo_format_t dest_format = cairo_image_surface_get_format(dest);
+    g_return_val_if_fail(dest_format == CAIRO_FORMAT_RGB24 || dest_format == CAIRO_FORMAT_ARGB32, FALSE);
+
+    cairo_surface_flush(dest);
+    int result = frame_convert(frame_convert_get_kernels(),
+                               gtk_pip_frame_format_get_frame_format(format),
+                               planes,
+                               strides,
+                               width,
+                               height,
+                               gtk_pip_frame_scale_get_frame_scale(scale),
+                               cairo_image_surface_get_data(dest),
+                               cairo_image_surface_get_stride(dest),
+                               cairo_image_surface_get_width(dest),
+                               cairo_image_surface_get_height(dest));
+    cairo_surface_mark_dirty(dest);
+
+    if (result != 0)
+    {
+        g_critical("Invalid frame or destination passed to gtk_pip_frame_convert ()");
+        return FALSE;
+    }
+    return TRUE;
 }
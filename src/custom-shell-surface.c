@@ -17,39 +17,147 @@
 #include <gdk/gdk.h>
 #include <gdk/gdkwayland.h>
 
-static const char *custom_shell_surface_key = "wayland_custom_shell_surface";
+// A quark avoids interning the key string on every lookup
+static GQuark custom_shell_surface_quark = 0;
 
-struct _CustomShellSurfacePrivate
+static int map_batch_depth = 0;
+static gboolean map_batch_needs_roundtrip = FALSE;
+
+// Maps the realized GdkWindow of every shell surface to the surface, so GDK overrides don't need GdkWindow -> GtkWindow
+// -> qdata lookups. Entries are added on realize and removed when the GdkWindow or the shell surface goes away.
+static GHashTable *gdk_window_index = NULL;
+
+// Maps a GdkWindow that popups are transient for to the nearest shell surface up its transient-for chain (or NULL if
+// there is none). Emptied whenever the index or any transient-for changes, and entries are weakly referenced.
+static GHashTable *transient_cache = NULL;
+
+static void custom_shell_surface_on_gdk_window_finalize (gpointer data, GObject *where_the_object_was);
+
+static void
+custom_shell_surface_on_cached_window_finalize (gpointer data, GObject *where_the_object_was)
+{
+    (void)data;
+    g_hash_table_remove (transient_cache, where_the_object_was);
+}
+
+void
+custom_shell_surface_invalidate_transient_cache (void)
+{
+    if (!transient_cache || g_hash_table_size (transient_cache) == 0)
+        return;
+
+    GHashTableIter iter;
+    gpointer gdk_window;
+    g_hash_table_iter_init (&iter, transient_cache);
+    while (g_hash_table_iter_next (&iter, &gdk_window, NULL))
+        g_object_weak_unref (G_OBJECT (gdk_window), custom_shell_surface_on_cached_window_finalize, NULL);
+    g_hash_table_remove_all (transient_cache);
+}
+
+static void
+custom_shell_surface_index_remove (CustomShellSurface *self)
+{
+    GdkWindow *gdk_window = self->private.gdk_window;
+    if (!gdk_window)
+        return;
+
+    g_object_weak_unref (G_OBJECT (gdk_window), custom_shell_surface_on_gdk_window_finalize, self);
+    g_hash_table_remove (gdk_window_index, gdk_window);
+    self->private.gdk_window = NULL;
+    custom_shell_surface_invalidate_transient_cache ();
+}
+
+static void
+custom_shell_surface_on_gdk_window_finalize (gpointer data, GObject *where_the_object_was)
 {
-    GtkWindow *gtk_window;
-};
+    CustomShellSurface *self = data;
+    g_hash_table_remove (gdk_window_index, where_the_object_was);
+    // The window's weak refs are already gone, so its own cache entry must not be weakly unreferenced
+    if (transient_cache)
+        g_hash_table_remove (transient_cache, where_the_object_was);
+    self->private.gdk_window = NULL;
+    custom_shell_surface_invalidate_transient_cache ();
+}
+
+static void
+custom_shell_surface_index_add (CustomShellSurface *self, GdkWindow *gdk_window)
+{
+    if (self->private.gdk_window == gdk_window)
+        return;
+
+    custom_shell_surface_index_remove (self);
+
+    if (!gdk_window_index)
+        gdk_window_index = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+    g_hash_table_insert (gdk_window_index, gdk_window, self);
+    g_object_weak_ref (G_OBJECT (gdk_window), custom_shell_surface_on_gdk_window_finalize, self);
+    self->private.gdk_window = gdk_window;
+    custom_shell_surface_invalidate_transient_cache ();
+}
 
 static void
 custom_shell_surface_on_window_destroy (CustomShellSurface *self)
 {
+    custom_shell_surface_index_remove (self);
     self->virtual->finalize (self);
-    g_free (self->private);
     g_free (self);
 }
 
-static void
-custom_shell_surface_on_window_realize (GtkWidget *widget, CustomShellSurface *self)
+CustomShellSurface *
+custom_shell_surface_get_for_gdk_window (GdkWindow *gdk_window)
+{
+    if (!gdk_window || !gdk_window_index)
+        return NULL;
+
+    return g_hash_table_lookup (gdk_window_index, gdk_window);
+}
+
+CustomShellSurface *
+custom_shell_surface_find_for_transient (GdkWindow *transient_for)
 {
-    g_return_if_fail (GTK_WIDGET (self->private->gtk_window) == widget);
+    // Nothing can be found before the first shell surface is realized, so the common no-pip case stays allocation free
+    if (!transient_for || !gdk_window_index || g_hash_table_size (gdk_window_index) == 0)
+        return NULL;
+
+    gpointer cached;
+    if (transient_cache && g_hash_table_lookup_extended (transient_cache, transient_for, NULL, &cached))
+        return cached;
+
+    // Popups of shell surfaces (including nested custom popups, which are shell surfaces too) stop at the first level
+    CustomShellSurface *shell_surface = NULL;
+    GdkWindow *toplevel_gdk_window = transient_for;
+    while (toplevel_gdk_window) {
+        toplevel_gdk_window = gdk_window_get_toplevel (toplevel_gdk_window);
+        shell_surface = custom_shell_surface_get_for_gdk_window (toplevel_gdk_window);
+        if (shell_surface)
+            break;
+        toplevel_gdk_window = gdk_window_get_priv_transient_for (toplevel_gdk_window);
+    }
 
-    GdkWindow *gdk_window = gtk_widget_get_window (GTK_WIDGET (self->private->gtk_window));
+    if (!transient_cache)
+        transient_cache = g_hash_table_new (g_direct_hash, g_direct_equal);
+    g_hash_table_insert (transient_cache, transient_for, shell_surface);
+    g_object_weak_ref (G_OBJECT (transient_for), custom_shell_surface_on_cached_window_finalize, NULL);
+
+    return shell_surface;
+}
+
+void
+custom_shell_surface_on_window_realize (CustomShellSurface *self)
+{
+    GdkWindow *gdk_window = gtk_widget_get_window (GTK_WIDGET (self->private.gtk_window));
     g_return_if_fail (gdk_window);
 
     gtk_priv_access_init (gdk_window);
     gdk_wayland_window_set_use_custom_surface (gdk_window);
+    custom_shell_surface_index_add (self, gdk_window);
 }
 
-static void
-custom_shell_surface_on_window_map (GtkWidget *widget, CustomShellSurface *self)
+void
+custom_shell_surface_on_window_map (CustomShellSurface *self)
 {
-    g_return_if_fail (GTK_WIDGET (self->private->gtk_window) == widget);
-
-    GdkWindow *gdk_window = gtk_widget_get_window (GTK_WIDGET (self->private->gtk_window));
+    GdkWindow *gdk_window = gtk_widget_get_window (GTK_WIDGET (self->private.gtk_window));
     g_return_if_fail (gdk_window);
 
     struct wl_surface *wl_surface = gdk_wayland_window_get_wl_surface (gdk_window);
@@ -65,7 +173,36 @@ custom_shell_surface_on_window_map (GtkWidget *widget, CustomShellSurface *self)
     gdk_window_set_priv_mapped (gdk_window);
 
     wl_surface_commit (wl_surface);
-    wl_display_roundtrip (gdk_wayland_display_get_wl_display (gdk_display_get_default ()));
+
+    if (map_batch_depth > 0)
+        map_batch_needs_roundtrip = TRUE;
+    else
+        wl_display_roundtrip (gdk_wayland_display_get_wl_display (gdk_display_get_default ()));
+}
+
+void
+custom_shell_surface_on_window_size_allocate (CustomShellSurface *self, GdkRectangle *allocation)
+{
+    if (self->virtual->size_allocate)
+        self->virtual->size_allocate (self, allocation);
+}
+
+void
+custom_shell_surface_begin_map_batch (void)
+{
+    map_batch_depth++;
+}
+
+void
+custom_shell_surface_end_map_batch (void)
+{
+    g_return_if_fail (map_batch_depth > 0);
+
+    map_batch_depth--;
+    if (map_batch_depth == 0 && map_batch_needs_roundtrip) {
+        map_batch_needs_roundtrip = FALSE;
+        wl_display_roundtrip (gdk_wayland_display_get_wl_display (gdk_display_get_default ()));
+    }
 }
 
 void
@@ -73,38 +210,42 @@ custom_shell_surface_init (CustomShellSurface *self, GtkWindow *gtk_window)
 {
     g_assert (self->virtual); // Subclass should have set this up first
 
-    self->private = g_new0 (CustomShellSurfacePrivate, 1);
-    self->private->gtk_window = gtk_window;
+    self->private.gtk_window = gtk_window;
 
     g_return_if_fail (gtk_window);
     g_return_if_fail (!gtk_widget_get_mapped (GTK_WIDGET (gtk_window)));
-    g_object_set_data_full (G_OBJECT (gtk_window),
-                            custom_shell_surface_key,
-                            self,
-                            (GDestroyNotify) custom_shell_surface_on_window_destroy);
-    g_signal_connect (gtk_window, "realize", G_CALLBACK (custom_shell_surface_on_window_realize), self);
-    g_signal_connect (gtk_window, "map", G_CALLBACK (custom_shell_surface_on_window_map), self);
+
+    if (!custom_shell_surface_quark)
+        custom_shell_surface_quark = g_quark_from_static_string ("wayland_custom_shell_surface");
+
+    // No per-window signal handlers are connected; realize, map and size-allocate reach the surface through the
+    // vfuncs of the private window subtype in gtk-wayland.c, which look the surface up with this qdata
+    g_object_set_qdata_full (G_OBJECT (gtk_window),
+                             custom_shell_surface_quark,
+                             self,
+                             (GDestroyNotify) custom_shell_surface_on_window_destroy);
+    gtk_wayland_override_window_class (gtk_window);
 
     if (gtk_widget_get_realized (GTK_WIDGET (gtk_window))) {
         // We must be in the process of realizing now
-        custom_shell_surface_on_window_realize (GTK_WIDGET (gtk_window), self);
+        custom_shell_surface_on_window_realize (self);
     }
 }
 
 CustomShellSurface *
 gtk_window_get_custom_shell_surface (GtkWindow *gtk_window)
 {
-    if (!gtk_window)
+    if (!gtk_window || !custom_shell_surface_quark)
         return NULL;
 
-    return g_object_get_data (G_OBJECT (gtk_window), custom_shell_surface_key);
+    return g_object_get_qdata (G_OBJECT (gtk_window), custom_shell_surface_quark);
 }
 
 GtkWindow *
 custom_shell_surface_get_gtk_window (CustomShellSurface *self)
 {
     g_return_val_if_fail (self, NULL);
-    return self->private->gtk_window;
+    return self->private.gtk_window;
 }
 
 void
@@ -112,16 +253,16 @@ custom_shell_surface_get_window_geom (CustomShellSurface *self, GdkRectangle *ge
 {
     g_return_if_fail (self);
     // TODO: Store the actual window geometry used
-    *geom = gtk_wayland_get_logical_geom (self->private->gtk_window);
+    *geom = gtk_wayland_get_logical_geom (self->private.gtk_window);
 }
 
 void
 custom_shell_surface_needs_commit (CustomShellSurface *self)
 {
-    if (!self->private->gtk_window)
+    if (!self->private.gtk_window)
         return;
 
-    GdkWindow *gdk_window = gtk_widget_get_window (GTK_WIDGET (self->private->gtk_window));
+    GdkWindow *gdk_window = gtk_widget_get_window (GTK_WIDGET (self->private.gtk_window));
 
     if (!gdk_window)
         return;
@@ -129,6 +270,9 @@ custom_shell_surface_needs_commit (CustomShellSurface *self)
     // Hopefully this will trigger a commit
     // Don't commit directly, as that screws up GTK's internal state
     // (see https://github.com/wmww/gtk-pip-shell/issues/51)
-    gdk_window_invalidate_rect (gdk_window, NULL, FALSE);
+    // Only a single pixel is invalidated, as GDK repaints and damages exactly the invalidated region. Invalidating the
+    // whole window would make the compositor re-upload the entire buffer for what is usually just a state change.
+    GdkRectangle rect = {0, 0, 1, 1};
+    gdk_window_invalidate_rect (gdk_window, &rect, FALSE);
 }
 
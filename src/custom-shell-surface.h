@@ -35,6 +35,10 @@ struct _CustomShellSurfaceVirtual
     // Will usually call unmap; can be the same function if no other resources need to be freed
     void (*finalize) (CustomShellSurface *super);
 
+    // Called after the window's default size-allocate handler has run
+    // May be NULL
+    void (*size_allocate) (CustomShellSurface *super, GdkRectangle *allocation);
+
     struct xdg_popup *(*get_popup) (CustomShellSurface *super,
                                     struct xdg_surface *popup_xdg_surface,
                                     struct xdg_positioner *positioner);
@@ -43,10 +47,19 @@ struct _CustomShellSurfaceVirtual
     GdkRectangle (*get_logical_geom) (CustomShellSurface *super);
 };
 
+// Embedded in the shell surface so each surface is a single allocation
+// Only custom-shell-surface.c should touch these fields
+struct _CustomShellSurfacePrivate
+{
+    GtkWindow *gtk_window;
+    // The realized GdkWindow this surface is indexed under, or NULL
+    GdkWindow *gdk_window;
+};
+
 struct _CustomShellSurface
 {
     CustomShellSurfaceVirtual const *virtual;
-    CustomShellSurfacePrivate *private;
+    CustomShellSurfacePrivate private;
 };
 
 // Usually called by the subclass constructors
@@ -59,13 +72,37 @@ CustomShellSurface *gtk_window_get_custom_shell_surface (GtkWindow *gtk_window);
 
 GtkWindow *custom_shell_surface_get_gtk_window (CustomShellSurface *self);
 
+// If the GdkWindow is the realized window of a shell surface, return the surface; else return NULL
+// A single hash table lookup, NULL input is handled gracefully
+CustomShellSurface *custom_shell_surface_get_for_gdk_window (GdkWindow *gdk_window);
+
+// Returns the nearest shell surface up the transient-for chain of the given window (starting with its toplevel), or NULL
+// The result is cached per window until a shell surface is realized or destroyed, or any transient-for changes
+CustomShellSurface *custom_shell_surface_find_for_transient (GdkWindow *transient_for);
+
+// Must be called when GDK changes any window's transient-for
+void custom_shell_surface_invalidate_transient_cache (void);
+
+// Called by the vfuncs of the private window subtype in gtk-wayland.c after chaining up
+// Signals are not connected per window, so these are the only entry points for window state changes
+void custom_shell_surface_on_window_realize (CustomShellSurface *self);
+void custom_shell_surface_on_window_map (CustomShellSurface *self);
+void custom_shell_surface_on_window_size_allocate (CustomShellSurface *self, GdkRectangle *allocation);
+
 // In theory this could commit once on next event loop, but for now it will just commit every time it is called
 // Does nothing is the shell surface does not currently have a GdkWindow with a wl_surface
+// The commit only damages a single pixel, so calling this does not cause the whole surface to be re-uploaded
 void custom_shell_surface_needs_commit (CustomShellSurface *self);
 
 // Unmap and remap a currently mapped shell surface
 void custom_shell_surface_remap (CustomShellSurface *self);
 
+// While a map batch is open, mapping a shell surface does not block on a Wayland roundtrip
+// A single roundtrip is done when the outermost batch is ended (if any surface was mapped during it)
+// Batches must be ended before returning to the main loop, or GTK may attach buffers before the initial configure
+void custom_shell_surface_begin_map_batch (void);
+void custom_shell_surface_end_map_batch (void);
+
 // Destruction is taken care of automatically when the associated window is destroyed
 
 #endif // CUSTOM_SHELL_SURFACE_H
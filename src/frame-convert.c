@@ -0,0 +1,712 @@
+/* This entire file is licensed under MIT
+ *
+ * Copyright 2020 Sophie Winter
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "frame-convert.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define FRAME_CONVERT_X86
+#include <immintrin.h>
+#endif
+
+#if defined(__aarch64__) || defined(__ARM_NEON)
+#define FRAME_CONVERT_NEON
+#include <arm_neon.h>
+#endif
+
+// BT.601 limited range, in 8.8 fixed point:
+// R = 1.164(Y - 16) + 1.596(V - 128)
+// G = 1.164(Y - 16) - 0.391(U - 128) - 0.813(V - 128)
+// B = 1.164(Y - 16) + 2.018(U - 128)
+#define COEF_Y 298
+#define COEF_RV 409
+#define COEF_GU -100
+#define COEF_GV -208
+#define COEF_BU 516
+
+static inline uint8_t
+clamp_u8(int value)
+{
+    return value < 0 ? 0 : (value > 255 ? 255 : value);
+}
+
+static void
+yuv_row_to_xrgb_scalar(const uint8_t *y, const uint8_t *u, const uint8_t *v, uint32_t *dest, int width)
+{
+    for (int i = 0; i < width; i++)
+    {
+        int c = COEF_Y * (y[i] - 16) + 128;
+        int d = u[i] - 128;
+        int e = v[i] - 128;
+        uint32_t r = clamp_u8((c + COEF_RV * e) >> 8);
+        uint32_t g = clamp_u8((c + COEF_GU * d + COEF_GV * e) >> 8);
+        uint32_t b = clamp_u8((c + COEF_BU * d) >> 8);
+        dest[i] = 0xff000000 | (r << 16) | (g << 8) | b;
+    }
+}
+
+static void
+blend_rows_scalar(const uint8_t *a, const uint8_t *b, uint8_t *dest, int width, int weight)
+{
+    for (int i = 0; i < width; i++)
+        dest[i] = (a[i] * (256 - weight) + b[i] * weight + 128) >> 8;
+}
+
+static void
+accumulate_row_scalar(const uint8_t *src, uint32_t *sums, int width)
+{
+    for (int i = 0; i < width; i++)
+        sums[i] += src[i];
+}
+
+static const FrameConvertKernels scalar_kernels = {
+    .name = "scalar",
+    .yuv_row_to_xrgb = yuv_row_to_xrgb_scalar,
+    .blend_rows = blend_rows_scalar,
+    .accumulate_row = accumulate_row_scalar,
+};
+
+#ifdef FRAME_CONVERT_X86
+
+// The products are done in 32 bits with madd, on pairs of (Y, U or V) samples, so the results match the scalar code
+
+__attribute__((target("sse2"))) static void
+yuv_row_to_xrgb_sse2(const uint8_t *y, const uint8_t *u, const uint8_t *v, uint32_t *dest, int width)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i y_offset = _mm_set1_epi16(16);
+    const __m128i uv_offset = _mm_set1_epi16(128);
+    const __m128i rounding = _mm_set1_epi32(128);
+    const __m128i max = _mm_set1_epi16(255);
+    const __m128i alpha = _mm_set1_epi16((short)0xff00);
+    const __m128i coef_r = _mm_setr_epi16(COEF_Y, COEF_RV, COEF_Y, COEF_RV, COEF_Y, COEF_RV, COEF_Y, COEF_RV);
+    const __m128i coef_gu = _mm_setr_epi16(COEF_Y, COEF_GU, COEF_Y, COEF_GU, COEF_Y, COEF_GU, COEF_Y, COEF_GU);
+    const __m128i coef_gv = _mm_setr_epi16(COEF_GV, 0, COEF_GV, 0, COEF_GV, 0, COEF_GV, 0);
+    const __m128i coef_b = _mm_setr_epi16(COEF_Y, COEF_BU, COEF_Y, COEF_BU, COEF_Y, COEF_BU, COEF_Y, COEF_BU);
+
+    int i = 0;
+    for (; i + 8 <= width; i += 8)
+    {
+        __m128i c = _mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(y + i)), zero), y_offset);
+        __m128i d = _mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(u + i)), zero), uv_offset);
+        __m128i e = _mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(v + i)), zero), uv_offset);
+
+        __m128i ce_lo = _mm_unpacklo_epi16(c, e);
+        __m128i ce_hi = _mm_unpackhi_epi16(c, e);
+        __m128i cd_lo = _mm_unpacklo_epi16(c, d);
+        __m128i cd_hi = _mm_unpackhi_epi16(c, d);
+        __m128i e0_lo = _mm_unpacklo_epi16(e, zero);
+        __m128i e0_hi = _mm_unpackhi_epi16(e, zero);
+
+        __m128i r_lo = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(ce_lo, coef_r), rounding), 8);
+        __m128i r_hi = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(ce_hi, coef_r), rounding), 8);
+        __m128i g_lo = _mm_add_epi32(_mm_madd_epi16(cd_lo, coef_gu), _mm_madd_epi16(e0_lo, coef_gv));
+        __m128i g_hi = _mm_add_epi32(_mm_madd_epi16(cd_hi, coef_gu), _mm_madd_epi16(e0_hi, coef_gv));
+        g_lo = _mm_srai_epi32(_mm_add_epi32(g_lo, rounding), 8);
+        g_hi = _mm_srai_epi32(_mm_add_epi32(g_hi, rounding), 8);
+        __m128i b_lo = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(cd_lo, coef_b), rounding), 8);
+        __m128i b_hi = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(cd_hi, coef_b), rounding), 8);
+
+        __m128i r = _mm_min_epi16(_mm_max_epi16(_mm_packs_epi32(r_lo, r_hi), zero), max);
+        __m128i g = _mm_min_epi16(_mm_max_epi16(_mm_packs_epi32(g_lo, g_hi), zero), max);
+        __m128i b = _mm_min_epi16(_mm_max_epi16(_mm_packs_epi32(b_lo, b_hi), zero), max);
+
+        // Little endian XRGB is B, G, R, X in memory
+        __m128i bg = _mm_or_si128(b, _mm_slli_epi16(g, 8));
+        __m128i ra = _mm_or_si128(r, alpha);
+        _mm_storeu_si128((__m128i *)(dest + i), _mm_unpacklo_epi16(bg, ra));
+        _mm_storeu_si128((__m128i *)(dest + i + 4), _mm_unpackhi_epi16(bg, ra));
+    }
+
+    yuv_row_to_xrgb_scalar(y + i, u + i, v + i, dest + i, width - i);
+}
+
+__attribute__((target("sse2"))) static void
+blend_rows_sse2(const uint8_t *a, const uint8_t *b, uint8_t *dest, int width, int weight)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i weight_a = _mm_set1_epi16(256 - weight);
+    const __m128i weight_b = _mm_set1_epi16(weight);
+    const __m128i rounding = _mm_set1_epi16(128);
+
+    // The sums never exceed 65408, so 16 bit unsigned arithmetic is exact
+    int i = 0;
+    for (; i + 16 <= width; i += 16)
+    {
+        __m128i va = _mm_loadu_si128((const __m128i *)(a + i));
+        __m128i vb = _mm_loadu_si128((const __m128i *)(b + i));
+        __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(va, zero), weight_a),
+                                   _mm_mullo_epi16(_mm_unpacklo_epi8(vb, zero), weight_b));
+        __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(va, zero), weight_a),
+                                   _mm_mullo_epi16(_mm_unpackhi_epi8(vb, zero), weight_b));
+        lo = _mm_srli_epi16(_mm_add_epi16(lo, rounding), 8);
+        hi = _mm_srli_epi16(_mm_add_epi16(hi, rounding), 8);
+        _mm_storeu_si128((__m128i *)(dest + i), _mm_packus_epi16(lo, hi));
+    }
+
+    blend_rows_scalar(a + i, b + i, dest + i, width - i, weight);
+}
+
+__attribute__((target("sse2"))) static void
+accumulate_row_sse2(const uint8_t *src, uint32_t *sums, int width)
+{
+    const __m128i zero = _mm_setzero_si128();
+
+    int i = 0;
+    for (; i + 16 <= width; i += 16)
+    {
+        __m128i bytes = _mm_loadu_si128((const __m128i *)(src + i));
+        __m128i lo = _mm_unpacklo_epi8(bytes, zero);
+        __m128i hi = _mm_unpackhi_epi8(bytes, zero);
+        __m128i *out = (__m128i *)(sums + i);
+        _mm_storeu_si128(out + 0, _mm_add_epi32(_mm_loadu_si128(out + 0), _mm_unpacklo_epi16(lo, zero)));
+        _mm_storeu_si128(out + 1, _mm_add_epi32(_mm_loadu_si128(out + 1), _mm_unpackhi_epi16(lo, zero)));
+        _mm_storeu_si128(out + 2, _mm_add_epi32(_mm_loadu_si128(out + 2), _mm_unpacklo_epi16(hi, zero)));
+        _mm_storeu_si128(out + 3, _mm_add_epi32(_mm_loadu_si128(out + 3), _mm_unpackhi_epi16(hi, zero)));
+    }
+
+    accumulate_row_scalar(src + i, sums + i, width - i);
+}
+
+static const FrameConvertKernels sse2_kernels = {
+    .name = "sse2",
+    .yuv_row_to_xrgb = yuv_row_to_xrgb_sse2,
+    .blend_rows = blend_rows_sse2,
+    .accumulate_row = accumulate_row_sse2,
+};
+
+// Same as the SSE2 version, 16 pixels at a time
+// Unpacks and packs work within 128 bit lanes, so the pixel order only needs fixing up on the way out
+__attribute__((target("avx2"))) static void
+yuv_row_to_xrgb_avx2(const uint8_t *y, const uint8_t *u, const uint8_t *v, uint32_t *dest, int width)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i y_offset = _mm256_set1_epi16(16);
+    const __m256i uv_offset = _mm256_set1_epi16(128);
+    const __m256i rounding = _mm256_set1_epi32(128);
+    const __m256i max = _mm256_set1_epi16(255);
+    const __m256i alpha = _mm256_set1_epi16((short)0xff00);
+    const __m256i coef_r = _mm256_set1_epi32((int)(((uint32_t)(uint16_t)COEF_RV << 16) | (uint16_t)COEF_Y));
+    const __m256i coef_gu = _mm256_set1_epi32((int)(((uint32_t)(uint16_t)COEF_GU << 16) | (uint16_t)COEF_Y));
+    const __m256i coef_gv = _mm256_set1_epi32((int)(uint16_t)COEF_GV);
+    const __m256i coef_b = _mm256_set1_epi32((int)(((uint32_t)(uint16_t)COEF_BU << 16) | (uint16_t)COEF_Y));
+
+    int i = 0;
+    for (; i + 16 <= width; i += 16)
+    {
+        __m256i c = _mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(y + i))), y_offset);
+        __m256i d = _mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(u + i))), uv_offset);
+        __m256i e = _mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(v + i))), uv_offset);
+
+        __m256i ce_lo = _mm256_unpacklo_epi16(c, e);
+        __m256i ce_hi = _mm256_unpackhi_epi16(c, e);
+        __m256i cd_lo = _mm256_unpacklo_epi16(c, d);
+        __m256i cd_hi = _mm256_unpackhi_epi16(c, d);
+        __m256i e0_lo = _mm256_unpacklo_epi16(e, zero);
+        __m256i e0_hi = _mm256_unpackhi_epi16(e, zero);
+
+        __m256i r_lo = _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(ce_lo, coef_r), rounding), 8);
+        __m256i r_hi = _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(ce_hi, coef_r), rounding), 8);
+        __m256i g_lo = _mm256_add_epi32(_mm256_madd_epi16(cd_lo, coef_gu), _mm256_madd_epi16(e0_lo, coef_gv));
+        __m256i g_hi = _mm256_add_epi32(_mm256_madd_epi16(cd_hi, coef_gu), _mm256_madd_epi16(e0_hi, coef_gv));
+        g_lo = _mm256_srai_epi32(_mm256_add_epi32(g_lo, rounding), 8);
+        g_hi = _mm256_srai_epi32(_mm256_add_epi32(g_hi, rounding), 8);
+        __m256i b_lo = _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(cd_lo, coef_b), rounding), 8);
+        __m256i b_hi = _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(cd_hi, coef_b), rounding), 8);
+
+        // Packing undoes the unpacking within each lane, so these are back in pixel order
+        __m256i r = _mm256_min_epi16(_mm256_max_epi16(_mm256_packs_epi32(r_lo, r_hi), zero), max);
+        __m256i g = _mm256_min_epi16(_mm256_max_epi16(_mm256_packs_epi32(g_lo, g_hi), zero), max);
+        __m256i b = _mm256_min_epi16(_mm256_max_epi16(_mm256_packs_epi32(b_lo, b_hi), zero), max);
+
+        __m256i bg = _mm256_or_si256(b, _mm256_slli_epi16(g, 8));
+        __m256i ra = _mm256_or_si256(r, alpha);
+        __m256i px_lo = _mm256_unpacklo_epi16(bg, ra); // Pixels 0-3 and 8-11
+        __m256i px_hi = _mm256_unpackhi_epi16(bg, ra); // Pixels 4-7 and 12-15
+        _mm256_storeu_si256((__m256i *)(dest + i), _mm256_permute2x128_si256(px_lo, px_hi, 0x20));
+        _mm256_storeu_si256((__m256i *)(dest + i + 8), _mm256_permute2x128_si256(px_lo, px_hi, 0x31));
+    }
+
+    yuv_row_to_xrgb_sse2(y + i, u + i, v + i, dest + i, width - i);
+}
+
+__attribute__((target("avx2"))) static void
+blend_rows_avx2(const uint8_t *a, const uint8_t *b, uint8_t *dest, int width, int weight)
+{
+    const __m256i weight_a = _mm256_set1_epi16(256 - weight);
+    const __m256i weight_b = _mm256_set1_epi16(weight);
+    const __m256i rounding = _mm256_set1_epi16(128);
+
+    int i = 0;
+    for (; i + 32 <= width; i += 32)
+    {
+        __m256i a0 = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(a + i)));
+        __m256i a1 = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(a + i + 16)));
+        __m256i b0 = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(b + i)));
+        __m256i b1 = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(b + i + 16)));
+        __m256i r0 = _mm256_add_epi16(_mm256_mullo_epi16(a0, weight_a), _mm256_mullo_epi16(b0, weight_b));
+        __m256i r1 = _mm256_add_epi16(_mm256_mullo_epi16(a1, weight_a), _mm256_mullo_epi16(b1, weight_b));
+        r0 = _mm256_srli_epi16(_mm256_add_epi16(r0, rounding), 8);
+        r1 = _mm256_srli_epi16(_mm256_add_epi16(r1, rounding), 8);
+        // packus interleaves the lanes of its inputs, the permute puts the 64 bit blocks back in order
+        __m256i packed = _mm256_packus_epi16(r0, r1);
+        _mm256_storeu_si256((__m256i *)(dest + i), _mm256_permute4x64_epi64(packed, 0xd8));
+    }
+
+    blend_rows_sse2(a + i, b + i, dest + i, width - i, weight);
+}
+
+__attribute__((target("avx2"))) static void
+accumulate_row_avx2(const uint8_t *src, uint32_t *sums, int width)
+{
+    int i = 0;
+    for (; i + 16 <= width; i += 16)
+    {
+        __m256i lo = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(src + i)));
+        __m256i hi = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(src + i + 8)));
+        __m256i *out = (__m256i *)(sums + i);
+        _mm256_storeu_si256(out + 0, _mm256_add_epi32(_mm256_loadu_si256(out + 0), lo));
+        _mm256_storeu_si256(out + 1, _mm256_add_epi32(_mm256_loadu_si256(out + 1), hi));
+    }
+
+    accumulate_row_sse2(src + i, sums + i, width - i);
+}
+
+static const FrameConvertKernels avx2_kernels = {
+    .name = "avx2",
+    .yuv_row_to_xrgb = yuv_row_to_xrgb_avx2,
+    .blend_rows = blend_rows_avx2,
+    .accumulate_row = accumulate_row_avx2,
+};
+
+#endif // FRAME_CONVERT_X86
+
+#ifdef FRAME_CONVERT_NEON
+
+static inline uint8x8_t
+neon_channel(int32x4_t lo, int32x4_t hi)
+{
+    // vrshrn adds 128 before shifting, the same rounding as the scalar code
+    return vqmovun_s16(vcombine_s16(vrshrn_n_s32(lo, 8), vrshrn_n_s32(hi, 8)));
+}
+
+static void
+yuv_row_to_xrgb_neon(const uint8_t *y, const uint8_t *u, const uint8_t *v, uint32_t *dest, int width)
+{
+    const int16x8_t y_offset = vdupq_n_s16(16);
+    const int16x8_t uv_offset = vdupq_n_s16(128);
+
+    int i = 0;
+    for (; i + 8 <= width; i += 8)
+    {
+        int16x8_t c = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vld1_u8(y + i))), y_offset);
+        int16x8_t d = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vld1_u8(u + i))), uv_offset);
+        int16x8_t e = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vld1_u8(v + i))), uv_offset);
+
+        int32x4_t y_lo = vmull_n_s16(vget_low_s16(c), COEF_Y);
+        int32x4_t y_hi = vmull_n_s16(vget_high_s16(c), COEF_Y);
+
+        int32x4_t r_lo = vmlal_n_s16(y_lo, vget_low_s16(e), COEF_RV);
+        int32x4_t r_hi = vmlal_n_s16(y_hi, vget_high_s16(e), COEF_RV);
+        int32x4_t g_lo = vmlal_n_s16(vmlal_n_s16(y_lo, vget_low_s16(d), COEF_GU), vget_low_s16(e), COEF_GV);
+        int32x4_t g_hi = vmlal_n_s16(vmlal_n_s16(y_hi, vget_high_s16(d), COEF_GU), vget_high_s16(e), COEF_GV);
+        int32x4_t b_lo = vmlal_n_s16(y_lo, vget_low_s16(d), COEF_BU);
+        int32x4_t b_hi = vmlal_n_s16(y_hi, vget_high_s16(d), COEF_BU);
+
+        uint8x8x4_t pixels;
+        pixels.val[0] = neon_channel(b_lo, b_hi);
+        pixels.val[1] = neon_channel(g_lo, g_hi);
+        pixels.val[2] = neon_channel(r_lo, r_hi);
+        pixels.val[3] = vdup_n_u8(0xff);
+        vst4_u8((uint8_t *)(dest + i), pixels);
+    }
+
+    yuv_row_to_xrgb_scalar(y + i, u + i, v + i, dest + i, width - i);
+}
+
+static void
+blend_rows_neon(const uint8_t *a, const uint8_t *b, uint8_t *dest, int width, int weight)
+{
+    const uint16x8_t weight_a = vdupq_n_u16(256 - weight);
+    const uint16x8_t weight_b = vdupq_n_u16(weight);
+    const uint16x8_t rounding = vdupq_n_u16(128);
+
+    int i = 0;
+    for (; i + 8 <= width; i += 8)
+    {
+        uint16x8_t sum = vmulq_u16(vmovl_u8(vld1_u8(a + i)), weight_a);
+        sum = vmlaq_u16(sum, vmovl_u8(vld1_u8(b + i)), weight_b);
+        vst1_u8(dest + i, vshrn_n_u16(vaddq_u16(sum, rounding), 8));
+    }
+
+    blend_rows_scalar(a + i, b + i, dest + i, width - i, weight);
+}
+
+static void
+accumulate_row_neon(const uint8_t *src, uint32_t *sums, int width)
+{
+    int i = 0;
+    for (; i + 16 <= width; i += 16)
+    {
+        uint8x16_t bytes = vld1q_u8(src + i);
+        uint16x8_t lo = vmovl_u8(vget_low_u8(bytes));
+        uint16x8_t hi = vmovl_u8(vget_high_u8(bytes));
+        vst1q_u32(sums + i + 0, vaddw_u16(vld1q_u32(sums + i + 0), vget_low_u16(lo)));
+        vst1q_u32(sums + i + 4, vaddw_u16(vld1q_u32(sums + i + 4), vget_high_u16(lo)));
+        vst1q_u32(sums + i + 8, vaddw_u16(vld1q_u32(sums + i + 8), vget_low_u16(hi)));
+        vst1q_u32(sums + i + 12, vaddw_u16(vld1q_u32(sums + i + 12), vget_high_u16(hi)));
+    }
+
+    accumulate_row_scalar(src + i, sums + i, width - i);
+}
+
+static const FrameConvertKernels neon_kernels = {
+    .name = "neon",
+    .yuv_row_to_xrgb = yuv_row_to_xrgb_neon,
+    .blend_rows = blend_rows_neon,
+    .accumulate_row = accumulate_row_neon,
+};
+
+#endif // FRAME_CONVERT_NEON
+
+const FrameConvertKernels *const *
+frame_convert_get_supported_kernels(void)
+{
+    // Scalar, SSE2, AVX2 and NEON at most, plus the terminator
+    static const FrameConvertKernels *supported[5] = {NULL};
+
+    if (!supported[0])
+    {
+        int count = 0;
+        const FrameConvertKernels *found[4];
+        found[count++] = &scalar_kernels;
+#ifdef FRAME_CONVERT_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("sse2"))
+        {
+            found[count++] = &sse2_kernels;
+            if (__builtin_cpu_supports("avx2"))
+                found[count++] = &avx2_kernels;
+        }
+#endif
+#ifdef FRAME_CONVERT_NEON
+        found[count++] = &neon_kernels;
+#endif
+        // Fill in back to front, so a racing thread never sees a partial list once supported[0] is set
+        for (int i = count - 1; i >= 0; i--)
+            supported[i] = found[i];
+    }
+
+    return supported;
+}
+
+const FrameConvertKernels *
+frame_convert_get_kernels(void)
+{
+    static const FrameConvertKernels *best = NULL;
+
+    if (!best)
+    {
+        const FrameConvertKernels *const *supported = frame_convert_get_supported_kernels();
+        const FrameConvertKernels *last = supported[0];
+        for (int i = 1; supported[i]; i++)
+            last = supported[i];
+        best = last;
+    }
+
+    return best;
+}
+
+// Where output sample i should be taken from, for bilinear scaling
+// Sample centers are lined up, so an output sample can land between two input samples
+typedef struct
+{
+    int index; // First input sample, the second is index + 1 clamped to the input size
+    int weight; // Weight of the second input sample, in the range [0, 256)
+} BilinearTap;
+
+static BilinearTap
+bilinear_tap_at(int i, int dest_size, int src_size)
+{
+    // Input position of the center of output sample i, in 16.16 fixed point
+    int64_t pos = (((int64_t)(2 * i + 1) * src_size) << 16) / (2 * dest_size) - (1 << 15);
+    if (pos < 0)
+        pos = 0;
+
+    BilinearTap tap = {
+        .index = pos >> 16,
+        .weight = (pos >> 8) & 0xff,
+    };
+    if (tap.index >= src_size - 1)
+    {
+        tap.index = src_size - 1;
+        tap.weight = 0;
+    }
+    return tap;
+}
+
+static void
+bilinear_resample_row(const uint8_t *src, uint8_t *dest, const BilinearTap *taps, int dest_width)
+{
+    for (int i = 0; i < dest_width; i++)
+    {
+        const uint8_t *sample = src + taps[i].index;
+        int weight = taps[i].weight;
+        // When weight is 0 the second sample may be past the end, but it does not contribute
+        dest[i] = weight ? (sample[0] * (256 - weight) + sample[1] * weight + 128) >> 8 : sample[0];
+    }
+}
+
+// Output sample i of box scaling is the average of input samples [start, end)
+typedef struct
+{
+    int start;
+    int end;
+} BoxSpan;
+
+static BoxSpan
+box_span_at(int i, int dest_size, int src_size)
+{
+    BoxSpan span = {
+        .start = (int)((int64_t)i * src_size / dest_size),
+        .end = (int)((int64_t)(i + 1) * src_size / dest_size),
+    };
+    if (span.end <= span.start)
+        span.end = span.start + 1;
+    return span;
+}
+
+// Averages are divided by multiplying with a fixed point reciprocal, which gives the same result as dividing as long
+// as sum * count < 2^RECIPROCAL_SHIFT (true for boxes of up to about a million pixels)
+#define RECIPROCAL_SHIFT 48
+#define MAX_CACHED_RECIPROCAL 4096
+
+typedef struct
+{
+    uint64_t *table; // Indexed by count, 0 if not calculated yet
+    uint32_t size;
+} ReciprocalCache;
+
+static inline uint8_t
+box_average(uint32_t sum, uint32_t count, ReciprocalCache *cache)
+{
+    uint64_t rounded = sum + count / 2;
+    if (count >= cache->size)
+        return rounded / count;
+    if (!cache->table[count])
+        cache->table[count] = ((uint64_t)1 << RECIPROCAL_SHIFT) / count + 1;
+    return (rounded * cache->table[count]) >> RECIPROCAL_SHIFT;
+}
+
+static void
+box_resample_row(const uint32_t *column_sums, int row_count, const BoxSpan *spans, uint8_t *dest, int dest_width,
+                 ReciprocalCache *cache)
+{
+    for (int i = 0; i < dest_width; i++)
+    {
+        uint32_t sum = 0;
+        for (int x = spans[i].start; x < spans[i].end; x++)
+            sum += column_sums[x];
+        dest[i] = box_average(sum, (uint32_t)(spans[i].end - spans[i].start) * row_count, cache);
+    }
+}
+
+// Splits a row of interleaved UV samples into separate U and V rows
+static void
+deinterleave_row(const uint8_t *uv, uint8_t *u, uint8_t *v, int width)
+{
+    for (int i = 0; i < width; i++)
+    {
+        u[i] = uv[2 * i];
+        v[i] = uv[2 * i + 1];
+    }
+}
+
+typedef struct
+{
+    FrameFormat format;
+    const uint8_t *const *planes;
+    const int *strides;
+    int chroma_width;
+} ChromaSource;
+
+// Gets separate U and V rows, deinterleaving into the given buffers for NV12
+static void
+chroma_source_get_row(const ChromaSource *source, int row, const uint8_t **u, const uint8_t **v, uint8_t *u_buffer,
+                      uint8_t *v_buffer)
+{
+    if (source->format == FRAME_FORMAT_I420)
+    {
+        *u = source->planes[1] + (size_t)row * source->strides[1];
+        *v = source->planes[2] + (size_t)row * source->strides[2];
+    }
+    else
+    {
+        deinterleave_row(source->planes[1] + (size_t)row * source->strides[1], u_buffer, v_buffer,
+                         source->chroma_width);
+        *u = u_buffer;
+        *v = v_buffer;
+    }
+}
+
+int frame_convert(const FrameConvertKernels *kernels,
+                  FrameFormat format,
+                  const uint8_t *const *planes,
+                  const int *strides,
+                  int src_width,
+                  int src_height,
+                  FrameScale scale,
+                  uint8_t *dest,
+                  int dest_stride,
+                  int dest_width,
+                  int dest_height)
+{
+    if (!kernels || !planes || !strides || !dest)
+        return -1;
+    if (src_width <= 0 || src_height <= 0 || dest_width <= 0 || dest_height <= 0)
+        return -1;
+    if (dest_stride < dest_width * 4)
+        return -1;
+    if (format != FRAME_FORMAT_I420 && format != FRAME_FORMAT_NV12)
+        return -1;
+    if (scale != FRAME_SCALE_BILINEAR && scale != FRAME_SCALE_BOX)
+        return -1;
+
+    int chroma_width = (src_width + 1) / 2;
+    int chroma_height = (src_height + 1) / 2;
+    ChromaSource chroma = {
+        .format = format,
+        .planes = planes,
+        .strides = strides,
+        .chroma_width = chroma_width,
+    };
+
+    // The largest box is ceil(src / dest) samples along each axis, chroma boxes are never larger than luma ones
+    uint64_t max_box = (uint64_t)((src_width + dest_width - 1) / dest_width) *
+                       (uint64_t)((src_height + dest_height - 1) / dest_height);
+    ReciprocalCache reciprocals = {
+        .table = NULL,
+        .size = (scale == FRAME_SCALE_BOX) ? (max_box < MAX_CACHED_RECIPROCAL ? max_box : MAX_CACHED_RECIPROCAL) + 1 : 0,
+    };
+
+    // Every scratch buffer is carved out of a single allocation, largest alignment first
+    size_t tap_count = (scale == FRAME_SCALE_BILINEAR) ? 2 * (size_t)dest_width : 0;
+    size_t span_count = (scale == FRAME_SCALE_BOX) ? 2 * (size_t)dest_width : 0;
+    size_t sum_count = (scale == FRAME_SCALE_BOX) ? (size_t)src_width + 2 * (size_t)chroma_width : 0;
+    size_t row_bytes = (size_t)src_width + 6 * (size_t)chroma_width + 3 * (size_t)dest_width;
+    void *scratch = calloc(1,
+                           reciprocals.size * sizeof(uint64_t) +
+                           tap_count * sizeof(BilinearTap) +
+                           span_count * sizeof(BoxSpan) +
+                           sum_count * sizeof(uint32_t) +
+                           row_bytes);
+    if (!scratch)
+        return -1;
+
+    reciprocals.table = scratch;
+    // Taps are only used (and allocated) for bilinear scaling, and spans and sums only for box scaling
+    BilinearTap *luma_taps = (BilinearTap *)(reciprocals.table + reciprocals.size);
+    BilinearTap *chroma_taps = luma_taps + dest_width;
+    BoxSpan *luma_spans = (BoxSpan *)(luma_taps + tap_count);
+    BoxSpan *chroma_spans = luma_spans + dest_width;
+    uint32_t *luma_sums = (uint32_t *)(luma_spans + span_count);
+    uint32_t *u_sums = luma_sums + src_width;
+    uint32_t *v_sums = u_sums + chroma_width;
+    uint8_t *y_row = (uint8_t *)(luma_sums + sum_count);
+    uint8_t *u_rows[2] = {y_row + src_width, y_row + src_width + chroma_width};
+    uint8_t *v_rows[2] = {u_rows[1] + chroma_width, u_rows[1] + 2 * chroma_width};
+    uint8_t *u_row = v_rows[1] + chroma_width;
+    uint8_t *v_row = u_row + chroma_width;
+    uint8_t *dest_y = v_row + chroma_width;
+    uint8_t *dest_u = dest_y + dest_width;
+    uint8_t *dest_v = dest_u + dest_width;
+
+    for (int i = 0; i < dest_width; i++)
+    {
+        if (scale == FRAME_SCALE_BILINEAR)
+        {
+            luma_taps[i] = bilinear_tap_at(i, dest_width, src_width);
+            chroma_taps[i] = bilinear_tap_at(i, dest_width, chroma_width);
+        }
+        else
+        {
+            luma_spans[i] = box_span_at(i, dest_width, src_width);
+            chroma_spans[i] = box_span_at(i, dest_width, chroma_width);
+        }
+    }
+
+    for (int row = 0; row < dest_height; row++)
+    {
+        uint32_t *dest_row = (uint32_t *)(dest + (size_t)row * dest_stride);
+
+        if (scale == FRAME_SCALE_BILINEAR)
+        {
+            BilinearTap luma_tap = bilinear_tap_at(row, dest_height, src_height);
+            BilinearTap chroma_tap = bilinear_tap_at(row, dest_height, chroma_height);
+
+            const uint8_t *y0 = planes[0] + (size_t)luma_tap.index * strides[0];
+            const uint8_t *y_src = y0;
+            if (luma_tap.weight)
+            {
+                kernels->blend_rows(y0, y0 + strides[0], y_row, src_width, luma_tap.weight);
+                y_src = y_row;
+            }
+            if (dest_width == src_width)
+                memcpy(dest_y, y_src, dest_width); // The taps would be an identity mapping
+            else
+                bilinear_resample_row(y_src, dest_y, luma_taps, dest_width);
+
+            const uint8_t *u0, *v0;
+            chroma_source_get_row(&chroma, chroma_tap.index, &u0, &v0, u_rows[0], v_rows[0]);
+            const uint8_t *u_src = u0;
+            const uint8_t *v_src = v0;
+            if (chroma_tap.weight)
+            {
+                const uint8_t *u1, *v1;
+                chroma_source_get_row(&chroma, chroma_tap.index + 1, &u1, &v1, u_rows[1], v_rows[1]);
+                kernels->blend_rows(u0, u1, u_row, chroma_width, chroma_tap.weight);
+                kernels->blend_rows(v0, v1, v_row, chroma_width, chroma_tap.weight);
+                u_src = u_row;
+                v_src = v_row;
+            }
+            bilinear_resample_row(u_src, dest_u, chroma_taps, dest_width);
+            bilinear_resample_row(v_src, dest_v, chroma_taps, dest_width);
+        }
+        else
+        {
+            BoxSpan rows = box_span_at(row, dest_height, src_height);
+            memset(luma_sums, 0, src_width * sizeof(uint32_t));
+            for (int y = rows.start; y < rows.end; y++)
+                kernels->accumulate_row(planes[0] + (size_t)y * strides[0], luma_sums, src_width);
+            box_resample_row(luma_sums, rows.end - rows.start, luma_spans, dest_y, dest_width, &reciprocals);
+
+            rows = box_span_at(row, dest_height, chroma_height);
+            memset(u_sums, 0, chroma_width * sizeof(uint32_t));
+            memset(v_sums, 0, chroma_width * sizeof(uint32_t));
+            for (int y = rows.start; y < rows.end; y++)
+            {
+                const uint8_t *u, *v;
+                chroma_source_get_row(&chroma, y, &u, &v, u_rows[0], v_rows[0]);
+                kernels->accumulate_row(u, u_sums, chroma_width);
+                kernels->accumulate_row(v, v_sums, chroma_width);
+            }
+            box_resample_row(u_sums, rows.end - rows.start, chroma_spans, dest_u, dest_width, &reciprocals);
+            box_resample_row(v_sums, rows.end - rows.start, chroma_spans, dest_v, dest_width, &reciprocals);
+        }
+
+        kernels->yuv_row_to_xrgb(dest_y, dest_u, dest_v, dest_row, dest_width);
+    }
+
+    free(scratch);
+    return 0;
+}
@@ -0,0 +1,68 @@
+/* This entire file is licensed under MIT
+ *
+ * Copyright 2020 Sophie Winter
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef FRAME_CONVERT_H
+#define FRAME_CONVERT_H
+
+#include <stdint.h>
+
+// Converts YUV video frames into XRGB8888 (CAIRO_FORMAT_RGB24) while scaling them, in a single pass over the source
+// Colors are BT.601 limited range, chroma is assumed to be centered between luma samples
+// Kept free of GTK so the kernels can be tested and benchmarked on their own
+
+typedef enum
+{
+    FRAME_FORMAT_I420, // Y plane, then quarter size U and V planes
+    FRAME_FORMAT_NV12, // Y plane, then a quarter size plane of interleaved U and V
+} FrameFormat;
+
+typedef enum
+{
+    FRAME_SCALE_BILINEAR, // Good for upscaling and small downscales, samples at most 2x2 source pixels per output pixel
+    FRAME_SCALE_BOX, // Averages every source pixel that covers an output pixel, good for large downscales
+} FrameScale;
+
+// Row kernels, every implementation must give bit-identical results to the scalar one
+typedef struct
+{
+    const char *name;
+
+    // Converts a row of full resolution Y, U and V samples into XRGB pixels
+    void (*yuv_row_to_xrgb) (const uint8_t *y, const uint8_t *u, const uint8_t *v, uint32_t *dest, int width);
+
+    // dest[i] = (a[i] * (256 - weight) + b[i] * weight + 128) >> 8, weight is in the range [0, 256]
+    void (*blend_rows) (const uint8_t *a, const uint8_t *b, uint8_t *dest, int width, int weight);
+
+    // sums[i] += src[i], used to add up the rows of a box
+    void (*accumulate_row) (const uint8_t *src, uint32_t *sums, int width);
+} FrameConvertKernels;
+
+// The fastest kernels the CPU supports, chosen the first time this is called
+const FrameConvertKernels *frame_convert_get_kernels (void);
+
+// NULL-terminated list of every implementation the CPU supports, the scalar one first
+const FrameConvertKernels *const *frame_convert_get_supported_kernels (void);
+
+// Planes and strides are indexed Y, U, V for I420 and Y, UV for NV12
+// Returns 0 on success, or -1 if the arguments are invalid
+int frame_convert (const FrameConvertKernels *kernels,
+                   FrameFormat format,
+                   const uint8_t *const *planes,
+                   const int *strides,
+                   int src_width,
+                   int src_height,
+                   FrameScale scale,
+                   uint8_t *dest,
+                   int dest_stride,
+                   int dest_width,
+                   int dest_height);
+
+#endif // FRAME_CONVERT_H
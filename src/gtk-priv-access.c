@@ -13,6 +13,7 @@
 #include "gtk-wayland.h"
 #include "xdg-popup-surface.h"
 #include "pip-surface.h"
+#include "shm-buffer.h"
 
 #include "wayland-client.h"
 
@@ -45,9 +46,36 @@ typedef void (*MoveToRectFunc) (GdkWindow *window,
                                 int rect_anchor_dx,
                                 int rect_anchor_dy);
 
+// The types of the function pointers of GdkWindowImpl's begin_resize_drag and begin_move_drag methods
+typedef void (*BeginResizeDragFunc) (GdkWindow *window,
+                                     GdkWindowEdge edge,
+                                     GdkDevice *device,
+                                     gint button,
+                                     gint root_x,
+                                     gint root_y,
+                                     guint32 timestamp);
+typedef void (*BeginMoveDragFunc) (GdkWindow *window,
+                                   GdkDevice *device,
+                                   gint button,
+                                   gint root_x,
+                                   gint root_y,
+                                   guint32 timestamp);
+
+// The types of the function pointers of GdkWindowImpl's begin_paint and end_paint methods
+typedef gboolean (*BeginPaintFunc) (GdkWindow *window);
+typedef void (*EndPaintFunc) (GdkWindow *window);
+
+// The type of the function pointer of GdkWindowImpl's set_transient_for method
+typedef void (*SetTransientForFunc) (GdkWindow *window, GdkWindow *parent);
+
 static MoveToRectFunc gdk_window_move_to_rect_real = NULL;
+static BeginResizeDragFunc gdk_window_begin_resize_drag_real = NULL;
+static BeginMoveDragFunc gdk_window_begin_move_drag_real = NULL;
+static BeginPaintFunc gdk_window_begin_paint_real = NULL;
+static EndPaintFunc gdk_window_end_paint_real = NULL;
+static SetTransientForFunc gdk_window_set_transient_for_real = NULL;
 
-static GdkWindow *
+GdkWindow *
 gdk_window_get_priv_transient_for (GdkWindow *gdk_window)
 {
     GdkWindow *window_transient_for = gdk_window_priv_get_transient_for (gdk_window);
@@ -85,6 +113,118 @@ gdk_window_get_priv_latest_serial (GdkSeat *seat)
     return serial;
 }
 
+static uint32_t
+gdk_seat_get_priv_serial_for_device (GdkSeat *seat, GdkDevice *device)
+{
+    GdkWaylandSeat *wayland_seat = (GdkWaylandSeat *)seat;
+
+    for (GList *l = gdk_wayland_seat_priv_get_tablets (wayland_seat); l; l = l->next) {
+        GdkWaylandTabletData *tablet_data = l->data;
+        if (device == gdk_wayland_tablet_data_priv_get_master (tablet_data) ||
+            device == gdk_wayland_tablet_data_priv_get_stylus_device (tablet_data) ||
+            device == gdk_wayland_tablet_data_priv_get_eraser_device (tablet_data) ||
+            device == gdk_wayland_tablet_data_priv_get_current_device (tablet_data)) {
+            GdkWaylandPointerData *pointer_data = gdk_wayland_tablet_data_priv_get_pointer_info_ptr (tablet_data);
+            return gdk_wayland_pointer_data_priv_get_press_serial (pointer_data);
+        }
+    }
+
+    if (device == gdk_wayland_seat_priv_get_touch (wayland_seat) ||
+        device == gdk_wayland_seat_priv_get_touch_master (wayland_seat)) {
+        // GDK records the serial of the touch that emulates the pointer here
+        GdkWaylandPointerData *touch_info = gdk_wayland_seat_priv_get_touch_info_ptr (wayland_seat);
+        return gdk_wayland_pointer_data_priv_get_press_serial (touch_info);
+    }
+
+    if (device == gdk_wayland_seat_priv_get_keyboard (wayland_seat) ||
+        device == gdk_wayland_seat_priv_get_master_keyboard (wayland_seat))
+        return gdk_wayland_seat_priv_get_keyboard_key_serial (wayland_seat);
+
+    if (device == gdk_wayland_seat_priv_get_pointer (wayland_seat) ||
+        device == gdk_wayland_seat_priv_get_master_pointer (wayland_seat)) {
+        GdkWaylandPointerData* pointer_data = gdk_wayland_seat_priv_get_pointer_info_ptr (wayland_seat);
+        return gdk_wayland_pointer_data_priv_get_press_serial (pointer_data);
+    }
+
+    // Not a device we know how to look up, so any recent input will have to do
+    return gdk_window_get_priv_latest_serial (seat);
+}
+
+uint32_t
+gdk_device_get_priv_serial (GdkDevice *device, GdkSeat **seat_out)
+{
+    GdkSeat *seat = device ? gdk_device_get_seat (device) : NULL;
+    if (!seat)
+        seat = gdk_display_get_default_seat (gdk_display_get_default ());
+    if (seat_out)
+        *seat_out = seat;
+    if (!seat)
+        return 0;
+
+    if (!device)
+        return gdk_window_get_priv_latest_serial (seat);
+
+    return gdk_seat_get_priv_serial_for_device (seat, device);
+}
+
+uint32_t
+gdk_event_get_priv_serial (const GdkEvent *event, GdkSeat **seat_out)
+{
+    GdkSeat *seat = gdk_event_get_seat (event);
+    if (!seat)
+        seat = gdk_display_get_default_seat (gdk_display_get_default ());
+    if (seat_out)
+        *seat_out = seat;
+    if (!seat)
+        return 0;
+
+    switch (gdk_event_get_event_type (event)) {
+    case GDK_TOUCH_BEGIN:
+    case GDK_TOUCH_UPDATE:
+    case GDK_TOUCH_END: {
+        // GDK's Wayland backend makes event sequences from touch IDs plus one (see GDK_SLOT_TO_EVENT_SEQUENCE)
+        guint id = GPOINTER_TO_UINT (gdk_event_get_event_sequence (event)) - 1;
+        GHashTable *touches = gdk_wayland_seat_priv_get_touches ((GdkWaylandSeat *)seat);
+        GdkWaylandTouchData *touch = g_hash_table_lookup (touches, GUINT_TO_POINTER (id));
+        if (touch)
+            return gdk_wayland_touch_data_priv_get_touch_down_serial (touch);
+        break;
+    }
+
+    default:
+        break;
+    }
+
+    // The source device tells pointers, tablet tools and touchscreens emulating a pointer apart
+    GdkDevice *device = gdk_event_get_source_device (event);
+    if (!device)
+        device = gdk_event_get_device (event);
+    if (!device)
+        return gdk_window_get_priv_latest_serial (seat);
+
+    return gdk_seat_get_priv_serial_for_device (seat, device);
+}
+
+struct wl_pointer *
+gdk_seat_get_priv_wl_pointer (GdkSeat *seat)
+{
+    return gdk_wayland_seat_priv_get_wl_pointer ((GdkWaylandSeat *)seat);
+}
+
+uint32_t
+gdk_seat_get_priv_pointer_enter_serial (GdkSeat *seat)
+{
+    GdkWaylandPointerData *pointer_data = gdk_wayland_seat_priv_get_pointer_info_ptr ((GdkWaylandSeat *)seat);
+    return gdk_wayland_pointer_data_priv_get_enter_serial (pointer_data);
+}
+
+GdkWindow *
+gdk_seat_get_priv_pointer_focus (GdkSeat *seat)
+{
+    GdkWaylandPointerData *pointer_data = gdk_wayland_seat_priv_get_pointer_info_ptr ((GdkWaylandSeat *)seat);
+    return gdk_wayland_pointer_data_priv_get_focus (pointer_data);
+}
+
 static GdkSeat *
 gdk_window_get_priv_grab_seat_for_single_window (GdkWindow *gdk_window)
 {
@@ -141,16 +281,7 @@ gdk_window_move_to_rect_impl_override (GdkWindow *window,
                                   rect_anchor_dy);
 
     GdkWindow *transient_for_gdk_window = gdk_window_get_priv_transient_for (window);
-    CustomShellSurface *transient_for_shell_surface = NULL;
-    GdkWindow *toplevel_gdk_window = transient_for_gdk_window;
-    while (toplevel_gdk_window) {
-        toplevel_gdk_window = gdk_window_get_toplevel (toplevel_gdk_window);
-        GtkWindow *toplevel_gtk_window = gtk_wayland_gdk_to_gtk_window (toplevel_gdk_window);
-        transient_for_shell_surface = gtk_window_get_custom_shell_surface (toplevel_gtk_window);
-        if (transient_for_shell_surface)
-            break;
-        toplevel_gdk_window = gdk_window_get_priv_transient_for (toplevel_gdk_window);
-    }
+    CustomShellSurface *transient_for_shell_surface = custom_shell_surface_find_for_transient (transient_for_gdk_window);
     if (transient_for_shell_surface) {
         g_return_if_fail (rect);
         XdgPopupPosition position = {
@@ -169,6 +300,220 @@ gdk_window_move_to_rect_impl_override (GdkWindow *window,
     }
 }
 
+struct wl_output *
+gdk_window_get_priv_output (GdkWindow *gdk_window)
+{
+    GdkWindowImplWayland *window_impl = (GdkWindowImplWayland *)gdk_window_priv_get_impl (gdk_window);
+    // GDK prepends to this list in its wl_surface.enter handler and removes from it in wl_surface.leave
+    GSList *outputs = gdk_window_impl_wayland_priv_get_display_server_outputs (window_impl);
+    return outputs ? outputs->data : NULL;
+}
+
+gsize
+gdk_window_get_priv_backfill_bytes (GdkWindow *gdk_window)
+{
+    GdkWindowImplWayland *window_impl = (GdkWindowImplWayland *)gdk_window_priv_get_impl (gdk_window);
+    // GDK copies from the backfill surface in its after-paint handler, but only when it commits a new buffer
+    if (!gdk_window_impl_wayland_priv_get_backfill_cairo_surface (window_impl) ||
+        !gdk_window_impl_wayland_priv_get_pending_buffer_attached (window_impl))
+        return 0;
+
+    cairo_rectangle_int_t window_rect = {
+        0, 0,
+        gdk_window_get_width (gdk_window),
+        gdk_window_get_height (gdk_window),
+    };
+    cairo_region_t *copied_region = cairo_region_create_rectangle (&window_rect);
+    cairo_region_t *staged_updates_region = gdk_window_impl_wayland_priv_get_staged_updates_region (window_impl);
+    if (staged_updates_region)
+        cairo_region_subtract (copied_region, staged_updates_region);
+
+    gsize area = 0;
+    for (int i = 0; i < cairo_region_num_rectangles (copied_region); i++) {
+        cairo_rectangle_int_t rect;
+        cairo_region_get_rectangle (copied_region, i, &rect);
+        area += (gsize)rect.width * rect.height;
+    }
+    cairo_region_destroy (copied_region);
+
+    // GDK's shm buffers are always 4 bytes per pixel
+    int scale = gdk_window_get_scale_factor (gdk_window);
+    return area * scale * scale * 4;
+}
+
+void
+gdk_window_drop_priv_backfill (GdkWindow *gdk_window)
+{
+    GdkWindowImplWayland *window_impl = (GdkWindowImplWayland *)gdk_window_priv_get_impl (gdk_window);
+    cairo_surface_t *backfill = gdk_window_impl_wayland_priv_get_backfill_cairo_surface (window_impl);
+    if (!backfill)
+        return;
+
+    // GDK checks for NULL before reading back, and clears staged_updates_region itself once it commits
+    gdk_window_impl_wayland_priv_set_backfill_cairo_surface (window_impl, NULL);
+    cairo_surface_destroy (backfill);
+}
+
+void
+gdk_window_release_priv_pool_surface (GdkWindow *gdk_window, cairo_surface_t *surface)
+{
+    // Does for pool buffers what GDK's buffer release handler does for its own
+    GdkWindowImplWayland *window_impl = gdk_window ?
+        (GdkWindowImplWayland *)gdk_window_priv_get_impl (gdk_window) :
+        NULL;
+    cairo_surface_t *staging = window_impl ? gdk_window_impl_wayland_priv_get_staging_cairo_surface (window_impl) : NULL;
+    cairo_surface_t *committed = window_impl ? gdk_window_impl_wayland_priv_get_committed_cairo_surface (window_impl) : NULL;
+
+    if (surface == staging)
+        return;
+
+    if (surface != committed) {
+        // GDK forgets a committed surface once it commits another (or the window is hidden or resized), leaving its
+        // reference to be dropped when the buffer is released
+        cairo_surface_destroy (surface);
+        return;
+    }
+
+    gdk_window_impl_wayland_priv_set_committed_cairo_surface (window_impl, NULL);
+    if (staging) {
+        // Updates have already been drawn into a newer buffer
+        cairo_surface_destroy (surface);
+    } else {
+        // Nothing has been drawn since, so the next frame can draw into this buffer, which already has the last one
+        gdk_window_impl_wayland_priv_set_staging_cairo_surface (window_impl, surface);
+    }
+}
+
+// Called when GDK is about to draw into the staging surface, creating it if there isn't one
+static gboolean
+gdk_window_begin_paint_override (GdkWindow *window)
+{
+    CustomShellSurface *shell_surface = custom_shell_surface_get_for_gdk_window (window);
+    PipSurface *pip_surface = custom_shell_surface_get_pip_surface (shell_surface);
+    ShmPool *pool = pip_surface ? pip_surface_get_buffer_pool (pip_surface) : NULL;
+    GdkWindowImplWayland *window_impl = (GdkWindowImplWayland *)gdk_window_priv_get_impl (window);
+
+    // Pool buffers are not backfilled from the last frame like GDK's, so they are only used when there is no committed
+    // buffer (so GDK would not backfill either, as the whole window is being drawn) or the app repaints everything
+    if (pool &&
+        !gdk_window_impl_wayland_priv_get_staging_cairo_surface (window_impl) &&
+        !gdk_window_impl_wayland_priv_get_display_server_egl_window (window_impl) &&
+        (!gdk_window_impl_wayland_priv_get_committed_cairo_surface (window_impl) ||
+         pip_surface_get_full_repaint (pip_surface))) {
+        cairo_surface_t *staging = shm_pool_acquire_surface (pool,
+                                                             gdk_window_get_width (window),
+                                                             gdk_window_get_height (window),
+                                                             gdk_window_get_scale_factor (window));
+        // If the pool is exhausted, GDK allocates a buffer like it normally would
+        if (staging)
+            gdk_window_impl_wayland_priv_set_staging_cairo_surface (window_impl, staging);
+    }
+
+    g_assert (gdk_window_begin_paint_real);
+    return gdk_window_begin_paint_real (window);
+}
+
+static struct wl_region *
+gdk_window_wl_region_from_cairo_region (GdkWindow *window, cairo_region_t *region)
+{
+    struct wl_compositor *wl_compositor = gdk_wayland_display_get_wl_compositor (gdk_window_get_display (window));
+    struct wl_region *wl_region = wl_compositor_create_region (wl_compositor);
+    for (int i = 0; i < cairo_region_num_rectangles (region); i++) {
+        cairo_rectangle_int_t rect;
+        cairo_region_get_rectangle (region, i, &rect);
+        wl_region_add (wl_region, rect.x, rect.y, rect.width, rect.height);
+    }
+    return wl_region;
+}
+
+// Sends the opaque and input regions set on the GdkWindow since they were last sent, which GDK's end_paint does after
+// attaching its own buffers. GDK also syncs the margin there, but only as the window geometry of an xdg_surface it
+// created itself. Windows with a custom shell surface don't have one, their shell surface sets its own geometry.
+static void
+gdk_window_sync_pending_regions (GdkWindow *window)
+{
+    GdkWindowImplWayland *window_impl = (GdkWindowImplWayland *)gdk_window_priv_get_impl (window);
+    struct wl_surface *wl_surface = gdk_window_impl_wayland_priv_get_display_server_wl_surface (window_impl);
+    if (!wl_surface)
+        return;
+
+    if (gdk_window_impl_wayland_priv_get_opaque_region_dirty (window_impl)) {
+        cairo_region_t *region = gdk_window_impl_wayland_priv_get_opaque_region (window_impl);
+        struct wl_region *wl_region = region ? gdk_window_wl_region_from_cairo_region (window, region) : NULL;
+        wl_surface_set_opaque_region (wl_surface, wl_region);
+        if (wl_region)
+            wl_region_destroy (wl_region);
+        gdk_window_impl_wayland_priv_set_opaque_region_dirty (window_impl, FALSE);
+    }
+
+    if (gdk_window_impl_wayland_priv_get_input_region_dirty (window_impl)) {
+        cairo_region_t *region = gdk_window_impl_wayland_priv_get_input_region (window_impl);
+        struct wl_region *wl_region = region ? gdk_window_wl_region_from_cairo_region (window, region) : NULL;
+        wl_surface_set_input_region (wl_surface, wl_region);
+        if (wl_region)
+            wl_region_destroy (wl_region);
+        gdk_window_impl_wayland_priv_set_input_region_dirty (window_impl, FALSE);
+    }
+}
+
+// GDK only knows how to attach its own shm surfaces (and asserts that the staging surface is one), so frames drawn
+// into pool buffers are finished here instead of by GDK's end_paint, including the region sync it would do
+static void
+gdk_window_end_paint_override (GdkWindow *window)
+{
+    GdkWindowImplWayland *window_impl = (GdkWindowImplWayland *)gdk_window_priv_get_impl (window);
+    cairo_surface_t *staging = gdk_window_impl_wayland_priv_get_staging_cairo_surface (window_impl);
+
+    g_assert (gdk_window_end_paint_real);
+    if (!shm_pool_is_pool_surface (staging)) {
+        gdk_window_end_paint_real (window);
+        return;
+    }
+
+    cairo_region_t *region = gdk_window_priv_get_current_paint_region (window);
+    if (!gdk_window_priv_get_current_paint_use_gl (window) && region && !cairo_region_is_empty (region)) {
+        // What GDK does for its own buffers
+        struct wl_surface *wl_surface = gdk_wayland_window_get_wl_surface (window);
+        shm_pool_surface_attach (staging, wl_surface);
+        wl_surface_set_buffer_scale (wl_surface, gdk_window_get_scale_factor (window));
+
+        // Track which parts are staged until the next frame, so a buffer GDK allocates while this one is still held
+        // by the compositor is backfilled from the last committed frame
+        cairo_surface_t *committed = gdk_window_impl_wayland_priv_get_committed_cairo_surface (window_impl);
+        if (committed) {
+            cairo_region_t *staged = gdk_window_impl_wayland_priv_get_staged_updates_region (window_impl);
+            if (staged) {
+                cairo_region_union (staged, region);
+            } else {
+                gdk_window_impl_wayland_priv_set_staged_updates_region (window_impl, cairo_region_copy (region));
+                gdk_window_impl_wayland_priv_set_backfill_cairo_surface (window_impl,
+                                                                        cairo_surface_reference (committed));
+            }
+        }
+
+        for (int i = 0; i < cairo_region_num_rectangles (region); i++) {
+            cairo_rectangle_int_t rect;
+            cairo_region_get_rectangle (region, i, &rect);
+            wl_surface_damage (wl_surface, rect.x, rect.y, rect.width, rect.height);
+        }
+        // GDK commits in its after-paint handler, and then makes the staging surface the committed one
+        gdk_window_impl_wayland_priv_set_pending_buffer_attached (window_impl, TRUE);
+        gdk_window_impl_wayland_priv_set_pending_commit (window_impl, TRUE);
+    }
+
+    gdk_window_sync_pending_regions (window);
+}
+
+// Nearest shell surface lookups for popups are cached per window, so they have to be redone when a chain changes
+static void
+gdk_window_set_transient_for_override (GdkWindow *window, GdkWindow *parent)
+{
+    custom_shell_surface_invalidate_transient_cache ();
+
+    g_assert (gdk_window_set_transient_for_real);
+    gdk_window_set_transient_for_real (window, parent);
+}
+
 void
 gdk_window_set_priv_mapped (GdkWindow *gdk_window)
 {
@@ -176,16 +521,48 @@ gdk_window_set_priv_mapped (GdkWindow *gdk_window)
     gdk_window_impl_wayland_priv_set_mapped (window_impl, TRUE);
 }
 
-static void 
-gdk_window_begin_move_drag_override(GdkWindow *window, GdkDevice *device, gint button, gint root_x, gint root_y, guint32 timestamp)
+// gtk_window_begin_move_drag () and gtk_window_begin_resize_drag () end up here, with the device that started the drag
+static void
+gdk_window_begin_move_drag_override (GdkWindow *window,
+                                     GdkDevice *device,
+                                     gint button,
+                                     gint root_x,
+                                     gint root_y,
+                                     guint32 timestamp)
 {
-    CustomShellSurface *shell_surface = gtk_window_get_custom_shell_surface (gtk_wayland_gdk_to_gtk_window(window));
-    g_return_if_fail(shell_surface); //TODO call real_begin_move_drag_override
+    CustomShellSurface *shell_surface = custom_shell_surface_get_for_gdk_window (window);
+    PipSurface *pip_surface = custom_shell_surface_get_pip_surface (shell_surface);
+    if (!pip_surface) {
+        g_assert (gdk_window_begin_move_drag_real);
+        gdk_window_begin_move_drag_real (window, device, button, root_x, root_y, timestamp);
+        return;
+    }
 
+    GdkSeat *seat;
+    uint32_t serial = gdk_device_get_priv_serial (device, &seat);
+    pip_surface_move (pip_surface, seat, serial);
+}
+
+static void
+gdk_window_begin_resize_drag_override (GdkWindow *window,
+                                       GdkWindowEdge edge,
+                                       GdkDevice *device,
+                                       gint button,
+                                       gint root_x,
+                                       gint root_y,
+                                       guint32 timestamp)
+{
+    CustomShellSurface *shell_surface = custom_shell_surface_get_for_gdk_window (window);
     PipSurface *pip_surface = custom_shell_surface_get_pip_surface (shell_surface);
-    g_return_if_fail(pip_surface);
+    if (!pip_surface) {
+        g_assert (gdk_window_begin_resize_drag_real);
+        gdk_window_begin_resize_drag_real (window, edge, device, button, root_x, root_y, timestamp);
+        return;
+    }
 
-    pip_surface_move(pip_surface);
+    GdkSeat *seat;
+    uint32_t serial = gdk_device_get_priv_serial (device, &seat);
+    pip_surface_resize (pip_surface, edge, seat, serial);
 }
 
 void
@@ -204,5 +581,28 @@ gtk_priv_access_init (GdkWindow *gdk_window)
         gdk_window_impl_class_priv_set_move_to_rect (window_class, gdk_window_move_to_rect_impl_override);
     }
 
-    gdk_window_impl_class_priv_set_begin_move_drag(window_class, gdk_window_begin_move_drag_override);
+    if (gdk_window_impl_class_priv_get_begin_move_drag (window_class) != gdk_window_begin_move_drag_override) {
+        gdk_window_begin_move_drag_real = gdk_window_impl_class_priv_get_begin_move_drag (window_class);
+        gdk_window_impl_class_priv_set_begin_move_drag (window_class, gdk_window_begin_move_drag_override);
+    }
+
+    if (gdk_window_impl_class_priv_get_begin_resize_drag (window_class) != gdk_window_begin_resize_drag_override) {
+        gdk_window_begin_resize_drag_real = gdk_window_impl_class_priv_get_begin_resize_drag (window_class);
+        gdk_window_impl_class_priv_set_begin_resize_drag (window_class, gdk_window_begin_resize_drag_override);
+    }
+
+    if (gdk_window_impl_class_priv_get_begin_paint (window_class) != gdk_window_begin_paint_override) {
+        gdk_window_begin_paint_real = gdk_window_impl_class_priv_get_begin_paint (window_class);
+        gdk_window_impl_class_priv_set_begin_paint (window_class, gdk_window_begin_paint_override);
+    }
+
+    if (gdk_window_impl_class_priv_get_end_paint (window_class) != gdk_window_end_paint_override) {
+        gdk_window_end_paint_real = gdk_window_impl_class_priv_get_end_paint (window_class);
+        gdk_window_impl_class_priv_set_end_paint (window_class, gdk_window_end_paint_override);
+    }
+
+    if (gdk_window_impl_class_priv_get_set_transient_for (window_class) != gdk_window_set_transient_for_override) {
+        gdk_window_set_transient_for_real = gdk_window_impl_class_priv_get_set_transient_for (window_class);
+        gdk_window_impl_class_priv_set_set_transient_for (window_class, gdk_window_set_transient_for_override);
+    }
 }
@@ -23,9 +23,44 @@ void gtk_priv_access_init (GdkWindow *gdk_window);
 // Can be used for popups grabs and such
 uint32_t gdk_window_get_priv_latest_serial (GdkSeat *seat);
 
+// GDK events don't carry serials, so these return the serial of the last press (or touch down, or key event) from the
+// device an event came from, which is the event itself when called from its handler
+// *seat is set to the seat of the device, or the default seat if it can't be found. Unlike
+// gdk_window_get_priv_latest_serial (), input from other devices and seats doesn't change the result.
+uint32_t gdk_event_get_priv_serial (const GdkEvent *event, GdkSeat **seat);
+uint32_t gdk_device_get_priv_serial (GdkDevice *device, GdkSeat **seat);
+
+// The seat's wl_pointer, or NULL if it does not have one
+struct wl_pointer *gdk_seat_get_priv_wl_pointer (GdkSeat *seat);
+
+// The serial of the last wl_pointer.enter, which setting the cursor requires
+uint32_t gdk_seat_get_priv_pointer_enter_serial (GdkSeat *seat);
+
+// The window the seat's pointer is over, or NULL
+GdkWindow *gdk_seat_get_priv_pointer_focus (GdkSeat *seat);
+
+// Returns the window GDK treats as the parent of the given one for placement (the Wayland one if set), or NULL
+GdkWindow *gdk_window_get_priv_transient_for (GdkWindow *gdk_window);
+
 // Returns the GdkSeat that can be used for popup grabs
 GdkSeat *gdk_window_get_priv_grab_seat (GdkWindow *gdk_window);
 
+// Returns the output GDK most recently saw the window's surface enter, or NULL if it has not entered any
+struct wl_output *gdk_window_get_priv_output (GdkWindow *gdk_window);
+
+// The number of bytes GDK will copy from the previous buffer into the new one when the frame being painted is
+// committed. GDK does this for the parts of the window that were not repainted if the compositor still holds the
+// previous buffer. Returns 0 if no copy is pending.
+gsize gdk_window_get_priv_backfill_bytes (GdkWindow *gdk_window);
+
+// Drops the reference GDK keeps to the previous buffer for the copy described above, so the copy is skipped
+// Only correct if the whole window has been repainted since the last commit
+void gdk_window_drop_priv_backfill (GdkWindow *gdk_window);
+
+// Called when the compositor releases a pip's pool buffer, gdk_window may be NULL if the window is gone
+// Pool buffers are hooked into GDK's staging surface for pip windows in gdk_window_begin_paint_override ()
+void gdk_window_release_priv_pool_surface (GdkWindow *gdk_window, cairo_surface_t *surface);
+
 // Sets the window as mapped (mapped is set to false automatically in gdk_wayland_window_hide_surface ())
 // If window is not set to mapped, some subsurfaces fail (see https://github.com/wmww/gtk-pip-shell/issues/38)
 void gdk_window_set_priv_mapped (GdkWindow *gdk_window);
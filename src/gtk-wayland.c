@@ -17,17 +17,67 @@
 
 #include "xdg-shell-client.h"
 #include "xdg-pip-v1-client.h"
+#ifdef HAVE_FRACTIONAL_SCALE
+#include "fractional-scale-v1-client.h"
+#endif
+#ifdef HAVE_CURSOR_SHAPE
+#include "cursor-shape-v1-client.h"
+#endif
+#ifdef HAVE_CONTENT_TYPE
+#include "content-type-v1-client.h"
+#endif
+#ifdef HAVE_TEARING_CONTROL
+#include "tearing-control-v1-client.h"
+#endif
+#ifdef HAVE_LINUX_DMABUF
+#include "linux-dmabuf-unstable-v1-client.h"
+#endif
 
 #include <gtk/gtk.h>
 #include <gdk/gdk.h>
 #include <gdk/gdkwayland.h>
 
-static const char *gtk_window_key = "linked-gtk-window";
 static const char *popup_position_key = "custom-popup-position";
 
 static struct wl_registry *wl_registry_global = NULL;
 static struct xdg_wm_base *xdg_wm_base_global = NULL;
 static struct xdg_wm_pip_v1 *pip_shell_global = NULL;
+static struct wp_fractional_scale_manager_v1 *fractional_scale_manager_global = NULL;
+static struct wl_shm *wl_shm_global = NULL;
+static struct wp_cursor_shape_manager_v1 *cursor_shape_manager_global = NULL;
+static struct wp_content_type_manager_v1 *content_type_manager_global = NULL;
+static struct wp_tearing_control_manager_v1 *tearing_control_manager_global = NULL;
+static struct wl_subcompositor *wl_subcompositor_global = NULL;
+static struct zwp_linux_dmabuf_v1 *linux_dmabuf_global = NULL;
+
+#ifdef HAVE_LINUX_DMABUF
+typedef struct
+{
+    uint32_t format;
+    uint64_t modifier;
+} DmabufFormat;
+
+// Every format and modifier pair the compositor advertised, NULL until they have been received
+static GArray *dmabuf_formats = NULL;
+#endif
+
+#ifdef HAVE_CURSOR_SHAPE
+static const char *cursor_shape_device_key = "wayland-cursor-shape-device";
+
+typedef struct
+{
+    struct wp_cursor_shape_device_v1 *device;
+    // The pointer the device was created for, it is useless once GDK has released that
+    struct wl_pointer *wl_pointer;
+} CursorShapeDevice;
+
+static void
+cursor_shape_device_free (CursorShapeDevice *self)
+{
+    wp_cursor_shape_device_v1_destroy (self->device);
+    g_free (self);
+}
+#endif
 
 static gboolean has_initialized = FALSE;
 
@@ -49,6 +99,148 @@ gtk_wayland_get_xdg_wm_base_global ()
     return xdg_wm_base_global;
 }
 
+struct wp_fractional_scale_manager_v1 *
+gtk_wayland_get_fractional_scale_manager_global ()
+{
+    return fractional_scale_manager_global;
+}
+
+struct wl_shm *
+gtk_wayland_get_wl_shm_global ()
+{
+    return wl_shm_global;
+}
+
+struct wp_cursor_shape_manager_v1 *
+gtk_wayland_get_cursor_shape_manager_global ()
+{
+    return cursor_shape_manager_global;
+}
+
+struct wp_content_type_manager_v1 *
+gtk_wayland_get_content_type_manager_global ()
+{
+    return content_type_manager_global;
+}
+
+struct wp_tearing_control_manager_v1 *
+gtk_wayland_get_tearing_control_manager_global ()
+{
+    return tearing_control_manager_global;
+}
+
+struct wl_subcompositor *
+gtk_wayland_get_wl_subcompositor_global ()
+{
+    return wl_subcompositor_global;
+}
+
+struct zwp_linux_dmabuf_v1 *
+gtk_wayland_get_linux_dmabuf_global ()
+{
+    return linux_dmabuf_global;
+}
+
+#ifdef HAVE_LINUX_DMABUF
+static void
+linux_dmabuf_handle_format (void *_data, struct zwp_linux_dmabuf_v1 *_linux_dmabuf, uint32_t _format)
+{
+    (void)_data;
+    (void)_linux_dmabuf;
+    (void)_format;
+
+    // Also sent for backwards compatibility, modifier events list every format again
+}
+
+static void
+linux_dmabuf_handle_modifier (void *_data,
+                              struct zwp_linux_dmabuf_v1 *_linux_dmabuf,
+                              uint32_t format,
+                              uint32_t modifier_hi,
+                              uint32_t modifier_lo)
+{
+    (void)_data;
+    (void)_linux_dmabuf;
+
+    DmabufFormat entry = {
+        .format = format,
+        .modifier = ((uint64_t)modifier_hi << 32) | modifier_lo,
+    };
+    g_array_append_val (dmabuf_formats, entry);
+}
+
+static const struct zwp_linux_dmabuf_v1_listener linux_dmabuf_listener = {
+    .format = linux_dmabuf_handle_format,
+    .modifier = linux_dmabuf_handle_modifier,
+};
+#endif
+
+gboolean
+gtk_wayland_get_dmabuf_format_supported (guint32 fourcc, guint64 modifier)
+{
+#ifdef HAVE_LINUX_DMABUF
+    if (!linux_dmabuf_global)
+        return FALSE;
+
+    // The formats are sent after the bind, so only wait for them when someone first asks
+    if (!dmabuf_formats) {
+        dmabuf_formats = g_array_new (FALSE, FALSE, sizeof (DmabufFormat));
+        zwp_linux_dmabuf_v1_add_listener (linux_dmabuf_global, &linux_dmabuf_listener, NULL);
+        wl_display_roundtrip (gdk_wayland_display_get_wl_display (gdk_display_get_default ()));
+    }
+
+    for (guint i = 0; i < dmabuf_formats->len; i++) {
+        DmabufFormat *entry = &g_array_index (dmabuf_formats, DmabufFormat, i);
+        if (entry->format == fourcc && entry->modifier == modifier)
+            return TRUE;
+    }
+    return FALSE;
+#else
+    (void)fourcc;
+    (void)modifier;
+    return FALSE;
+#endif
+}
+
+struct wp_cursor_shape_device_v1 *
+gtk_wayland_get_cursor_shape_device (GdkSeat *seat)
+{
+#ifdef HAVE_CURSOR_SHAPE
+    if (!cursor_shape_manager_global || !seat)
+        return NULL;
+
+    struct wl_pointer *wl_pointer = gdk_seat_get_priv_wl_pointer (seat);
+    if (!wl_pointer)
+        return NULL;
+
+    // When the seat loses its pointer capability GDK releases the wl_pointer and drops the pointer device wrapping it,
+    // and gets a new pair when the capability comes back. The device is cached on the pointer device, so it goes away
+    // with it, and checked against the wl_pointer in case GDK ever reuses the pointer device.
+    GList *pointers = gdk_seat_get_slaves (seat, GDK_SEAT_CAPABILITY_POINTER);
+    GdkDevice *pointer = pointers ? pointers->data : NULL;
+    g_list_free (pointers);
+    if (!pointer)
+        return NULL;
+
+    CursorShapeDevice *cached = g_object_get_data (G_OBJECT (pointer), cursor_shape_device_key);
+    if (cached && cached->wl_pointer == wl_pointer)
+        return cached->device;
+
+    // One device per pointer is shared by every window, replacing (and destroying) one made for a released pointer
+    cached = g_new0 (CursorShapeDevice, 1);
+    cached->device = wp_cursor_shape_manager_v1_get_pointer (cursor_shape_manager_global, wl_pointer);
+    cached->wl_pointer = wl_pointer;
+    g_object_set_data_full (G_OBJECT (pointer),
+                            cursor_shape_device_key,
+                            cached,
+                            (GDestroyNotify) cursor_shape_device_free);
+    return cached->device;
+#else
+    (void)seat;
+    return NULL;
+#endif
+}
+
 static void
 wl_registry_handle_global (void *_data,
                            struct wl_registry *registry,
@@ -71,7 +263,58 @@ wl_registry_handle_global (void *_data,
                                                id,
                                                &xdg_wm_base_interface,
                                                MIN((uint32_t)xdg_wm_base_interface.version, version));
+    } else if (strcmp (interface, wl_shm_interface.name) == 0) {
+        // GDK has its own, but does not expose it
+        wl_shm_global = wl_registry_bind (registry,
+                                          id,
+                                          &wl_shm_interface,
+                                          MIN((uint32_t)wl_shm_interface.version, version));
+    } else if (strcmp (interface, wl_subcompositor_interface.name) == 0) {
+        // GDK has its own, but does not expose it
+        wl_subcompositor_global = wl_registry_bind (registry,
+                                                    id,
+                                                    &wl_subcompositor_interface,
+                                                    MIN((uint32_t)wl_subcompositor_interface.version, version));
+    }
+#ifdef HAVE_FRACTIONAL_SCALE
+    else if (strcmp (interface, wp_fractional_scale_manager_v1_interface.name) == 0) {
+        fractional_scale_manager_global = wl_registry_bind (registry,
+                                                            id,
+                                                            &wp_fractional_scale_manager_v1_interface,
+                                                            MIN((uint32_t)wp_fractional_scale_manager_v1_interface.version, version));
+    }
+#endif
+#ifdef HAVE_CURSOR_SHAPE
+    else if (strcmp (interface, wp_cursor_shape_manager_v1_interface.name) == 0) {
+        cursor_shape_manager_global = wl_registry_bind (registry,
+                                                        id,
+                                                        &wp_cursor_shape_manager_v1_interface,
+                                                        MIN((uint32_t)wp_cursor_shape_manager_v1_interface.version, version));
+    }
+#endif
+#ifdef HAVE_CONTENT_TYPE
+    else if (strcmp (interface, wp_content_type_manager_v1_interface.name) == 0) {
+        content_type_manager_global = wl_registry_bind (registry,
+                                                        id,
+                                                        &wp_content_type_manager_v1_interface,
+                                                        MIN((uint32_t)wp_content_type_manager_v1_interface.version, version));
     }
+#endif
+#ifdef HAVE_TEARING_CONTROL
+    else if (strcmp (interface, wp_tearing_control_manager_v1_interface.name) == 0) {
+        tearing_control_manager_global = wl_registry_bind (registry,
+                                                           id,
+                                                           &wp_tearing_control_manager_v1_interface,
+                                                           MIN((uint32_t)wp_tearing_control_manager_v1_interface.version, version));
+    }
+#endif
+#ifdef HAVE_LINUX_DMABUF
+    else if (strcmp (interface, zwp_linux_dmabuf_v1_interface.name) == 0 && version >= 3) {
+        // Version 3 is the newest that lists modifiers with events instead of feedback objects, and the first that
+        // sends them at all.
+        linux_dmabuf_global = wl_registry_bind (registry, id, &zwp_linux_dmabuf_v1_interface, 3);
+    }
+#endif
 }
 
 static void
@@ -106,46 +349,120 @@ gtk_wayland_setup_custom_popup (GtkWindow *gtk_window, XdgPopupPosition const *p
     }
 }
 
-// This function associates a GTK window with a GDK window
-// It overrides the default so it can run for EVERY window without needed to be attached to each one
+// Popup positions stored on GDK windows that were not yet connected to a GTK window, see popup_position_key
+static guint pending_popup_count = 0;
+// The realize emission hook that looks for them, or 0 while there are none
+static gulong pending_popup_realize_hook = 0;
+
+// GQuark of the type data that marks the private window subtypes below
+static GQuark shell_surface_window_type_quark = 0;
+
+// Windows that get a shell surface are moved to a private subtype of their own type (see
+// gtk_wayland_override_window_class ()), whose vfuncs are replaced with these. They chain up to the vfunc of the
+// original type, so neither GtkWindow's class nor any other window class is ever patched, and windows without a shell
+// surface pay nothing.
+
+static GtkWidgetClass *
+gtk_wayland_window_get_original_class (GtkWidget *widget)
+{
+    return g_type_class_peek (g_type_parent (G_OBJECT_TYPE (widget)));
+}
+
 static void
-gtk_wayland_override_on_window_realize (GtkWindow *gtk_window, void *_data)
+gtk_wayland_window_realize_override (GtkWidget *widget)
 {
-    (void)_data;
+    gtk_wayland_window_get_original_class (widget)->realize (widget);
 
-    // Call the super class's realize handler
-    GValue args[1] = { G_VALUE_INIT };
-    g_value_init_from_instance (&args[0], gtk_window);
-    g_signal_chain_from_overridden (args, NULL);
-    g_value_unset (&args[0]);
+    // Surfaces created below are already realized, so custom_shell_surface_init () handles them itself
+    CustomShellSurface *shell_surface = gtk_window_get_custom_shell_surface (GTK_WINDOW (widget));
+    if (shell_surface)
+        custom_shell_surface_on_window_realize (shell_surface);
+}
 
-    GdkWindow *gdk_window = gtk_widget_get_window (GTK_WIDGET (gtk_window));
-    g_object_set_data (G_OBJECT (gdk_window), gtk_window_key, gtk_window);
+static void
+gtk_wayland_window_map_override (GtkWidget *widget)
+{
+    gtk_wayland_window_get_original_class (widget)->map (widget);
 
-    XdgPopupPosition *position = g_object_get_data (G_OBJECT (gdk_window), popup_position_key);
-    if (position) {
-        // This is a custom popup waiting to be realized
-        gtk_wayland_setup_custom_popup (gtk_window, position);
-        g_object_set_data (G_OBJECT (gdk_window), popup_position_key, NULL);
-    }
+    CustomShellSurface *shell_surface = gtk_window_get_custom_shell_surface (GTK_WINDOW (widget));
+    if (shell_surface)
+        custom_shell_surface_on_window_map (shell_surface);
 }
 
-// This callback must override the default unmap handler, so it can run first
-// The custom surface's unmap method must be called before GtkWidget's unmap, or Wayland objects are destroyed in the wrong order
 static void
-gtk_wayland_override_on_window_unmap (GtkWindow *gtk_window, void *_data)
+gtk_wayland_window_size_allocate_override (GtkWidget *widget, GtkAllocation *allocation)
 {
-    (void)_data;
+    gtk_wayland_window_get_original_class (widget)->size_allocate (widget, allocation);
 
-    CustomShellSurface *shell_surface = gtk_window_get_custom_shell_surface (gtk_window);
+    CustomShellSurface *shell_surface = gtk_window_get_custom_shell_surface (GTK_WINDOW (widget));
+    if (shell_surface)
+        custom_shell_surface_on_window_size_allocate (shell_surface, allocation);
+}
+
+// The custom surface's unmap method must be called before GtkWidget's unmap, or Wayland objects are destroyed in the wrong order
+static void
+gtk_wayland_window_unmap_override (GtkWidget *widget)
+{
+    CustomShellSurface *shell_surface = gtk_window_get_custom_shell_surface (GTK_WINDOW (widget));
     if (shell_surface)
         shell_surface->virtual->unmap (shell_surface);
 
-    // Call the super class's unmap handler
-    GValue args[1] = { G_VALUE_INIT };
-    g_value_init_from_instance (&args[0], gtk_window);
-    g_signal_chain_from_overridden (args, NULL);
-    g_value_unset (&args[0]);
+    gtk_wayland_window_get_original_class (widget)->unmap (widget);
+}
+
+static void
+gtk_wayland_shell_surface_window_class_init (gpointer g_class, gpointer _data)
+{
+    (void)_data;
+
+    GtkWidgetClass *widget_class = g_class;
+    widget_class->realize = gtk_wayland_window_realize_override;
+    widget_class->map = gtk_wayland_window_map_override;
+    widget_class->unmap = gtk_wayland_window_unmap_override;
+    widget_class->size_allocate = gtk_wayland_window_size_allocate_override;
+}
+
+// Returns the private subtype of type, registering it the first time
+static GType
+gtk_wayland_get_shell_surface_window_type (GType type)
+{
+    g_autofree char *name = g_strdup_printf ("GtkPipShellSurface%s", g_type_name (type));
+    GType subtype = g_type_from_name (name);
+    if (subtype)
+        return subtype;
+
+    GTypeQuery query;
+    g_type_query (type, &query);
+    subtype = g_type_register_static_simple (type,
+                                             g_intern_string (name),
+                                             query.class_size,
+                                             gtk_wayland_shell_surface_window_class_init,
+                                             query.instance_size,
+                                             NULL,
+                                             0);
+    if (subtype)
+        g_type_set_qdata (subtype, shell_surface_window_type_quark, GINT_TO_POINTER (TRUE));
+    return subtype;
+}
+
+void
+gtk_wayland_override_window_class (GtkWindow *gtk_window)
+{
+    g_return_if_fail (shell_surface_window_type_quark);
+
+    GType type = G_OBJECT_TYPE (gtk_window);
+    if (g_type_get_qdata (type, shell_surface_window_type_quark))
+        return;
+
+    GType subtype = gtk_wayland_get_shell_surface_window_type (type);
+    g_return_if_fail (subtype);
+
+    // The subtype adds no fields, so the instance only needs to point at its class. Instances hold a reference to
+    // their class, which GObject drops when the instance is freed.
+    GTypeInstance *instance = (GTypeInstance *)gtk_window;
+    GTypeClass *original_class = instance->g_class;
+    instance->g_class = g_type_class_ref (subtype);
+    g_type_class_unref (original_class);
 }
 
 void
@@ -169,13 +486,7 @@ gtk_wayland_init_if_needed ()
     if (!xdg_wm_base_global)
         g_warning ("It appears your Wayland compositor does not support the XDG Shell stable protocol");
 
-    gint realize_signal_id = g_signal_lookup ("realize", GTK_TYPE_WINDOW);
-    GClosure *realize_closure = g_cclosure_new (G_CALLBACK (gtk_wayland_override_on_window_realize), NULL, NULL);
-    g_signal_override_class_closure (realize_signal_id, GTK_TYPE_WINDOW, realize_closure);
-
-    gint unmap_signal_id = g_signal_lookup ("unmap", GTK_TYPE_WINDOW);
-    GClosure *unmap_closure = g_cclosure_new (G_CALLBACK (gtk_wayland_override_on_window_unmap), NULL, NULL);
-    g_signal_override_class_closure (unmap_signal_id, GTK_TYPE_WINDOW, unmap_closure);
+    shell_surface_window_type_quark = g_quark_from_static_string ("gtk-pip-shell-surface-window-type");
 
     has_initialized = TRUE;
 }
@@ -183,7 +494,51 @@ gtk_wayland_init_if_needed ()
 GtkWindow *
 gtk_wayland_gdk_to_gtk_window (GdkWindow *gdk_window)
 {
-    return GTK_WINDOW (g_object_get_data (G_OBJECT (gdk_window), gtk_window_key));
+    if (!gdk_window)
+        return NULL;
+
+    // GTK registers a toplevel GdkWindow with the GtkWindow that owns it as soon as the GdkWindow is created
+    gpointer widget = NULL;
+    gdk_window_get_user_data (gdk_window, &widget);
+    return GTK_IS_WINDOW (widget) ? GTK_WINDOW (widget) : NULL;
+}
+
+// Realize is a run-first signal, so this runs once the GtkWindow has connected itself to its GdkWindow
+static gboolean
+gtk_wayland_pending_popup_realize_hook (GSignalInvocationHint *_hint,
+                                        guint _n_param_values,
+                                        const GValue *param_values,
+                                        gpointer _data)
+{
+    (void)_hint;
+    (void)_n_param_values;
+    (void)_data;
+
+    if (pending_popup_count == 0) {
+        pending_popup_realize_hook = 0;
+        return FALSE;
+    }
+
+    GtkWidget *widget = g_value_get_object (&param_values[0]);
+    if (!GTK_IS_WINDOW (widget))
+        return TRUE;
+
+    GdkWindow *gdk_window = gtk_widget_get_window (widget);
+    XdgPopupPosition *position = gdk_window ? g_object_get_data (G_OBJECT (gdk_window), popup_position_key) : NULL;
+    if (position) {
+        // This is a custom popup waiting to be realized
+        gtk_wayland_setup_custom_popup (GTK_WINDOW (widget), position);
+        g_object_set_data (G_OBJECT (gdk_window), popup_position_key, NULL);
+    }
+    return TRUE;
+}
+
+static void
+gtk_wayland_free_pending_popup_position (XdgPopupPosition *position)
+{
+    // The realize hook removes itself the next time it runs
+    pending_popup_count--;
+    g_free (position);
 }
 
 void
@@ -194,10 +549,22 @@ gtk_wayland_setup_window_as_custom_popup (GdkWindow *gdk_window, XdgPopupPositio
         // The GDK window has been connected to a GTK window
         gtk_wayland_setup_custom_popup (gtk_window, position);
     } else {
-        // We need to hold the position and wait for a connected GTK window to be realized
+        // We need to hold the position and wait for a connected GTK window to be realized. Its class is not known yet,
+        // so every realize is checked for a position, but only while there are positions waiting.
+        if (!pending_popup_realize_hook) {
+            pending_popup_realize_hook = g_signal_add_emission_hook (g_signal_lookup ("realize", GTK_TYPE_WIDGET),
+                                                                     0,
+                                                                     gtk_wayland_pending_popup_realize_hook,
+                                                                     NULL,
+                                                                     NULL);
+        }
         XdgPopupPosition *position_owned = g_new (XdgPopupPosition, 1);
         *position_owned = *position;
-        g_object_set_data_full (G_OBJECT (gdk_window), popup_position_key, position_owned, g_free);
+        pending_popup_count++;
+        g_object_set_data_full (G_OBJECT (gdk_window),
+                                popup_position_key,
+                                position_owned,
+                                (GDestroyNotify) gtk_wayland_free_pending_popup_position);
     }
 }
 
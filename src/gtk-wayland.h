@@ -20,9 +20,32 @@
 gboolean gtk_wayland_get_has_initialized (void);
 struct xdg_wm_base *gtk_wayland_get_xdg_wm_base_global (void);
 struct xdg_wm_pip_v1 *gtk_wayland_get_pip_shell_global (void);
+// NULL if the compositor does not support it or the library was built without it
+struct wp_fractional_scale_manager_v1 *gtk_wayland_get_fractional_scale_manager_global (void);
+struct wl_shm *gtk_wayland_get_wl_shm_global (void);
+// NULL if the compositor does not support it or the library was built without it
+struct wp_cursor_shape_manager_v1 *gtk_wayland_get_cursor_shape_manager_global (void);
+// NULL if the compositor does not support it or the library was built without it
+struct wp_content_type_manager_v1 *gtk_wayland_get_content_type_manager_global (void);
+// NULL if the compositor does not support it or the library was built without it
+struct wp_tearing_control_manager_v1 *gtk_wayland_get_tearing_control_manager_global (void);
+struct wl_subcompositor *gtk_wayland_get_wl_subcompositor_global (void);
+// NULL if the compositor does not support version 3 or the library was built without it
+struct zwp_linux_dmabuf_v1 *gtk_wayland_get_linux_dmabuf_global (void);
+
+// If the compositor advertised the DRM format and modifier pair, does a roundtrip to collect them the first time
+gboolean gtk_wayland_get_dmabuf_format_supported (guint32 fourcc, guint64 modifier);
+
+// The cursor shape device for the seat's pointer, created the first time it is needed
+// NULL if there is no cursor shape manager or the seat has no pointer
+struct wp_cursor_shape_device_v1 *gtk_wayland_get_cursor_shape_device (GdkSeat *seat);
 
 void gtk_wayland_init_if_needed (void);
 
+// Moves the window to a private subtype of its type whose realize, map, unmap and size-allocate reach its custom shell
+// surface. Called for every window that gets one; no existing class, GtkWindow's included, is modified.
+void gtk_wayland_override_window_class (GtkWindow *gtk_window);
+
 GtkWindow *gtk_wayland_gdk_to_gtk_window (GdkWindow *gdk_window);
 
 // Does not take ownership of position
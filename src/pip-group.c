@@ -0,0 +1,114 @@
+/* This entire file is licensed under MIT
+ *
+ * Copyright 2020 Sophie Winter
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "gtk-pip-shell.h"
+#include "custom-shell-surface.h"
+
+#include <gtk/gtk.h>
+#include <gdk/gdkwayland.h>
+
+// Only map and unmap are batched, buffer pools and frame callbacks stay per window
+struct _GtkPipGroup
+{
+    // Windows are not referenced, they are removed from the group when destroyed
+    GPtrArray *windows;
+};
+
+static void
+gtk_pip_group_on_window_destroy(GtkWidget *window, GtkPipGroup *group)
+{
+    g_ptr_array_remove(group->windows, window);
+}
+
+GtkPipGroup *
+gtk_pip_group_new()
+{
+    GtkPipGroup *group = g_new0(GtkPipGroup, 1);
+    group->windows = g_ptr_array_new();
+    return group;
+}
+
+void gtk_pip_group_free(GtkPipGroup *group)
+{
+    g_return_if_fail(group);
+
+    for (guint i = 0; i < group->windows->len; i++)
+        g_signal_handlers_disconnect_by_func(g_ptr_array_index(group->windows, i),
+                                             gtk_pip_group_on_window_destroy,
+                                             group);
+
+    g_ptr_array_free(group->windows, TRUE);
+    g_free(group);
+}
+
+void gtk_pip_group_add_window(GtkPipGroup *group, GtkWindow *window)
+{
+    g_return_if_fail(group);
+    g_return_if_fail(window);
+
+    if (!gtk_window_get_custom_shell_surface(window))
+        gtk_pip_init_for_window(window);
+
+    for (guint i = 0; i < group->windows->len; i++)
+    {
+        if (g_ptr_array_index(group->windows, i) == (gpointer)window)
+            return;
+    }
+
+    g_ptr_array_add(group->windows, window);
+    g_signal_connect(window, "destroy", G_CALLBACK(gtk_pip_group_on_window_destroy), group);
+}
+
+guint gtk_pip_group_get_n_windows(GtkPipGroup *group)
+{
+    g_return_val_if_fail(group, 0);
+    return group->windows->len;
+}
+
+GtkWindow *
+gtk_pip_group_get_window(GtkPipGroup *group, guint index)
+{
+    g_return_val_if_fail(group, NULL);
+    g_return_val_if_fail(index < group->windows->len, NULL);
+    return g_ptr_array_index(group->windows, index);
+}
+
+void gtk_pip_group_show_all(GtkPipGroup *group)
+{
+    g_return_if_fail(group);
+
+    // Each window's map would otherwise block on its own roundtrip
+    custom_shell_surface_begin_map_batch();
+    for (guint i = 0; i < group->windows->len; i++)
+        gtk_widget_show_all(GTK_WIDGET(g_ptr_array_index(group->windows, i)));
+    custom_shell_surface_end_map_batch();
+}
+
+void gtk_pip_group_hide_all(GtkPipGroup *group)
+{
+    g_return_if_fail(group);
+
+    for (guint i = 0; i < group->windows->len; i++)
+        gtk_widget_hide(GTK_WIDGET(g_ptr_array_index(group->windows, i)));
+
+    wl_display_flush(gdk_wayland_display_get_wl_display(gdk_display_get_default()));
+}
+
+void gtk_pip_group_destroy_all(GtkPipGroup *group)
+{
+    g_return_if_fail(group);
+
+    // Destroying a window removes it from the group, so always destroy the last one
+    while (group->windows->len > 0)
+        gtk_widget_destroy(GTK_WIDGET(g_ptr_array_index(group->windows, group->windows->len - 1)));
+
+    wl_display_flush(gdk_wayland_display_get_wl_display(gdk_display_get_default()));
+}
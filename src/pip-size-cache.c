@@ -0,0 +1,198 @@
+/* This entire file is licensed under MIT
+ *
+ * Copyright 2020 Sophie Winter
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "pip-size-cache.h"
+
+#include <glib/gstdio.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define CACHE_MAGIC 0x43504950 // "PIPC"
+#define CACHE_VERSION 1
+#define CACHE_SLOT_COUNT 64
+#define CACHE_APP_ID_SIZE 112 // Longer app IDs are not cached
+#define CACHE_MAX_SIZE 16384 // Anything larger is treated as a corrupt entry
+
+typedef struct
+{
+    uint32_t hash; // 0 if the slot is empty
+    uint32_t last_used; // Value of the file's clock when the slot was last stored or found
+    int32_t width;
+    int32_t height;
+    int32_t bounds_width;
+    int32_t bounds_height;
+    char app_id[CACHE_APP_ID_SIZE];
+} CacheSlot;
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t clock;
+    uint32_t reserved;
+    CacheSlot slots[CACHE_SLOT_COUNT];
+} CacheFile;
+
+static CacheFile *cache_file = NULL;
+static gboolean cache_file_opened = FALSE; // Set even if opening failed, so it is only tried once
+
+static CacheFile *
+pip_size_cache_get_file()
+{
+    if (cache_file_opened)
+        return cache_file;
+    cache_file_opened = TRUE;
+
+    char *dir = g_build_filename(g_get_user_cache_dir(), "gtk-pip-shell", NULL);
+    char *path = g_build_filename(dir, "pip-sizes", NULL);
+    int fd = -1;
+
+    if (g_mkdir_with_parents(dir, 0700) != 0)
+        goto out;
+
+    fd = g_open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (fd < 0)
+        goto out;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0)
+        goto out;
+    if ((size_t)info.st_size < sizeof(CacheFile) && ftruncate(fd, sizeof(CacheFile)) != 0)
+        goto out;
+
+    void *mapping = mmap(NULL, sizeof(CacheFile), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED)
+        goto out;
+
+    cache_file = mapping;
+    if (cache_file->magic != CACHE_MAGIC || cache_file->version != CACHE_VERSION)
+    {
+        // New file or one written by an incompatible version
+        memset(cache_file, 0, sizeof(CacheFile));
+        cache_file->magic = CACHE_MAGIC;
+        cache_file->version = CACHE_VERSION;
+    }
+
+out:
+    if (fd >= 0)
+        close(fd); // The mapping stays valid
+    if (!cache_file)
+        g_debug("Could not open pip size cache %s, sizes will not be remembered", path);
+    g_free(path);
+    g_free(dir);
+    return cache_file;
+}
+
+static uint32_t
+pip_size_cache_hash(const char *app_id)
+{
+    uint32_t hash = g_str_hash(app_id);
+    return hash ? hash : 1; // 0 marks empty slots
+}
+
+// Other processes may be writing at the same time, so entries are checked before being trusted
+static gboolean
+pip_size_cache_slot_matches(const CacheSlot *slot, uint32_t hash, const char *app_id)
+{
+    return slot->hash == hash &&
+           memchr(slot->app_id, '\0', CACHE_APP_ID_SIZE) &&
+           strcmp(slot->app_id, app_id) == 0;
+}
+
+static CacheSlot *
+pip_size_cache_find_slot(CacheFile *file, const char *app_id)
+{
+    uint32_t hash = pip_size_cache_hash(app_id);
+    for (int i = 0; i < CACHE_SLOT_COUNT; i++)
+    {
+        if (pip_size_cache_slot_matches(&file->slots[i], hash, app_id))
+            return &file->slots[i];
+    }
+    return NULL;
+}
+
+gboolean pip_size_cache_lookup(const char *app_id, PipSizeCacheEntry *entry)
+{
+    g_return_val_if_fail(app_id, FALSE);
+    g_return_val_if_fail(entry, FALSE);
+
+    if (strlen(app_id) >= CACHE_APP_ID_SIZE)
+        return FALSE;
+
+    CacheFile *file = pip_size_cache_get_file();
+    if (!file)
+        return FALSE;
+
+    CacheSlot *slot = pip_size_cache_find_slot(file, app_id);
+    if (!slot)
+        return FALSE;
+
+    PipSizeCacheEntry result = {
+        .width = slot->width,
+        .height = slot->height,
+        .bounds_width = slot->bounds_width,
+        .bounds_height = slot->bounds_height,
+    };
+    if (result.width <= 0 || result.width > CACHE_MAX_SIZE || result.height <= 0 || result.height > CACHE_MAX_SIZE)
+        return FALSE;
+
+    slot->last_used = ++file->clock;
+    *entry = result;
+    return TRUE;
+}
+
+void pip_size_cache_store(const char *app_id, const PipSizeCacheEntry *entry)
+{
+    g_return_if_fail(app_id);
+    g_return_if_fail(entry);
+
+    if (strlen(app_id) >= CACHE_APP_ID_SIZE)
+        return;
+
+    CacheFile *file = pip_size_cache_get_file();
+    if (!file)
+        return;
+
+    CacheSlot *slot = pip_size_cache_find_slot(file, app_id);
+    if (slot &&
+        slot->width == entry->width &&
+        slot->height == entry->height &&
+        slot->bounds_width == entry->bounds_width &&
+        slot->bounds_height == entry->bounds_height)
+    {
+        // Avoid dirtying the page when nothing changed
+        return;
+    }
+
+    if (!slot)
+    {
+        // Take an empty slot, or else the least recently used one
+        slot = &file->slots[0];
+        for (int i = 0; i < CACHE_SLOT_COUNT && slot->hash; i++)
+        {
+            if (!file->slots[i].hash || file->slots[i].last_used < slot->last_used)
+                slot = &file->slots[i];
+        }
+        slot->hash = 0; // Invalidate while the key is rewritten
+        g_strlcpy(slot->app_id, app_id, CACHE_APP_ID_SIZE);
+    }
+
+    slot->width = entry->width;
+    slot->height = entry->height;
+    slot->bounds_width = entry->bounds_width;
+    slot->bounds_height = entry->bounds_height;
+    slot->last_used = ++file->clock;
+    slot->hash = pip_size_cache_hash(app_id);
+}
@@ -0,0 +1,35 @@
+/* This entire file is licensed under MIT
+ *
+ * Copyright 2020 Sophie Winter
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef PIP_SIZE_CACHE_H
+#define PIP_SIZE_CACHE_H
+
+#include <glib.h>
+
+// Remembers the last size each app's pip surface was configured to, so the next one can be laid out at that size
+// before it is mapped. Stored in a small memory mapped file in the user's cache directory, shared between processes.
+// It is only a cache: entries can be evicted, and a failure to open the file just means every lookup misses.
+
+typedef struct
+{
+    int width;
+    int height;
+    int bounds_width; // The configure_bounds in effect when the size was stored, or 0 if none were sent
+    int bounds_height;
+} PipSizeCacheEntry;
+
+// Returns TRUE and fills in entry if app_id has a stored size
+gboolean pip_size_cache_lookup (const char *app_id, PipSizeCacheEntry *entry);
+
+// Replaces the stored size for app_id, evicting the least recently used entry if the cache is full
+void pip_size_cache_store (const char *app_id, const PipSizeCacheEntry *entry);
+
+#endif // PIP_SIZE_CACHE_H
@@ -15,13 +15,38 @@
 #include "simple-conversions.h"
 #include "custom-shell-surface.h"
 #include "gtk-wayland.h"
+#include "gtk-priv-access.h"
+#include "pip-size-cache.h"
+#include "shm-buffer.h"
+#include "video-subsurface.h"
 
 #include "xdg-pip-v1-client.h"
 #include "xdg-shell-client.h"
+#ifdef HAVE_FRACTIONAL_SCALE
+#include "fractional-scale-v1-client.h"
+#endif
+#ifdef HAVE_CURSOR_SHAPE
+#include "cursor-shape-v1-client.h"
+#endif
+#ifdef HAVE_CONTENT_TYPE
+#include "content-type-v1-client.h"
+#endif
+#ifdef HAVE_TEARING_CONTROL
+#include "tearing-control-v1-client.h"
+#endif
 
 #include <gtk/gtk.h>
 #include <gdk/gdkwayland.h>
 
+// The protocol has no way to tell when an interactive resize ends, so assume it has once configures stop arriving
+#define RESIZE_END_TIMEOUT_MS 200
+
+// Predictions don't extrapolate further than this many configure deltas, so a burst of configures can't overshoot
+#define MAX_PREDICTED_DELTAS 2.0
+
+// Used if the frame clock doesn't know the refresh rate yet
+#define DEFAULT_FRAME_INTERVAL_US 16667
+
 /*
  * Sets the window's geometry hints (used to force the window to be a specific size)
  * Needs to be called whenever last_configure_size or anchors are changed
@@ -33,25 +58,28 @@ pip_surface_update_size(PipSurface *self)
 {
     GtkWindow *gtk_window = custom_shell_surface_get_gtk_window((CustomShellSurface *)self);
 
-    gint width = -1;
-    gint height = -1;
+    gint width = self->last_configure_size.width;
+    gint height = self->last_configure_size.height;
 
-    width = self->last_configure_size.width;
+    GdkGeometry hints = {0};
+    GdkWindowHints mask = 0;
 
-    height = self->last_configure_size.height;
-
-    GdkGeometry hints;
-    hints.min_width = width;
-    hints.max_width = width;
-    hints.min_height = height;
-    hints.max_height = height;
+    // A size of 0 means the client decides, so don't force the window to be 0x0
+    if (width > 0 && height > 0)
+    {
+        hints.min_width = width;
+        hints.max_width = width;
+        hints.min_height = height;
+        hints.max_height = height;
+        mask = GDK_HINT_MIN_SIZE | GDK_HINT_MAX_SIZE;
+    }
 
     gtk_window_set_geometry_hints(gtk_window,
                                   NULL,
                                   &hints,
-                                  GDK_HINT_MIN_SIZE | GDK_HINT_MAX_SIZE);
+                                  mask);
 
-    // This will usually get called in a moment by the pip_surface_on_size_allocate () triggered by the above
+    // This will usually get called in a moment by the pip_surface_size_allocate () triggered by the above
     // gtk_window_set_geometry_hints (). However in some cases (such as a streatching a window after a size request has
     // been set), an allocate will not be triggered but the set size does need to change. For this reason we make the
     // call here as well and let the later call clean up any mistakes this one makes. This makes the flicker problem
@@ -59,30 +87,266 @@ pip_surface_update_size(PipSurface *self)
     // pip_surface_send_set_size(self);
 }
 
+/*
+ * Scales the remembered size by how much the bounds have changed since it was stored (such as when it was stored on a
+ * larger output), keeping its aspect ratio. Does nothing until the current bounds are known.
+ */
+static void
+pip_surface_fit_remembered_size(PipSurface *self)
+{
+    GtkRequisition stored = self->remembered_bounds;
+    GtkRequisition current = self->last_bounds;
+    if (stored.width <= 0 || stored.height <= 0 || current.width <= 0 || current.height <= 0)
+        return;
+
+    self->remembered_bounds = (GtkRequisition){0, 0};
+    if (stored.width == current.width && stored.height == current.height)
+        return;
+
+    double factor = MIN((double)current.width / stored.width, (double)current.height / stored.height);
+    self->last_configure_size = (GtkRequisition){
+        .width = MAX((int)(self->last_configure_size.width * factor + 0.5), 1),
+        .height = MAX((int)(self->last_configure_size.height * factor + 0.5), 1),
+    };
+    pip_surface_update_size(self);
+}
+
+/*
+ * Sizes the window from the size cache, so the first layout is usually the final one
+ * Only done before the surface is mapped, after that the compositor decides
+ */
+static void
+pip_surface_apply_remembered_size(PipSurface *self)
+{
+    if (!self->remember_size || self->pip_surface)
+        return;
+
+    PipSizeCacheEntry entry;
+    if (!pip_size_cache_lookup(pip_surface_get_app_id(self), &entry))
+        return;
+
+    self->last_configure_size = (GtkRequisition){
+        .width = entry.width,
+        .height = entry.height,
+    };
+    self->remembered_bounds = (GtkRequisition){
+        .width = entry.bounds_width,
+        .height = entry.bounds_height,
+    };
+    pip_surface_update_size(self);
+    // Bounds from an earlier map of this window are the best guess until the compositor sends new ones
+    pip_surface_fit_remembered_size(self);
+}
+
+static void
+pip_surface_end_resize(PipSurface *self)
+{
+    if (!self->resizing)
+        return;
+
+    if (self->resize_end_timeout)
+    {
+        g_source_remove(self->resize_end_timeout);
+        self->resize_end_timeout = 0;
+    }
+
+    GtkWindow *gtk_window = custom_shell_surface_get_gtk_window((CustomShellSurface *)self);
+    GdkWindow *gdk_window = gtk_widget_get_window(GTK_WIDGET(gtk_window));
+    if (self->after_paint_handler && gdk_window)
+        g_signal_handler_disconnect(gdk_window_get_frame_clock(gdk_window), self->after_paint_handler);
+    self->after_paint_handler = 0;
+
+    if (self->snapshot_draw_handler)
+        g_signal_handler_disconnect(gtk_window, self->snapshot_draw_handler);
+    self->snapshot_draw_handler = 0;
+    if (self->resize_snapshot_image)
+        cairo_surface_destroy(self->resize_snapshot_image);
+    self->resize_snapshot_image = NULL;
+
+    self->resizing = FALSE;
+    self->predicted_size = (GtkRequisition){0, 0};
+    self->pending_commit_us = 0;
+}
+
+static gboolean
+pip_surface_on_resize_end_timeout(gpointer data)
+{
+    PipSurface *self = data;
+    self->resize_end_timeout = 0;
+    pip_surface_end_resize(self);
+
+    // Let apps that switched to a cheaper render path while resizing draw at full quality again
+    GtkWindow *gtk_window = custom_shell_surface_get_gtk_window((CustomShellSurface *)self);
+    gtk_widget_queue_draw(GTK_WIDGET(gtk_window));
+    return G_SOURCE_REMOVE;
+}
+
+static void
+pip_surface_restart_resize_end_timeout(PipSurface *self)
+{
+    if (self->resize_end_timeout)
+        g_source_remove(self->resize_end_timeout);
+    self->resize_end_timeout = g_timeout_add(RESIZE_END_TIMEOUT_MS, pip_surface_on_resize_end_timeout, self);
+}
+
+/*
+ * GDK commits the frame in its own after-paint handler, which was connected first, so by now the buffer for the
+ * pending configure has been committed if the window has been laid out at the configured size
+ */
+static void
+pip_surface_on_after_paint(GdkFrameClock *_frame_clock, PipSurface *self)
+{
+    (void)_frame_clock;
+
+    if (!self->pending_commit_us)
+        return;
+
+    if (self->current_allocation.width != self->last_configure_size.width ||
+        self->current_allocation.height != self->last_configure_size.height)
+        return;
+
+    gint64 latency_us = g_get_monotonic_time() - self->pending_commit_us;
+    self->pending_commit_us = 0;
+
+    self->resize_stats.commits++;
+    self->resize_stats.last_latency_us = latency_us;
+    self->resize_stats.max_latency_us = MAX(self->resize_stats.max_latency_us, latency_us);
+    self->resize_latency_total_us += latency_us;
+    self->resize_stats.mean_latency_us = self->resize_latency_total_us / self->resize_stats.commits;
+}
+
+static gint64
+pip_surface_get_frame_interval_us(PipSurface *self)
+{
+    GtkWindow *gtk_window = custom_shell_surface_get_gtk_window((CustomShellSurface *)self);
+    GdkWindow *gdk_window = gtk_widget_get_window(GTK_WIDGET(gtk_window));
+    if (!gdk_window)
+        return DEFAULT_FRAME_INTERVAL_US;
+
+    GdkFrameClock *frame_clock = gdk_window_get_frame_clock(gdk_window);
+    gint64 refresh_interval_us = 0;
+    gdk_frame_clock_get_refresh_info(frame_clock,
+                                     gdk_frame_clock_get_frame_time(frame_clock),
+                                     &refresh_interval_us,
+                                     NULL);
+    return refresh_interval_us > 0 ? refresh_interval_us : DEFAULT_FRAME_INTERVAL_US;
+}
+
+/*
+ * Called for each configure during an interactive resize, before last_configure_size is updated
+ * Extrapolates where the dragged edge will be one frame from now, assuming it keeps moving like it did between the
+ * last two configures
+ */
+static void
+pip_surface_track_resize_configure(PipSurface *self, int width, int height)
+{
+    gint64 now_us = g_get_monotonic_time();
+    GtkRequisition predicted = {
+        .width = width,
+        .height = height,
+    };
+
+    if (self->last_resize_configure_us && now_us > self->last_resize_configure_us)
+    {
+        self->resize_delta = (GtkRequisition){
+            .width = width - self->last_configure_size.width,
+            .height = height - self->last_configure_size.height,
+        };
+        // Only the dragged edges are expected to keep moving
+        if (!(self->resize_edges & (XDG_PIP_V1_RESIZE_EDGE_LEFT | XDG_PIP_V1_RESIZE_EDGE_RIGHT)))
+            self->resize_delta.width = 0;
+        if (!(self->resize_edges & (XDG_PIP_V1_RESIZE_EDGE_TOP | XDG_PIP_V1_RESIZE_EDGE_BOTTOM)))
+            self->resize_delta.height = 0;
+        double deltas = (double)pip_surface_get_frame_interval_us(self) / (now_us - self->last_resize_configure_us);
+        deltas = MIN(deltas, MAX_PREDICTED_DELTAS);
+        predicted.width += (int)(self->resize_delta.width * deltas);
+        predicted.height += (int)(self->resize_delta.height * deltas);
+    }
+
+    if (self->last_bounds.width > 0)
+        predicted.width = MIN(predicted.width, self->last_bounds.width);
+    if (self->last_bounds.height > 0)
+        predicted.height = MIN(predicted.height, self->last_bounds.height);
+    predicted.width = MAX(predicted.width, 1);
+    predicted.height = MAX(predicted.height, 1);
+
+    self->predicted_size = predicted;
+    self->last_resize_configure_us = now_us;
+    self->pending_commit_us = now_us;
+    pip_surface_restart_resize_end_timeout(self);
+}
+
 static void
 pip_surface_handle_configure(void *data,
                              struct xdg_pip_v1 *_surface,
                              int32_t w,
-                             int32_t h,
-                             struct wl_array *_states)
+                             int32_t h)
 {
     PipSurface *self = data;
+    (void)_surface;
 
-    self->last_configure_size = (GtkRequisition){
-        .width = w,
-        .height = h,
-    };
+    if (w > 0 && h > 0)
+    {
+        if (self->resizing)
+            pip_surface_track_resize_configure(self, w, h);
+
+        self->last_configure_size = (GtkRequisition){
+            .width = w,
+            .height = h,
+        };
+        self->remembered_bounds = (GtkRequisition){0, 0};
+
+        if (self->remember_size)
+        {
+            PipSizeCacheEntry entry = {
+                .width = w,
+                .height = h,
+                .bounds_width = self->last_bounds.width,
+                .bounds_height = self->last_bounds.height,
+            };
+            pip_size_cache_store(pip_surface_get_app_id(self), &entry);
+        }
+    }
+    else
+    {
+        // We get to pick the size. Keep the remembered size if there is one, as long as it is within the bounds
+        if (self->last_bounds.width > 0 && self->last_configure_size.width > self->last_bounds.width)
+            self->last_configure_size.width = self->last_bounds.width;
+        if (self->last_bounds.height > 0 && self->last_configure_size.height > self->last_bounds.height)
+            self->last_configure_size.height = self->last_bounds.height;
+    }
 
     pip_surface_update_size(self);
 }
 
 static void
 pip_surface_handle_configure_bounds(void *data,
-                                    struct xdg_pip_v1 *surface,
+                                    struct xdg_pip_v1 *_surface,
                                     int32_t w,
                                     int32_t h)
 {
     PipSurface *self = data;
+    (void)_surface;
+
+    self->last_bounds = (GtkRequisition){
+        .width = w,
+        .height = h,
+    };
+    pip_surface_fit_remembered_size(self);
+}
+
+/*
+ * Frees the buffer pool, a new one is created if the window draws again
+ * GDK drops its buffers when the window is hidden, so this is the last of the memory a hidden window would hold on to
+ */
+static void
+pip_surface_drop_buffer_pool(PipSurface *self)
+{
+    if (self->buffer_pool)
+    {
+        shm_pool_destroy(self->buffer_pool);
+        self->buffer_pool = NULL;
+    }
 }
 
 static void
@@ -93,7 +357,23 @@ pip_surface_handle_dismissed(void *data,
     (void)_surface;
 
     GtkWindow *gtk_window = custom_shell_surface_get_gtk_window((CustomShellSurface *)self);
-    gtk_window_close(gtk_window);
+    GtkPipDismissPolicy policy = self->dismiss_policy;
+    GtkPipDismissedFunc dismissed_callback = self->dismissed_callback;
+    gpointer dismissed_data = self->dismissed_data;
+
+    // The callback may destroy the window, and self along with it
+    g_object_ref(gtk_window);
+    if (policy == GTK_PIP_DISMISS_POLICY_HIDE)
+    {
+        // Unmapping destroys the role objects, the widget tree is kept for the next time the window is shown
+        gtk_widget_hide(GTK_WIDGET(gtk_window));
+        pip_surface_drop_buffer_pool(self);
+    }
+    if (dismissed_callback)
+        dismissed_callback(gtk_window, dismissed_data);
+    if (policy == GTK_PIP_DISMISS_POLICY_CLOSE)
+        gtk_window_close(gtk_window);
+    g_object_unref(gtk_window);
 }
 
 static const struct xdg_pip_v1_listener pip_surface_listener = {
@@ -102,6 +382,115 @@ static const struct xdg_pip_v1_listener pip_surface_listener = {
     .dismissed = pip_surface_handle_dismissed,
 };
 
+static void
+pip_surface_discard_offscreen_buffer(PipSurface *self)
+{
+    if (self->offscreen_buffer)
+    {
+        wl_buffer_destroy(self->offscreen_buffer);
+        self->offscreen_buffer = NULL;
+    }
+    self->offscreen_attached = FALSE;
+}
+
+static void
+pip_surface_handle_offscreen_buffer_release(void *data, struct wl_buffer *_buffer)
+{
+    (void)_buffer;
+    pip_surface_discard_offscreen_buffer(data);
+}
+
+static const struct wl_buffer_listener offscreen_buffer_listener = {
+    .release = pip_surface_handle_offscreen_buffer_release,
+};
+
+/*
+ * Draws the window as it is currently laid out into a new image surface at the window's scale
+ * Returns NULL if the window has not been realized and allocated yet
+ */
+static cairo_surface_t *
+pip_surface_draw_to_image(PipSurface *self)
+{
+    GtkWidget *widget = GTK_WIDGET(custom_shell_surface_get_gtk_window((CustomShellSurface *)self));
+    GdkWindow *gdk_window = gtk_widget_get_window(widget);
+
+    if (!gdk_window || self->current_allocation.width <= 0 || self->current_allocation.height <= 0)
+        return NULL;
+
+    int scale = gdk_window_get_scale_factor(gdk_window);
+    cairo_surface_t *image = cairo_image_surface_create(CAIRO_FORMAT_ARGB32,
+                                                        self->current_allocation.width * scale,
+                                                        self->current_allocation.height * scale);
+    cairo_surface_set_device_scale(image, scale, scale);
+    cairo_t *cr = cairo_create(image);
+    gtk_widget_draw(widget, cr);
+    cairo_destroy(cr);
+    return image;
+}
+
+/*
+ * Renders the window as it is currently laid out into a shm buffer, so it can be shown as soon as the first configure
+ * is acked instead of on GTK's next frame. Must be called before the role is created, as the buffer is not attached.
+ */
+static void
+pip_surface_render_offscreen(PipSurface *self)
+{
+    struct wl_shm *shm = gtk_wayland_get_wl_shm_global();
+
+    pip_surface_discard_offscreen_buffer(self);
+
+    if (!shm)
+        return;
+
+    cairo_surface_t *image = pip_surface_draw_to_image(self);
+    if (!image)
+        return;
+    double scale;
+    cairo_surface_get_device_scale(image, &scale, NULL);
+
+    self->offscreen_buffer = shm_buffer_new_from_image(shm, image);
+    cairo_surface_destroy(image);
+
+    if (!self->offscreen_buffer)
+        return;
+
+    wl_buffer_add_listener(self->offscreen_buffer, &offscreen_buffer_listener, self);
+    self->offscreen_size = self->current_allocation;
+    self->offscreen_scale = (int)scale;
+}
+
+/*
+ * Attaches and commits the offscreen buffer if the configure that was just acked lets the window keep the size it was
+ * rendered at. GTK attaches its own buffer on its next frame, after which the compositor releases this one.
+ */
+static void
+pip_surface_attach_offscreen_buffer(PipSurface *self)
+{
+    if (!self->offscreen_buffer || self->offscreen_attached)
+        return;
+
+    gboolean width_matches = self->last_configure_size.width <= 0 ||
+                             self->last_configure_size.width == self->offscreen_size.width;
+    gboolean height_matches = self->last_configure_size.height <= 0 ||
+                              self->last_configure_size.height == self->offscreen_size.height;
+    if (!width_matches || !height_matches)
+    {
+        // Showing it would be a frame at the wrong size, GTK's first frame will be right
+        pip_surface_discard_offscreen_buffer(self);
+        return;
+    }
+
+    GtkWindow *gtk_window = custom_shell_surface_get_gtk_window((CustomShellSurface *)self);
+    struct wl_surface *wl_surface = gdk_wayland_window_get_wl_surface(gtk_widget_get_window(GTK_WIDGET(gtk_window)));
+    g_return_if_fail(wl_surface);
+
+    wl_surface_set_buffer_scale(wl_surface, self->offscreen_scale);
+    wl_surface_attach(wl_surface, self->offscreen_buffer, 0, 0);
+    wl_surface_damage_buffer(wl_surface, 0, 0, INT32_MAX, INT32_MAX);
+    wl_surface_commit(wl_surface);
+    self->offscreen_attached = TRUE;
+}
+
 static void
 xdg_surface_handle_configure(void *data,
                              struct xdg_surface *_xdg_surface,
@@ -111,12 +500,232 @@ xdg_surface_handle_configure(void *data,
     (void)_xdg_surface;
 
     xdg_surface_ack_configure(self->xdg_surface, serial);
+    pip_surface_attach_offscreen_buffer(self);
 }
 
 static const struct xdg_surface_listener xdg_surface_listener = {
     .configure = xdg_surface_handle_configure,
 };
 
+/*
+ * If the window's CSS background is opaque GTK paints it under everything, so the whole window can be marked opaque
+ * (unless the app has taken over painting). The visual can't tell, on Wayland the RGBA visual is the only one.
+ */
+static gboolean
+pip_surface_is_automatically_opaque(PipSurface *self)
+{
+    GtkWidget *widget = GTK_WIDGET(custom_shell_surface_get_gtk_window((CustomShellSurface *)self));
+    if (gtk_widget_get_app_paintable(widget) || gtk_widget_get_opacity(widget) < 1.0)
+        return FALSE;
+
+    // The video subsurface shows through wherever the app leaves the window transparent
+    if (self->dmabuf_below)
+        return FALSE;
+
+    GtkStyleContext *style_context = gtk_widget_get_style_context(widget);
+    GdkRGBA *background = NULL;
+    gtk_style_context_get(style_context,
+                          gtk_style_context_get_state(style_context),
+                          GTK_STYLE_PROPERTY_BACKGROUND_COLOR, &background,
+                          NULL);
+    gboolean opaque = background && background->alpha >= 1.0;
+    gdk_rgba_free(background);
+    return opaque;
+}
+
+/*
+ * Applies the opaque and input regions to the GdkWindow, which sends them with the next commit
+ * Needs to be called whenever the allocation or either rect changes, and after GTK sets its own opaque region in
+ * size-allocate
+ */
+static void
+pip_surface_update_regions(PipSurface *self)
+{
+    GtkWindow *gtk_window = custom_shell_surface_get_gtk_window((CustomShellSurface *)self);
+    GdkWindow *gdk_window = gtk_widget_get_window(GTK_WIDGET(gtk_window));
+    if (!gdk_window)
+        return;
+
+    cairo_rectangle_int_t window_rect = {
+        .x = 0,
+        .y = 0,
+        .width = self->current_allocation.width,
+        .height = self->current_allocation.height,
+    };
+
+    if (self->has_opaque_rect)
+    {
+        cairo_region_t *opaque_region = cairo_region_create_rectangle(&self->opaque_rect);
+        cairo_region_intersect_rectangle(opaque_region, &window_rect);
+        gdk_window_set_opaque_region(gdk_window, opaque_region);
+        cairo_region_destroy(opaque_region);
+    }
+    else if (pip_surface_is_automatically_opaque(self))
+    {
+        cairo_region_t *opaque_region = cairo_region_create_rectangle(&window_rect);
+        gdk_window_set_opaque_region(gdk_window, opaque_region);
+        cairo_region_destroy(opaque_region);
+    }
+    else
+    {
+        // GTK only looks at the CSS background, which an app-paintable window may not draw
+        gdk_window_set_opaque_region(gdk_window, NULL);
+    }
+
+    if (self->has_input_rect)
+    {
+        cairo_region_t *input_region = cairo_region_create_rectangle(&self->input_rect);
+        cairo_region_intersect_rectangle(input_region, &window_rect);
+        gdk_window_input_shape_combine_region(gdk_window, input_region, 0, 0);
+        cairo_region_destroy(input_region);
+    }
+    else
+    {
+        gdk_window_input_shape_combine_region(gdk_window, NULL, 0, 0);
+    }
+}
+
+#ifdef HAVE_FRACTIONAL_SCALE
+static void
+pip_surface_handle_preferred_scale(void *data,
+                                   struct wp_fractional_scale_v1 *_fractional_scale,
+                                   uint32_t scale)
+{
+    PipSurface *self = data;
+    (void)_fractional_scale;
+
+    if (self->preferred_scale_120 == scale)
+        return;
+
+    self->preferred_scale_120 = scale;
+
+    // Apps query the preferred buffer size while drawing, so give them a chance to pick up the new one
+    GtkWindow *gtk_window = custom_shell_surface_get_gtk_window((CustomShellSurface *)self);
+    gtk_widget_queue_draw(GTK_WIDGET(gtk_window));
+}
+
+static const struct wp_fractional_scale_v1_listener fractional_scale_listener = {
+    .preferred_scale = pip_surface_handle_preferred_scale,
+};
+#endif
+
+/*
+ * Makes every invalidation cover the whole window, so each frame repaints every pixel
+ * GDK then has nothing to copy from the previous buffer, and GTK redraws anything that an app drawing the whole
+ * window each frame would not have
+ */
+static void
+pip_surface_invalidate_whole_window(GdkWindow *gdk_window, cairo_region_t *region)
+{
+    cairo_rectangle_int_t window_rect = {
+        0, 0,
+        gdk_window_get_width(gdk_window),
+        gdk_window_get_height(gdk_window),
+    };
+    cairo_region_union_rectangle(region, &window_rect);
+}
+
+static void
+pip_surface_apply_full_repaint(PipSurface *self, GdkWindow *gdk_window)
+{
+    gdk_window_set_invalidate_handler(gdk_window,
+                                      self->full_repaint ? pip_surface_invalidate_whole_window : NULL);
+}
+
+/*
+ * GDK paints (and sets up the backfill for the frame) in its own paint handler, which was connected first, and copies
+ * from the backfill buffer in its after-paint handler, so this runs in between
+ */
+static void
+pip_surface_on_paint(GdkFrameClock *_frame_clock, PipSurface *self)
+{
+    (void)_frame_clock;
+
+    GtkWindow *gtk_window = custom_shell_surface_get_gtk_window((CustomShellSurface *)self);
+    GdkWindow *gdk_window = gtk_widget_get_window(GTK_WIDGET(gtk_window));
+    if (!gdk_window)
+        return;
+
+    if (self->full_repaint)
+        gdk_window_drop_priv_backfill(gdk_window);
+    else
+        self->backfill_bytes += gdk_window_get_priv_backfill_bytes(gdk_window);
+}
+
+/*
+ * Sends the content type and tearing hints, creating the objects they need the first time they are non-default
+ * Both are double buffered surface state, so the caller must make sure a commit follows
+ */
+static void
+pip_surface_send_presentation_hints(PipSurface *self, struct wl_surface *wl_surface)
+{
+#ifdef HAVE_CONTENT_TYPE
+    struct wp_content_type_manager_v1 *content_type_manager = gtk_wayland_get_content_type_manager_global();
+    if (!self->content_type_hint && content_type_manager && self->content_type != GTK_PIP_CONTENT_TYPE_NONE)
+        self->content_type_hint = wp_content_type_manager_v1_get_surface_content_type(content_type_manager,
+                                                                                      wl_surface);
+    if (self->content_type_hint)
+        wp_content_type_v1_set_content_type(self->content_type_hint,
+                                            gtk_pip_content_type_get_wp_content_type(self->content_type));
+#endif
+
+#ifdef HAVE_TEARING_CONTROL
+    struct wp_tearing_control_manager_v1 *tearing_control_manager = gtk_wayland_get_tearing_control_manager_global();
+    if (!self->tearing_control && tearing_control_manager && self->low_latency)
+        self->tearing_control = wp_tearing_control_manager_v1_get_tearing_control(tearing_control_manager,
+                                                                                  wl_surface);
+    if (self->tearing_control)
+        wp_tearing_control_v1_set_presentation_hint(self->tearing_control,
+                                                    self->low_latency ?
+                                                        WP_TEARING_CONTROL_V1_PRESENTATION_HINT_ASYNC :
+                                                        WP_TEARING_CONTROL_V1_PRESENTATION_HINT_VSYNC);
+#endif
+
+    (void)self;
+    (void)wl_surface;
+}
+
+static void
+pip_surface_destroy_presentation_hints(PipSurface *self)
+{
+#ifdef HAVE_CONTENT_TYPE
+    if (self->content_type_hint)
+    {
+        wp_content_type_v1_destroy(self->content_type_hint);
+        self->content_type_hint = NULL;
+    }
+#endif
+#ifdef HAVE_TEARING_CONTROL
+    if (self->tearing_control)
+    {
+        wp_tearing_control_v1_destroy(self->tearing_control);
+        self->tearing_control = NULL;
+    }
+#endif
+    (void)self;
+}
+
+/*
+ * Tells the compositor the size the window is laid out at and where it would like to go, so the first configure can
+ * carry the final size instead of 0x0 followed by another configure once the surface is placed
+ * Must be sent before the initial commit, compositors that only support version 1 of the protocol get neither
+ */
+static void
+pip_surface_send_initial_hints(PipSurface *self)
+{
+    if (xdg_pip_v1_get_version(self->pip_surface) < XDG_PIP_V1_SET_INITIAL_SIZE_SINCE_VERSION)
+        return;
+
+    GtkRequisition size = self->current_allocation;
+    if (size.width <= 0 || size.height <= 0)
+        size = self->last_configure_size;
+    if (size.width > 0 && size.height > 0)
+        xdg_pip_v1_set_initial_size(self->pip_surface, size.width, size.height);
+
+    if (self->preferred_corner != GTK_PIP_CORNER_NONE)
+        xdg_pip_v1_set_preferred_corner(self->pip_surface, gtk_pip_corner_get_xdg_pip_corner(self->preferred_corner));
+}
+
 static void
 pip_surface_map(CustomShellSurface *super, struct wl_surface *wl_surface)
 {
@@ -124,6 +733,9 @@ pip_surface_map(CustomShellSurface *super, struct wl_surface *wl_surface)
 
     g_return_if_fail(!self->pip_surface);
 
+    if (self->prepare_offscreen)
+        pip_surface_render_offscreen(self);
+
     struct xdg_wm_pip_v1 *pip_shell_global = gtk_wayland_get_pip_shell_global();
     g_return_if_fail(pip_shell_global);
 
@@ -136,12 +748,36 @@ pip_surface_map(CustomShellSurface *super, struct wl_surface *wl_surface)
 
     g_return_if_fail(self->pip_surface);
 
-    const char *app_id = pip_surface_get_app_id(self);
+    const char *app_id = pip_surface_get_app_id(self);
+
+    xdg_pip_v1_set_app_id(self->pip_surface, app_id);
+    pip_surface_send_initial_hints(self);
+
+    xdg_surface_add_listener(self->xdg_surface, &xdg_surface_listener, self);
+    xdg_pip_v1_add_listener(self->pip_surface, &pip_surface_listener, self);
+
+#ifdef HAVE_FRACTIONAL_SCALE
+    struct wp_fractional_scale_manager_v1 *fractional_scale_manager = gtk_wayland_get_fractional_scale_manager_global();
+    if (fractional_scale_manager)
+    {
+        self->fractional_scale = wp_fractional_scale_manager_v1_get_fractional_scale(fractional_scale_manager,
+                                                                                     wl_surface);
+        wp_fractional_scale_v1_add_listener(self->fractional_scale, &fractional_scale_listener, self);
+    }
+#endif
+
+    // Must arrive before the initial commit, so the compositor can pick the right output path for the first frame
+    pip_surface_send_presentation_hints(self, wl_surface);
 
-    xdg_pip_v1_set_app_id(self->pip_surface, app_id);
+    GtkWindow *gtk_window = custom_shell_surface_get_gtk_window((CustomShellSurface *)self);
+    GdkWindow *gdk_window = gtk_widget_get_window(GTK_WIDGET(gtk_window));
+    pip_surface_apply_full_repaint(self, gdk_window);
+    self->paint_handler = g_signal_connect(gdk_window_get_frame_clock(gdk_window),
+                                           "paint",
+                                           G_CALLBACK(pip_surface_on_paint),
+                                           self);
 
-    xdg_surface_add_listener(self->xdg_surface, &xdg_surface_listener, self);
-    xdg_pip_v1_add_listener(self->pip_surface, &pip_surface_listener, self);
+    pip_surface_update_regions(self);
 }
 
 static void
@@ -149,6 +785,32 @@ pip_surface_unmap(CustomShellSurface *super)
 {
     PipSurface *self = (PipSurface *)super;
 
+    pip_surface_end_resize(self);
+    pip_surface_destroy_presentation_hints(self);
+    if (self->video_subsurface)
+    {
+        video_subsurface_destroy(self->video_subsurface);
+        self->video_subsurface = NULL;
+    }
+    GtkWindow *gtk_window = custom_shell_surface_get_gtk_window((CustomShellSurface *)self);
+    GdkWindow *gdk_window = gtk_widget_get_window(GTK_WIDGET(gtk_window));
+    if (self->paint_handler)
+    {
+        if (gdk_window)
+            g_signal_handler_disconnect(gdk_window_get_frame_clock(gdk_window), self->paint_handler);
+        self->paint_handler = 0;
+    }
+    // Set again on map, the GdkWindow may outlive the pip (e.g. if it is reused as a normal window)
+    if (gdk_window && self->full_repaint)
+        gdk_window_set_invalidate_handler(gdk_window, NULL);
+#ifdef HAVE_FRACTIONAL_SCALE
+    if (self->fractional_scale)
+    {
+        wp_fractional_scale_v1_destroy(self->fractional_scale);
+        self->fractional_scale = NULL;
+    }
+#endif
+    pip_surface_discard_offscreen_buffer(self);
     if (self->pip_surface)
     {
         xdg_pip_v1_destroy(self->pip_surface);
@@ -166,6 +828,8 @@ pip_surface_finalize(CustomShellSurface *super)
 {
     PipSurface *self = (PipSurface *)super;
     pip_surface_unmap(super);
+    pip_surface_drop_buffer_pool(self);
+    pip_surface_set_dismissed_callback(self, NULL, NULL, NULL);
     g_free((gpointer)self->app_id);
 }
 
@@ -176,19 +840,10 @@ pip_surface_get_logical_geom(CustomShellSurface *super)
     return (GdkRectangle){0, 0, 0, 0};
 }
 
-static const CustomShellSurfaceVirtual pip_surface_virtual = {
-    .map = pip_surface_map,
-    .unmap = pip_surface_unmap,
-    .finalize = pip_surface_finalize,
-    .get_logical_geom = pip_surface_get_logical_geom,
-};
-
 static void
-pip_surface_on_size_allocate(GtkWidget *_gtk_window,
-                             GdkRectangle *allocation,
-                             PipSurface *self)
+pip_surface_size_allocate(CustomShellSurface *super, GdkRectangle *allocation)
 {
-    (void)_gtk_window;
+    PipSurface *self = (PipSurface *)super;
 
     if (self->current_allocation.width != allocation->width ||
         self->current_allocation.height != allocation->height)
@@ -199,8 +854,19 @@ pip_surface_on_size_allocate(GtkWidget *_gtk_window,
             .height = allocation->height,
         };
     }
+
+    // GTK resets the opaque region in its own size-allocate, which has already run
+    pip_surface_update_regions(self);
 }
 
+static const CustomShellSurfaceVirtual pip_surface_virtual = {
+    .map = pip_surface_map,
+    .unmap = pip_surface_unmap,
+    .finalize = pip_surface_finalize,
+    .size_allocate = pip_surface_size_allocate,
+    .get_logical_geom = pip_surface_get_logical_geom,
+};
+
 PipSurface *
 pip_surface_new(GtkWindow *gtk_window)
 {
@@ -215,11 +881,43 @@ pip_surface_new(GtkWindow *gtk_window)
         .height = 0,
     };
     self->last_configure_size = self->current_allocation;
+    self->last_bounds = self->current_allocation;
+    self->remembered_bounds = self->current_allocation;
+    self->remember_size = FALSE;
+    self->prepare_offscreen = FALSE;
+    self->preferred_corner = GTK_PIP_CORNER_NONE;
+    self->dismiss_policy = GTK_PIP_DISMISS_POLICY_CLOSE;
+    self->dismissed_callback = NULL;
+    self->dismissed_data = NULL;
+    self->dismissed_destroy = NULL;
+    self->offscreen_buffer = NULL;
+    self->offscreen_attached = FALSE;
     self->app_id = NULL;
     self->pip_surface = NULL;
+    self->fractional_scale = NULL;
+    self->content_type_hint = NULL;
+    self->tearing_control = NULL;
+    self->preferred_scale_120 = 0;
+    self->content_type = GTK_PIP_CONTENT_TYPE_NONE;
+    self->low_latency = FALSE;
+    self->full_repaint = FALSE;
+    self->use_buffer_pool = FALSE;
+    self->buffer_pool = NULL;
+    self->paint_handler = 0;
+    self->backfill_bytes = 0;
+    self->video_subsurface = NULL;
+    self->dmabuf_below = FALSE;
+    self->has_opaque_rect = FALSE;
+    self->has_input_rect = FALSE;
+    self->resizing = FALSE;
+    self->resize_end_timeout = 0;
+    self->after_paint_handler = 0;
+    self->resize_snapshot = FALSE;
+    self->resize_snapshot_image = NULL;
+    self->snapshot_draw_handler = 0;
+    self->has_resize_cursor = FALSE;
 
     gtk_window_set_decorated(gtk_window, FALSE);
-    g_signal_connect(gtk_window, "size-allocate", G_CALLBACK(pip_surface_on_size_allocate), self);
 
     return self;
 }
@@ -234,9 +932,82 @@ void pip_surface_set_app_id(PipSurface *self, char const *app_id)
         {
             xdg_pip_v1_set_app_id(self->pip_surface, app_id);
         }
+        pip_surface_apply_remembered_size(self);
+    }
+}
+
+void pip_surface_set_remember_size(PipSurface *self, gboolean remember_size)
+{
+    remember_size = remember_size ? TRUE : FALSE;
+    if (self->remember_size == remember_size)
+        return;
+
+    self->remember_size = remember_size;
+    if (remember_size)
+    {
+        pip_surface_apply_remembered_size(self);
+    }
+    else if (!self->pip_surface)
+    {
+        // Forget a remembered size that was never confirmed by the compositor
+        self->last_configure_size = (GtkRequisition){0, 0};
+        self->remembered_bounds = (GtkRequisition){0, 0};
+        pip_surface_update_size(self);
     }
 }
 
+gboolean pip_surface_get_remember_size(PipSurface *self)
+{
+    return self->remember_size;
+}
+
+void pip_surface_set_prepare_offscreen(PipSurface *self, gboolean prepare_offscreen)
+{
+    self->prepare_offscreen = prepare_offscreen ? TRUE : FALSE;
+}
+
+gboolean pip_surface_get_prepare_offscreen(PipSurface *self)
+{
+    return self->prepare_offscreen;
+}
+
+void pip_surface_set_preferred_corner(PipSurface *self, GtkPipCorner corner)
+{
+    self->preferred_corner = corner;
+}
+
+GtkPipCorner pip_surface_get_preferred_corner(PipSurface *self)
+{
+    return self->preferred_corner;
+}
+
+void pip_surface_set_dismiss_policy(PipSurface *self, GtkPipDismissPolicy policy)
+{
+    self->dismiss_policy = policy;
+}
+
+GtkPipDismissPolicy pip_surface_get_dismiss_policy(PipSurface *self)
+{
+    return self->dismiss_policy;
+}
+
+void pip_surface_set_dismissed_callback(PipSurface *self,
+                                        GtkPipDismissedFunc callback,
+                                        gpointer user_data,
+                                        GDestroyNotify destroy)
+{
+    GDestroyNotify old_destroy = self->dismissed_destroy;
+    gpointer old_data = self->dismissed_data;
+
+    self->dismissed_callback = callback;
+    self->dismissed_data = user_data;
+    self->dismissed_destroy = destroy;
+
+    // Called last, in case it sets a new callback
+    if (old_destroy)
+        old_destroy(old_data);
+}
+
 const char *
 pip_surface_get_app_id(PipSurface *self)
 {
@@ -246,40 +1017,488 @@ pip_surface_get_app_id(PipSurface *self)
         return "gtk-pip-shell";
 }
 
-void pip_surface_move(PipSurface *self)
+void pip_surface_set_opaque_rect(PipSurface *self, const GdkRectangle *rect)
 {
-    if (!self->pip_surface)
+    if (!rect && !self->has_opaque_rect)
+        return;
+
+    if (rect && self->has_opaque_rect && gdk_rectangle_equal(rect, &self->opaque_rect))
+        return;
+
+    if (rect)
     {
+        self->opaque_rect = *rect;
+        self->has_opaque_rect = TRUE;
+    }
+    else
+    {
+        self->has_opaque_rect = FALSE;
+        // Drop the explicit region, automatic mode may not replace it
+        GtkWindow *gtk_window = custom_shell_surface_get_gtk_window((CustomShellSurface *)self);
+        GdkWindow *gdk_window = gtk_widget_get_window(GTK_WIDGET(gtk_window));
+        if (gdk_window)
+            gdk_window_set_opaque_region(gdk_window, NULL);
+    }
+
+    pip_surface_update_regions(self);
+    custom_shell_surface_needs_commit((CustomShellSurface *)self);
+}
+
+void pip_surface_set_input_rect(PipSurface *self, const GdkRectangle *rect)
+{
+    if (!rect && !self->has_input_rect)
+        return;
+
+    if (rect && self->has_input_rect && gdk_rectangle_equal(rect, &self->input_rect))
+        return;
+
+    self->has_input_rect = (rect != NULL);
+    if (rect)
+        self->input_rect = *rect;
+
+    pip_surface_update_regions(self);
+    custom_shell_surface_needs_commit((CustomShellSurface *)self);
+}
+
+static void
+pip_surface_update_presentation_hints(PipSurface *self)
+{
+    if (!self->pip_surface)
+        return;
+
+    GtkWindow *gtk_window = custom_shell_surface_get_gtk_window((CustomShellSurface *)self);
+    GdkWindow *gdk_window = gtk_widget_get_window(GTK_WIDGET(gtk_window));
+    g_return_if_fail(gdk_window);
+
+    pip_surface_send_presentation_hints(self, gdk_wayland_window_get_wl_surface(gdk_window));
+    custom_shell_surface_needs_commit((CustomShellSurface *)self);
+}
+
+void pip_surface_set_content_type(PipSurface *self, GtkPipContentType content_type)
+{
+    if (self->content_type == content_type)
+        return;
+
+    self->content_type = content_type;
+    pip_surface_update_presentation_hints(self);
+}
+
+GtkPipContentType pip_surface_get_content_type(PipSurface *self)
+{
+    return self->content_type;
+}
+
+void pip_surface_set_low_latency(PipSurface *self, gboolean low_latency)
+{
+    low_latency = low_latency != FALSE;
+    if (self->low_latency == low_latency)
+        return;
+
+    self->low_latency = low_latency;
+    pip_surface_update_presentation_hints(self);
+}
+
+gboolean pip_surface_get_low_latency(PipSurface *self)
+{
+    return self->low_latency;
+}
+
+void pip_surface_set_full_repaint(PipSurface *self, gboolean full_repaint)
+{
+    full_repaint = full_repaint != FALSE;
+    if (self->full_repaint == full_repaint)
+        return;
+
+    self->full_repaint = full_repaint;
+
+    // Takes effect on map otherwise
+    if (!self->pip_surface)
         return;
+
+    GtkWindow *gtk_window = custom_shell_surface_get_gtk_window((CustomShellSurface *)self);
+    GdkWindow *gdk_window = gtk_widget_get_window(GTK_WIDGET(gtk_window));
+    pip_surface_apply_full_repaint(self, gdk_window);
+    // Parts already invalidated were not widened, so make sure the next frame is a full one
+    gdk_window_invalidate_rect(gdk_window, NULL, FALSE);
+}
+
+gboolean pip_surface_get_full_repaint(PipSurface *self)
+{
+    return self->full_repaint;
+}
+
+guint64 pip_surface_get_backfill_bytes(PipSurface *self)
+{
+    return self->backfill_bytes;
+}
+
+static void
+pip_surface_on_pool_buffer_release(cairo_surface_t *surface, void *data)
+{
+    PipSurface *self = data;
+    GtkWindow *gtk_window = custom_shell_surface_get_gtk_window((CustomShellSurface *)self);
+    gdk_window_release_priv_pool_surface(gtk_widget_get_window(GTK_WIDGET(gtk_window)), surface);
+}
+
+ShmPool *
+pip_surface_get_buffer_pool(PipSurface *self)
+{
+    if (!self->use_buffer_pool)
+        return NULL;
+
+    if (!self->buffer_pool)
+    {
+        struct wl_shm *shm = gtk_wayland_get_wl_shm_global();
+        if (!shm)
+            return NULL;
+        self->buffer_pool = shm_pool_new(shm, pip_surface_on_pool_buffer_release, self);
+        // Don't try again every frame
+        if (!self->buffer_pool)
+            self->use_buffer_pool = FALSE;
     }
-    GdkSeat *gdk_seat = gdk_display_get_default_seat(gdk_display_get_default());
-    if (!gdk_seat)
+
+    return self->buffer_pool;
+}
+
+void pip_surface_set_use_buffer_pool(PipSurface *self, gboolean use_buffer_pool)
+{
+    self->use_buffer_pool = use_buffer_pool != FALSE;
+}
+
+gboolean pip_surface_get_use_buffer_pool(PipSurface *self)
+{
+    return self->use_buffer_pool;
+}
+
+gboolean pip_surface_set_dmabuf_frame(PipSurface *self,
+                                      int width,
+                                      int height,
+                                      guint32 fourcc,
+                                      guint64 modifier,
+                                      int n_planes,
+                                      const int *fds,
+                                      const guint32 *offsets,
+                                      const guint32 *strides,
+                                      GtkPipDmabufReleaseFunc release_func,
+                                      gpointer user_data)
+{
+    if (!self->pip_surface)
+        return FALSE;
+
+    struct zwp_linux_dmabuf_v1 *linux_dmabuf = gtk_wayland_get_linux_dmabuf_global();
+    if (!linux_dmabuf || !gtk_wayland_get_dmabuf_format_supported(fourcc, modifier))
+        return FALSE;
+
+    GtkWindow *gtk_window = custom_shell_surface_get_gtk_window((CustomShellSurface *)self);
+    GdkWindow *gdk_window = gtk_widget_get_window(GTK_WIDGET(gtk_window));
+    g_return_val_if_fail(gdk_window, FALSE);
+
+    gboolean created = FALSE;
+    if (!self->video_subsurface)
     {
+        struct wl_subcompositor *subcompositor = gtk_wayland_get_wl_subcompositor_global();
+        g_return_val_if_fail(subcompositor, FALSE);
+        struct wl_surface *wl_surface = gdk_wayland_window_get_wl_surface(gdk_window);
+        self->video_subsurface =
+            video_subsurface_new(gdk_wayland_display_get_wl_compositor(gdk_window_get_display(gdk_window)),
+                                 subcompositor,
+                                 wl_surface);
+        if (self->dmabuf_below)
+            video_subsurface_set_below(self->video_subsurface, wl_surface, TRUE);
+        created = TRUE;
+    }
+
+    gboolean shown = video_subsurface_show_dmabuf(self->video_subsurface,
+                                                  linux_dmabuf,
+                                                  width,
+                                                  height,
+                                                  fourcc,
+                                                  modifier,
+                                                  n_planes,
+                                                  fds,
+                                                  offsets,
+                                                  strides,
+                                                  gdk_window_get_scale_factor(gdk_window),
+                                                  release_func,
+                                                  user_data);
+
+    // A new subsurface is only added to the window by the window's next commit, which then shows the first frame too
+    if (created)
+        custom_shell_surface_needs_commit((CustomShellSurface *)self);
+
+    return shown;
+}
+
+void pip_surface_clear_dmabuf_frame(PipSurface *self)
+{
+    if (!self->video_subsurface)
+        return;
+
+    video_subsurface_destroy(self->video_subsurface);
+    self->video_subsurface = NULL;
+    custom_shell_surface_needs_commit((CustomShellSurface *)self);
+}
+
+void pip_surface_set_dmabuf_below(PipSurface *self, gboolean below)
+{
+    below = below != FALSE;
+    if (self->dmabuf_below == below)
         return;
+
+    self->dmabuf_below = below;
+    pip_surface_update_regions(self);
+
+    if (self->video_subsurface)
+    {
+        GtkWindow *gtk_window = custom_shell_surface_get_gtk_window((CustomShellSurface *)self);
+        GdkWindow *gdk_window = gtk_widget_get_window(GTK_WIDGET(gtk_window));
+        video_subsurface_set_below(self->video_subsurface, gdk_wayland_window_get_wl_surface(gdk_window), below);
+    }
+    // Restacking and the opaque region both only take effect on the window's next commit
+    custom_shell_surface_needs_commit((CustomShellSurface *)self);
+}
+
+gboolean pip_surface_get_dmabuf_below(PipSurface *self)
+{
+    return self->dmabuf_below;
+}
+
+double
+pip_surface_get_preferred_scale(PipSurface *self)
+{
+    if (self->preferred_scale_120)
+        return self->preferred_scale_120 / 120.0;
+
+    GtkWindow *gtk_window = custom_shell_surface_get_gtk_window((CustomShellSurface *)self);
+    return gtk_widget_get_scale_factor(GTK_WIDGET(gtk_window));
+}
+
+void pip_surface_get_preferred_buffer_size(PipSurface *self, int *width, int *height)
+{
+    double scale = pip_surface_get_preferred_scale(self);
+
+    // The fractional-scale protocol says to round halfway away from zero
+    if (width)
+        *width = (int)(self->current_allocation.width * scale + 0.5);
+    if (height)
+        *height = (int)(self->current_allocation.height * scale + 0.5);
+}
+
+GdkMonitor *
+pip_surface_get_monitor(PipSurface *self)
+{
+    GtkWindow *gtk_window = custom_shell_surface_get_gtk_window((CustomShellSurface *)self);
+    GdkWindow *gdk_window = gtk_widget_get_window(GTK_WIDGET(gtk_window));
+    if (!gdk_window)
+        return NULL;
+
+    struct wl_output *wl_output = gdk_window_get_priv_output(gdk_window);
+    if (!wl_output)
+        return NULL;
+
+    GdkDisplay *display = gdk_window_get_display(gdk_window);
+    for (int i = 0; i < gdk_display_get_n_monitors(display); i++)
+    {
+        GdkMonitor *monitor = gdk_display_get_monitor(display, i);
+        if (gdk_wayland_monitor_get_wl_output(monitor) == wl_output)
+            return monitor;
+    }
+
+    return NULL;
+}
+
+/*
+ * Falls back to the newest serial on the default seat if no seat is given
+ * Returns the Wayland seat to use, or NULL if there isn't one
+ */
+static struct wl_seat *
+pip_surface_resolve_seat(GdkSeat **gdk_seat, uint32_t *serial)
+{
+    if (!*gdk_seat)
+    {
+        *gdk_seat = gdk_display_get_default_seat(gdk_display_get_default());
+        if (!*gdk_seat)
+            return NULL;
+        *serial = gdk_window_get_priv_latest_serial(*gdk_seat);
     }
-    uint32_t serial = gdk_window_get_priv_latest_serial(gdk_seat);
+    return gdk_wayland_seat_get_wl_seat(*gdk_seat);
+}
 
-    struct wl_seat *wl_seat = gdk_wayland_seat_get_wl_seat(gdk_seat);
+void pip_surface_move(PipSurface *self, GdkSeat *gdk_seat, uint32_t serial)
+{
+    if (!self->pip_surface)
+    {
+        return;
+    }
+    struct wl_seat *wl_seat = pip_surface_resolve_seat(&gdk_seat, &serial);
+    if (!wl_seat)
+    {
+        return;
+    }
 
     xdg_pip_v1_move(self->pip_surface, wl_seat, serial);
 }
 
-void pip_surface_resize(PipSurface *self, GdkWindowEdge edge)
+/*
+ * Connected to the window's draw signal ahead of GTK's own handler while a resize snapshot is shown, so the widgets
+ * are still laid out at each new size but not drawn
+ */
+static gboolean
+pip_surface_on_draw_resize_snapshot(GtkWidget *widget, cairo_t *cr, PipSurface *self)
+{
+    cairo_surface_t *image = self->resize_snapshot_image;
+    double scale;
+    cairo_surface_get_device_scale(image, &scale, NULL);
+    double width = cairo_image_surface_get_width(image) / scale;
+    double height = cairo_image_surface_get_height(image) / scale;
+
+    cairo_save(cr);
+    cairo_scale(cr, gtk_widget_get_allocated_width(widget) / width, gtk_widget_get_allocated_height(widget) / height);
+    cairo_set_source_surface(cr, image, 0, 0);
+    cairo_pattern_set_filter(cairo_get_source(cr), CAIRO_FILTER_BILINEAR);
+    cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
+    cairo_paint(cr);
+    cairo_restore(cr);
+    return GDK_EVENT_STOP;
+}
+
+static void
+pip_surface_begin_resize_snapshot(PipSurface *self)
+{
+    self->resize_snapshot_image = pip_surface_draw_to_image(self);
+    if (!self->resize_snapshot_image)
+        return;
+
+    GtkWindow *gtk_window = custom_shell_surface_get_gtk_window((CustomShellSurface *)self);
+    self->snapshot_draw_handler = g_signal_connect(gtk_window,
+                                                   "draw",
+                                                   G_CALLBACK(pip_surface_on_draw_resize_snapshot),
+                                                   self);
+}
+
+void pip_surface_resize(PipSurface *self, GdkWindowEdge edge, GdkSeat *gdk_seat, uint32_t serial)
 {
     if (!self->pip_surface)
     {
         return;
     }
-    GdkSeat *gdk_seat = gdk_display_get_default_seat(gdk_display_get_default());
-    if (!gdk_seat)
+    struct wl_seat *wl_seat = pip_surface_resolve_seat(&gdk_seat, &serial);
+    if (!wl_seat)
     {
         return;
     }
-    uint32_t serial = gdk_window_get_priv_latest_serial(gdk_seat);
-    struct wl_seat *wl_seat = gdk_wayland_seat_get_wl_seat(gdk_seat);
 
     uint32_t resize_edge = gdk_get_resize_edge(edge);
     xdg_pip_v1_resize(self->pip_surface, wl_seat, serial, resize_edge);
+
+    pip_surface_end_resize(self);
+    self->resizing = TRUE;
+    self->resize_edges = resize_edge;
+    self->predicted_size = self->current_allocation;
+    self->resize_delta = (GtkRequisition){0, 0};
+    self->last_resize_configure_us = 0;
+    self->pending_commit_us = 0;
+    self->resize_stats = (GtkPipResizeStats){0};
+    self->resize_latency_total_us = 0;
+
+    GtkWindow *gtk_window = custom_shell_surface_get_gtk_window((CustomShellSurface *)self);
+    GdkWindow *gdk_window = gtk_widget_get_window(GTK_WIDGET(gtk_window));
+    self->after_paint_handler = g_signal_connect(gdk_window_get_frame_clock(gdk_window),
+                                                 "after-paint",
+                                                 G_CALLBACK(pip_surface_on_after_paint),
+                                                 self);
+    // Also ends the resize if the compositor ignores the request
+    pip_surface_restart_resize_end_timeout(self);
+
+    if (self->resize_snapshot)
+        pip_surface_begin_resize_snapshot(self);
+
+    // Let apps switch to a cheaper render path for the drag
+    gtk_widget_queue_draw(GTK_WIDGET(gtk_window));
+}
+
+/*
+ * With wp_cursor_shape_v1 the compositor draws the cursor itself, so no cursor image has to be rendered and uploaded
+ * as a shm buffer each time it changes. The shape only lasts until the pointer leaves the surface or GDK sets its own
+ * cursor, which happens behind our back, so the shape is sent every time this is called rather than cached.
+ */
+static void
+pip_surface_apply_resize_cursor(PipSurface *self)
+{
+    GtkWindow *gtk_window = custom_shell_surface_get_gtk_window((CustomShellSurface *)self);
+    GdkWindow *gdk_window = gtk_widget_get_window(GTK_WIDGET(gtk_window));
+    if (!gdk_window)
+        return;
+
+    GdkDisplay *display = gdk_window_get_display(gdk_window);
+
+#ifdef HAVE_CURSOR_SHAPE
+    GdkSeat *seat = gdk_display_get_default_seat(display);
+    struct wp_cursor_shape_device_v1 *cursor_shape_device = gtk_wayland_get_cursor_shape_device(seat);
+    if (cursor_shape_device)
+    {
+        // Only the surface the pointer is over can set its shape
+        if (gdk_seat_get_priv_pointer_focus(seat) != gdk_window)
+            return;
+
+        uint32_t serial = gdk_seat_get_priv_pointer_enter_serial(seat);
+        uint32_t shape = self->has_resize_cursor ?
+                             gdk_get_resize_cursor_shape(self->resize_cursor_edge) :
+                             WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_DEFAULT;
+        wp_cursor_shape_device_v1_set_shape(cursor_shape_device, serial, shape);
+        return;
+    }
+#endif
+
+    // Same as GTK would do, the cursor image is uploaded by GDK
+    GdkCursor *cursor = NULL;
+    if (self->has_resize_cursor)
+        cursor = gdk_cursor_new_from_name(display, gdk_get_resize_cursor_name(self->resize_cursor_edge));
+    gdk_window_set_cursor(gdk_window, cursor);
+    if (cursor)
+        g_object_unref(cursor);
+}
+
+void pip_surface_set_resize_cursor(PipSurface *self, GdkWindowEdge edge)
+{
+    self->has_resize_cursor = TRUE;
+    self->resize_cursor_edge = edge;
+    pip_surface_apply_resize_cursor(self);
+}
+
+void pip_surface_unset_resize_cursor(PipSurface *self)
+{
+    self->has_resize_cursor = FALSE;
+    pip_surface_apply_resize_cursor(self);
+}
+
+gboolean pip_surface_get_resizing(PipSurface *self)
+{
+    return self->resizing;
+}
+
+void pip_surface_get_predicted_size(PipSurface *self, int *width, int *height)
+{
+    GtkRequisition size = self->resizing ? self->predicted_size : self->current_allocation;
+    if (width)
+        *width = size.width;
+    if (height)
+        *height = size.height;
+}
+
+void pip_surface_get_resize_stats(PipSurface *self, GtkPipResizeStats *stats)
+{
+    *stats = self->resize_stats;
+}
+
+void pip_surface_set_resize_snapshot(PipSurface *self, gboolean resize_snapshot)
+{
+    self->resize_snapshot = resize_snapshot != FALSE;
+}
+
+gboolean pip_surface_get_resize_snapshot(PipSurface *self)
+{
+    return self->resize_snapshot;
 }
 
 PipSurface *
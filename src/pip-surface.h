@@ -13,6 +13,8 @@
 #define LAYER_SHELL_SURFACE_H
 
 #include "custom-shell-surface.h"
+#include "shm-buffer.h"
+#include "video-subsurface.h"
 #include "xdg-pip-v1-client.h"
 #include "gtk-pip-shell.h"
 #include <gtk/gtk.h>
@@ -31,11 +33,68 @@ struct _LayerSurface
     // Not set by user requests
     struct xdg_pip_v1 *pip_surface; // The actual pip surface Wayland object (can be NULL)
     struct xdg_surface *xdg_surface; // the Wayland object for the underlying xdg_surface(can be NULL)
+    struct wp_fractional_scale_v1 *fractional_scale; // Can be NULL even when mapped, if unsupported
+    struct wp_content_type_v1 *content_type_hint; // Only created once a content type is set, NULL if unsupported
+    struct wp_tearing_control_v1 *tearing_control; // Only created once low latency is enabled, NULL if unsupported
+
+    uint32_t preferred_scale_120; // Last fractional scale sent by the compositor in 120ths, or 0 if none was sent
+    struct wl_buffer *offscreen_buffer; // Rendered before the role is created, NULL once released or discarded
+    GtkRequisition offscreen_size; // Logical size of offscreen_buffer
+    int offscreen_scale; // Buffer scale of offscreen_buffer
+    gboolean offscreen_attached; // If offscreen_buffer has been attached, so it must only be destroyed once released
 
     GtkRequisition current_allocation; // Last size allocation, or (0, 0) if there hasn't been one
-    GtkRequisition last_configure_size; // Last size received from a configure event
+
+    // Set by user requests
+    gboolean has_opaque_rect; // If FALSE, the opaque region is chosen automatically
+    GdkRectangle opaque_rect; // In window coordinates, clipped to the window when applied
+    gboolean has_input_rect; // If FALSE, the whole window accepts input
+    GdkRectangle input_rect; // In window coordinates, clipped to the window when applied
+    GtkRequisition last_configure_size; // Last size received from a configure event, or the remembered size
+    GtkRequisition last_bounds; // Last size received from a configure_bounds event, or (0, 0) if there hasn't been one
+    GtkRequisition remembered_bounds; // Bounds the remembered size was stored with, (0, 0) once fitted to last_bounds
+    gboolean remember_size; // If to pre-size the window from, and save its size to, the size cache
+    gboolean prepare_offscreen; // If to render the first buffer before mapping, see gtk_pip_set_prepare_offscreen ()
+    GtkPipCorner preferred_corner;
+    GtkPipDismissPolicy dismiss_policy;
+    GtkPipDismissedFunc dismissed_callback; // See gtk_pip_set_dismissed_callback (), can be NULL
+    gpointer dismissed_data;
+    GDestroyNotify dismissed_destroy; // Called on dismissed_data when the callback is replaced or self is finalized
+    GtkPipContentType content_type;
+    gboolean full_repaint; // If the app promises to draw every pixel, so GDK's backfill copy can be skipped
+    gboolean low_latency; // If the compositor may tear to show frames sooner
+
+    // Interactive resize, started by pip_surface_resize ()
+    gboolean resizing; // Until configures stop arriving for a while, the protocol does not say when the drag ends
+    enum xdg_pip_v1_resize_edge resize_edges; // The edges being dragged
+    GtkRequisition predicted_size; // Extrapolated size one frame after the last configure, or (0, 0) if not resizing
+    GtkRequisition resize_delta; // Change in size between the last two configures of the drag
+    gint64 last_resize_configure_us; // When the last configure of the drag arrived, or 0 if none has yet
+    gint64 pending_commit_us; // When the configure that is yet to be committed arrived, or 0 if there isn't one
+    guint resize_end_timeout; // GSource ID of the timeout that ends the drag, or 0
+    gulong after_paint_handler; // Connected to the frame clock only while resizing, or 0
+    GtkPipResizeStats resize_stats; // Of the current drag, or the last one if not resizing
+    gint64 resize_latency_total_us; // Used to compute resize_stats.mean_latency_us
+    gboolean resize_snapshot; // See gtk_pip_set_resize_snapshot ()
+    cairo_surface_t *resize_snapshot_image; // Drawn when the drag started, NULL if not resizing or not enabled
+    gulong snapshot_draw_handler; // Connected to the window's draw signal while the snapshot is shown, or 0
+
+    gboolean use_buffer_pool; // See gtk_pip_set_buffer_pool ()
+    ShmPool *buffer_pool; // Created the first time GDK needs a new buffer, NULL until then
+    gulong paint_handler; // Connected to the frame clock while mapped, or 0
+    guint64 backfill_bytes; // Copied by GDK from previous buffers since the surface was created
+    VideoSubsurface *video_subsurface; // Created by the first dmabuf frame while mapped, NULL otherwise
+    gboolean dmabuf_below; // See gtk_pip_set_dmabuf_below ()
+
+    gboolean has_resize_cursor; // If resize_cursor_edge is set, see pip_surface_set_resize_cursor ()
+    GdkWindowEdge resize_cursor_edge;
 };
 
+// Memory budget: creating a surface (everything gtk_pip_init_for_window () does once the Wayland globals are bound)
+// costs at most 4 heap allocations and 1024 bytes. The shell surface is one allocation with its private part embedded
+// (408 bytes on 64-bit), and no per-window signal handlers are connected. The rest is GLib growing the window's qdata
+// array for the surface (up to 392 bytes for 16 entries) and GTK notifying that the window was undecorated. Wayland
+// objects created on map are not counted. Enforced by test-pip-memory-budget, update it along with this comment.
 PipSurface *pip_surface_new (GtkWindow *gtk_window);
 
 // Safe cast, returns NULL if wrong type sent
@@ -47,8 +106,90 @@ void pip_surface_set_app_id (PipSurface *self, char const* name_space); // Makes
 // Returns the effective namespace (default if unset). Does not return ownership. Never returns NULL. Handles null self.
 const char* pip_surface_get_app_id (PipSurface *self);
 
-void pip_surface_move(PipSurface *self);
+// If enabled and the surface is not mapped, the window is immediately sized from the cache
+void pip_surface_set_remember_size (PipSurface *self, gboolean remember_size);
+gboolean pip_surface_get_remember_size (PipSurface *self);
+
+// Takes effect the next time the surface is mapped
+void pip_surface_set_prepare_offscreen (PipSurface *self, gboolean prepare_offscreen);
+gboolean pip_surface_get_prepare_offscreen (PipSurface *self);
+
+// Sent with the initial size when the surface is mapped, so takes effect the next time it is
+void pip_surface_set_preferred_corner (PipSurface *self, GtkPipCorner corner);
+GtkPipCorner pip_surface_get_preferred_corner (PipSurface *self);
+
+// Applied when the compositor dismisses the surface, after which the dismissed callback is called
+void pip_surface_set_dismiss_policy (PipSurface *self, GtkPipDismissPolicy policy);
+GtkPipDismissPolicy pip_surface_get_dismiss_policy (PipSurface *self);
+void pip_surface_set_dismissed_callback (PipSurface *self,
+                                         GtkPipDismissedFunc callback,
+                                         gpointer user_data,
+                                         GDestroyNotify destroy);
+
+// Returns the fractional scale the compositor would like the surface to be rendered at
+// Falls back to GTK's integer scale if the compositor has not sent a fractional one
+double pip_surface_get_preferred_scale (PipSurface *self);
+
+// The logical size of the window multiplied by the preferred scale, rounded as the fractional-scale protocol requires
+void pip_surface_get_preferred_buffer_size (PipSurface *self, int *width, int *height);
+
+// The monitor the surface most recently entered, or NULL if it is not on any
+GdkMonitor *pip_surface_get_monitor (PipSurface *self);
+
+// NULL rect means automatic (opaque region) or the whole window (input region)
+void pip_surface_set_opaque_rect (PipSurface *self, const GdkRectangle *rect);
+void pip_surface_set_input_rect (PipSurface *self, const GdkRectangle *rect);
+
+// Hints are sent before the initial commit if set before mapping, otherwise they apply on the next commit
+void pip_surface_set_content_type (PipSurface *self, GtkPipContentType content_type);
+GtkPipContentType pip_surface_get_content_type (PipSurface *self);
+void pip_surface_set_low_latency (PipSurface *self, gboolean low_latency);
+gboolean pip_surface_get_low_latency (PipSurface *self);
+
+// See gtk_pip_set_full_repaint () and gtk_pip_get_backfill_bytes ()
+void pip_surface_set_full_repaint (PipSurface *self, gboolean full_repaint);
+gboolean pip_surface_get_full_repaint (PipSurface *self);
+guint64 pip_surface_get_backfill_bytes (PipSurface *self);
+
+// Returns NULL if disabled with gtk_pip_set_buffer_pool () or the pool can't be created
+// Buffers handed out keep working after the pool is disabled, it is only destroyed along with the surface
+ShmPool *pip_surface_get_buffer_pool (PipSurface *self);
+void pip_surface_set_use_buffer_pool (PipSurface *self, gboolean use_buffer_pool);
+gboolean pip_surface_get_use_buffer_pool (PipSurface *self);
+
+// See gtk_pip_set_dmabuf_frame (), returns FALSE if not mapped or the compositor can't import the format and modifier
+gboolean pip_surface_set_dmabuf_frame (PipSurface *self,
+                                       int width,
+                                       int height,
+                                       guint32 fourcc,
+                                       guint64 modifier,
+                                       int n_planes,
+                                       const int *fds,
+                                       const guint32 *offsets,
+                                       const guint32 *strides,
+                                       GtkPipDmabufReleaseFunc release_func,
+                                       gpointer user_data);
+void pip_surface_clear_dmabuf_frame (PipSurface *self);
+void pip_surface_set_dmabuf_below (PipSurface *self, gboolean below);
+gboolean pip_surface_get_dmabuf_below (PipSurface *self);
+
+// The serial must be of an input event from gdk_seat, see gdk_event_get_priv_serial ()
+// If gdk_seat is NULL, the newest serial of any device on the default seat is used instead
+void pip_surface_move(PipSurface *self, GdkSeat *gdk_seat, uint32_t serial);
+
+void pip_surface_resize(PipSurface *self, GdkWindowEdge edge, GdkSeat *gdk_seat, uint32_t serial);
+
+// Uses wp_cursor_shape_v1 if the compositor supports it, otherwise sets the GdkWindow's cursor like GTK would
+void pip_surface_set_resize_cursor (PipSurface *self, GdkWindowEdge edge);
+void pip_surface_unset_resize_cursor (PipSurface *self);
+
+// See gtk_pip_get_resizing (), gtk_pip_get_predicted_size () and gtk_pip_get_resize_stats ()
+gboolean pip_surface_get_resizing (PipSurface *self);
+void pip_surface_get_predicted_size (PipSurface *self, int *width, int *height);
+void pip_surface_get_resize_stats (PipSurface *self, GtkPipResizeStats *stats);
 
-void pip_surface_resize(PipSurface *self, GdkWindowEdge edge);
+// See gtk_pip_set_resize_snapshot (), takes effect from the next interactive resize
+void pip_surface_set_resize_snapshot (PipSurface *self, gboolean resize_snapshot);
+gboolean pip_surface_get_resize_snapshot (PipSurface *self);
 
 #endif // LAYER_SHELL_SURFACE_H
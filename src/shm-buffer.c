@@ -0,0 +1,363 @@
+/* This entire file is licensed under MIT
+ *
+ * Copyright 2020 Sophie Winter
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#define _GNU_SOURCE // For memfd_create ()
+
+#include "shm-buffer.h"
+
+#include <glib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// Enough for the staging buffer, the committed buffer and one the compositor hasn't released yet, plus one spare
+#define SHM_POOL_MAX_SLOTS 4
+
+// Address space reserved for each pool, only the part that is in use is backed by the memfd. Every pip has a pool of
+// its own, so this is kept to what four buffers of a pip as large as a 1080p screen need (16 MB each once rounded up
+// to a size class). Larger windows fall back to buffers GDK allocates.
+#define SHM_POOL_MAX_SIZE ((size_t)64 << 20)
+
+// Slot capacities are rounded up to a power of two of at least this, so nearby sizes share a slot
+#define SHM_POOL_MIN_SLOT_SIZE ((size_t)64 << 10)
+
+struct wl_buffer *
+shm_buffer_new_from_image(struct wl_shm *shm, cairo_surface_t *image)
+{
+    g_return_val_if_fail(shm, NULL);
+    g_return_val_if_fail(cairo_image_surface_get_format(image) == CAIRO_FORMAT_ARGB32, NULL);
+
+    cairo_surface_flush(image);
+    int width = cairo_image_surface_get_width(image);
+    int height = cairo_image_surface_get_height(image);
+    int src_stride = cairo_image_surface_get_stride(image);
+    const unsigned char *src = cairo_image_surface_get_data(image);
+    g_return_val_if_fail(width > 0 && height > 0 && src, NULL);
+
+    int stride = width * 4;
+    size_t size = (size_t)stride * height;
+
+    int fd = memfd_create("gtk-pip-shell-buffer", MFD_CLOEXEC);
+    if (fd < 0)
+    {
+        g_warning("Failed to create shared memory for a %dx%d buffer", width, height);
+        return NULL;
+    }
+
+    struct wl_buffer *buffer = NULL;
+    if (ftruncate(fd, size) != 0)
+        goto out;
+
+    unsigned char *dest = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (dest == MAP_FAILED)
+        goto out;
+
+    // Cairo's ARGB32 is premultiplied native endian ARGB, which is exactly WL_SHM_FORMAT_ARGB8888
+    for (int y = 0; y < height; y++)
+        memcpy(dest + (size_t)y * stride, src + (size_t)y * src_stride, stride);
+    munmap(dest, size);
+
+    struct wl_shm_pool *pool = wl_shm_create_pool(shm, fd, size);
+    buffer = wl_shm_pool_create_buffer(pool, 0, width, height, stride, WL_SHM_FORMAT_ARGB8888);
+    wl_shm_pool_destroy(pool); // The buffer keeps the memory alive
+
+out:
+    if (!buffer)
+        g_warning("Failed to create a %dx%d shm buffer", width, height);
+    close(fd);
+    return buffer;
+}
+
+typedef struct
+{
+    ShmPool *pool;
+    size_t offset; // Into the pool
+    size_t capacity; // 0 if the slot has no memory yet
+    struct wl_buffer *buffer; // Created for the last size handed out, NULL if there hasn't been one
+    int width, height, stride; // Of buffer
+    cairo_surface_t *surface; // Not referenced, NULL once destroyed
+    gboolean busy; // Attached and not yet released by the compositor
+} ShmPoolSlot;
+
+struct _ShmPool
+{
+    struct wl_shm *shm;
+    ShmPoolReleaseFunc release_func; // NULL once the pool has been destroyed by its owner
+    void *release_data;
+    int fd;
+    unsigned char *data; // Start of the reserved address space
+    size_t size; // Of the memfd and the part of the reservation mapped to it
+    size_t used; // Slots are laid out below this
+    struct wl_shm_pool *wl_shm_pool; // NULL until the pool first grows
+    int ref_count; // One for the owner plus one for each live surface
+    ShmPoolSlot slots[SHM_POOL_MAX_SLOTS];
+};
+
+static cairo_user_data_key_t shm_pool_surface_key;
+
+static void
+shm_pool_unref(ShmPool *pool)
+{
+    if (--pool->ref_count > 0)
+        return;
+
+    for (int i = 0; i < SHM_POOL_MAX_SLOTS; i++)
+    {
+        if (pool->slots[i].buffer)
+            wl_buffer_destroy(pool->slots[i].buffer);
+    }
+    if (pool->wl_shm_pool)
+        wl_shm_pool_destroy(pool->wl_shm_pool);
+    munmap(pool->data, SHM_POOL_MAX_SIZE);
+    close(pool->fd);
+    g_free(pool);
+}
+
+static void
+shm_pool_handle_buffer_release(void *data, struct wl_buffer *_buffer)
+{
+    ShmPoolSlot *slot = data;
+    (void)_buffer;
+
+    slot->busy = FALSE;
+    if (!slot->surface)
+        return;
+
+    if (slot->pool->release_func)
+        slot->pool->release_func(slot->surface, slot->pool->release_data);
+    else
+        cairo_surface_destroy(slot->surface);
+}
+
+static const struct wl_buffer_listener shm_pool_buffer_listener = {
+    .release = shm_pool_handle_buffer_release,
+};
+
+ShmPool *
+shm_pool_new(struct wl_shm *shm, ShmPoolReleaseFunc release_func, void *release_data)
+{
+    g_return_val_if_fail(shm, NULL);
+
+    int fd = memfd_create("gtk-pip-shell-pool", MFD_CLOEXEC);
+    if (fd < 0)
+    {
+        g_warning("Failed to create shared memory for a buffer pool");
+        return NULL;
+    }
+
+    // Reserve the address space without committing any memory, it is mapped to the memfd as the pool grows
+    void *data = mmap(NULL, SHM_POOL_MAX_SIZE, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (data == MAP_FAILED)
+    {
+        g_warning("Failed to reserve address space for a buffer pool");
+        close(fd);
+        return NULL;
+    }
+
+    ShmPool *pool = g_new0(ShmPool, 1);
+    pool->shm = shm;
+    pool->release_func = release_func;
+    pool->release_data = release_data;
+    pool->fd = fd;
+    pool->data = data;
+    pool->ref_count = 1;
+    for (int i = 0; i < SHM_POOL_MAX_SLOTS; i++)
+        pool->slots[i].pool = pool;
+    return pool;
+}
+
+void
+shm_pool_destroy(ShmPool *pool)
+{
+    g_return_if_fail(pool);
+    pool->release_func = NULL;
+    pool->release_data = NULL;
+    shm_pool_unref(pool);
+}
+
+static gboolean
+shm_pool_ensure_size(ShmPool *pool, size_t size)
+{
+    if (size <= pool->size)
+        return TRUE;
+
+    // Double each time, so a window growing steadily only grows the pool a few times
+    size_t page_size = sysconf(_SC_PAGESIZE);
+    size_t new_size = MAX(size, pool->size * 2);
+    new_size = (new_size + page_size - 1) / page_size * page_size;
+    if (new_size > SHM_POOL_MAX_SIZE)
+        return FALSE;
+
+    if (ftruncate(pool->fd, new_size) != 0)
+        return FALSE;
+
+    // Only map the new part, pages that are already mapped keep their page table entries
+    void *extension = mmap(pool->data + pool->size,
+                           new_size - pool->size,
+                           PROT_READ | PROT_WRITE,
+                           MAP_SHARED | MAP_FIXED,
+                           pool->fd,
+                           pool->size);
+    if (extension == MAP_FAILED)
+        return FALSE;
+
+    if (pool->wl_shm_pool)
+        wl_shm_pool_resize(pool->wl_shm_pool, new_size);
+    else
+        pool->wl_shm_pool = wl_shm_create_pool(pool->shm, pool->fd, new_size);
+    pool->size = new_size;
+    return TRUE;
+}
+
+static size_t
+shm_pool_get_size_class(size_t size)
+{
+    size_t size_class = SHM_POOL_MIN_SLOT_SIZE;
+    while (size_class < size)
+        size_class *= 2;
+    return size_class;
+}
+
+static gboolean
+shm_pool_slot_is_free(ShmPoolSlot *slot)
+{
+    return !slot->surface && !slot->busy;
+}
+
+static void
+shm_pool_slot_clear_buffer(ShmPoolSlot *slot)
+{
+    if (slot->buffer)
+        wl_buffer_destroy(slot->buffer);
+    slot->buffer = NULL;
+}
+
+// Returns a free slot with room for size bytes, giving it (more) memory if needed, or NULL
+static ShmPoolSlot *
+shm_pool_get_slot(ShmPool *pool, size_t size)
+{
+    ShmPoolSlot *best = NULL;
+    gboolean all_free = TRUE;
+    for (int i = 0; i < SHM_POOL_MAX_SLOTS; i++)
+    {
+        ShmPoolSlot *slot = &pool->slots[i];
+        if (!shm_pool_slot_is_free(slot))
+        {
+            all_free = FALSE;
+            continue;
+        }
+        if (slot->capacity >= size && (!best || slot->capacity < best->capacity))
+            best = slot;
+    }
+    if (best)
+        return best;
+
+    // Slots that were outgrown leave holes, which can only be reclaimed once nothing is using the pool
+    if (all_free)
+    {
+        for (int i = 0; i < SHM_POOL_MAX_SLOTS; i++)
+        {
+            shm_pool_slot_clear_buffer(&pool->slots[i]);
+            pool->slots[i].offset = 0;
+            pool->slots[i].capacity = 0;
+        }
+        pool->used = 0;
+    }
+
+    // Give a new region to the free slot with the least memory, as it is the least useful
+    for (int i = 0; i < SHM_POOL_MAX_SLOTS; i++)
+    {
+        ShmPoolSlot *slot = &pool->slots[i];
+        if (shm_pool_slot_is_free(slot) && (!best || slot->capacity < best->capacity))
+            best = slot;
+    }
+    if (!best)
+        return NULL;
+
+    size_t capacity = shm_pool_get_size_class(size);
+    if (!shm_pool_ensure_size(pool, pool->used + capacity))
+        return NULL;
+
+    shm_pool_slot_clear_buffer(best);
+    best->offset = pool->used;
+    best->capacity = capacity;
+    pool->used += capacity;
+    return best;
+}
+
+static void
+shm_pool_on_surface_destroy(void *data)
+{
+    ShmPoolSlot *slot = data;
+    slot->surface = NULL;
+    shm_pool_unref(slot->pool);
+}
+
+cairo_surface_t *
+shm_pool_acquire_surface(ShmPool *pool, int width, int height, int scale)
+{
+    g_return_val_if_fail(pool, NULL);
+    g_return_val_if_fail(pool->release_func, NULL);
+    g_return_val_if_fail(width > 0 && height > 0 && scale > 0, NULL);
+
+    int buffer_width = width * scale;
+    int buffer_height = height * scale;
+    int stride = cairo_format_stride_for_width(CAIRO_FORMAT_ARGB32, buffer_width);
+    size_t size = (size_t)stride * buffer_height;
+
+    ShmPoolSlot *slot = shm_pool_get_slot(pool, size);
+    if (!slot)
+        return NULL;
+
+    // Creating a buffer is only a request, the memory behind it is reused
+    if (slot->buffer && (slot->width != buffer_width || slot->height != buffer_height || slot->stride != stride))
+        shm_pool_slot_clear_buffer(slot);
+    if (!slot->buffer)
+    {
+        slot->buffer = wl_shm_pool_create_buffer(pool->wl_shm_pool,
+                                                 slot->offset,
+                                                 buffer_width,
+                                                 buffer_height,
+                                                 stride,
+                                                 WL_SHM_FORMAT_ARGB8888);
+        wl_buffer_add_listener(slot->buffer, &shm_pool_buffer_listener, slot);
+        slot->width = buffer_width;
+        slot->height = buffer_height;
+        slot->stride = stride;
+    }
+
+    slot->surface = cairo_image_surface_create_for_data(pool->data + slot->offset,
+                                                        CAIRO_FORMAT_ARGB32,
+                                                        buffer_width,
+                                                        buffer_height,
+                                                        stride);
+    cairo_surface_set_device_scale(slot->surface, scale, scale);
+    cairo_surface_set_user_data(slot->surface, &shm_pool_surface_key, slot, shm_pool_on_surface_destroy);
+    pool->ref_count++;
+    return slot->surface;
+}
+
+gboolean
+shm_pool_is_pool_surface(cairo_surface_t *surface)
+{
+    return surface && cairo_surface_get_user_data(surface, &shm_pool_surface_key) != NULL;
+}
+
+void
+shm_pool_surface_attach(cairo_surface_t *surface, struct wl_surface *wl_surface)
+{
+    ShmPoolSlot *slot = cairo_surface_get_user_data(surface, &shm_pool_surface_key);
+    g_return_if_fail(slot);
+
+    cairo_surface_flush(surface);
+    wl_surface_attach(wl_surface, slot->buffer, 0, 0);
+    slot->busy = TRUE;
+}
@@ -0,0 +1,49 @@
+/* This entire file is licensed under MIT
+ *
+ * Copyright 2020 Sophie Winter
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef SHM_BUFFER_H
+#define SHM_BUFFER_H
+
+#include <cairo.h>
+#include <glib.h>
+#include <wayland-client.h>
+
+// Copies a CAIRO_FORMAT_ARGB32 image surface into a new ARGB8888 wl_shm buffer
+// Returns NULL on failure. The caller owns the returned buffer and should destroy it once it has been released.
+struct wl_buffer *shm_buffer_new_from_image (struct wl_shm *shm, cairo_surface_t *image);
+
+// A growable pool of ARGB8888 buffers sharing one memfd, mapping and wl_shm_pool
+// Buffer memory is rounded up to a size class and reused for any size that fits, so a window being resized only makes
+// syscalls when it outgrows every free buffer. The pool then grows with wl_shm_pool.resize, within address space
+// reserved up front so the data pointers of surfaces handed out earlier stay valid.
+typedef struct _ShmPool ShmPool;
+
+// Called when the compositor releases a buffer whose surface is still alive
+typedef void (*ShmPoolReleaseFunc) (cairo_surface_t *surface, void *data);
+
+ShmPool *shm_pool_new (struct wl_shm *shm, ShmPoolReleaseFunc release_func, void *release_data);
+
+// The pool is freed once every surface it has handed out is destroyed. After this, surfaces that are released by the
+// compositor are destroyed instead of being passed to the release function, as no one is left to reuse them.
+void shm_pool_destroy (ShmPool *pool);
+
+// Returns a new CAIRO_FORMAT_ARGB32 image surface of the given logical size and scale, drawn straight into a pool
+// buffer, or NULL if every buffer is in use or the pool can't grow. The buffer is free again once the surface has been
+// destroyed and the compositor has released it.
+cairo_surface_t *shm_pool_acquire_surface (ShmPool *pool, int width, int height, int scale);
+
+// If the surface came from shm_pool_acquire_surface ()
+gboolean shm_pool_is_pool_surface (cairo_surface_t *surface);
+
+// Attaches the surface's buffer to wl_surface, it is then in use until the compositor releases it
+void shm_pool_surface_attach (cairo_surface_t *surface, struct wl_surface *wl_surface);
+
+#endif // SHM_BUFFER_H
@@ -37,6 +37,100 @@ enum xdg_pip_v1_resize_edge gdk_get_resize_edge(GdkWindowEdge edge)
     }
 }
 
+enum xdg_pip_v1_corner gtk_pip_corner_get_xdg_pip_corner(GtkPipCorner corner)
+{
+    switch (corner)
+    {
+    case GTK_PIP_CORNER_NONE:
+        return XDG_PIP_V1_CORNER_NONE;
+    case GTK_PIP_CORNER_TOP_LEFT:
+        return XDG_PIP_V1_CORNER_TOP_LEFT;
+    case GTK_PIP_CORNER_TOP_RIGHT:
+        return XDG_PIP_V1_CORNER_TOP_RIGHT;
+    case GTK_PIP_CORNER_BOTTOM_LEFT:
+        return XDG_PIP_V1_CORNER_BOTTOM_LEFT;
+    case GTK_PIP_CORNER_BOTTOM_RIGHT:
+        return XDG_PIP_V1_CORNER_BOTTOM_RIGHT;
+    default:
+        g_critical("Invalid GtkPipCorner %d", corner);
+        return XDG_PIP_V1_CORNER_NONE;
+    }
+}
+
+#ifdef HAVE_CURSOR_SHAPE
+enum wp_cursor_shape_device_v1_shape gdk_get_resize_cursor_shape(GdkWindowEdge edge)
+{
+    switch (edge)
+    {
+    case GDK_WINDOW_EDGE_NORTH_WEST:
+        return WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_NW_RESIZE;
+    case GDK_WINDOW_EDGE_NORTH:
+        return WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_N_RESIZE;
+    case GDK_WINDOW_EDGE_NORTH_EAST:
+        return WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_NE_RESIZE;
+    case GDK_WINDOW_EDGE_WEST:
+        return WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_W_RESIZE;
+    case GDK_WINDOW_EDGE_EAST:
+        return WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_E_RESIZE;
+    case GDK_WINDOW_EDGE_SOUTH_WEST:
+        return WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_SW_RESIZE;
+    case GDK_WINDOW_EDGE_SOUTH:
+        return WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_S_RESIZE;
+    case GDK_WINDOW_EDGE_SOUTH_EAST:
+        return WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_SE_RESIZE;
+    default:
+        g_critical("Invalid GdkWindowEdge %d", edge);
+        return WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_DEFAULT;
+    }
+}
+#endif
+
+#ifdef HAVE_CONTENT_TYPE
+enum wp_content_type_v1_type gtk_pip_content_type_get_wp_content_type(GtkPipContentType content_type)
+{
+    switch (content_type)
+    {
+    case GTK_PIP_CONTENT_TYPE_NONE:
+        return WP_CONTENT_TYPE_V1_TYPE_NONE;
+    case GTK_PIP_CONTENT_TYPE_PHOTO:
+        return WP_CONTENT_TYPE_V1_TYPE_PHOTO;
+    case GTK_PIP_CONTENT_TYPE_VIDEO:
+        return WP_CONTENT_TYPE_V1_TYPE_VIDEO;
+    case GTK_PIP_CONTENT_TYPE_GAME:
+        return WP_CONTENT_TYPE_V1_TYPE_GAME;
+    default:
+        g_critical("Invalid GtkPipContentType %d", content_type);
+        return WP_CONTENT_TYPE_V1_TYPE_NONE;
+    }
+}
+#endif
+
+const char *gdk_get_resize_cursor_name(GdkWindowEdge edge)
+{
+    switch (edge)
+    {
+    case GDK_WINDOW_EDGE_NORTH_WEST:
+        return "nw-resize";
+    case GDK_WINDOW_EDGE_NORTH:
+        return "n-resize";
+    case GDK_WINDOW_EDGE_NORTH_EAST:
+        return "ne-resize";
+    case GDK_WINDOW_EDGE_WEST:
+        return "w-resize";
+    case GDK_WINDOW_EDGE_EAST:
+        return "e-resize";
+    case GDK_WINDOW_EDGE_SOUTH_WEST:
+        return "sw-resize";
+    case GDK_WINDOW_EDGE_SOUTH:
+        return "s-resize";
+    case GDK_WINDOW_EDGE_SOUTH_EAST:
+        return "se-resize";
+    default:
+        g_critical("Invalid GdkWindowEdge %d", edge);
+        return "default";
+    }
+}
+
 enum xdg_positioner_gravity
 gdk_gravity_get_xdg_positioner_gravity(GdkGravity gravity)
 {
@@ -117,3 +211,31 @@ gdk_anchor_hints_get_xdg_positioner_constraint_adjustment(GdkAnchorHints hints)
         adjustment |= XDG_POSITIONER_CONSTRAINT_ADJUSTMENT_RESIZE_Y;
     return adjustment;
 }
+
+FrameFormat gtk_pip_frame_format_get_frame_format(GtkPipFrameFormat format)
+{
+    switch (format)
+    {
+    case GTK_PIP_FRAME_FORMAT_I420:
+        return FRAME_FORMAT_I420;
+    case GTK_PIP_FRAME_FORMAT_NV12:
+        return FRAME_FORMAT_NV12;
+    default:
+        g_critical("Invalid GtkPipFrameFormat %d", format);
+        return FRAME_FORMAT_I420;
+    }
+}
+
+FrameScale gtk_pip_frame_scale_get_frame_scale(GtkPipFrameScale scale)
+{
+    switch (scale)
+    {
+    case GTK_PIP_FRAME_SCALE_BILINEAR:
+        return FRAME_SCALE_BILINEAR;
+    case GTK_PIP_FRAME_SCALE_BOX:
+        return FRAME_SCALE_BOX;
+    default:
+        g_critical("Invalid GtkPipFrameScale %d", scale);
+        return FRAME_SCALE_BILINEAR;
+    }
+}
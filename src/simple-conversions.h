@@ -15,11 +15,29 @@
 #include "xdg-shell-client.h"
 #include "xdg-pip-v1-client.h"
 #include "gtk-pip-shell.h"
+#include "frame-convert.h"
+#ifdef HAVE_CURSOR_SHAPE
+#include "cursor-shape-v1-client.h"
+#endif
+#ifdef HAVE_CONTENT_TYPE
+#include "content-type-v1-client.h"
+#endif
 #include <gdk/gdk.h>
 
 enum xdg_pip_v1_resize_edge gdk_get_resize_edge(GdkWindowEdge edge);
+enum xdg_pip_v1_corner gtk_pip_corner_get_xdg_pip_corner(GtkPipCorner corner);
+#ifdef HAVE_CURSOR_SHAPE
+enum wp_cursor_shape_device_v1_shape gdk_get_resize_cursor_shape(GdkWindowEdge edge);
+#endif
+#ifdef HAVE_CONTENT_TYPE
+enum wp_content_type_v1_type gtk_pip_content_type_get_wp_content_type(GtkPipContentType content_type);
+#endif
+// The CSS cursor name GTK uses for resizing from the edge
+const char *gdk_get_resize_cursor_name(GdkWindowEdge edge);
 enum xdg_positioner_gravity gdk_gravity_get_xdg_positioner_gravity (GdkGravity gravity);
 enum xdg_positioner_anchor gdk_gravity_get_xdg_positioner_anchor (GdkGravity anchor);
 enum xdg_positioner_constraint_adjustment gdk_anchor_hints_get_xdg_positioner_constraint_adjustment (GdkAnchorHints hints);
+FrameFormat gtk_pip_frame_format_get_frame_format (GtkPipFrameFormat format);
+FrameScale gtk_pip_frame_scale_get_frame_scale (GtkPipFrameScale scale);
 
 #endif // SIMPLE_CONVERSIONS_H
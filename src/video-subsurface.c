@@ -0,0 +1,218 @@
+/* This entire file is licensed under MIT
+ *
+ * Copyright 2020 Sophie Winter
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "video-subsurface.h"
+
+#ifdef HAVE_LINUX_DMABUF
+#include "linux-dmabuf-unstable-v1-client.h"
+#endif
+
+typedef struct
+{
+    VideoSubsurface *owner;
+#ifdef HAVE_LINUX_DMABUF
+    struct zwp_linux_buffer_params_v1 *params; // Until the compositor has imported the dmabuf, NULL after
+#endif
+    struct wl_buffer *wl_buffer; // NULL until the compositor has imported the dmabuf
+    int scale;
+    VideoFrameReleaseFunc release_func; // Can be NULL
+    void *release_data;
+} VideoFrame;
+
+struct _VideoSubsurface
+{
+    struct wl_surface *wl_surface;
+    struct wl_subsurface *wl_subsurface;
+    GSList *frames; // VideoFrame *, being imported or attached and not yet released by the compositor
+};
+
+static void
+video_frame_release(VideoFrame *frame)
+{
+#ifdef HAVE_LINUX_DMABUF
+    if (frame->params)
+        zwp_linux_buffer_params_v1_destroy(frame->params);
+#endif
+    if (frame->wl_buffer)
+        wl_buffer_destroy(frame->wl_buffer);
+    if (frame->release_func)
+        frame->release_func(frame->release_data);
+    g_free(frame);
+}
+
+static void
+video_frame_handle_buffer_release(void *data, struct wl_buffer *_buffer)
+{
+    (void)_buffer;
+
+    VideoFrame *frame = data;
+    frame->owner->frames = g_slist_remove(frame->owner->frames, frame);
+    video_frame_release(frame);
+}
+
+static const struct wl_buffer_listener video_frame_buffer_listener = {
+    .release = video_frame_handle_buffer_release,
+};
+
+#ifdef HAVE_LINUX_DMABUF
+static void
+video_frame_handle_params_created(void *data, struct zwp_linux_buffer_params_v1 *params, struct wl_buffer *wl_buffer)
+{
+    VideoFrame *frame = data;
+    VideoSubsurface *self = frame->owner;
+
+    zwp_linux_buffer_params_v1_destroy(params);
+    frame->params = NULL;
+    frame->wl_buffer = wl_buffer;
+    wl_buffer_add_listener(wl_buffer, &video_frame_buffer_listener, frame);
+
+    wl_surface_set_buffer_scale(self->wl_surface, frame->scale);
+    wl_surface_attach(self->wl_surface, wl_buffer, 0, 0);
+    wl_surface_damage(self->wl_surface, 0, 0, G_MAXINT32, G_MAXINT32);
+    wl_surface_commit(self->wl_surface);
+}
+
+static void
+video_frame_handle_params_failed(void *data, struct zwp_linux_buffer_params_v1 *_params)
+{
+    (void)_params;
+
+    // The frame was never shown, so it is released straight away and the last one stays on screen
+    VideoFrame *frame = data;
+    g_warning("The compositor failed to import a dmabuf frame");
+    frame->owner->frames = g_slist_remove(frame->owner->frames, frame);
+    video_frame_release(frame);
+}
+
+static const struct zwp_linux_buffer_params_v1_listener video_frame_params_listener = {
+    .created = video_frame_handle_params_created,
+    .failed = video_frame_handle_params_failed,
+};
+#endif
+
+VideoSubsurface *
+video_subsurface_new(struct wl_compositor *compositor,
+                     struct wl_subcompositor *subcompositor,
+                     struct wl_surface *parent)
+{
+    g_return_val_if_fail(compositor, NULL);
+    g_return_val_if_fail(subcompositor, NULL);
+    g_return_val_if_fail(parent, NULL);
+
+    VideoSubsurface *self = g_new0(VideoSubsurface, 1);
+    self->wl_surface = wl_compositor_create_surface(compositor);
+    self->wl_subsurface = wl_subcompositor_get_subsurface(subcompositor, self->wl_surface, parent);
+    wl_subsurface_set_position(self->wl_subsurface, 0, 0);
+    wl_subsurface_set_desync(self->wl_subsurface);
+
+    // Input goes through to the widgets GTK draws, such as playback controls
+    struct wl_region *input_region = wl_compositor_create_region(compositor);
+    wl_surface_set_input_region(self->wl_surface, input_region);
+    wl_region_destroy(input_region);
+
+    self->frames = NULL;
+    return self;
+}
+
+void
+video_subsurface_set_below(VideoSubsurface *self, struct wl_surface *parent, gboolean below)
+{
+    g_return_if_fail(self);
+    g_return_if_fail(parent);
+
+    if (below)
+        wl_subsurface_place_below(self->wl_subsurface, parent);
+    else
+        wl_subsurface_place_above(self->wl_subsurface, parent);
+}
+
+void
+video_subsurface_destroy(VideoSubsurface *self)
+{
+    g_return_if_fail(self);
+
+    wl_subsurface_destroy(self->wl_subsurface);
+    wl_surface_destroy(self->wl_surface);
+
+    // Once its buffer is destroyed the compositor can't release a frame, and frames still being imported will never be
+    // shown, so release them all here
+    g_slist_free_full(self->frames, (GDestroyNotify)video_frame_release);
+    g_free(self);
+}
+
+gboolean
+video_subsurface_show_dmabuf(VideoSubsurface *self,
+                             struct zwp_linux_dmabuf_v1 *linux_dmabuf,
+                             int width,
+                             int height,
+                             uint32_t fourcc,
+                             uint64_t modifier,
+                             int n_planes,
+                             const int *fds,
+                             const uint32_t *offsets,
+                             const uint32_t *strides,
+                             int scale,
+                             VideoFrameReleaseFunc release_func,
+                             void *release_data)
+{
+#ifdef HAVE_LINUX_DMABUF
+    g_return_val_if_fail(self, FALSE);
+    g_return_val_if_fail(linux_dmabuf, FALSE);
+    g_return_val_if_fail(width > 0 && height > 0, FALSE);
+    g_return_val_if_fail(n_planes > 0 && n_planes <= VIDEO_SUBSURFACE_MAX_PLANES, FALSE);
+    g_return_val_if_fail(fds && offsets && strides, FALSE);
+    g_return_val_if_fail(scale > 0, FALSE);
+    for (int i = 0; i < n_planes; i++)
+        g_return_val_if_fail(fds[i] >= 0, FALSE);
+
+    struct zwp_linux_buffer_params_v1 *params = zwp_linux_dmabuf_v1_create_params(linux_dmabuf);
+    for (int i = 0; i < n_planes; i++)
+        zwp_linux_buffer_params_v1_add(params,
+                                       fds[i],
+                                       i,
+                                       offsets[i],
+                                       strides[i],
+                                       (uint32_t)(modifier >> 32),
+                                       (uint32_t)(modifier & 0xffffffff));
+
+    VideoFrame *frame = g_new0(VideoFrame, 1);
+    frame->owner = self;
+    frame->params = params;
+    frame->wl_buffer = NULL;
+    // A frame that doesn't divide evenly by the scale is shown at scale 1 instead of being a protocol error
+    frame->scale = (width % scale == 0 && height % scale == 0) ? scale : 1;
+    frame->release_func = release_func;
+    frame->release_data = release_data;
+    self->frames = g_slist_prepend(self->frames, frame);
+
+    // The import can fail even for an advertised format (such as when the dmabuf is too small or the GPU can't read
+    // it), which create_immed would turn into a fatal protocol error. The frame is shown once the created event
+    // arrives, in the order the frames were set.
+    zwp_linux_buffer_params_v1_add_listener(params, &video_frame_params_listener, frame);
+    zwp_linux_buffer_params_v1_create(params, width, height, fourcc, 0);
+    return TRUE;
+#else
+    (void)self;
+    (void)linux_dmabuf;
+    (void)width;
+    (void)height;
+    (void)fourcc;
+    (void)modifier;
+    (void)n_planes;
+    (void)fds;
+    (void)offsets;
+    (void)strides;
+    (void)scale;
+    (void)release_func;
+    (void)release_data;
+    return FALSE;
+#endif
+}
@@ -0,0 +1,58 @@
+/* This entire file is licensed under MIT
+ *
+ * Copyright 2020 Sophie Winter
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef VIDEO_SUBSURFACE_H
+#define VIDEO_SUBSURFACE_H
+
+#include <glib.h>
+#include <wayland-client.h>
+
+struct zwp_linux_dmabuf_v1;
+
+#define VIDEO_SUBSURFACE_MAX_PLANES 4
+
+// A desynchronized subsurface in the top left corner of a pip, that shows dmabuf frames without copying them
+// Frames are committed as soon as the compositor has imported them, so they don't wait for GTK to repaint the window
+// The subsurface starts out above its parent, so it covers whatever GTK draws there
+typedef struct _VideoSubsurface VideoSubsurface;
+
+// Called once the compositor releases a frame, or the subsurface is destroyed while the frame is still held
+typedef void (*VideoFrameReleaseFunc) (void *data);
+
+// The subsurface only becomes part of parent once parent is committed
+VideoSubsurface *video_subsurface_new (struct wl_compositor *compositor,
+                                       struct wl_subcompositor *subcompositor,
+                                       struct wl_surface *parent);
+
+// Restacks the subsurface directly below or above parent, which takes effect on parent's next commit
+void video_subsurface_set_below (VideoSubsurface *self, struct wl_surface *parent, gboolean below);
+
+// Destroys the Wayland objects and releases every frame that is still held
+void video_subsurface_destroy (VideoSubsurface *self);
+
+// The format must be one linux_dmabuf advertised. Plane fds are duplicated by libwayland, so they still belong to the
+// caller. Returns FALSE if the arguments are invalid. If the compositor then fails to import the dmabuf, the frame is
+// released without being shown.
+gboolean video_subsurface_show_dmabuf (VideoSubsurface *self,
+                                       struct zwp_linux_dmabuf_v1 *linux_dmabuf,
+                                       int width,
+                                       int height,
+                                       uint32_t fourcc,
+                                       uint64_t modifier,
+                                       int n_planes,
+                                       const int *fds,
+                                       const uint32_t *offsets,
+                                       const uint32_t *strides,
+                                       int scale,
+                                       VideoFrameReleaseFunc release_func,
+                                       void *release_data);
+
+#endif // VIDEO_SUBSURFACE_H
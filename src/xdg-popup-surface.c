@@ -239,20 +239,10 @@ xdg_popup_surface_get_logical_geom (CustomShellSurface *super)
     return self->geom;
 }
 
-static const CustomShellSurfaceVirtual xdg_popup_surface_virtual = {
-    .map = xdg_popup_surface_map,
-    .unmap = xdg_popup_surface_unmap,
-    .finalize = xdg_popup_surface_finalize,
-    .get_popup = xdg_popup_surface_get_popup,
-    .get_logical_geom = xdg_popup_surface_get_logical_geom,
-};
-
 static void
-xdg_popup_surface_on_size_allocate (GtkWidget *_widget,
-                                    GdkRectangle *allocation,
-                                    XdgPopupSurface *self)
+xdg_popup_surface_size_allocate (CustomShellSurface *super, GdkRectangle *allocation)
 {
-    (void)_widget;
+    XdgPopupSurface *self = (XdgPopupSurface *)super;
 
     if (self->xdg_surface && !gdk_rectangle_equal (&self->cached_allocation, allocation)) {
         self->cached_allocation = *allocation;
@@ -267,6 +257,15 @@ xdg_popup_surface_on_size_allocate (GtkWidget *_widget,
     }
 }
 
+static const CustomShellSurfaceVirtual xdg_popup_surface_virtual = {
+    .map = xdg_popup_surface_map,
+    .unmap = xdg_popup_surface_unmap,
+    .finalize = xdg_popup_surface_finalize,
+    .size_allocate = xdg_popup_surface_size_allocate,
+    .get_popup = xdg_popup_surface_get_popup,
+    .get_logical_geom = xdg_popup_surface_get_logical_geom,
+};
+
 XdgPopupSurface *
 xdg_popup_surface_new (GtkWindow *gtk_window, XdgPopupPosition const* position)
 {
@@ -286,8 +285,6 @@ xdg_popup_surface_new (GtkWindow *gtk_window, XdgPopupPosition const* position)
     self->xdg_surface = NULL;
     self->xdg_popup = NULL;
 
-    g_signal_connect (gtk_window, "size-allocate", G_CALLBACK (xdg_popup_surface_on_size_allocate), self);
-
     return self;
 }
 
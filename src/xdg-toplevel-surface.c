@@ -159,20 +159,10 @@ xdg_toplevel_surface_get_logical_geom (CustomShellSurface *super)
     return self->geom;
 }
 
-static const CustomShellSurfaceVirtual xdg_toplevel_surface_virtual = {
-    .map = xdg_toplevel_surface_map,
-    .unmap = xdg_toplevel_surface_unmap,
-    .finalize = xdg_toplevel_surface_finalize,
-    .get_popup = xdg_toplevel_surface_get_popup,
-    .get_logical_geom = xdg_toplevel_surface_get_logical_geom,
-};
-
 static void
-xdg_toplevel_surface_on_size_allocate (GtkWidget *_widget,
-                                       GdkRectangle *allocation,
-                                       XdgToplevelSurface *self)
+xdg_toplevel_surface_size_allocate (CustomShellSurface *super, GdkRectangle *allocation)
 {
-    (void)_widget;
+    XdgToplevelSurface *self = (XdgToplevelSurface *)super;
 
     if (self->xdg_surface && !gdk_rectangle_equal (&self->cached_allocation, allocation)) {
         self->cached_allocation = *allocation;
@@ -187,6 +177,15 @@ xdg_toplevel_surface_on_size_allocate (GtkWidget *_widget,
     }
 }
 
+static const CustomShellSurfaceVirtual xdg_toplevel_surface_virtual = {
+    .map = xdg_toplevel_surface_map,
+    .unmap = xdg_toplevel_surface_unmap,
+    .finalize = xdg_toplevel_surface_finalize,
+    .size_allocate = xdg_toplevel_surface_size_allocate,
+    .get_popup = xdg_toplevel_surface_get_popup,
+    .get_logical_geom = xdg_toplevel_surface_get_logical_geom,
+};
+
 XdgToplevelSurface *
 xdg_toplevel_surface_new (GtkWindow *gtk_window)
 {
@@ -206,7 +205,6 @@ xdg_toplevel_surface_new (GtkWindow *gtk_window)
     self->xdg_toplevel = NULL;
 
     gtk_window_set_decorated (gtk_window, FALSE);
-    g_signal_connect (gtk_window, "size-allocate", G_CALLBACK (xdg_toplevel_surface_on_size_allocate), self);
 
     return self;
 }
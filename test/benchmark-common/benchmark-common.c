@@ -0,0 +1,104 @@
+/* This entire file is licensed under MIT
+ *
+ * Copyright 2020 Sophie Winter
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "benchmark-common.h"
+
+#include <sys/resource.h>
+#include <dirent.h>
+
+long benchmark_soak_cycles = 0;
+
+gint64 benchmark_time_us()
+{
+    return g_get_monotonic_time();
+}
+
+long benchmark_rss_kb()
+{
+    long size = 0, resident = 0;
+    FILE* statm = fopen("/proc/self/statm", "r");
+    if (!statm)
+        return 0;
+    if (fscanf(statm, "%ld %ld", &size, &resident) != 2)
+        resident = 0;
+    fclose(statm);
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+long benchmark_minor_faults()
+{
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+    return usage.ru_minflt;
+}
+
+long benchmark_open_fds()
+{
+    DIR* dir = opendir("/proc/self/fd");
+    if (!dir)
+        return 0;
+    long count = 0;
+    struct dirent* entry;
+    while ((entry = readdir(dir)))
+    {
+        if (entry->d_name[0] != '.')
+            count++;
+    }
+    closedir(dir);
+    // Don't count the fd used to read the directory
+    return count - 1;
+}
+
+static guint gobject_instances_of(GType type)
+{
+    guint count = g_type_get_instance_count(type);
+    guint n_children;
+    GType* children = g_type_children(type, &n_children);
+    for (guint i = 0; i < n_children; i++)
+        count += gobject_instances_of(children[i]);
+    g_free(children);
+    return count;
+}
+
+guint benchmark_gobject_instances()
+{
+    return gobject_instances_of(G_TYPE_OBJECT);
+}
+
+void benchmark_roundtrip()
+{
+    wl_display_roundtrip(gdk_wayland_display_get_wl_display(gdk_display_get_default()));
+}
+
+void benchmark_flush_main_loop()
+{
+    benchmark_roundtrip();
+    while (gtk_events_pending())
+        gtk_main_iteration();
+}
+
+int main(int argc, char** argv)
+{
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--soak") == 0 && i + 1 < argc)
+            benchmark_soak_cycles = atol(argv[++i]);
+    }
+
+    gtk_init(0, NULL);
+
+    for (int i = 0; benchmark_callbacks[i]; i++) {
+        benchmark_callbacks[i]();
+        benchmark_flush_main_loop();
+    }
+
+    return 0;
+}
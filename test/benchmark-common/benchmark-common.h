@@ -0,0 +1,54 @@
+/* This entire file is licensed under MIT
+ *
+ * Copyright 2020 Sophie Winter
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef BENCHMARK_COMMON_H
+#define BENCHMARK_COMMON_H
+
+#include "gtk-pip-shell.h"
+#include "test-common.h"
+#include <gtk/gtk.h>
+#include <gdk/gdk.h>
+#include <gdk/gdkwayland.h>
+#include <stdio.h>
+
+// NULL-terminated list of benchmarks that are run in order
+// Should be defined in the benchmark file using BENCHMARK_CALLBACKS()
+extern void (* benchmark_callbacks[])(void);
+
+// Input is a sequence of callback names with a trailing comma
+#define BENCHMARK_CALLBACKS(...) void (* benchmark_callbacks[])(void) = {__VA_ARGS__ NULL};
+
+// Set with --soak <cycles> (the runner's --soak option passes it on), 0 otherwise
+// Benchmarks that support soaking run this many cycles instead of their usual amount
+extern long benchmark_soak_cycles;
+
+// Monotonic time in microseconds
+gint64 benchmark_time_us();
+
+// Resident set size of this process in kilobytes
+long benchmark_rss_kb();
+
+// Minor page faults this process has taken so far
+long benchmark_minor_faults();
+
+// File descriptors this process has open
+long benchmark_open_fds();
+
+// Live instances of every GObject type, only counted when GOBJECT_DEBUG=instance-count is set (else returns 0)
+guint benchmark_gobject_instances();
+
+// Blocks until the compositor has processed all requests sent so far
+void benchmark_roundtrip();
+
+// Runs the GTK main loop until there is nothing left for it to do
+void benchmark_flush_main_loop();
+
+#endif // BENCHMARK_COMMON_H
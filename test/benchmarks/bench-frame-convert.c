@@ -0,0 +1,98 @@
+/* This entire file is licensed under MIT
+ *
+ * Copyright 2020 Sophie Winter
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "benchmark-common.h"
+#include "frame-convert.h"
+
+// Measures converting and scaling a 1080p video frame into a pip sized buffer with each kernel the CPU supports
+
+#define SRC_WIDTH 1920
+#define SRC_HEIGHT 1080
+#define DEST_WIDTH 640
+#define DEST_HEIGHT 360
+
+static const int iterations = 50;
+
+static uint8_t* y_plane;
+static uint8_t* u_plane;
+static uint8_t* v_plane;
+static uint8_t* uv_plane;
+static uint8_t* dest;
+
+static void run_conversion(const FrameConvertKernels* kernels, FrameFormat format, FrameScale scale)
+{
+    const uint8_t* i420_planes[] = {y_plane, u_plane, v_plane};
+    const int i420_strides[] = {SRC_WIDTH, SRC_WIDTH / 2, SRC_WIDTH / 2};
+    const uint8_t* nv12_planes[] = {y_plane, uv_plane};
+    const int nv12_strides[] = {SRC_WIDTH, SRC_WIDTH};
+    int is_i420 = (format == FRAME_FORMAT_I420);
+
+    gint64 start = benchmark_time_us();
+    for (int i = 0; i < iterations; i++) {
+        frame_convert(
+            kernels, format,
+            is_i420 ? i420_planes : nv12_planes,
+            is_i420 ? i420_strides : nv12_strides,
+            SRC_WIDTH, SRC_HEIGHT,
+            scale,
+            dest, DEST_WIDTH * 4, DEST_WIDTH, DEST_HEIGHT);
+    }
+    gint64 elapsed = benchmark_time_us() - start;
+
+    char name[64];
+    snprintf(name, sizeof(name), "%s-%s-%s",
+             kernels->name,
+             is_i420 ? "i420" : "nv12",
+             scale == FRAME_SCALE_BILINEAR ? "bilinear" : "box");
+    BENCHMARK_REPORT(name, "%" G_GINT64_FORMAT, elapsed / iterations, "us/frame");
+}
+
+static void setup()
+{
+    y_plane = g_malloc(SRC_WIDTH * SRC_HEIGHT);
+    u_plane = g_malloc(SRC_WIDTH / 2 * SRC_HEIGHT / 2);
+    v_plane = g_malloc(SRC_WIDTH / 2 * SRC_HEIGHT / 2);
+    uv_plane = g_malloc(SRC_WIDTH * SRC_HEIGHT / 2);
+    dest = g_malloc(DEST_WIDTH * DEST_HEIGHT * 4);
+    for (int i = 0; i < SRC_WIDTH * SRC_HEIGHT; i++)
+        y_plane[i] = g_random_int_range(0, 256);
+    for (int i = 0; i < SRC_WIDTH / 2 * SRC_HEIGHT / 2; i++) {
+        u_plane[i] = uv_plane[2 * i] = g_random_int_range(0, 256);
+        v_plane[i] = uv_plane[2 * i + 1] = g_random_int_range(0, 256);
+    }
+    BENCHMARK_REPORT("selected-kernel", "%s", frame_convert_get_kernels()->name, "");
+}
+
+static void convert_all_kernels()
+{
+    const FrameConvertKernels* const* kernels = frame_convert_get_supported_kernels();
+    for (int k = 0; kernels[k]; k++) {
+        run_conversion(kernels[k], FRAME_FORMAT_I420, FRAME_SCALE_BILINEAR);
+        run_conversion(kernels[k], FRAME_FORMAT_I420, FRAME_SCALE_BOX);
+        run_conversion(kernels[k], FRAME_FORMAT_NV12, FRAME_SCALE_BILINEAR);
+        run_conversion(kernels[k], FRAME_FORMAT_NV12, FRAME_SCALE_BOX);
+    }
+}
+
+static void teardown()
+{
+    g_free(y_plane);
+    g_free(u_plane);
+    g_free(v_plane);
+    g_free(uv_plane);
+    g_free(dest);
+}
+
+BENCHMARK_CALLBACKS(
+    setup,
+    convert_all_kernels,
+    teardown,
+)
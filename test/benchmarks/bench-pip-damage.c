@@ -0,0 +1,98 @@
+/* This entire file is licensed under MIT
+ *
+ * Copyright 2020 Sophie Winter
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "benchmark-common.h"
+
+// Measures how much of a pip window is damaged per commit when only a small overlay (such as a timestamp) changes, and
+// when only the surface state changes. The mock server reports the damaged area per pip surface, named by app ID.
+
+static const int frame_count = 60;
+
+typedef struct
+{
+    GtkWindow* window;
+    GtkWidget* overlay;
+} DamageWindow;
+
+static DamageWindow create_damage_window(const char* app_id)
+{
+    DamageWindow result;
+    result.window = GTK_WINDOW(gtk_window_new(GTK_WINDOW_TOPLEVEL));
+    gtk_pip_init_for_window(result.window);
+    gtk_pip_set_app_id(result.window, app_id);
+    GtkWidget* box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 0);
+    GtkWidget* video = gtk_drawing_area_new();
+    gtk_widget_set_size_request(video, DEFAULT_PIP_WIDTH, DEFAULT_PIP_HEIGHT - 20);
+    result.overlay = gtk_label_new("00:00");
+    gtk_box_pack_start(GTK_BOX(box), video, TRUE, TRUE, 0);
+    gtk_box_pack_start(GTK_BOX(box), result.overlay, FALSE, FALSE, 0);
+    gtk_container_add(GTK_CONTAINER(result.window), box);
+    gtk_widget_show_all(GTK_WIDGET(result.window));
+    benchmark_flush_main_loop();
+    return result;
+}
+
+static void destroy_damage_window(DamageWindow* damage_window)
+{
+    gtk_widget_destroy(GTK_WIDGET(damage_window->window));
+    benchmark_flush_main_loop();
+}
+
+static void report_frame_time(const char* name, gint64 elapsed)
+{
+    BENCHMARK_REPORT(name, "%" G_GINT64_FORMAT, elapsed / frame_count, "us/frame");
+}
+
+static void full_window_redraw()
+{
+    DamageWindow damage_window = create_damage_window("bench-full-window-redraw");
+    gint64 start = benchmark_time_us();
+    for (int i = 0; i < frame_count; i++) {
+        gtk_widget_queue_draw(GTK_WIDGET(damage_window.window));
+        benchmark_flush_main_loop();
+    }
+    report_frame_time("full-window-redraw", benchmark_time_us() - start);
+    destroy_damage_window(&damage_window);
+}
+
+static void overlay_redraw()
+{
+    DamageWindow damage_window = create_damage_window("bench-overlay-redraw");
+    gint64 start = benchmark_time_us();
+    for (int i = 0; i < frame_count; i++) {
+        char text[16];
+        snprintf(text, sizeof(text), "00:%02d", i);
+        gtk_label_set_text(GTK_LABEL(damage_window.overlay), text);
+        benchmark_flush_main_loop();
+    }
+    report_frame_time("overlay-redraw", benchmark_time_us() - start);
+    destroy_damage_window(&damage_window);
+}
+
+static void state_change()
+{
+    DamageWindow damage_window = create_damage_window("bench-state-change");
+    gint64 start = benchmark_time_us();
+    for (int i = 0; i < frame_count; i++) {
+        // Each change needs a commit, but does not change the contents
+        GdkRectangle rect = {0, 0, DEFAULT_PIP_WIDTH, i % 2 ? DEFAULT_PIP_HEIGHT : 20};
+        gtk_pip_set_input_rect(damage_window.window, &rect);
+        benchmark_flush_main_loop();
+    }
+    report_frame_time("state-change", benchmark_time_us() - start);
+    destroy_damage_window(&damage_window);
+}
+
+BENCHMARK_CALLBACKS(
+    full_window_redraw,
+    overlay_redraw,
+    state_change,
+)
@@ -0,0 +1,132 @@
+/* This entire file is licensed under MIT
+ *
+ * Copyright 2020 Sophie Winter
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "benchmark-common.h"
+
+// Measures how long it takes to get a pip back on screen after the compositor dismissed it, when dismissal closes the
+// window (so the app has to build a new one) and when it only hides it. The window has a widget tree along the lines
+// of a video player's controls. The mock server dismisses each pip as soon as it has placed it, so a window counts as
+// back on screen once it has been dismissed again.
+
+static const int reopen_count = 10;
+static const int chapter_count = 48;
+
+static GtkWindow* build_player(GtkPipDismissPolicy policy)
+{
+    GtkWindow* window = GTK_WINDOW(gtk_window_new(GTK_WINDOW_TOPLEVEL));
+    gtk_pip_init_for_window(window);
+    gtk_pip_set_app_id(window, "bench-dismiss-reopen" PIP_DISMISS_APP_ID_SUFFIX);
+    gtk_pip_set_dismiss_policy(window, policy);
+
+    GtkWidget* box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 4);
+    GtkWidget* video = gtk_drawing_area_new();
+    gtk_widget_set_size_request(video, 160, 90);
+    gtk_box_pack_start(GTK_BOX(box), video, TRUE, TRUE, 0);
+
+    GtkWidget* controls = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 2);
+    const char* icons[] = {"media-skip-backward", "media-playback-start", "media-skip-forward", "audio-volume-high"};
+    for (size_t i = 0; i < G_N_ELEMENTS(icons); i++) {
+        GtkWidget* button = gtk_button_new_from_icon_name(icons[i], GTK_ICON_SIZE_BUTTON);
+        gtk_box_pack_start(GTK_BOX(controls), button, FALSE, FALSE, 0);
+    }
+    gtk_box_pack_start(GTK_BOX(controls), gtk_label_new("00:00:00"), FALSE, FALSE, 0);
+    GtkWidget* seek = gtk_scale_new_with_range(GTK_ORIENTATION_HORIZONTAL, 0, 100, 1);
+    gtk_box_pack_start(GTK_BOX(controls), seek, TRUE, TRUE, 0);
+    gtk_box_pack_start(GTK_BOX(controls), gtk_label_new("01:42:17"), FALSE, FALSE, 0);
+    gtk_box_pack_start(GTK_BOX(box), controls, FALSE, FALSE, 0);
+
+    GtkWidget* chapters = gtk_flow_box_new();
+    for (int i = 0; i < chapter_count; i++) {
+        char markup[64];
+        snprintf(markup, sizeof(markup), "<small><b>%d</b> Chapter <i>%d</i></small>", i + 1, i + 1);
+        GtkWidget* label = gtk_label_new(NULL);
+        gtk_label_set_markup(GTK_LABEL(label), markup);
+        gtk_container_add(GTK_CONTAINER(chapters), label);
+    }
+    gtk_box_pack_start(GTK_BOX(box), chapters, FALSE, FALSE, 0);
+
+    gtk_container_add(GTK_CONTAINER(window), box);
+    return window;
+}
+
+static void on_pip_dismissed(GtkWindow* _window, gpointer dismissed_count)
+{
+    (void)_window;
+    (*(int*)dismissed_count)++;
+}
+
+static void on_destroy(GtkWidget* _widget, gboolean* destroyed)
+{
+    (void)_widget;
+    *destroyed = TRUE;
+}
+
+// Shows the window and waits until the mock server has placed (and so dismissed) it
+static void show_until_dismissed(GtkWindow* window, int* dismissed_count)
+{
+    int before = *dismissed_count;
+    gtk_widget_show_all(GTK_WIDGET(window));
+    while (*dismissed_count == before) {
+        benchmark_roundtrip();
+        benchmark_flush_main_loop();
+    }
+}
+
+static void report(const char* name, gint64 elapsed)
+{
+    char report_name[64];
+    snprintf(report_name, sizeof(report_name), "%s-reopen-to-placed", name);
+    BENCHMARK_REPORT(report_name, "%" G_GINT64_FORMAT, elapsed / reopen_count, "us/reopen");
+}
+
+static void close_policy()
+{
+    int dismissed_count = 0;
+    gint64 elapsed = 0;
+    // The first window pays for loading the theme and icons, which a real app would have done long before
+    for (int i = 0; i <= reopen_count; i++) {
+        gboolean destroyed = FALSE;
+        gint64 start = benchmark_time_us();
+        GtkWindow* window = build_player(GTK_PIP_DISMISS_POLICY_CLOSE);
+        gtk_pip_set_dismissed_callback(window, on_pip_dismissed, &dismissed_count, NULL);
+        g_signal_connect(window, "destroy", G_CALLBACK(on_destroy), &destroyed);
+        show_until_dismissed(window, &dismissed_count);
+        if (i > 0)
+            elapsed += benchmark_time_us() - start;
+
+        while (!destroyed)
+            benchmark_flush_main_loop();
+    }
+    report("close-policy", elapsed);
+}
+
+static void hide_policy()
+{
+    int dismissed_count = 0;
+    gint64 elapsed = 0;
+    GtkWindow* window = build_player(GTK_PIP_DISMISS_POLICY_HIDE);
+    gtk_pip_set_dismissed_callback(window, on_pip_dismissed, &dismissed_count, NULL);
+    show_until_dismissed(window, &dismissed_count);
+    for (int i = 0; i < reopen_count; i++) {
+        gint64 start = benchmark_time_us();
+        show_until_dismissed(window, &dismissed_count);
+        elapsed += benchmark_time_us() - start;
+        ASSERT(!gtk_widget_get_visible(GTK_WIDGET(window)));
+    }
+    report("hide-policy", elapsed);
+    gtk_widget_destroy(GTK_WIDGET(window));
+    benchmark_flush_main_loop();
+}
+
+BENCHMARK_CALLBACKS(
+    close_policy,
+    hide_policy,
+)
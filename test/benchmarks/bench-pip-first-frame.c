@@ -0,0 +1,69 @@
+/* This entire file is licensed under MIT
+ *
+ * Copyright 2020 Sophie Winter
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "benchmark-common.h"
+
+// Measures how long a pip window takes to become visible after gtk_widget_show (), with and without a pre-rendered
+// first buffer. A window counts as visible once the mock server has placed it, which it does on the first commit with
+// a buffer. The mock server also reports the time from role creation to the first buffer for each window.
+
+static const int window_count = 10;
+
+static void measure(const char* name, gboolean prepare_offscreen)
+{
+    struct wl_display* wl_display = gdk_wayland_display_get_wl_display(gdk_display_get_default());
+    int roundtrip_count = 0;
+    gint64 elapsed = 0;
+    for (int i = 0; i < window_count; i++) {
+        GtkWindow* window = GTK_WINDOW(gtk_window_new(GTK_WINDOW_TOPLEVEL));
+        gtk_container_add(GTK_CONTAINER(window), gtk_label_new("Picture in picture"));
+        // The first configure has the placed size, the pre-rendered buffer is only used if it matches
+        gtk_widget_set_size_request(GTK_WIDGET(window), DEFAULT_PIP_WIDTH, DEFAULT_PIP_HEIGHT);
+        gtk_pip_init_for_window(window);
+        gtk_pip_set_app_id(window, name);
+        gtk_pip_set_prepare_offscreen(window, prepare_offscreen);
+
+        gint64 start = benchmark_time_us();
+        gtk_widget_show_all(GTK_WIDGET(window));
+        // The main loop only runs between roundtrips, so GTK gets one frame per roundtrip
+        while (!gtk_pip_get_monitor(window)) {
+            wl_display_roundtrip(wl_display);
+            roundtrip_count++;
+            if (!gtk_pip_get_monitor(window))
+                benchmark_flush_main_loop();
+        }
+        elapsed += benchmark_time_us() - start;
+
+        gtk_widget_destroy(GTK_WIDGET(window));
+        benchmark_flush_main_loop();
+    }
+
+    char report_name[64];
+    snprintf(report_name, sizeof(report_name), "%s-show-to-visible", name);
+    BENCHMARK_REPORT(report_name, "%" G_GINT64_FORMAT, elapsed / window_count, "us/window");
+    snprintf(report_name, sizeof(report_name), "%s-roundtrips-to-visible", name);
+    BENCHMARK_REPORT(report_name, "%.2f", (double)roundtrip_count / window_count, "roundtrips/window");
+}
+
+static void gtk_first_frame()
+{
+    measure("gtk-first-frame", FALSE);
+}
+
+static void offscreen_first_frame()
+{
+    measure("offscreen-first-frame", TRUE);
+}
+
+BENCHMARK_CALLBACKS(
+    gtk_first_frame,
+    offscreen_first_frame,
+)
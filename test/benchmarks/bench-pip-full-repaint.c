@@ -0,0 +1,70 @@
+/* This entire file is licensed under MIT
+ *
+ * Copyright 2020 Sophie Winter
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "benchmark-common.h"
+
+// Measures how many bytes GDK copies from the previous buffer per frame when only a small overlay changes, with and
+// without full repaint mode. The mock server holds each buffer until the next one is committed, so every frame is drawn
+// into a new one.
+
+static const int frame_count = 60;
+
+static void overlay_redraw(const char* name, gboolean full_repaint)
+{
+    GtkWindow* window = GTK_WINDOW(gtk_window_new(GTK_WINDOW_TOPLEVEL));
+    gtk_pip_init_for_window(window);
+    gtk_pip_set_app_id(window, name);
+    gtk_pip_set_full_repaint(window, full_repaint);
+    GtkWidget* box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 0);
+    GtkWidget* video = gtk_drawing_area_new();
+    gtk_widget_set_size_request(video, DEFAULT_PIP_WIDTH, DEFAULT_PIP_HEIGHT - 20);
+    GtkWidget* overlay = gtk_label_new("00:00");
+    gtk_box_pack_start(GTK_BOX(box), video, TRUE, TRUE, 0);
+    gtk_box_pack_start(GTK_BOX(box), overlay, FALSE, FALSE, 0);
+    gtk_container_add(GTK_CONTAINER(window), box);
+    gtk_widget_show_all(GTK_WIDGET(window));
+    benchmark_flush_main_loop();
+
+    guint64 start_bytes = gtk_pip_get_backfill_bytes(window);
+    gint64 start = benchmark_time_us();
+    for (int i = 0; i < frame_count; i++) {
+        char text[16];
+        snprintf(text, sizeof(text), "00:%02d", i);
+        gtk_label_set_text(GTK_LABEL(overlay), text);
+        benchmark_flush_main_loop();
+    }
+    gint64 elapsed = benchmark_time_us() - start;
+    guint64 copied = gtk_pip_get_backfill_bytes(window) - start_bytes;
+
+    char report_name[256];
+    snprintf(report_name, sizeof(report_name), "%s-backfill", name);
+    BENCHMARK_REPORT(report_name, "%" G_GUINT64_FORMAT, copied / frame_count, "bytes/frame");
+    snprintf(report_name, sizeof(report_name), "%s-frame-time", name);
+    BENCHMARK_REPORT(report_name, "%" G_GINT64_FORMAT, elapsed / frame_count, "us/frame");
+
+    gtk_widget_destroy(GTK_WIDGET(window));
+    benchmark_flush_main_loop();
+}
+
+static void partial_repaint()
+{
+    overlay_redraw("bench-partial-repaint", FALSE);
+}
+
+static void full_repaint()
+{
+    overlay_redraw("bench-full-repaint", TRUE);
+}
+
+BENCHMARK_CALLBACKS(
+    partial_repaint,
+    full_repaint,
+)
@@ -0,0 +1,92 @@
+/* This entire file is licensed under MIT
+ *
+ * Copyright 2020 Sophie Winter
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "benchmark-common.h"
+
+// Measures how the time and memory needed to bring up a set of pip windows grow with the number of windows, both when
+// each window is shown on its own and when they are shown together with a GtkPipGroup
+
+static const int window_counts[] = {1, 4, 16, 32};
+
+static GtkWindow* create_pip_window()
+{
+    GtkWindow* window = GTK_WINDOW(gtk_window_new(GTK_WINDOW_TOPLEVEL));
+    gtk_container_add(GTK_CONTAINER(window), gtk_label_new("Picture-in-picture"));
+    return window;
+}
+
+static void run_startup(int count, gboolean grouped)
+{
+    GtkPipGroup* group = gtk_pip_group_new();
+    GtkWindow** windows = g_new0(GtkWindow*, count);
+
+    long rss_before = benchmark_rss_kb();
+    gint64 start = benchmark_time_us();
+
+    for (int i = 0; i < count; i++) {
+        windows[i] = create_pip_window();
+        if (grouped)
+            gtk_pip_group_add_window(group, windows[i]);
+        else
+            gtk_pip_init_for_window(windows[i]);
+    }
+    if (grouped) {
+        gtk_pip_group_show_all(group);
+    } else {
+        for (int i = 0; i < count; i++)
+            gtk_widget_show_all(GTK_WIDGET(windows[i]));
+    }
+    benchmark_flush_main_loop();
+
+    gint64 elapsed = benchmark_time_us() - start;
+    long rss = benchmark_rss_kb() - rss_before;
+
+    char name[64];
+    snprintf(name, sizeof(name), "%s-startup-%d-windows", grouped ? "grouped" : "ungrouped", count);
+    BENCHMARK_REPORT(name, "%" G_GINT64_FORMAT, elapsed, "us");
+    snprintf(name, sizeof(name), "%s-memory-%d-windows", grouped ? "grouped" : "ungrouped", count);
+    BENCHMARK_REPORT(name, "%ld", rss, "KiB");
+
+    if (grouped) {
+        gtk_pip_group_destroy_all(group);
+    } else {
+        for (int i = 0; i < count; i++)
+            gtk_widget_destroy(GTK_WIDGET(windows[i]));
+    }
+    benchmark_flush_main_loop();
+
+    g_free(windows);
+    gtk_pip_group_free(group);
+}
+
+static void warm_up()
+{
+    // The first window pays for loading themes, fonts and such, which would skew the first measurement
+    run_startup(1, FALSE);
+}
+
+static void ungrouped()
+{
+    for (size_t i = 0; i < G_N_ELEMENTS(window_counts); i++)
+        run_startup(window_counts[i], FALSE);
+}
+
+static void grouped()
+{
+    for (size_t i = 0; i < G_N_ELEMENTS(window_counts); i++)
+        run_startup(window_counts[i], TRUE);
+}
+
+BENCHMARK_CALLBACKS(
+    warm_up,
+    ungrouped,
+    grouped,
+)
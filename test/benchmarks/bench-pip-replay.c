@@ -0,0 +1,98 @@
+/* This entire file is licensed under MIT
+ *
+ * Copyright 2020 Sophie Winter
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "benchmark-common.h"
+#include <poll.h>
+
+// Replays a recorded event trace (given to the mock server with --replay, see test/meson.build) against a pip window,
+// and measures the time spent dispatching the events (which is where pip_surface_handle_configure () runs) separately
+// from the layout and painting GTK does in response. The mock server dismisses the pip once the trace is done.
+
+static gboolean window_destroyed = FALSE;
+static gint64 paint_start = 0;
+static gint64 paint_us = 0;
+static int frame_count = 0;
+
+static void on_before_paint(GdkFrameClock* _clock, gpointer _data)
+{
+    (void)_clock; (void)_data;
+    paint_start = benchmark_time_us();
+}
+
+static void on_after_paint(GdkFrameClock* _clock, gpointer _data)
+{
+    (void)_clock; (void)_data;
+    paint_us += benchmark_time_us() - paint_start;
+    frame_count++;
+}
+
+static void on_destroy(GtkWidget* _widget, gpointer _data)
+{
+    (void)_widget; (void)_data;
+    window_destroyed = TRUE;
+}
+
+// Reads and dispatches events ourselves, so their handlers can be timed apart from GTK's main loop
+static gint64 read_and_dispatch(struct wl_display* wl_display)
+{
+    gint64 dispatch_us = 0;
+    while (wl_display_prepare_read(wl_display) != 0) {
+        gint64 start = benchmark_time_us();
+        wl_display_dispatch_pending(wl_display);
+        dispatch_us += benchmark_time_us() - start;
+    }
+    wl_display_flush(wl_display);
+
+    struct pollfd fd = {wl_display_get_fd(wl_display), POLLIN, 0};
+    if (poll(&fd, 1, 5000) <= 0) {
+        wl_display_cancel_read(wl_display);
+        FATAL("timed out waiting for the replay, is the mock server running with --replay?");
+    }
+    wl_display_read_events(wl_display);
+
+    gint64 start = benchmark_time_us();
+    wl_display_dispatch_pending(wl_display);
+    return dispatch_us + benchmark_time_us() - start;
+}
+
+static void replay()
+{
+    struct wl_display* wl_display = gdk_wayland_display_get_wl_display(gdk_display_get_default());
+    GtkWindow* window = GTK_WINDOW(gtk_window_new(GTK_WINDOW_TOPLEVEL));
+    gtk_container_add(GTK_CONTAINER(window), gtk_label_new("Picture in picture"));
+    gtk_pip_init_for_window(window);
+    gtk_pip_set_app_id(window, "bench-pip-replay");
+    g_signal_connect(window, "destroy", G_CALLBACK(on_destroy), NULL);
+    gtk_widget_show_all(GTK_WIDGET(window));
+
+    GdkFrameClock* frame_clock = gtk_widget_get_frame_clock(GTK_WIDGET(window));
+    g_signal_connect(frame_clock, "before-paint", G_CALLBACK(on_before_paint), NULL);
+    g_signal_connect(frame_clock, "after-paint", G_CALLBACK(on_after_paint), NULL);
+
+    // The replay starts once the pip has been placed, and ends with it being dismissed
+    gint64 dispatch_us = 0;
+    gint64 start = benchmark_time_us();
+    while (!window_destroyed) {
+        dispatch_us += read_and_dispatch(wl_display);
+        while (gtk_events_pending() && !window_destroyed)
+            gtk_main_iteration();
+    }
+    gint64 elapsed = benchmark_time_us() - start;
+
+    BENCHMARK_REPORT("replay-client-wall-time", "%" G_GINT64_FORMAT, elapsed, "us");
+    BENCHMARK_REPORT("replay-event-dispatch", "%" G_GINT64_FORMAT, dispatch_us, "us");
+    BENCHMARK_REPORT("replay-frames", "%d", frame_count, "frames");
+    BENCHMARK_REPORT("replay-layout-and-paint", "%" G_GINT64_FORMAT, frame_count ? paint_us / frame_count : 0, "us/frame");
+}
+
+BENCHMARK_CALLBACKS(
+    replay,
+)
@@ -0,0 +1,126 @@
+/* This entire file is licensed under MIT
+ *
+ * Copyright 2020 Sophie Winter
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#define _GNU_SOURCE // For memfd_create ()
+
+#include "benchmark-common.h"
+
+// Measures the shared memory syscalls and page faults per step of an interactive resize, with GDK's own buffers and
+// with the buffer pool. The mock server grows the pip by PIP_RESIZE_STEP_SIZE each committed frame.
+
+#ifdef __GLIBC__
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Interposed so calls from GDK and the library are counted, and passed straight to the kernel
+static gboolean counting = FALSE;
+static long shm_syscalls = 0;
+
+static void count_syscall()
+{
+    if (counting)
+        shm_syscalls++;
+}
+
+int memfd_create(const char *name, unsigned int flags)
+{
+    count_syscall();
+    return syscall(SYS_memfd_create, name, flags);
+}
+
+int ftruncate(int fd, off_t length)
+{
+    count_syscall();
+    return syscall(SYS_ftruncate, fd, length);
+}
+
+int posix_fallocate(int fd, off_t offset, off_t len)
+{
+    count_syscall();
+    return syscall(SYS_fallocate, fd, 0, offset, len) == 0 ? 0 : errno;
+}
+
+void *mmap(void *addr, size_t length, int prot, int flags, int fd, off_t offset)
+{
+    count_syscall();
+    return (void *)syscall(SYS_mmap, addr, length, prot, flags, fd, offset);
+}
+
+int munmap(void *addr, size_t length)
+{
+    count_syscall();
+    return syscall(SYS_munmap, addr, length);
+}
+
+static void interactive_resize(const char* name, gboolean buffer_pool)
+{
+    GtkWindow* window = GTK_WINDOW(gtk_window_new(GTK_WINDOW_TOPLEVEL));
+    gtk_pip_init_for_window(window);
+    gtk_pip_set_app_id(window, name);
+    gtk_pip_set_buffer_pool(window, buffer_pool);
+    GtkWidget* video = gtk_drawing_area_new();
+    gtk_widget_set_size_request(video, DEFAULT_PIP_WIDTH / 2, DEFAULT_PIP_HEIGHT / 2);
+    gtk_container_add(GTK_CONTAINER(window), video);
+    gtk_widget_show_all(GTK_WIDGET(window));
+    benchmark_flush_main_loop();
+
+    shm_syscalls = 0;
+    long start_faults = benchmark_minor_faults();
+    counting = TRUE;
+    gtk_pip_resize(window, GDK_WINDOW_EDGE_SOUTH_EAST);
+    // The resize ends on a timeout once the mock server stops sending configures
+    while (gtk_pip_get_resizing(window))
+        gtk_main_iteration();
+    counting = FALSE;
+    long faults = benchmark_minor_faults() - start_faults;
+
+    char report_name[256];
+    snprintf(report_name, sizeof(report_name), "%s-syscalls", name);
+    BENCHMARK_REPORT(report_name, "%.1f", (double)shm_syscalls / PIP_RESIZE_STEPS, "syscalls/step");
+    snprintf(report_name, sizeof(report_name), "%s-page-faults", name);
+    BENCHMARK_REPORT(report_name, "%.1f", (double)faults / PIP_RESIZE_STEPS, "faults/step");
+
+    gtk_widget_destroy(GTK_WIDGET(window));
+    benchmark_flush_main_loop();
+}
+
+static void gdk_buffers()
+{
+    interactive_resize("bench-resize-gdk-buffers", FALSE);
+}
+
+static void pooled_buffers()
+{
+    interactive_resize("bench-resize-pooled-buffers", TRUE);
+}
+
+BENCHMARK_CALLBACKS(
+    gdk_buffers,
+    pooled_buffers,
+)
+
+#else // __GLIBC__
+
+// Syscalls can only be counted by interposing glibc's wrappers
+static void not_supported()
+{
+    fprintf(stderr, "Not built against glibc, resize buffers not measured\n");
+}
+
+BENCHMARK_CALLBACKS(
+    not_supported,
+)
+
+#endif // __GLIBC__
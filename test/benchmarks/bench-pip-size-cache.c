@@ -0,0 +1,96 @@
+/* This entire file is licensed under MIT
+ *
+ * Copyright 2020 Sophie Winter
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "benchmark-common.h"
+
+// Measures how long it takes a pip window to show its first frame at the size the compositor picked, and how many
+// layouts it takes to get there, with and without a remembered size. The runner gives each run an empty cache.
+
+static const int window_count = 20;
+
+typedef struct
+{
+    int layout_count; // Size allocations until the window had the placed size
+    gboolean placed;
+} SizeCacheRun;
+
+static void on_size_allocate(GtkWidget* _widget, GdkRectangle* allocation, SizeCacheRun* run)
+{
+    (void)_widget;
+    if (run->placed)
+        return;
+    run->layout_count++;
+    if (allocation->width == DEFAULT_PIP_WIDTH && allocation->height == DEFAULT_PIP_HEIGHT)
+        run->placed = TRUE;
+}
+
+// If unique_app_ids is set, every window gets its own app ID so none of them can hit the cache
+static void measure(const char* name, const char* app_id, gboolean remember_size, gboolean unique_app_ids)
+{
+    int layout_count = 0;
+    gint64 elapsed = 0;
+    for (int i = 0; i < window_count; i++) {
+        char window_app_id[64];
+        if (unique_app_ids)
+            snprintf(window_app_id, sizeof(window_app_id), "%s-%d", app_id, i);
+        else
+            snprintf(window_app_id, sizeof(window_app_id), "%s", app_id);
+
+        SizeCacheRun run = {0, FALSE};
+        GtkWindow* window = GTK_WINDOW(gtk_window_new(GTK_WINDOW_TOPLEVEL));
+        gtk_container_add(GTK_CONTAINER(window), gtk_label_new("Picture in picture"));
+        gtk_pip_init_for_window(window);
+        gtk_pip_set_app_id(window, window_app_id);
+        gtk_pip_set_remember_size(window, remember_size);
+        g_signal_connect(window, "size-allocate", G_CALLBACK(on_size_allocate), &run);
+
+        gint64 start = benchmark_time_us();
+        gtk_widget_show_all(GTK_WIDGET(window));
+        while (!run.placed) {
+            benchmark_roundtrip();
+            benchmark_flush_main_loop();
+        }
+        elapsed += benchmark_time_us() - start;
+        layout_count += run.layout_count;
+
+        gtk_widget_destroy(GTK_WIDGET(window));
+        benchmark_flush_main_loop();
+    }
+
+    char report_name[64];
+    snprintf(report_name, sizeof(report_name), "%s-time-to-placed", name);
+    BENCHMARK_REPORT(report_name, "%" G_GINT64_FORMAT, elapsed / window_count, "us/window");
+    snprintf(report_name, sizeof(report_name), "%s-layouts-to-placed", name);
+    BENCHMARK_REPORT(report_name, "%.2f", (double)layout_count / window_count, "layouts/window");
+}
+
+static void not_remembered()
+{
+    measure("not-remembered", "bench-size-cache-off", FALSE, FALSE);
+}
+
+static void cold_cache()
+{
+    measure("cold-cache", "bench-size-cache-cold", TRUE, TRUE);
+}
+
+static void warm_cache()
+{
+    // Make sure the size is stored, then every measured window is a hit
+    measure("warm-cache-first", "bench-size-cache-warm", TRUE, FALSE);
+    measure("warm-cache", "bench-size-cache-warm", TRUE, FALSE);
+}
+
+BENCHMARK_CALLBACKS(
+    not_remembered,
+    cold_cache,
+    warm_cache,
+)
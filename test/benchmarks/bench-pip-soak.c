@@ -0,0 +1,168 @@
+/* This entire file is licensed under MIT
+ *
+ * Copyright 2020 Sophie Winter
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "benchmark-common.h"
+
+// Cycles a pip through showing and hiding, being dismissed by the compositor, opening a popup and being interactively
+// resized, and fails if RSS, open fds or live GObjects keep growing. The runner's --soak option sets the number of
+// cycles (meson runs a short soak, pass something like --soak 300000 to leave it running for hours), makes the mock
+// server fail if the client's Wayland objects keep growing, and turns on GObject instance counting.
+
+static const long default_cycles = 2000;
+#define SAMPLE_COUNT 40
+
+// How far the late samples may rise above the highest of the early ones before it counts as a leak. GTK and the
+// allocator warm up over the first quarter of the samples (theme, fonts, glyph caches, size classes).
+static const long rss_slack_kb = 4096;
+static const long fd_slack = 2;
+static const guint gobject_slack = 32;
+
+typedef struct {
+    long rss_kb;
+    long fds;
+    guint gobjects;
+} Sample;
+
+static GtkWindow* pip;
+
+static void show_pip()
+{
+    gtk_widget_show_all(GTK_WIDGET(pip));
+    benchmark_flush_main_loop();
+}
+
+static void hide_pip()
+{
+    gtk_widget_hide(GTK_WIDGET(pip));
+    benchmark_flush_main_loop();
+}
+
+static void on_dismissed_destroy(GtkWidget* widget, gpointer destroyed)
+{
+    *(gboolean*)destroyed = TRUE;
+}
+
+static void dismiss_cycle()
+{
+    GtkWindow* window = GTK_WINDOW(gtk_window_new(GTK_WINDOW_TOPLEVEL));
+    gtk_pip_init_for_window(window);
+    gtk_pip_set_app_id(window, "bench-soak" PIP_DISMISS_APP_ID_SUFFIX);
+    gtk_container_add(GTK_CONTAINER(window), gtk_label_new("Dismissed"));
+    gboolean destroyed = FALSE;
+    g_signal_connect(window, "destroy", G_CALLBACK(on_dismissed_destroy), &destroyed);
+    gtk_widget_show_all(GTK_WIDGET(window));
+    // Placed on the first roundtrip, dismissed once placed and closed on the next
+    for (int i = 0; i < 4 && !destroyed; i++)
+        benchmark_flush_main_loop();
+    ASSERT(destroyed);
+}
+
+static void popup_cycle()
+{
+    show_pip();
+    GtkWindow* popup = GTK_WINDOW(gtk_window_new(GTK_WINDOW_POPUP));
+    gtk_window_set_transient_for(popup, pip);
+    gtk_container_add(GTK_CONTAINER(popup), gtk_label_new("Popup"));
+    gtk_widget_realize(GTK_WIDGET(popup));
+    GdkRectangle rect = {10, 10, 20, 20};
+    gdk_window_move_to_rect(gtk_widget_get_window(GTK_WIDGET(popup)),
+                            &rect, GDK_GRAVITY_SOUTH_WEST, GDK_GRAVITY_NORTH_WEST, 0, 0, 0);
+    gtk_widget_show_all(GTK_WIDGET(popup));
+    benchmark_flush_main_loop();
+    gtk_widget_destroy(GTK_WIDGET(popup));
+    hide_pip();
+}
+
+static void resize_cycle()
+{
+    show_pip();
+    gtk_pip_resize(pip, GDK_WINDOW_EDGE_SOUTH_EAST);
+    // The mock server sends the next step of the resize once the previous one has been committed
+    for (int i = 0; i < PIP_RESIZE_STEPS + 1; i++)
+        benchmark_flush_main_loop();
+    hide_pip();
+}
+
+static void show_hide_cycle()
+{
+    show_pip();
+    hide_pip();
+}
+
+static void (* const cycles[])(void) = {
+    show_hide_cycle,
+    dismiss_cycle,
+    popup_cycle,
+    resize_cycle,
+};
+
+static Sample take_sample()
+{
+    return (Sample){
+        .rss_kb = benchmark_rss_kb(),
+        .fds = benchmark_open_fds(),
+        .gobjects = benchmark_gobject_instances(),
+    };
+}
+
+static void soak()
+{
+    pip = GTK_WINDOW(gtk_window_new(GTK_WINDOW_TOPLEVEL));
+    gtk_pip_init_for_window(pip);
+    gtk_pip_set_app_id(pip, "bench-soak");
+    gtk_container_add(GTK_CONTAINER(pip), gtk_label_new("Soak"));
+
+    long cycle_count = benchmark_soak_cycles > 0 ? benchmark_soak_cycles : default_cycles;
+    // Samples are always taken after the same kind of cycle, so they are comparable
+    long kinds = G_N_ELEMENTS(cycles);
+    long cycles_per_sample = MAX(cycle_count / SAMPLE_COUNT / kinds, 1) * kinds;
+    Sample samples[SAMPLE_COUNT];
+    int taken = 0;
+
+    gint64 start = benchmark_time_us();
+    for (long i = 0; i < cycle_count; i++) {
+        cycles[i % G_N_ELEMENTS(cycles)]();
+        if ((i + 1) % cycles_per_sample == 0 && taken < SAMPLE_COUNT)
+            samples[taken++] = take_sample();
+    }
+    gint64 elapsed = benchmark_time_us() - start;
+    ASSERT(taken >= 8);
+
+    // Compare the highest of the late samples against the highest of the early ones, so a single spike is not a leak
+    // but a steady climb is
+    Sample early = samples[0], late = samples[taken - taken / 4];
+    for (int i = 0; i < taken / 4; i++) {
+        early.rss_kb = MAX(early.rss_kb, samples[i].rss_kb);
+        early.fds = MAX(early.fds, samples[i].fds);
+        early.gobjects = MAX(early.gobjects, samples[i].gobjects);
+    }
+    for (int i = taken - taken / 4; i < taken; i++) {
+        late.rss_kb = MAX(late.rss_kb, samples[i].rss_kb);
+        late.fds = MAX(late.fds, samples[i].fds);
+        late.gobjects = MAX(late.gobjects, samples[i].gobjects);
+    }
+
+    BENCHMARK_REPORT("soak-cycles", "%ld", cycle_count, "cycles");
+    BENCHMARK_REPORT("soak-cycle-time", "%.1f", (double)elapsed / cycle_count, "us/cycle");
+    BENCHMARK_REPORT("soak-rss-growth", "%ld", late.rss_kb - early.rss_kb, "kB");
+    BENCHMARK_REPORT("soak-fd-growth", "%ld", late.fds - early.fds, "fds");
+    BENCHMARK_REPORT("soak-gobject-growth", "%d", (int)late.gobjects - (int)early.gobjects, "instances");
+
+    ASSERT(late.rss_kb <= early.rss_kb + rss_slack_kb);
+    ASSERT(late.fds <= early.fds + fd_slack);
+    ASSERT(late.gobjects <= early.gobjects + gobject_slack);
+
+    gtk_widget_destroy(GTK_WIDGET(pip));
+}
+
+BENCHMARK_CALLBACKS(
+    soak,
+)
@@ -0,0 +1,83 @@
+/* This entire file is licensed under MIT
+ *
+ * Copyright 2020 Sophie Winter
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "benchmark-common.h"
+
+// Animates a pip for a fixed time against the mock server's virtual 60Hz refresh clock, which answers frame callbacks
+// on vblank and holds replaced buffers for a while before releasing them (see the runner arguments in meson.build).
+// The client reports how often it drew, and the server reports (as each pip is destroyed) how many frames it presented
+// per second, how many vblanks passed without a new frame and how many buffers were waiting to be released at once.
+// The slow phase takes longer than a refresh period to draw, so it shows how the library behaves when it falls behind.
+
+static const gint64 run_time_us = 2000000;
+// Longer than a 60Hz refresh period
+static const gulong slow_draw_us = 25000;
+
+static int draw_count;
+
+static gboolean on_draw(GtkWidget* widget, cairo_t* cr, gpointer slow)
+{
+    draw_count++;
+    if (slow)
+        g_usleep(slow_draw_us);
+    double shade = (draw_count % 60) / 60.0;
+    cairo_set_source_rgb(cr, shade, 0.2, 1.0 - shade);
+    cairo_paint(cr);
+    return TRUE;
+}
+
+static gboolean on_tick(GtkWidget* widget, GdkFrameClock* frame_clock, gpointer data)
+{
+    gtk_widget_queue_draw(widget);
+    return G_SOURCE_CONTINUE;
+}
+
+static void animate(const char* name, gboolean slow)
+{
+    GtkWindow* window = GTK_WINDOW(gtk_window_new(GTK_WINDOW_TOPLEVEL));
+    gtk_pip_init_for_window(window);
+    gtk_pip_set_app_id(window, name);
+    GtkWidget* video = gtk_drawing_area_new();
+    gtk_widget_set_size_request(video, DEFAULT_PIP_WIDTH, DEFAULT_PIP_HEIGHT);
+    g_signal_connect(video, "draw", G_CALLBACK(on_draw), GINT_TO_POINTER(slow));
+    gtk_widget_add_tick_callback(video, on_tick, NULL, NULL);
+    gtk_container_add(GTK_CONTAINER(window), video);
+    gtk_widget_show_all(GTK_WIDGET(window));
+    benchmark_flush_main_loop();
+
+    draw_count = 0;
+    gint64 start = benchmark_time_us();
+    while (benchmark_time_us() - start < run_time_us)
+        g_main_context_iteration(NULL, TRUE);
+    gint64 elapsed = benchmark_time_us() - start;
+
+    char report_name[256];
+    snprintf(report_name, sizeof(report_name), "%s-drawn-fps", name);
+    BENCHMARK_REPORT(report_name, "%.1f", draw_count / (elapsed / 1000000.0), "fps");
+
+    gtk_widget_destroy(GTK_WIDGET(window));
+    benchmark_flush_main_loop();
+}
+
+static void fast_content()
+{
+    animate("bench-vblank-fast", FALSE);
+}
+
+static void slow_content()
+{
+    animate("bench-vblank-slow", TRUE);
+}
+
+BENCHMARK_CALLBACKS(
+    fast_content,
+    slow_content,
+)
@@ -0,0 +1,86 @@
+/* This entire file is licensed under MIT
+ *
+ * Copyright 2020 Sophie Winter
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "benchmark-common.h"
+
+// Measures how long GDK takes to position a popup that is transient for a chain of plain windows leading up to a pip.
+// Every move_to_rect goes through the library's override, which has to find the nearest shell surface up the chain.
+// With the lookup cached, the cost should not depend on how long the chain is.
+
+static const int move_count = 2000;
+static const int depths[] = {1, 8, 32};
+
+static GtkWindow* pip;
+
+static void measure_depth(int depth)
+{
+    GtkWindow* chain[32];
+    GtkWindow* transient_for = pip;
+    for (int i = 0; i < depth; i++) {
+        chain[i] = GTK_WINDOW(gtk_window_new(GTK_WINDOW_TOPLEVEL));
+        gtk_window_set_transient_for(chain[i], transient_for);
+        gtk_widget_realize(GTK_WIDGET(chain[i]));
+        transient_for = chain[i];
+    }
+
+    GtkWindow* popup = GTK_WINDOW(gtk_window_new(GTK_WINDOW_POPUP));
+    gtk_window_set_transient_for(popup, transient_for);
+    gtk_container_add(GTK_CONTAINER(popup), gtk_label_new("Popup"));
+    gtk_widget_realize(GTK_WIDGET(popup));
+    GdkWindow* popup_gdk_window = gtk_widget_get_window(GTK_WIDGET(popup));
+
+    GdkRectangle rect = {10, 10, 20, 20};
+    gint64 start = benchmark_time_us();
+    for (int i = 0; i < move_count; i++) {
+        rect.x = 10 + i % 50;
+        gdk_window_move_to_rect(popup_gdk_window, &rect, GDK_GRAVITY_SOUTH_WEST, GDK_GRAVITY_NORTH_WEST, 0, 0, 0);
+    }
+    gint64 elapsed = benchmark_time_us() - start;
+
+    char name[64];
+    snprintf(name, sizeof(name), "popup-move-to-rect-depth-%d", depth);
+    BENCHMARK_REPORT(name, "%.3f", (double)elapsed / move_count, "us/move");
+
+    gtk_widget_destroy(GTK_WIDGET(popup));
+    for (int i = depth - 1; i >= 0; i--)
+        gtk_widget_destroy(GTK_WIDGET(chain[i]));
+    benchmark_flush_main_loop();
+}
+
+static void setup()
+{
+    pip = GTK_WINDOW(gtk_window_new(GTK_WINDOW_TOPLEVEL));
+    gtk_pip_init_for_window(pip);
+    gtk_pip_set_app_id(pip, "bench-popup-transient-depth");
+    gtk_container_add(GTK_CONTAINER(pip), gtk_label_new("Pip"));
+    gtk_widget_show_all(GTK_WIDGET(pip));
+    benchmark_flush_main_loop();
+
+    // Warm up, so the first measurement doesn't pay for loading the theme and fonts
+    measure_depth(1);
+}
+
+static void run()
+{
+    for (size_t i = 0; i < G_N_ELEMENTS(depths); i++)
+        measure_depth(depths[i]);
+}
+
+static void teardown()
+{
+    gtk_widget_destroy(GTK_WIDGET(pip));
+}
+
+BENCHMARK_CALLBACKS(
+    setup,
+    run,
+    teardown,
+)
@@ -0,0 +1,92 @@
+/* This entire file is licensed under MIT
+ *
+ * Copyright 2020 Sophie Winter
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "benchmark-common.h"
+
+// Measures how fast a tooltip-like popup of a plain (non-pip) GtkWindow can be realized, shown, hidden and unrealized,
+// before the library is initialized and while a pip window exists. Windows with a shell surface are moved to a private
+// subtype, so GtkWindow's own class is never modified and the tooltip should cost the same either way.
+
+static const int cycle_count = 400;
+// Requests are flushed this often, so the socket buffer never fills up
+static const int cycles_per_flush = 20;
+
+static GtkWindow* parent;
+static GtkWindow* tooltip;
+// us/cycle measured without the library
+static double baseline;
+
+static double tooltip_churn(const char* name)
+{
+    gint64 start = benchmark_time_us();
+    for (int i = 0; i < cycle_count; i++) {
+        gtk_widget_show_all(GTK_WIDGET(tooltip));
+        gtk_widget_hide(GTK_WIDGET(tooltip));
+        gtk_widget_unrealize(GTK_WIDGET(tooltip));
+        if ((i + 1) % cycles_per_flush == 0)
+            benchmark_flush_main_loop();
+    }
+    double per_cycle = (double)(benchmark_time_us() - start) / cycle_count;
+    BENCHMARK_REPORT(name, "%.2f", per_cycle, "us/cycle");
+    return per_cycle;
+}
+
+static void setup()
+{
+    // Shown with plain GTK, the library has not been used yet
+    parent = GTK_WINDOW(gtk_window_new(GTK_WINDOW_TOPLEVEL));
+    gtk_container_add(GTK_CONTAINER(parent), gtk_label_new("Parent"));
+    gtk_widget_show_all(GTK_WIDGET(parent));
+
+    tooltip = GTK_WINDOW(gtk_window_new(GTK_WINDOW_POPUP));
+    gtk_window_set_type_hint(tooltip, GDK_WINDOW_TYPE_HINT_TOOLTIP);
+    gtk_window_set_transient_for(tooltip, parent);
+    gtk_container_add(GTK_CONTAINER(tooltip), gtk_label_new("Tooltip"));
+
+    // Warm up, so the first measurement doesn't pay for loading the theme and fonts
+    tooltip_churn("warm-up-tooltip-churn");
+}
+
+static void without_library()
+{
+    baseline = tooltip_churn("without-library-tooltip-churn");
+}
+
+static void with_library()
+{
+    GtkWindow* pip = GTK_WINDOW(gtk_window_new(GTK_WINDOW_TOPLEVEL));
+    gtk_pip_init_for_window(pip);
+    gtk_pip_set_app_id(pip, "bench-tooltip-churn");
+    gtk_widget_show_all(GTK_WIDGET(pip));
+    benchmark_flush_main_loop();
+
+    // Only the pip has moved to the private subtype, the tooltip is still a plain GtkWindow
+    g_assert(G_OBJECT_TYPE(pip) != GTK_TYPE_WINDOW);
+    g_assert(G_OBJECT_TYPE(tooltip) == GTK_TYPE_WINDOW);
+
+    double with = tooltip_churn("with-library-tooltip-churn");
+    BENCHMARK_REPORT("tooltip-churn-overhead", "%.1f", (with - baseline) * 100.0 / baseline, "%");
+
+    gtk_widget_destroy(GTK_WIDGET(pip));
+}
+
+static void teardown()
+{
+    gtk_widget_destroy(GTK_WIDGET(tooltip));
+    gtk_widget_destroy(GTK_WIDGET(parent));
+}
+
+BENCHMARK_CALLBACKS(
+    setup,
+    without_library,
+    with_library,
+    teardown,
+)
@@ -0,0 +1,85 @@
+#!/usr/bin/python3
+'''
+This entire file is licensed under MIT.
+
+Copyright 2020 Sophie Winter
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+'''
+
+# Converts a WAYLAND_DEBUG log of a client into an event trace the mock server can replay with --replay
+# This is how sessions on real compositors (such as configure storms seen in production) get reproduced in benchmarks
+# The trace format is documented in test/mock-server/mock-server.h
+usage = 'Usage: python3 convert-wayland-debug-trace.py <WAYLAND_DEBUG log> <output trace>'
+
+import re
+import struct
+import sys
+
+# Only events the mock server knows how to replay are kept
+replayable_events = {
+    'xdg_pip_v1.configure_bounds',
+    'xdg_pip_v1.configure',
+    'xdg_pip_v1.dismissed',
+    'xdg_surface.configure',
+    'wl_pointer.enter',
+    'wl_pointer.leave',
+    'wl_pointer.motion',
+    'wl_pointer.button',
+    'wl_pointer.axis',
+    'wl_pointer.frame',
+}
+
+# Matches events, such as "[1234567.890] {Default Queue} xdg_pip_v1@25.configure(320, 180)"
+# Requests are the same but with "->" before the object, so they don't match
+event_re = re.compile(r'^\[\s*(?P<time>\d+\.\d+)\]\s*(\{[^}]*\}\s*)?(?P<interface>\w+)@\d+\.(?P<event>\w+)\((?P<args>.*)\)\s*$')
+
+def convert_arg(arg: str) -> int:
+    '''Integers are kept, fixed point numbers are converted to their raw value and anything else becomes 0'''
+    arg = arg.strip()
+    if re.fullmatch(r'-?\d+', arg):
+        value = int(arg)
+        return value - (1 << 32) if value >= (1 << 31) else value
+    if re.fullmatch(r'-?\d+\.\d+', arg):
+        return int(round(float(arg) * 256))
+    return 0
+
+def convert(log_path: str, trace_path: str) -> int:
+    '''Writes the trace and returns the number of events in it'''
+    indexes = {}
+    count = 0
+    start_ms = None
+    with open(log_path, 'r') as log, open(trace_path, 'wb') as trace:
+        trace.write(b'MSEV' + struct.pack('=I', 1))
+        for line in log:
+            match = event_re.match(line)
+            if not match:
+                continue
+            name = match.group('interface') + '.' + match.group('event')
+            if name not in replayable_events:
+                continue
+            if name not in indexes:
+                indexes[name] = len(indexes) + 1
+                encoded = name.encode('utf-8')
+                trace.write(struct.pack('=BHH', 1, indexes[name], len(encoded)) + encoded)
+            time_ms = float(match.group('time'))
+            if start_ms is None:
+                start_ms = time_ms
+            raw_args = match.group('args').strip()
+            args = [convert_arg(arg) for arg in raw_args.split(',')] if raw_args else []
+            args = args[:4]
+            time_us = int(round((time_ms - start_ms) * 1000))
+            trace.write(struct.pack('=BHQB', 2, indexes[name], time_us, len(args)))
+            trace.write(struct.pack('=' + 'i' * len(args), *args))
+            count += 1
+    return count
+
+if __name__ == '__main__':
+    if len(sys.argv) != 3:
+        print(usage)
+        exit(1)
+    print(str(convert(sys.argv[1], sys.argv[2])) + ' events written')
@@ -11,11 +11,12 @@
 
 #include "integration-test-common.h"
 
-// Time in milliseconds for each callback to run
-static int step_time = 300;
+// Bounds how long a step may keep the client busy, in case something never stops drawing
+static const int max_settle_iterations = 1000;
 
 static int return_code = 0;
 static int callback_index = 0;
+static gboolean report_step_times = FALSE;
 
 static gboolean next_step(gpointer _data)
 {
@@ -32,6 +33,42 @@ static gboolean next_step(gpointer _data)
     }
 }
 
+// Runs the main loop and roundtrips until neither the client nor the mock server has anything left to do
+// A roundtrip only returns once the server has processed every request sent before it, and the events it sent in
+// response have been dispatched. Those usually queue more work for GTK (such as drawing a new frame), so keep going
+// until a roundtrip is followed by an idle main loop.
+static void wait_until_settled()
+{
+    struct wl_display* wl_display = gdk_wayland_display_get_wl_display(gdk_display_get_default());
+    for (int i = 0; i < max_settle_iterations; i++) {
+        if (wl_display_roundtrip(wl_display) < 0)
+            FATAL("Wayland connection failed while waiting for the step to settle");
+        if (!gtk_events_pending())
+            return;
+        while (gtk_events_pending())
+            gtk_main_iteration();
+    }
+    FATAL("test did not settle, is something drawing continuously?");
+}
+
+static gboolean auto_step(gpointer _data)
+{
+    (void)_data;
+
+    int index = callback_index;
+    gint64 start = g_get_monotonic_time();
+    if (!next_step(NULL))
+        return FALSE;
+    wait_until_settled();
+
+    if (report_step_times) {
+        char name[64];
+        snprintf(name, sizeof(name), "step-%d-latency", index);
+        BENCHMARK_REPORT(name, "%" G_GINT64_FORMAT, g_get_monotonic_time() - start, "us");
+    }
+    return TRUE;
+}
+
 GtkWindow* create_default_window()
 {
     GtkWindow* window = GTK_WINDOW(gtk_window_new(GTK_WINDOW_TOPLEVEL));
@@ -56,10 +93,7 @@ static void create_debug_control_window()
 {
     // Make a window with a continue button for debugging
     GtkWindow* window = GTK_WINDOW(gtk_window_new(GTK_WINDOW_TOPLEVEL));
-    gtk_layer_init_for_window(window);
-    gtk_layer_set_anchor(window, GTK_LAYER_SHELL_EDGE_BOTTOM, TRUE);
-    gtk_layer_set_margin(window, GTK_LAYER_SHELL_EDGE_BOTTOM, 200);
-    gtk_layer_set_layer(window, GTK_LAYER_SHELL_LAYER_OVERLAY);
+    gtk_pip_init_for_window(window);
     GtkWidget* button = gtk_button_new_with_label("Continue ->");
     g_signal_connect (button, "clicked", G_CALLBACK(continue_button_callback), NULL);
     gtk_container_add(GTK_CONTAINER(window), button);
@@ -76,9 +110,12 @@ int main(int argc, char** argv)
         create_debug_control_window();
         next_step(NULL);
     } else if (argc == 2 && g_strcmp0(argv[1], "--auto") == 0) {
-        // Run normally with a timeout
-        next_step(NULL);
-        g_timeout_add(step_time, next_step, NULL);
+        // Run normally, starting each step as soon as the previous one has settled
+        g_idle_add(auto_step, NULL);
+    } else if (argc == 2 && g_strcmp0(argv[1], "--benchmark") == 0) {
+        // Same as --auto, but report how long each step took to settle
+        report_step_times = TRUE;
+        g_idle_add(auto_step, NULL);
     } else {
         g_critical("Invalid arguments to integration test");
         return 1;
@@ -12,7 +12,7 @@
 #ifndef TEST_CLIENT_COMMON_H
 #define TEST_CLIENT_COMMON_H
 
-#include "gtk-layer-shell.h"
+#include "gtk-pip-shell.h"
 #include "test-common.h"
 #include <gtk/gtk.h>
 #include <gdk/gdk.h>
@@ -21,6 +21,8 @@
 
 // Tell the test script that a request containing the given space-separated components is expected
 #define EXPECT_MESSAGE(message) fprintf(stderr, "EXPECT: %s\n", #message)
+// Tell the test script that no request or event containing the given components may be sent until the next callback
+#define UNEXPECT_MESSAGE(message) fprintf(stderr, "UNEXPECT: %s\n", #message)
 // Tell the test script that all expected messages should now be fulfilled
 // (called automatically before each callback and at the end of the test)
 #define CHECK_EXPECTATIONS() fprintf(stderr, "CHECK EXPECTATIONS COMPLETED\n")
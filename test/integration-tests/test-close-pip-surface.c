@@ -16,13 +16,13 @@ static GtkWindow* window;
 static void callback_0()
 {
     window = create_default_window();
-    gtk_layer_init_for_window(window);
+    gtk_pip_init_for_window(window);
     gtk_widget_show_all(GTK_WIDGET(window));
 }
 
 static void callback_1()
 {
-    EXPECT_MESSAGE(zwlr_layer_surface_v1 .destroy);
+    EXPECT_MESSAGE(xdg_pip_v1 .destroy);
     EXPECT_MESSAGE(wl_surface .destroy);
     gtk_window_close(window);
 }
@@ -20,7 +20,7 @@ static void callback_0()
     EXPECT_MESSAGE(wl_subsurface .set_position -20 30);
 
     window = create_default_window();
-    gtk_layer_init_for_window(window);
+    gtk_pip_init_for_window(window);
 
     subsurface = GTK_WINDOW(gtk_window_new(GTK_WINDOW_POPUP));
     gtk_container_add(GTK_CONTAINER(subsurface), gtk_label_new("Subsurface"));
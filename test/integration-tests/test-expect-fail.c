@@ -16,10 +16,10 @@ static GtkWindow *window;
 static void callback_0()
 {
     // This should fail because the tokens are in the wrong order
-    EXPECT_MESSAGE(.get_layer_surface zwlr_layer_shell_v1);
+    EXPECT_MESSAGE(.get_xdg_pip xdg_wm_pip_v1);
 
     window = create_default_window();
-    gtk_layer_init_for_window(window);
+    gtk_pip_init_for_window(window);
     gtk_widget_show_all(GTK_WIDGET(window));
 }
 
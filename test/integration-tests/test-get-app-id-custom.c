@@ -16,11 +16,11 @@ static GtkWindow* window;
 static void callback_0()
 {
     window = create_default_window();
-    gtk_layer_init_for_window(window);
-    gtk_layer_set_namespace(window, "foobar");
+    gtk_pip_init_for_window(window);
+    gtk_pip_set_app_id(window, "foobar");
     gtk_widget_show_all(GTK_WIDGET(window));
-    const char *name_space = gtk_layer_get_namespace(window);
-    ASSERT_STR_EQ(name_space, "foobar");
+    const char *app_id = gtk_pip_get_app_id(window);
+    ASSERT_STR_EQ(app_id, "foobar");
 }
 
 TEST_CALLBACKS(
@@ -16,8 +16,8 @@ static GtkWindow* window;
 static void callback_0()
 {
     window = create_default_window();
-    const char *name_space = gtk_layer_get_namespace(window);
-    ASSERT_STR_EQ(name_space, "gtk-layer-shell");
+    const char *app_id = gtk_pip_get_app_id(window);
+    ASSERT_STR_EQ(app_id, "gtk-pip-shell");
 }
 
 TEST_CALLBACKS(
@@ -19,10 +19,10 @@ static void callback_0()
     window_a = create_default_window();
     window_b = create_default_window();
 
-    gtk_layer_init_for_window(window_a);
+    gtk_pip_init_for_window(window_a);
 
-    ASSERT(gtk_layer_is_layer_window(window_a));
-    ASSERT(!gtk_layer_is_layer_window(window_b));
+    ASSERT(gtk_pip_is_pip_window(window_a));
+    ASSERT(!gtk_pip_is_pip_window(window_b));
 
     gtk_widget_show_all(GTK_WIDGET(window_a));
     gtk_widget_show_all(GTK_WIDGET(window_b));
@@ -30,8 +30,8 @@ static void callback_0()
 
 static void callback_1()
 {
-    ASSERT(gtk_layer_is_layer_window(window_a));
-    ASSERT(!gtk_layer_is_layer_window(window_b));
+    ASSERT(gtk_pip_is_pip_window(window_a));
+    ASSERT(!gtk_pip_is_pip_window(window_b));
 }
 
 TEST_CALLBACKS(
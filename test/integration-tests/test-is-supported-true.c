@@ -13,8 +13,8 @@
 
 static void callback_0()
 {
-    ASSERT(gtk_layer_is_supported());
-    ASSERT(gtk_layer_is_supported());
+    ASSERT(gtk_pip_is_supported());
+    ASSERT(gtk_pip_is_supported());
 }
 
 TEST_CALLBACKS(
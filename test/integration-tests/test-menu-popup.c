@@ -15,9 +15,9 @@ static GtkWindow* window;
 
 static void callback_0()
 {
-    // The mock server will automatically click on our window, triggering the menu to open
+    // The mock server clicks pips with this app ID suffix once they are placed, triggering the menu to open
 
-    EXPECT_MESSAGE(zwlr_layer_shell_v1 .get_layer_surface);
+    EXPECT_MESSAGE(xdg_wm_pip_v1 .get_xdg_pip);
     EXPECT_MESSAGE(xdg_wm_base .get_xdg_surface);
     EXPECT_MESSAGE(xdg_surface .get_popup);
     EXPECT_MESSAGE(xdg_popup .grab);
@@ -32,7 +32,8 @@ static void callback_0()
     GtkWidget *close_item = gtk_menu_item_new_with_label("Menu item");
     gtk_menu_shell_append(GTK_MENU_SHELL(submenu), close_item);
 
-    gtk_layer_init_for_window(window);
+    gtk_pip_init_for_window(window);
+    gtk_pip_set_app_id(window, "test-menu-popup" PIP_CLICK_APP_ID_SUFFIX);
     gtk_widget_show_all(GTK_WIDGET(window));
 }
 
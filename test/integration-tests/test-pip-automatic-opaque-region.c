@@ -0,0 +1,59 @@
+/* This entire file is licensed under MIT
+ *
+ * Copyright 2020 Sophie Winter
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "integration-test-common.h"
+
+static GtkWindow* window;
+
+static void show_pip(GtkWindow* pip)
+{
+    if (window)
+        gtk_widget_destroy(GTK_WIDGET(window));
+    window = pip;
+    gtk_pip_init_for_window(window);
+    gtk_widget_show_all(GTK_WIDGET(window));
+}
+
+static void callback_0()
+{
+    // The theme's window background is opaque, so the whole window is
+    EXPECT_MESSAGE(wl_region .add 0 0);
+    EXPECT_MESSAGE(wl_surface .set_opaque_region wl_region);
+    show_pip(create_default_window());
+}
+
+static void callback_1()
+{
+    // The app may not draw the CSS background at all
+    UNEXPECT_MESSAGE(wl_surface .set_opaque_region wl_region);
+    GtkWindow* app_paintable = create_default_window();
+    gtk_widget_set_app_paintable(GTK_WIDGET(app_paintable), TRUE);
+    show_pip(app_paintable);
+}
+
+static void callback_2()
+{
+    UNEXPECT_MESSAGE(wl_surface .set_opaque_region wl_region);
+    GtkWindow* transparent = create_default_window();
+    GtkCssProvider* provider = gtk_css_provider_new();
+    gtk_css_provider_load_from_data(provider, "window { background-color: rgba(0, 0, 0, 0.5); }", -1, NULL);
+    gtk_style_context_add_provider(gtk_widget_get_style_context(GTK_WIDGET(transparent)),
+                                   GTK_STYLE_PROVIDER(provider),
+                                   GTK_STYLE_PROVIDER_PRIORITY_APPLICATION);
+    g_object_unref(provider);
+    show_pip(transparent);
+}
+
+TEST_CALLBACKS(
+    callback_0,
+    callback_1,
+    callback_2,
+)
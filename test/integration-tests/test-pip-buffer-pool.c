@@ -0,0 +1,68 @@
+/* This entire file is licensed under MIT
+ *
+ * Copyright 2020 Sophie Winter
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "integration-test-common.h"
+
+static GtkWindow* window;
+
+static void callback_0()
+{
+    window = create_default_window();
+    gtk_pip_init_for_window(window);
+    gtk_pip_set_app_id(window, "test-pip-buffer-pool");
+    ASSERT(!gtk_pip_get_buffer_pool(window));
+    gtk_pip_set_buffer_pool(window, TRUE);
+    ASSERT(gtk_pip_get_buffer_pool(window));
+
+    // There is no committed buffer to fill in from, so the first frame is drawn into the pool
+    EXPECT_MESSAGE(wl_shm .create_pool);
+    EXPECT_MESSAGE(wl_shm_pool .create_buffer);
+    EXPECT_MESSAGE(wl_surface .attach);
+    EXPECT_MESSAGE(wl_surface .commit);
+    gtk_widget_show_all(GTK_WIDGET(window));
+}
+
+static void callback_1()
+{
+    // Each step of the drag is a new size, which GDK would otherwise allocate a new shm pool for
+    EXPECT_MESSAGE(xdg_pip_v1 .resize);
+    EXPECT_MESSAGE(wl_shm_pool .create_buffer);
+    EXPECT_MESSAGE(wl_surface .attach);
+    gtk_pip_resize(window, GDK_WINDOW_EDGE_SOUTH_EAST);
+}
+
+static void callback_2()
+{
+    while (gtk_pip_get_resizing(window))
+        gtk_main_iteration();
+
+    int width, height;
+    gtk_window_get_size(window, &width, &height);
+    ASSERT_EQ(width, DEFAULT_PIP_WIDTH + PIP_RESIZE_STEPS * PIP_RESIZE_STEP_SIZE, "%d");
+    ASSERT_EQ(height, DEFAULT_PIP_HEIGHT + PIP_RESIZE_STEPS * PIP_RESIZE_STEP_SIZE, "%d");
+
+    // Buffers already handed out keep working once the pool is disabled
+    gtk_pip_set_buffer_pool(window, FALSE);
+    ASSERT(!gtk_pip_get_buffer_pool(window));
+    gtk_widget_queue_draw(GTK_WIDGET(window));
+}
+
+static void callback_3()
+{
+    gtk_widget_destroy(GTK_WIDGET(window));
+}
+
+TEST_CALLBACKS(
+    callback_0,
+    callback_1,
+    callback_2,
+    callback_3,
+)
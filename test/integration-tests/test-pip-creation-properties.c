@@ -15,16 +15,20 @@ static GtkWindow* window;
 
 static void callback_0()
 {
-    EXPECT_MESSAGE(zwlr_layer_surface_v1 .set_exclusive_zone -1);
-
     window = create_default_window();
-    gtk_layer_init_for_window(window);
-    gtk_layer_set_anchor(window, GTK_LAYER_SHELL_EDGE_BOTTOM, TRUE);
+    gtk_pip_init_for_window(window);
+    gtk_pip_set_app_id(window, "foobar");
+}
+
+static void callback_1()
+{
+    EXPECT_MESSAGE(xdg_wm_pip_v1 .get_xdg_pip);
+    EXPECT_MESSAGE(xdg_pip_v1 .set_app_id "foobar");
+    EXPECT_MESSAGE(wl_surface .commit);
     gtk_widget_show_all(GTK_WIDGET(window));
-    gtk_layer_set_exclusive_zone(window, -2);
-    ASSERT_EQ(gtk_layer_get_exclusive_zone(window), -1, "%d");
 }
 
 TEST_CALLBACKS(
     callback_0,
+    callback_1,
 )
@@ -0,0 +1,77 @@
+/* This entire file is licensed under MIT
+ *
+ * Copyright 2020 Sophie Winter
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "integration-test-common.h"
+
+static GtkWindow* window;
+static int dismissed_count = 0;
+static gboolean destroyed = FALSE;
+
+static void on_pip_dismissed(GtkWindow* _window, gpointer _data)
+{
+    (void)_window; (void)_data;
+    dismissed_count++;
+}
+
+static void on_destroy(GtkWidget* _widget, gpointer _data)
+{
+    (void)_widget; (void)_data;
+    destroyed = TRUE;
+}
+
+static void callback_0()
+{
+    window = create_default_window();
+    gtk_pip_init_for_window(window);
+    // The mock server dismisses pips with this suffix as soon as they are placed
+    gtk_pip_set_app_id(window, "test-pip-dismiss-policy" PIP_DISMISS_APP_ID_SUFFIX);
+    ASSERT_EQ(gtk_pip_get_dismiss_policy(window), GTK_PIP_DISMISS_POLICY_CLOSE, "%d");
+    gtk_pip_set_dismiss_policy(window, GTK_PIP_DISMISS_POLICY_HIDE);
+    ASSERT_EQ(gtk_pip_get_dismiss_policy(window), GTK_PIP_DISMISS_POLICY_HIDE, "%d");
+    gtk_pip_set_dismissed_callback(window, on_pip_dismissed, NULL, NULL);
+    g_signal_connect(window, "destroy", G_CALLBACK(on_destroy), NULL);
+    gtk_widget_show_all(GTK_WIDGET(window));
+}
+
+static void callback_1()
+{
+    ASSERT_EQ(dismissed_count, 1, "%d");
+    ASSERT(!destroyed);
+    ASSERT(!gtk_widget_get_visible(GTK_WIDGET(window)));
+
+    // The same window can be shown again, and gets a new pip surface
+    EXPECT_MESSAGE(xdg_wm_pip_v1 .get_xdg_pip);
+    gtk_widget_show_all(GTK_WIDGET(window));
+}
+
+static void callback_2()
+{
+    ASSERT_EQ(dismissed_count, 2, "%d");
+    ASSERT(!destroyed);
+    ASSERT(!gtk_widget_get_visible(GTK_WIDGET(window)));
+
+    gtk_pip_set_dismiss_policy(window, GTK_PIP_DISMISS_POLICY_CLOSE);
+    gtk_widget_show_all(GTK_WIDGET(window));
+}
+
+static void callback_3()
+{
+    // The callback is called under either policy
+    ASSERT_EQ(dismissed_count, 3, "%d");
+    ASSERT(destroyed);
+}
+
+TEST_CALLBACKS(
+    callback_0,
+    callback_1,
+    callback_2,
+    callback_3,
+)
@@ -0,0 +1,170 @@
+/* This entire file is licensed under MIT
+ *
+ * Copyright 2020 Sophie Winter
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#define _GNU_SOURCE // For memfd_create ()
+
+#include "integration-test-common.h"
+
+#include <fcntl.h>
+#include <linux/udmabuf.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+
+#define FRAME_SIZE 64
+#define FRAME_STRIDE (FRAME_SIZE * 4)
+
+static GtkWindow* window;
+static int dmabufs[3]; // The last one is a plain memfd, which the compositor fails to import
+static int releases[3];
+
+// Wraps a sealed memfd in a dmabuf, which needs no GPU. Returns -1 if udmabuf is not available.
+static int create_udmabuf(size_t size)
+{
+    int udmabuf = open("/dev/udmabuf", O_RDWR | O_CLOEXEC);
+    if (udmabuf < 0)
+        return -1;
+
+    int memfd = memfd_create("test-pip-dmabuf-frame", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    ASSERT(memfd >= 0);
+    ASSERT(ftruncate(memfd, size) == 0);
+    ASSERT(fcntl(memfd, F_ADD_SEALS, F_SEAL_SHRINK) == 0);
+
+    struct udmabuf_create create = {
+        .memfd = memfd,
+        .flags = UDMABUF_FLAGS_CLOEXEC,
+        .offset = 0,
+        .size = size,
+    };
+    int dmabuf = ioctl(udmabuf, UDMABUF_CREATE, &create);
+    close(memfd);
+    close(udmabuf);
+    return dmabuf;
+}
+
+static void on_release(gpointer data)
+{
+    (*(int*)data)++;
+}
+
+static gboolean set_frame(int index, guint32 fourcc)
+{
+    guint32 offset = 0;
+    guint32 stride = FRAME_STRIDE;
+    return gtk_pip_set_dmabuf_frame(window,
+                                    FRAME_SIZE, FRAME_SIZE,
+                                    fourcc, MOCK_DMABUF_MODIFIER,
+                                    1, &dmabufs[index], &offset, &stride,
+                                    on_release, &releases[index]);
+}
+
+static void callback_0()
+{
+    for (int i = 0; i < 2; i++)
+    {
+        dmabufs[i] = create_udmabuf(FRAME_STRIDE * FRAME_SIZE);
+        if (dmabufs[i] < 0)
+            SKIP("/dev/udmabuf is not available");
+    }
+    dmabufs[2] = memfd_create("test-pip-dmabuf-frame", MFD_CLOEXEC);
+    ASSERT(dmabufs[2] >= 0);
+    ASSERT(ftruncate(dmabufs[2], FRAME_STRIDE * FRAME_SIZE) == 0);
+
+    window = create_default_window();
+    gtk_pip_init_for_window(window);
+    gtk_pip_set_app_id(window, "test-pip-dmabuf-frame");
+
+    ASSERT(gtk_pip_get_dmabuf_supported(MOCK_DMABUF_FORMAT, MOCK_DMABUF_MODIFIER));
+    // DRM_FORMAT_ARGB8888, which the mock server does not advertise
+    ASSERT(!gtk_pip_get_dmabuf_supported(0x34325241, MOCK_DMABUF_MODIFIER));
+
+    // Not mapped yet
+    ASSERT(!set_frame(0, MOCK_DMABUF_FORMAT));
+
+    gtk_widget_show_all(GTK_WIDGET(window));
+}
+
+static void callback_1()
+{
+    // Rejected before anything is sent, the compositor would fail the import
+    ASSERT(!set_frame(0, 0x34325241));
+
+    EXPECT_MESSAGE(wl_subcompositor .get_subsurface);
+    EXPECT_MESSAGE(wl_subsurface .set_desync);
+    EXPECT_MESSAGE(zwp_linux_dmabuf_v1 .create_params);
+    EXPECT_MESSAGE(zwp_linux_buffer_params_v1 .add);
+    EXPECT_MESSAGE(zwp_linux_buffer_params_v1 .create);
+    EXPECT_MESSAGE(zwp_linux_buffer_params_v1 .created);
+    EXPECT_MESSAGE(wl_surface .attach);
+    EXPECT_MESSAGE(wl_surface .commit);
+    ASSERT(set_frame(0, MOCK_DMABUF_FORMAT));
+}
+
+static void callback_2()
+{
+    ASSERT_EQ(releases[0], 0, "%d");
+
+    // The mock server releases the first frame once the second one is committed
+    EXPECT_MESSAGE(zwp_linux_buffer_params_v1 .create);
+    EXPECT_MESSAGE(zwp_linux_buffer_params_v1 .created);
+    EXPECT_MESSAGE(wl_surface .commit);
+    EXPECT_MESSAGE(wl_buffer .release);
+    ASSERT(set_frame(1, MOCK_DMABUF_FORMAT));
+}
+
+static void callback_3()
+{
+    ASSERT_EQ(releases[0], 1, "%d");
+    ASSERT_EQ(releases[1], 0, "%d");
+
+    // The format is supported, so this is only caught by the import, which must not be a protocol error
+    EXPECT_MESSAGE(zwp_linux_buffer_params_v1 .create);
+    EXPECT_MESSAGE(zwp_linux_buffer_params_v1 .failed);
+    ASSERT(set_frame(2, MOCK_DMABUF_FORMAT));
+}
+
+static void callback_4()
+{
+    // A frame that failed to import is released right away, and the last frame stays on screen
+    ASSERT_EQ(releases[2], 1, "%d");
+    ASSERT_EQ(releases[1], 0, "%d");
+
+    // Lets controls drawn by GTK be shown on top of the video
+    ASSERT(!gtk_pip_get_dmabuf_below(window));
+    EXPECT_MESSAGE(wl_subsurface .place_below);
+    EXPECT_MESSAGE(wl_surface .commit);
+    gtk_pip_set_dmabuf_below(window, TRUE);
+    ASSERT(gtk_pip_get_dmabuf_below(window));
+}
+
+static void callback_5()
+{
+    // The frame still on screen is released along with the subsurface
+    EXPECT_MESSAGE(wl_subsurface .destroy);
+    gtk_pip_clear_dmabuf_frame(window);
+    ASSERT_EQ(releases[1], 1, "%d");
+}
+
+static void callback_6()
+{
+    gtk_widget_destroy(GTK_WIDGET(window));
+    for (int i = 0; i < 3; i++)
+        close(dmabufs[i]);
+}
+
+TEST_CALLBACKS(
+    callback_0,
+    callback_1,
+    callback_2,
+    callback_3,
+    callback_4,
+    callback_5,
+    callback_6,
+)
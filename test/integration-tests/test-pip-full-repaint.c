@@ -11,39 +11,47 @@
 
 #include "integration-test-common.h"
 
+// The mock server holds each buffer until the next one is committed, so GDK draws each frame into a new buffer and
+// copies whatever was not repainted over from the previous one, unless full repaint mode is on
+
 static GtkWindow* window;
+static guint64 backfill_bytes;
 
 static void callback_0()
 {
     window = create_default_window();
-    gtk_widget_set_size_request(GTK_WIDGET(window), 300, 200);
-    gtk_layer_init_for_window(window);
-
-    gtk_layer_set_anchor(window, GTK_LAYER_SHELL_EDGE_BOTTOM, TRUE);
-    ASSERT(!gtk_layer_auto_exclusive_zone_is_enabled(window));
-    gtk_layer_auto_exclusive_zone_enable(window);
-    ASSERT(gtk_layer_auto_exclusive_zone_is_enabled(window));
+    gtk_pip_init_for_window(window);
+    ASSERT(!gtk_pip_get_full_repaint(window));
     gtk_widget_show_all(GTK_WIDGET(window));
 }
 
 static void callback_1()
 {
-    ASSERT_EQ(gtk_layer_get_exclusive_zone(window), 200, "%d");
-    gtk_widget_set_size_request(GTK_WIDGET(window), 320, 240);
-    gtk_window_resize(window, 1, 1);
+    gtk_widget_queue_draw_area(GTK_WIDGET(window), 0, 0, 10, 10);
 }
 
 static void callback_2()
 {
-    ASSERT_EQ(gtk_layer_get_exclusive_zone(window), 240, "%d");
+    backfill_bytes = gtk_pip_get_backfill_bytes(window);
+    ASSERT(backfill_bytes > 0);
+    gtk_pip_set_full_repaint(window, TRUE);
+    ASSERT(gtk_pip_get_full_repaint(window));
+}
 
-    ASSERT(gtk_layer_auto_exclusive_zone_is_enabled(window));
-    gtk_layer_set_exclusive_zone(window, 20);
-    ASSERT(!gtk_layer_auto_exclusive_zone_is_enabled(window));
+static void callback_3()
+{
+    gtk_widget_queue_draw_area(GTK_WIDGET(window), 0, 0, 10, 10);
+}
+
+static void callback_4()
+{
+    ASSERT_EQ(gtk_pip_get_backfill_bytes(window), backfill_bytes, "%" G_GUINT64_FORMAT);
 }
 
 TEST_CALLBACKS(
     callback_0,
     callback_1,
     callback_2,
+    callback_3,
+    callback_4,
 )
@@ -15,20 +15,18 @@ static GtkWindow* window;
 
 static void callback_0()
 {
-    EXPECT_MESSAGE(zwlr_layer_shell_v1 .get_layer_surface wl_output@);
     window = create_default_window();
-    gtk_layer_init_for_window(window);
-    ASSERT_EQ(gdk_display_get_n_monitors(gdk_display_get_default()), 1, "%d");
-    GdkMonitor *monitor = gdk_display_get_monitor(gdk_display_get_default(), 0);
-    ASSERT(GDK_IS_MONITOR(monitor));
-    gtk_layer_set_monitor(window, monitor);
+    gtk_pip_init_for_window(window);
+    ASSERT_EQ(gtk_pip_get_monitor(window), NULL, "%p");
     gtk_widget_show_all(GTK_WIDGET(window));
 }
 
 static void callback_1()
 {
-    EXPECT_MESSAGE(zwlr_layer_shell_v1 .get_layer_surface nil);
-    gtk_layer_set_monitor(window, NULL);
+    // The mock server sends wl_surface.enter once the pip has been placed
+    ASSERT_EQ(gdk_display_get_n_monitors(gdk_display_get_default()), 1, "%d");
+    GdkMonitor *monitor = gdk_display_get_monitor(gdk_display_get_default(), 0);
+    ASSERT_EQ(gtk_pip_get_monitor(window), monitor, "%p");
 }
 
 TEST_CALLBACKS(
@@ -15,20 +15,23 @@ static GtkWindow* window;
 
 static void callback_0()
 {
+    EXPECT_MESSAGE(wp_fractional_scale_manager_v1 .get_fractional_scale);
     window = create_default_window();
-    gtk_layer_init_for_window(window);
-
-    gtk_layer_set_anchor(window, GTK_LAYER_SHELL_EDGE_LEFT, 1);
-    ASSERT_EQ(gtk_layer_get_anchor(window, GTK_LAYER_SHELL_EDGE_LEFT), 1, "%d");
-    gtk_layer_set_anchor(window, GTK_LAYER_SHELL_EDGE_LEFT, 2);
-    ASSERT_EQ(gtk_layer_get_anchor(window, GTK_LAYER_SHELL_EDGE_LEFT), 1, "%d");
-
+    gtk_pip_init_for_window(window);
     gtk_widget_show_all(GTK_WIDGET(window));
+}
 
-    gtk_layer_set_anchor(window, GTK_LAYER_SHELL_EDGE_TOP, -1);
-    ASSERT_EQ(gtk_layer_get_anchor(window, GTK_LAYER_SHELL_EDGE_TOP), 1, "%d");
+static void callback_1()
+{
+    double scale = gtk_pip_get_preferred_scale(window);
+    ASSERT_EQ((int)(scale * 120), DEFAULT_FRACTIONAL_SCALE_120, "%d");
+    int width, height;
+    gtk_pip_get_preferred_buffer_size(window, &width, &height);
+    ASSERT_EQ(width, DEFAULT_PIP_WIDTH * DEFAULT_FRACTIONAL_SCALE_120 / 120, "%d");
+    ASSERT_EQ(height, DEFAULT_PIP_HEIGHT * DEFAULT_FRACTIONAL_SCALE_120 / 120, "%d");
 }
 
 TEST_CALLBACKS(
     callback_0,
+    callback_1,
 )
@@ -0,0 +1,58 @@
+/* This entire file is licensed under MIT
+ *
+ * Copyright 2020 Sophie Winter
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "integration-test-common.h"
+
+static GtkWindow* window;
+static GtkRequisition last_allocation;
+static int size_changes;
+
+static void on_size_allocate(GtkWidget* _widget, GdkRectangle* allocation, gpointer _data)
+{
+    (void)_widget; (void)_data;
+    if (last_allocation.width == allocation->width && last_allocation.height == allocation->height)
+        return;
+    last_allocation = (GtkRequisition){allocation->width, allocation->height};
+    size_changes++;
+}
+
+static void callback_0()
+{
+    window = create_default_window();
+    gtk_widget_set_size_request(GTK_WIDGET(window), 300, 150);
+    gtk_pip_init_for_window(window);
+    gtk_pip_set_preferred_corner(window, GTK_PIP_CORNER_BOTTOM_RIGHT);
+    ASSERT_EQ(gtk_pip_get_preferred_corner(window), GTK_PIP_CORNER_BOTTOM_RIGHT, "%d");
+
+    // Both hints go out before the initial commit, so the first configure already has the placed size
+    EXPECT_MESSAGE(xdg_pip_v1 .set_initial_size 300 150);
+    EXPECT_MESSAGE(xdg_pip_v1 .set_preferred_corner 4);
+    EXPECT_MESSAGE(wl_surface .commit);
+    EXPECT_MESSAGE(xdg_pip_v1 .configure 320 180); // must match DEFAULT_PIP_WIDTH and DEFAULT_PIP_HEIGHT
+    gtk_widget_show_all(GTK_WIDGET(window));
+
+    // Only count the layouts after the one that picked the initial size
+    last_allocation = (GtkRequisition){300, 150};
+    g_signal_connect(window, "size-allocate", G_CALLBACK(on_size_allocate), NULL);
+}
+
+static void callback_1()
+{
+    // The mock server also asserts the first buffer was committed for the first configure
+    ASSERT_EQ(last_allocation.width, DEFAULT_PIP_WIDTH, "%d");
+    ASSERT_EQ(last_allocation.height, DEFAULT_PIP_HEIGHT, "%d");
+    ASSERT_EQ(size_changes, 1, "%d");
+}
+
+TEST_CALLBACKS(
+    callback_0,
+    callback_1,
+)
@@ -0,0 +1,77 @@
+/* This entire file is licensed under MIT
+ *
+ * Copyright 2020 Sophie Winter
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "integration-test-common.h"
+
+static GtkWindow* window;
+
+static void callback_0()
+{
+    window = create_default_window();
+    gtk_pip_init_for_window(window);
+    gtk_pip_set_app_id(window, "test-pip-interactive-resize");
+    gtk_widget_show_all(GTK_WIDGET(window));
+}
+
+static void callback_1()
+{
+    ASSERT(!gtk_pip_get_resizing(window));
+
+    EXPECT_MESSAGE(xdg_pip_v1 .resize);
+    // The mock server drags the bottom right corner, growing both axes by one step per committed frame
+    gtk_pip_resize(window, GDK_WINDOW_EDGE_SOUTH_EAST);
+    ASSERT(gtk_pip_get_resizing(window));
+}
+
+static void callback_2()
+{
+    // Frames may be throttled by the frame clock, so keep the main loop running until the drag is over
+    // The resize always ends on a timeout once the mock server stops sending configures
+    while (gtk_pip_get_resizing(window))
+    {
+        int width, height, predicted_width, predicted_height;
+        gtk_window_get_size(window, &width, &height);
+        gtk_pip_get_predicted_size(window, &predicted_width, &predicted_height);
+        // The edge only moves outwards and the prediction must stay within the bounds
+        ASSERT(predicted_width >= width);
+        ASSERT(predicted_height >= height);
+        ASSERT(predicted_width <= DEFAULT_OUTPUT_WIDTH / 2);
+        ASSERT(predicted_height <= DEFAULT_OUTPUT_HEIGHT / 2);
+        gtk_main_iteration();
+    }
+}
+
+static void callback_3()
+{
+    int width, height;
+    gtk_window_get_size(window, &width, &height);
+    ASSERT_EQ(width, DEFAULT_PIP_WIDTH + PIP_RESIZE_STEPS * PIP_RESIZE_STEP_SIZE, "%d");
+    ASSERT_EQ(height, DEFAULT_PIP_HEIGHT + PIP_RESIZE_STEPS * PIP_RESIZE_STEP_SIZE, "%d");
+
+    GtkPipResizeStats stats;
+    gtk_pip_get_resize_stats(window, &stats);
+    ASSERT(stats.commits > 0);
+    ASSERT(stats.commits <= PIP_RESIZE_STEPS);
+    ASSERT(stats.max_latency_us >= stats.mean_latency_us);
+
+    // Once the drag is over, the prediction is just the current size
+    int predicted_width, predicted_height;
+    gtk_pip_get_predicted_size(window, &predicted_width, &predicted_height);
+    ASSERT_EQ(predicted_width, width, "%d");
+    ASSERT_EQ(predicted_height, height, "%d");
+}
+
+TEST_CALLBACKS(
+    callback_0,
+    callback_1,
+    callback_2,
+    callback_3,
+)
@@ -0,0 +1,122 @@
+/* This entire file is licensed under MIT
+ *
+ * Copyright 2020 Sophie Winter
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "integration-test-common.h"
+
+// Keep in sync with the budget documented above pip_surface_new () in pip-surface.h
+#define MAX_ALLOCATIONS_PER_SURFACE 4
+#define MAX_BYTES_PER_SURFACE 1024
+#define MEASURED_WINDOW_COUNT 16
+
+#ifdef __GLIBC__
+
+// Count every allocation made while a shell surface is being created. Calls are passed straight through to glibc so
+// this works regardless of how GLib was built.
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+
+static gboolean counting = FALSE;
+static size_t allocation_count = 0;
+static size_t allocation_bytes = 0;
+
+void *malloc(size_t size)
+{
+    if (counting)
+    {
+        allocation_count++;
+        allocation_bytes += size;
+    }
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size)
+{
+    if (counting)
+    {
+        allocation_count++;
+        allocation_bytes += count * size;
+    }
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+    if (counting)
+    {
+        allocation_count++;
+        allocation_bytes += size;
+    }
+    return __libc_realloc(ptr, size);
+}
+
+static GtkWindow *windows[MEASURED_WINDOW_COUNT];
+
+static void callback_0()
+{
+    // The first surface pays for one-time setup (the Wayland globals, quarks and the private GtkWindow subtype)
+    GtkWindow *warm_up = create_default_window();
+    gtk_pip_init_for_window(warm_up);
+    gtk_widget_destroy(GTK_WIDGET(warm_up));
+
+    for (int i = 0; i < MEASURED_WINDOW_COUNT; i++)
+        windows[i] = create_default_window();
+
+    counting = TRUE;
+    for (int i = 0; i < MEASURED_WINDOW_COUNT; i++)
+        gtk_pip_init_for_window(windows[i]);
+    counting = FALSE;
+
+    size_t count = allocation_count / MEASURED_WINDOW_COUNT;
+    size_t bytes = allocation_bytes / MEASURED_WINDOW_COUNT;
+    fprintf(stderr, "Surface creation costs %zu allocations and %zu bytes\n", count, bytes);
+    ASSERT(count <= MAX_ALLOCATIONS_PER_SURFACE);
+    ASSERT(bytes <= MAX_BYTES_PER_SURFACE);
+
+    // Window state changes reach the surface through the vfuncs of the private subtype, not per-window handlers
+    for (int i = 0; i < MEASURED_WINDOW_COUNT; i++)
+    {
+        ASSERT(!g_signal_has_handler_pending(windows[i], g_signal_lookup("map", GTK_TYPE_WINDOW), 0, FALSE));
+        ASSERT(!g_signal_has_handler_pending(windows[i], g_signal_lookup("size-allocate", GTK_TYPE_WINDOW), 0, FALSE));
+    }
+}
+
+static void callback_1()
+{
+    // Surfaces created this way must still work
+    gtk_widget_show_all(GTK_WIDGET(windows[0]));
+}
+
+static void callback_2()
+{
+    for (int i = 0; i < MEASURED_WINDOW_COUNT; i++)
+        gtk_widget_destroy(GTK_WIDGET(windows[i]));
+}
+
+TEST_CALLBACKS(
+    callback_0,
+    callback_1,
+    callback_2,
+)
+
+#else // __GLIBC__
+
+// Allocations can only be counted by interposing glibc's allocator
+static void callback_0()
+{
+    fprintf(stderr, "Not built against glibc, memory budget not checked\n");
+}
+
+TEST_CALLBACKS(
+    callback_0,
+)
+
+#endif // __GLIBC__
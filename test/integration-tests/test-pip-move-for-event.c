@@ -12,55 +12,50 @@
 #include "integration-test-common.h"
 
 static GtkWindow* window;
+static GdkEvent* press_event = NULL;
 
-static void callback_0()
+static gboolean on_button_press(GtkWidget* _widget, GdkEventButton* event, gpointer _data)
 {
-    // First, anchor to bottom
-    EXPECT_MESSAGE(zwlr_layer_surface_v1 .set_exclusive_zone 200);
+    (void)_widget; (void)_data;
+    if (!press_event)
+        press_event = gdk_event_copy((GdkEvent*)event);
+    return FALSE;
+}
 
+static void callback_0()
+{
     window = create_default_window();
-
-    gtk_layer_init_for_window(window);
-    gtk_layer_auto_exclusive_zone_enable(window);
-    gtk_layer_set_anchor(window, GTK_LAYER_SHELL_EDGE_BOTTOM, TRUE);
-    gtk_widget_set_size_request(GTK_WIDGET(window), 300, 200);
+    gtk_pip_init_for_window(window);
+    // Makes the mock server click the pip and then press a key, so the click is not the newest serial
+    gtk_pip_set_app_id(window, "test-pip-move-for-event" PIP_CLICK_APP_ID_SUFFIX);
+    g_signal_connect(window, "button-press-event", G_CALLBACK(on_button_press), NULL);
     gtk_widget_show_all(GTK_WIDGET(window));
 }
 
 static void callback_1()
 {
-    // Resize
-    EXPECT_MESSAGE(zwlr_layer_surface_v1 .set_exclusive_zone 240);
-
-    gtk_widget_set_size_request(GTK_WIDGET(window), 320, 240);
-    gtk_window_resize(window, 1, 1);
+    ASSERT(press_event);
+    // The mock server fails if the serial is not the click's
+    EXPECT_MESSAGE(xdg_pip_v1 .move);
+    gtk_pip_move_for_event(window, press_event);
 }
 
 static void callback_2()
 {
-    // Streatch across left edge
-    EXPECT_MESSAGE(zwlr_layer_surface_v1 .set_exclusive_zone 320);
-
-    gtk_layer_set_anchor(window, GTK_LAYER_SHELL_EDGE_TOP, TRUE);
-    gtk_layer_set_anchor(window, GTK_LAYER_SHELL_EDGE_LEFT, TRUE);
+    EXPECT_MESSAGE(xdg_pip_v1 .move);
+    gtk_window_begin_move_drag(window,
+                               press_event->button.button,
+                               (gint)press_event->button.x_root,
+                               (gint)press_event->button.y_root,
+                               press_event->button.time);
 }
 
 static void callback_3()
 {
-    // Stretch across top
-    EXPECT_MESSAGE(zwlr_layer_surface_v1 .set_exclusive_zone 240);
-
-    gtk_layer_set_anchor(window, GTK_LAYER_SHELL_EDGE_BOTTOM, FALSE);
-    gtk_layer_set_anchor(window, GTK_LAYER_SHELL_EDGE_RIGHT, TRUE);
-}
-
-static void callback_4()
-{
-    // Anchor right
-    EXPECT_MESSAGE(zwlr_layer_surface_v1 .set_exclusive_zone 320);
-
-    gtk_layer_set_anchor(window, GTK_LAYER_SHELL_EDGE_TOP, FALSE);
-    gtk_layer_set_anchor(window, GTK_LAYER_SHELL_EDGE_LEFT, FALSE);
+    EXPECT_MESSAGE(xdg_pip_v1 .resize);
+    gtk_pip_resize_for_event(window, GDK_WINDOW_EDGE_SOUTH_EAST, press_event);
+    gdk_event_free(press_event);
+    press_event = NULL;
 }
 
 TEST_CALLBACKS(
@@ -68,5 +63,4 @@ TEST_CALLBACKS(
     callback_1,
     callback_2,
     callback_3,
-    callback_4,
 )
@@ -15,21 +15,23 @@ static GtkWindow* window;
 
 static void callback_0()
 {
-    EXPECT_MESSAGE(zwlr_layer_surface_v1 .set_exclusive_zone 300);
-
     window = create_default_window();
-
-    gtk_layer_init_for_window(window);
-    gtk_layer_auto_exclusive_zone_enable(window);
-
-    // Note that true bools are normally 1, but can be other non-zero values
-    // This used to cause a problem, as noted in https://github.com/wmww/gtk-layer-shell/pull/79
-    gtk_layer_set_anchor(window, GTK_LAYER_SHELL_EDGE_BOTTOM, 1);
-    gtk_layer_set_anchor(window, GTK_LAYER_SHELL_EDGE_TOP, 2);
-    gtk_layer_set_anchor(window, GTK_LAYER_SHELL_EDGE_LEFT, 3);
-
-    gtk_widget_set_size_request(GTK_WIDGET(window), 300, 200);
+    // The first configure has the size the mock server places pips at, which the buffer must be rendered at to be used
+    gtk_widget_set_size_request(GTK_WIDGET(window), DEFAULT_PIP_WIDTH, DEFAULT_PIP_HEIGHT);
+    gtk_pip_init_for_window(window);
+    gtk_pip_set_prepare_offscreen(window, TRUE);
+    ASSERT(gtk_pip_get_prepare_offscreen(window));
+
+    // The pre-rendered buffer is attached right after the first configure is acked, before GTK draws anything
+    EXPECT_MESSAGE(xdg_surface .ack_configure);
+    EXPECT_MESSAGE(wl_surface .attach);
+    EXPECT_MESSAGE(wl_surface .commit);
     gtk_widget_show_all(GTK_WIDGET(window));
+
+    // The mock server places the pip (and sends wl_surface.enter) once it has a buffer, which GTK on its own would not
+    // have committed yet as the main loop has not run
+    wl_display_roundtrip(gdk_wayland_display_get_wl_display(gdk_display_get_default()));
+    ASSERT(gtk_pip_get_monitor(window) != NULL);
 }
 
 TEST_CALLBACKS(
@@ -15,52 +15,51 @@ static GtkWindow* window;
 
 static void callback_0()
 {
-    EXPECT_MESSAGE(zwlr_layer_surface_v1 .set_size 0 0);
-
     window = create_default_window();
-    gtk_layer_init_for_window(window);
-    gtk_layer_set_layer(window, GTK_LAYER_SHELL_LAYER_BOTTOM);
-    gtk_layer_set_namespace(window, "foobar");
-    gtk_layer_set_anchor(window, GTK_LAYER_SHELL_EDGE_BOTTOM, TRUE);
-    gtk_layer_set_anchor(window, GTK_LAYER_SHELL_EDGE_TOP, TRUE);
-    gtk_layer_set_anchor(window, GTK_LAYER_SHELL_EDGE_LEFT, TRUE);
-    gtk_layer_set_anchor(window, GTK_LAYER_SHELL_EDGE_RIGHT, TRUE);
+    gtk_pip_init_for_window(window);
+    gtk_pip_set_content_type(window, GTK_PIP_CONTENT_TYPE_VIDEO);
+    gtk_pip_set_low_latency(window, TRUE);
+    ASSERT_EQ(gtk_pip_get_content_type(window), GTK_PIP_CONTENT_TYPE_VIDEO, "%d");
+    ASSERT(gtk_pip_get_low_latency(window));
+
+    // Both hints must be set before the initial commit, which the mock server answers with configure_bounds
+    EXPECT_MESSAGE(xdg_wm_pip_v1 .get_xdg_pip);
+    EXPECT_MESSAGE(wp_content_type_v1 .set_content_type 2);
+    EXPECT_MESSAGE(wp_tearing_control_v1 .set_presentation_hint 1);
+    EXPECT_MESSAGE(wl_surface .commit);
+    EXPECT_MESSAGE(xdg_pip_v1 .configure_bounds);
     gtk_widget_show_all(GTK_WIDGET(window));
 }
 
 static void callback_1()
 {
-    EXPECT_MESSAGE(zwlr_layer_surface_v1 .set_size 600 700);
-
-    gtk_layer_set_anchor(window, GTK_LAYER_SHELL_EDGE_BOTTOM, FALSE);
-    gtk_layer_set_anchor(window, GTK_LAYER_SHELL_EDGE_TOP, FALSE);
-    gtk_layer_set_anchor(window, GTK_LAYER_SHELL_EDGE_LEFT, FALSE);
-    gtk_layer_set_anchor(window, GTK_LAYER_SHELL_EDGE_RIGHT, FALSE);
-    gtk_widget_set_size_request(GTK_WIDGET(window), 600, 700);
-    gtk_window_resize(window, 1, 1);
+    // Changing a hint while mapped reuses the existing object
+    EXPECT_MESSAGE(wp_content_type_v1 .set_content_type 3);
+    EXPECT_MESSAGE(wl_surface .commit);
+    gtk_pip_set_content_type(window, GTK_PIP_CONTENT_TYPE_GAME);
 }
 
 static void callback_2()
 {
-    EXPECT_MESSAGE(zwlr_layer_surface_v1 .set_size 0 700);
-
-    gtk_layer_set_anchor(window, GTK_LAYER_SHELL_EDGE_LEFT, TRUE);
-    gtk_layer_set_anchor(window, GTK_LAYER_SHELL_EDGE_RIGHT, TRUE);
+    EXPECT_MESSAGE(wp_tearing_control_v1 .set_presentation_hint 0);
+    gtk_pip_set_low_latency(window, FALSE);
+    ASSERT(!gtk_pip_get_low_latency(window));
 }
 
 static void callback_3()
 {
-    EXPECT_MESSAGE(zwlr_layer_surface_v1 .set_size 0 0);
-
-    gtk_layer_set_anchor(window, GTK_LAYER_SHELL_EDGE_BOTTOM, TRUE);
-    gtk_layer_set_anchor(window, GTK_LAYER_SHELL_EDGE_TOP, TRUE);
+    // The mock server asserts the objects are destroyed, so remapping may create new ones
+    EXPECT_MESSAGE(wp_content_type_v1 .destroy);
+    EXPECT_MESSAGE(wp_tearing_control_v1 .destroy);
+    gtk_widget_hide(GTK_WIDGET(window));
 }
 
 static void callback_4()
 {
-    EXPECT_MESSAGE(zwlr_layer_surface_v1 .set_size 600 0);
-
-    gtk_layer_set_anchor(window, GTK_LAYER_SHELL_EDGE_RIGHT, FALSE);
+    EXPECT_MESSAGE(wp_content_type_manager_v1 .get_surface_content_type);
+    EXPECT_MESSAGE(wp_content_type_v1 .set_content_type 3);
+    EXPECT_MESSAGE(wl_surface .commit);
+    gtk_widget_show_all(GTK_WIDGET(window));
 }
 
 TEST_CALLBACKS(
@@ -12,40 +12,45 @@
 #include "integration-test-common.h"
 
 static GtkWindow* window;
+static GtkRequisition first_allocation;
 
-static void callback_0()
+static void on_size_allocate(GtkWidget* _widget, GdkRectangle* allocation, gpointer _data)
 {
-    EXPECT_MESSAGE(zwlr_layer_surface_v1 .set_size 0 0);
-    EXPECT_MESSAGE(.create_buffer 1920 1080); // size must match DEFAULT_OUTPUT_WIDTH/DEFAULT_OUTPUT_HEIGHT in common.h
-
-    window = create_default_window();
+    (void)_widget; (void)_data;
+    if (first_allocation.width == 0)
+        first_allocation = (GtkRequisition){allocation->width, allocation->height};
+}
 
-    gtk_layer_init_for_window(window);
-    gtk_layer_set_layer(window, GTK_LAYER_SHELL_LAYER_BOTTOM);
-    gtk_layer_set_namespace(window, "foobar");
-    gtk_layer_set_anchor(window, GTK_LAYER_SHELL_EDGE_BOTTOM, TRUE);
-    gtk_layer_set_anchor(window, GTK_LAYER_SHELL_EDGE_TOP, TRUE);
-    gtk_layer_set_anchor(window, GTK_LAYER_SHELL_EDGE_LEFT, TRUE);
-    gtk_layer_set_anchor(window, GTK_LAYER_SHELL_EDGE_RIGHT, TRUE);
+static GtkWindow* create_remembering_window()
+{
+    GtkWindow* result = create_default_window();
+    gtk_pip_init_for_window(result);
+    gtk_pip_set_app_id(result, "test-pip-remember-size");
+    gtk_pip_set_remember_size(result, TRUE);
+    ASSERT(gtk_pip_get_remember_size(result));
+    return result;
+}
 
-    gtk_widget_set_size_request(GTK_WIDGET(window), 600, 700);
-    gtk_window_resize(window, 1, 1);
+static void callback_0()
+{
+    window = create_remembering_window();
     gtk_widget_show_all(GTK_WIDGET(window));
 }
 
 static void callback_1()
 {
-    EXPECT_MESSAGE(zwlr_layer_surface_v1 .set_size 600 0);
-    EXPECT_MESSAGE(.create_buffer 600 1080); // size must match DEFAULT_OUTPUT_HEIGHT in common.h
-
-    gtk_layer_set_anchor(window, GTK_LAYER_SHELL_EDGE_LEFT, FALSE);
+    // By now the mock server has placed the pip, so its size has been stored
+    gtk_widget_destroy(GTK_WIDGET(window));
+    window = create_remembering_window();
+    g_signal_connect(window, "size-allocate", G_CALLBACK(on_size_allocate), NULL);
+    gtk_widget_show_all(GTK_WIDGET(window));
 }
 
 static void callback_2()
 {
-    EXPECT_MESSAGE(zwlr_layer_surface_v1 .set_size 600 700);
-    EXPECT_MESSAGE(.create_buffer 600 700);
-    gtk_layer_set_anchor(window, GTK_LAYER_SHELL_EDGE_BOTTOM, FALSE);
+    // The first layout should already use the remembered size instead of the label's natural size
+    ASSERT_EQ(first_allocation.width, DEFAULT_PIP_WIDTH, "%d");
+    ASSERT_EQ(first_allocation.height, DEFAULT_PIP_HEIGHT, "%d");
 }
 
 TEST_CALLBACKS(
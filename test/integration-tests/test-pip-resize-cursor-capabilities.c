@@ -13,41 +13,42 @@
 
 static GtkWindow* window;
 
-static void set_anchors(GtkWindow* window, gboolean top, gboolean bottom, gboolean left, gboolean right)
-{
-    gtk_layer_set_anchor(window, GTK_LAYER_SHELL_EDGE_TOP, top);
-    gtk_layer_set_anchor(window, GTK_LAYER_SHELL_EDGE_BOTTOM, bottom);
-    gtk_layer_set_anchor(window, GTK_LAYER_SHELL_EDGE_LEFT, left);
-    gtk_layer_set_anchor(window, GTK_LAYER_SHELL_EDGE_RIGHT, right);
-}
-
 static void callback_0()
 {
-    EXPECT_MESSAGE(zwlr_layer_surface_v1 .set_anchor 1);
-
     window = create_default_window();
-    gtk_layer_init_for_window(window);
+    gtk_pip_init_for_window(window);
+    // The mock server clicks the pip, so the pointer is over it
+    gtk_pip_set_app_id(window, "test-pip-resize-cursor-capabilities" PIP_CLICK_APP_ID_SUFFIX);
     gtk_widget_show_all(GTK_WIDGET(window));
-
-    set_anchors(window, TRUE, FALSE, FALSE, FALSE);
 }
 
 static void callback_1()
 {
-    EXPECT_MESSAGE(zwlr_layer_surface_v1 .set_anchor 2);
-    set_anchors(window, FALSE, TRUE, FALSE, FALSE);
+    EXPECT_MESSAGE(wp_cursor_shape_manager_v1 .get_pointer);
+    EXPECT_MESSAGE(wp_cursor_shape_device_v1 .set_shape 23); // se_resize
+    gtk_pip_set_resize_cursor(window, GDK_WINDOW_EDGE_SOUTH_EAST);
 }
 
 static void callback_2()
 {
-    EXPECT_MESSAGE(zwlr_layer_surface_v1 .set_anchor 4);
-    set_anchors(window, FALSE, FALSE, TRUE, FALSE);
+    // The mock server takes the pointer away and gives a new one back, which enters the pip again
+    EXPECT_MESSAGE(wl_pointer .release);
+    EXPECT_MESSAGE(wl_seat .get_pointer);
+    EXPECT_MESSAGE(wl_pointer .enter);
+    gtk_pip_set_app_id(window, "test-pip-resize-cursor-capabilities" PIP_TOGGLE_POINTER_APP_ID_SUFFIX);
 }
 
 static void callback_3()
 {
-    EXPECT_MESSAGE(zwlr_layer_surface_v1 .set_anchor 8);
-    set_anchors(window, FALSE, FALSE, FALSE, TRUE);
+    // The device made for the released pointer is of no use, so one is made for the new pointer
+    EXPECT_MESSAGE(wp_cursor_shape_manager_v1 .get_pointer);
+    EXPECT_MESSAGE(wp_cursor_shape_device_v1 .set_shape 19); // n_resize
+    gtk_pip_set_resize_cursor(window, GDK_WINDOW_EDGE_NORTH);
+}
+
+static void callback_4()
+{
+    gtk_widget_destroy(GTK_WIDGET(window));
 }
 
 TEST_CALLBACKS(
@@ -55,4 +56,5 @@ TEST_CALLBACKS(
     callback_1,
     callback_2,
     callback_3,
+    callback_4,
 )
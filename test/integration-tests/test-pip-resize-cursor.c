@@ -13,47 +13,40 @@
 
 static GtkWindow* window;
 
-static void set_anchors(GtkWindow* window, gboolean top, gboolean bottom, gboolean left, gboolean right)
-{
-    gtk_layer_set_anchor(window, GTK_LAYER_SHELL_EDGE_TOP, top);
-    gtk_layer_set_anchor(window, GTK_LAYER_SHELL_EDGE_BOTTOM, bottom);
-    gtk_layer_set_anchor(window, GTK_LAYER_SHELL_EDGE_LEFT, left);
-    gtk_layer_set_anchor(window, GTK_LAYER_SHELL_EDGE_RIGHT, right);
-}
-
 static void callback_0()
 {
-    EXPECT_MESSAGE(zwlr_layer_surface_v1 .set_anchor 0);
-
     window = create_default_window();
-    gtk_layer_init_for_window(window);
+    gtk_pip_init_for_window(window);
+    // The mock server clicks the pip, so the pointer is over it
+    gtk_pip_set_app_id(window, "test-pip-resize-cursor" PIP_CLICK_APP_ID_SUFFIX);
     gtk_widget_show_all(GTK_WIDGET(window));
-
-    set_anchors(window, FALSE, FALSE, FALSE, FALSE);
 }
 
 static void callback_1()
 {
-    EXPECT_MESSAGE(zwlr_layer_surface_v1 .set_anchor 3);
-    set_anchors(window, TRUE, TRUE, FALSE, FALSE);
+    EXPECT_MESSAGE(wp_cursor_shape_manager_v1 .get_pointer);
+    EXPECT_MESSAGE(wp_cursor_shape_device_v1 .set_shape 23); // se_resize
+    gtk_pip_set_resize_cursor(window, GDK_WINDOW_EDGE_SOUTH_EAST);
+    // GDK may have set its own cursor in between, so setting the same shape again sends it again
+    gtk_pip_set_resize_cursor(window, GDK_WINDOW_EDGE_SOUTH_EAST);
 }
 
 static void callback_2()
 {
-    EXPECT_MESSAGE(zwlr_layer_surface_v1 .set_anchor 13);
-    set_anchors(window, TRUE, FALSE, TRUE, TRUE);
+    EXPECT_MESSAGE(wp_cursor_shape_device_v1 .set_shape 19); // n_resize
+    gtk_pip_set_resize_cursor(window, GDK_WINDOW_EDGE_NORTH);
 }
 
 static void callback_3()
 {
-    EXPECT_MESSAGE(zwlr_layer_surface_v1 .set_anchor 15);
-    set_anchors(window, TRUE, TRUE, TRUE, TRUE);
+    EXPECT_MESSAGE(wp_cursor_shape_device_v1 .set_shape 1); // default
+    gtk_pip_unset_resize_cursor(window);
 }
 
 static void callback_4()
 {
-    EXPECT_MESSAGE(zwlr_layer_surface_v1 .set_anchor 0);
-    set_anchors(window, FALSE, FALSE, FALSE, FALSE);
+    // Lets the mock server report cursor uploads when benchmarking
+    gtk_widget_destroy(GTK_WIDGET(window));
 }
 
 TEST_CALLBACKS(
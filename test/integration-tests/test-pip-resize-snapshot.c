@@ -0,0 +1,72 @@
+/* This entire file is licensed under MIT
+ *
+ * Copyright 2020 Sophie Winter
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "integration-test-common.h"
+
+static GtkWindow* window;
+static int label_draws = 0;
+
+static gboolean on_label_draw(GtkWidget *_widget, cairo_t *_cr, gpointer _data)
+{
+    (void)_widget; (void)_cr; (void)_data;
+    label_draws++;
+    return FALSE;
+}
+
+static void callback_0()
+{
+    window = create_default_window();
+    gtk_pip_init_for_window(window);
+    gtk_pip_set_app_id(window, "test-pip-resize-snapshot");
+    ASSERT(!gtk_pip_get_resize_snapshot(window));
+    gtk_pip_set_resize_snapshot(window, TRUE);
+    ASSERT(gtk_pip_get_resize_snapshot(window));
+    g_signal_connect(gtk_bin_get_child(GTK_BIN(window)), "draw", G_CALLBACK(on_label_draw), NULL);
+    gtk_widget_show_all(GTK_WIDGET(window));
+}
+
+static void callback_1()
+{
+    EXPECT_MESSAGE(xdg_pip_v1 .resize);
+    // The snapshot is drawn here, outside of any frame
+    gtk_pip_resize(window, GDK_WINDOW_EDGE_SOUTH_EAST);
+    ASSERT(gtk_pip_get_resizing(window));
+    label_draws = 0;
+}
+
+static void callback_2()
+{
+    // Every frame of the drag shows the scaled snapshot, so the label is laid out but never drawn
+    while (gtk_pip_get_resizing(window))
+    {
+        gtk_main_iteration();
+        ASSERT_EQ(label_draws, 0, "%d");
+    }
+}
+
+static void callback_3()
+{
+    int width, height;
+    gtk_window_get_size(window, &width, &height);
+    ASSERT_EQ(width, DEFAULT_PIP_WIDTH + PIP_RESIZE_STEPS * PIP_RESIZE_STEP_SIZE, "%d");
+    ASSERT_EQ(height, DEFAULT_PIP_HEIGHT + PIP_RESIZE_STEPS * PIP_RESIZE_STEP_SIZE, "%d");
+
+    // The redraw queued when the drag ends draws the widgets again
+    while (label_draws == 0)
+        gtk_main_iteration();
+}
+
+TEST_CALLBACKS(
+    callback_0,
+    callback_1,
+    callback_2,
+    callback_3,
+)
@@ -15,38 +15,28 @@ static GtkWindow* window;
 
 static void callback_0()
 {
-    EXPECT_MESSAGE(zwlr_layer_shell_v1 .get_layer_surface 2);
-
     window = create_default_window();
-    gtk_layer_init_for_window(window);
-    gtk_layer_set_layer(window, GTK_LAYER_SHELL_LAYER_TOP);
+    gtk_pip_init_for_window(window);
     gtk_widget_show_all(GTK_WIDGET(window));
 }
 
 static void callback_1()
 {
-    EXPECT_MESSAGE(zwlr_layer_surface_v1 .set_layer 3);
-
-    gtk_layer_set_layer(window, GTK_LAYER_SHELL_LAYER_OVERLAY);
+    EXPECT_MESSAGE(wl_region .add 0 150 320 30); // must fit in DEFAULT_PIP_WIDTH/DEFAULT_PIP_HEIGHT in test-common.h
+    EXPECT_MESSAGE(wl_surface .set_input_region);
+    EXPECT_MESSAGE(wl_surface .commit);
+    GdkRectangle control_bar = {0, DEFAULT_PIP_HEIGHT - 30, DEFAULT_PIP_WIDTH, 30};
+    gtk_pip_set_input_rect(window, &control_bar);
 }
 
 static void callback_2()
 {
-    EXPECT_MESSAGE(zwlr_layer_surface_v1 .set_layer 0);
-
-    gtk_layer_set_layer(window, GTK_LAYER_SHELL_LAYER_BACKGROUND);
-}
-
-static void callback_3()
-{
-    EXPECT_MESSAGE(zwlr_layer_surface_v1 .set_layer 1);
-
-    gtk_layer_set_layer(window, GTK_LAYER_SHELL_LAYER_BOTTOM);
+    EXPECT_MESSAGE(wl_surface .set_input_region nil);
+    gtk_pip_set_input_rect(window, NULL);
 }
 
 TEST_CALLBACKS(
     callback_0,
     callback_1,
     callback_2,
-    callback_3,
 )
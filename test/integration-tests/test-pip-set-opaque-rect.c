@@ -15,27 +15,31 @@ static GtkWindow* window;
 
 static void callback_0()
 {
-    EXPECT_MESSAGE(zwlr_layer_surface_v1 .set_exclusive_zone 240);
-
     window = create_default_window();
-
-    gtk_layer_init_for_window(window);
-    gtk_layer_auto_exclusive_zone_enable(window);
-    gtk_layer_set_anchor(window, GTK_LAYER_SHELL_EDGE_BOTTOM, TRUE);
-    gtk_widget_set_size_request(GTK_WIDGET(window), 320, 240);
+    gtk_pip_init_for_window(window);
     gtk_widget_show_all(GTK_WIDGET(window));
 }
 
 static void callback_1()
 {
-    // Bottom margin should have no effect on exclusive zone but top margin should
-    EXPECT_MESSAGE(zwlr_layer_surface_v1 .set_exclusive_zone 250);
+    EXPECT_MESSAGE(wl_region .add 10 20 100 50);
+    EXPECT_MESSAGE(wl_surface .set_opaque_region);
+    EXPECT_MESSAGE(wl_surface .commit);
+    GdkRectangle rect = {10, 20, 100, 50};
+    gtk_pip_set_opaque_rect(window, &rect);
+}
 
-    gtk_layer_set_margin(window, GTK_LAYER_SHELL_EDGE_TOP, 10);
-    gtk_layer_set_margin(window, GTK_LAYER_SHELL_EDGE_BOTTOM, 5);
+static void callback_2()
+{
+    // Clipped to the window
+    EXPECT_MESSAGE(wl_region .add 0 0 320 30); // width must match DEFAULT_PIP_WIDTH in test-common.h
+    EXPECT_MESSAGE(wl_surface .set_opaque_region);
+    GdkRectangle rect = {-10, -10, 10000, 40};
+    gtk_pip_set_opaque_rect(window, &rect);
 }
 
 TEST_CALLBACKS(
     callback_0,
     callback_1,
+    callback_2,
 )
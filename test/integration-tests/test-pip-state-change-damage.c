@@ -16,19 +16,18 @@ static GtkWindow* window;
 static void callback_0()
 {
     window = create_default_window();
-    gtk_layer_init_for_window(window);
-    gtk_layer_set_layer(window, GTK_LAYER_SHELL_LAYER_BOTTOM);
-    gtk_layer_set_namespace(window, "foobar");
-    gtk_layer_set_anchor(window, GTK_LAYER_SHELL_EDGE_BOTTOM, TRUE);
-    gtk_layer_set_exclusive_zone(window, 32);
+    gtk_pip_init_for_window(window);
+    gtk_widget_show_all(GTK_WIDGET(window));
 }
 
 static void callback_1()
 {
-    EXPECT_MESSAGE(zwlr_layer_shell_v1 .get_layer_surface 1 "foobar");
-    EXPECT_MESSAGE(zwlr_layer_surface_v1 .set_exclusive_zone 32);
+    // Changing surface state needs a commit, but should not damage the whole surface
+    EXPECT_MESSAGE(wl_surface .set_input_region);
+    EXPECT_MESSAGE(wl_surface .damage 0 0 1 1);
     EXPECT_MESSAGE(wl_surface .commit);
-    gtk_widget_show_all(GTK_WIDGET(window));
+    GdkRectangle rect = {0, 0, 20, 20};
+    gtk_pip_set_input_rect(window, &rect);
 }
 
 TEST_CALLBACKS(
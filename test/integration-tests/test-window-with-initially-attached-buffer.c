@@ -27,7 +27,7 @@ static void callback_0()
 {
     window = create_default_window();
     g_signal_connect(G_OBJECT(window), "realize", G_CALLBACK(on_realize), NULL);
-    gtk_layer_init_for_window(window);
+    gtk_pip_init_for_window(window);
     gtk_widget_show_all(GTK_WIDGET(window));
 }
 TEST_CALLBACKS(
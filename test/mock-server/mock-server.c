@@ -10,8 +10,12 @@
  */
 
 #include "mock-server.h"
+#include <stdint.h>
+#include <time.h>
 
 struct wl_display* display = NULL;
+char benchmark_mode = 0;
+char leak_check_mode = 0;
 
 void* alloc_zeroed(size_t size)
 {
@@ -30,14 +34,67 @@ static const char* get_display_name()
     return result;
 }
 
+// Everything the dispatcher needs to know about a request, looked up by its wl_message pointer
 typedef struct
 {
-    const struct wl_message* message;
-    RequestOverrideFunction function;
-    struct wl_list link;
-} RequestOverride;
+    const struct wl_message* message; // NULL if the slot is empty
+    const char* interface_name;
+    RequestOverrideFunction function; // NULL if the default implementation is used
+    char is_destroy;
+    char has_new_id; // If any argument is a new_id, which needs a resource to be created
+    uint16_t recording_index; // Index used for this message in the recording, or 0 if not yet written
+} MessageInfo;
 
-struct wl_list request_overrides;
+// Open addressing hash table, always at most half full
+static MessageInfo* message_table = NULL;
+static size_t message_table_capacity = 0;
+static size_t message_table_count = 0;
+
+static FILE* recording = NULL;
+static uint16_t recording_message_count = 0;
+static uint64_t recording_start_us = 0;
+
+static size_t message_table_slot(const MessageInfo* table, size_t capacity, const struct wl_message* message)
+{
+    // Messages are elements of static arrays, so the low bits carry little information
+    size_t hash = (size_t)(uintptr_t)message;
+    hash = (hash >> 4) ^ (hash >> 12);
+    size_t slot = hash & (capacity - 1);
+    while (table[slot].message && table[slot].message != message)
+        slot = (slot + 1) & (capacity - 1);
+    return slot;
+}
+
+static void message_table_grow()
+{
+    size_t capacity = message_table_capacity ? message_table_capacity * 2 : 256;
+    MessageInfo* table = alloc_zeroed(capacity * sizeof(MessageInfo));
+    for (size_t i = 0; i < message_table_capacity; i++)
+    {
+        if (message_table[i].message)
+            table[message_table_slot(table, capacity, message_table[i].message)] = message_table[i];
+    }
+    free(message_table);
+    message_table = table;
+    message_table_capacity = capacity;
+}
+
+// Returns the info for the given message, adding it if this is the first time it has been seen
+static MessageInfo* message_table_get(const char* interface_name, const struct wl_message* message)
+{
+    if ((message_table_count + 1) * 2 > message_table_capacity)
+        message_table_grow();
+    MessageInfo* info = &message_table[message_table_slot(message_table, message_table_capacity, message)];
+    if (!info->message)
+    {
+        info->message = message;
+        info->interface_name = interface_name;
+        info->is_destroy = (strcmp(message->name, "destroy") == 0);
+        info->has_new_id = (strchr(message->signature, 'n') != NULL);
+        message_table_count++;
+    }
+    return info;
+}
 
 void install_request_override(const struct wl_interface* interface, const char* name, RequestOverrideFunction function)
 {
@@ -45,33 +102,81 @@ void install_request_override(const struct wl_interface* interface, const char*
     {
         if (strcmp(name, interface->methods[i].name) == 0)
         {
-            RequestOverride* override = ALLOC_STRUCT(RequestOverride);
-            override->message = &interface->methods[i];
-            override->function = function;
-            wl_list_insert(&request_overrides, &override->link);
+            message_table_get(interface->name, &interface->methods[i])->function = function;
             return;
         }
     }
     FATAL_FMT("Interface %s does not have a request named %s", interface->name, name);
 }
 
+uint64_t monotonic_time_us()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void recording_write(const void* data, size_t size)
+{
+    if (fwrite(data, size, 1, recording) != 1)
+        FATAL("failed to write to the recording");
+}
+
+static void open_recording(const char* path)
+{
+    recording = fopen(path, "wb");
+    if (!recording)
+        FATAL_FMT("failed to open recording %s", path);
+    recording_write(RECORDING_MAGIC, 4);
+    uint32_t version = RECORDING_VERSION;
+    recording_write(&version, sizeof(version));
+    recording_start_us = monotonic_time_us();
+}
+
+// See RECORDING_MAGIC for the format
+static void record_request(MessageInfo* info, struct wl_resource* resource)
+{
+    if (!info->recording_index)
+    {
+        if (recording_message_count == UINT16_MAX)
+            FATAL("too many different messages to record");
+        info->recording_index = ++recording_message_count;
+        char name[256];
+        int name_len = snprintf(name, sizeof(name), "%s.%s", info->interface_name, info->message->name);
+        uint8_t type = RECORDING_MESSAGE_NAME;
+        uint16_t len = (uint16_t)name_len;
+        recording_write(&type, sizeof(type));
+        recording_write(&info->recording_index, sizeof(info->recording_index));
+        recording_write(&len, sizeof(len));
+        recording_write(name, len);
+    }
+    uint8_t type = RECORDING_REQUEST;
+    uint32_t object_id = wl_resource_get_id(resource);
+    uint64_t time_us = monotonic_time_us() - recording_start_us;
+    recording_write(&type, sizeof(type));
+    recording_write(&info->recording_index, sizeof(info->recording_index));
+    recording_write(&object_id, sizeof(object_id));
+    recording_write(&time_us, sizeof(time_us));
+}
+
 static int default_dispatcher(const void* data, void* resource, uint32_t opcode, const struct wl_message* message, union wl_argument* args)
 {
+    MessageInfo* info = message_table_get(wl_resource_get_class(resource), message);
+
+    if (recording)
+        record_request(info, resource);
+
     // First, check if there is an override
-    RequestOverride* override;
-    wl_list_for_each(override, &request_overrides, link)
+    if (info->function)
     {
-        if (override->message == message)
-        {
-            override->function(resource, message, args);
-            return 0;
-        }
+        info->function(resource, message, args);
+        return 0;
     }
 
     // If there are any new-id type arguments, resources need to be created for them
     // See https://wayland.freedesktop.org/docs/html/apb.html#Client-structwl__message
     int arg = 0;
-    for (const char* c = message->signature; *c; c++)
+    for (const char* c = message->signature; info->has_new_id && *c; c++)
     {
         if (*c == 'n' && args[arg].n != 0)
         {
@@ -85,7 +190,7 @@ static int default_dispatcher(const void* data, void* resource, uint32_t opcode,
         if (*c >= 'a' && *c <= 'z')
             arg++;
     }
-    if (strcmp(message->name, "destroy") == 0)
+    if (info->is_destroy)
     {
         wl_resource_destroy(resource);
     }
@@ -146,7 +251,35 @@ static struct wl_listener client_connect_listener = {
 
 int main(int argc, const char** argv)
 {
-    wl_list_init(&request_overrides);
+    int ready_fd = -1;
+    const char* record_events_path = NULL;
+    const char* replay_path = NULL;
+    double replay_speed = 1.0;
+    double refresh_rate = 0;
+    uint64_t release_latency_us = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--benchmark") == 0)
+            benchmark_mode = 1;
+        else if (strcmp(argv[i], "--leak-check") == 0)
+            leak_check_mode = 1;
+        else if (strcmp(argv[i], "--ready-fd") == 0 && i + 1 < argc)
+            ready_fd = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc)
+            open_recording(argv[++i]);
+        else if (strcmp(argv[i], "--record-events") == 0 && i + 1 < argc)
+            record_events_path = argv[++i];
+        else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+            replay_path = argv[++i];
+        else if (strcmp(argv[i], "--replay-speed") == 0 && i + 1 < argc)
+            replay_speed = atof(argv[++i]);
+        else if (strcmp(argv[i], "--refresh-rate") == 0 && i + 1 < argc)
+            refresh_rate = atof(argv[++i]);
+        else if (strcmp(argv[i], "--release-latency") == 0 && i + 1 < argc)
+            release_latency_us = strtoull(argv[++i], NULL, 10);
+        else
+            FATAL_FMT("unknown argument %s", argv[i]);
+    }
 
     display = wl_display_create();
     if (wl_display_add_socket(display, get_display_name()) != 0)
@@ -157,9 +290,28 @@ int main(int argc, const char** argv)
     wl_display_add_client_created_listener(display, &client_connect_listener);
 
     init();
+    vblank_init(refresh_rate, release_latency_us);
+
+    if (record_events_path)
+        trace_record_events(record_events_path);
+    if (replay_path)
+        trace_load_replay(replay_path, replay_speed);
+
+    if (ready_fd >= 0)
+    {
+        // Tell the test runner clients can connect now, so it doesn't have to poll for the socket
+        if (write(ready_fd, "1", 1) != 1)
+            FATAL("failed to write to the ready fd");
+        close(ready_fd);
+    }
 
     wl_display_run(display);
     wl_display_destroy(display);
 
+    if (recording)
+        fclose(recording);
+    trace_finish();
+    leak_check_report();
+
     return 0;
 }
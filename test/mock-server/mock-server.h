@@ -23,10 +23,87 @@
 #include "test-common.h"
 #include <wayland-server.h>
 #include "xdg-shell-server.h"
+#include "xdg-pip-v1-server.h"
 #include "wlr-layer-shell-unstable-v1-server.h"
+#ifdef HAVE_FRACTIONAL_SCALE
+#include "fractional-scale-v1-server.h"
+#endif
+#ifdef HAVE_CURSOR_SHAPE
+#include "cursor-shape-v1-server.h"
+#endif
+#ifdef HAVE_CONTENT_TYPE
+#include "content-type-v1-server.h"
+#endif
+#ifdef HAVE_TEARING_CONTROL
+#include "tearing-control-v1-server.h"
+#endif
+#ifdef HAVE_LINUX_DMABUF
+#include "linux-dmabuf-unstable-v1-server.h"
+#endif
 
 extern struct wl_display* display;
 
+// Set when the server is run with --benchmark, overrides may then report measurements with BENCHMARK_REPORT()
+extern char benchmark_mode;
+
+// Set when the server is run with --leak-check, the server then fails if the number of objects the client has keeps
+// growing as pips are created and destroyed. Per pip reports are skipped, as soak runs destroy a great many pips.
+extern char leak_check_mode;
+// Reports the object counts seen by the leak check, if it ran
+void leak_check_report();
+
+// Format of the file written with --record, all integers are native endian:
+// - RECORDING_MAGIC, then a uint32_t RECORDING_VERSION
+// - A sequence of records, each starting with a uint8_t type:
+//   - RECORDING_MESSAGE_NAME: uint16_t message index, uint16_t length, then that many bytes of "interface.request"
+//     Written the first time each message is recorded, before any requests that use its index
+//   - RECORDING_REQUEST: uint16_t message index, uint32_t object ID, uint64_t microseconds since the recording started
+#define RECORDING_MAGIC "MSRQ"
+#define RECORDING_VERSION 1
+#define RECORDING_MESSAGE_NAME 1
+#define RECORDING_REQUEST 2
+
+// Format of the event traces written with --record-events and read with --replay, integers are native endian:
+// - TRACE_MAGIC, then a uint32_t TRACE_VERSION
+// - A sequence of records, each starting with a uint8_t type:
+//   - TRACE_MESSAGE_NAME: uint16_t message index, uint16_t length, then that many bytes of "interface.event"
+//     Written the first time each event is recorded, before any events that use its index
+//   - TRACE_EVENT: uint16_t message index, uint64_t microseconds since the trace started, uint8_t argument count, then
+//     that many int32_t arguments (fixed point numbers are raw, objects, serials and strings are 0)
+// test/convert-wayland-debug-trace.py writes the same format from a WAYLAND_DEBUG log
+#define TRACE_MAGIC "MSEV"
+#define TRACE_VERSION 1
+#define TRACE_MESSAGE_NAME 1
+#define TRACE_EVENT 2
+
+// Records pip, xdg_surface and pointer events sent to clients into an event trace
+void trace_record_events(const char* path);
+// Loads a trace to replay. Speed multiplies the trace's pace, 0 sends every event at once
+void trace_load_replay(const char* path, double speed);
+// Called once a pip is visible, starts replaying the loaded trace against it (only the first pip gets a replay)
+void trace_replay_begin(struct wl_resource* surface, struct wl_resource* xdg_surface, struct wl_resource* pip, struct wl_resource* pointer);
+// Closes the event trace being recorded, if any
+void trace_finish();
+
+// Starts the virtual refresh clock (see vblank.c). A refresh rate of 0 answers frame callbacks on commit, and a
+// release latency of 0 releases replaced buffers on commit.
+void vblank_init(double refresh_rate, uint64_t release_latency_us);
+// If a refresh rate was set
+char vblank_enabled();
+// The index of the last vblank at or before the given time (always 0 without a refresh rate)
+uint64_t vblank_index(uint64_t time_us);
+// When the vblank with the given index happens
+uint64_t vblank_time_us(uint64_t index);
+// Sends done and destroys the frame callback on the next vblank
+void vblank_frame_done(struct wl_resource* callback);
+// Releases the buffer once the release latency has passed, unless it is destroyed first
+void vblank_release_buffer(struct wl_resource* buffer);
+// The most buffers that were waiting to be released at once since this was last called
+uint32_t vblank_take_releases_held_peak();
+
+// Microseconds on the monotonic clock
+uint64_t monotonic_time_us();
+
 #define ALLOC_STRUCT(type) ((type*)alloc_zeroed(sizeof(type)))
 void* alloc_zeroed(size_t size);
 
@@ -34,6 +111,9 @@ void* alloc_zeroed(size_t size);
 #define NEW_ID_ARG(name, index) ASSERT(type_code_at_index(message, index) == 'n'); uint32_t name = args[index].n;
 #define RESOURCE_ARG(type, name, index) ASSERT(type_code_at_index(message, index) == 'o'); ASSERT(message->types[index] == &type##_interface); struct wl_resource* name = (struct wl_resource*)args[index].o;
 #define UINT_ARG(name, index) ASSERT(type_code_at_index(message, index) == 'u'); uint32_t name = args[index].u;
+#define INT_ARG(name, index) ASSERT(type_code_at_index(message, index) == 'i'); int32_t name = args[index].i;
+#define FD_ARG(name, index) ASSERT(type_code_at_index(message, index) == 'h'); int32_t name = args[index].h;
+#define STRING_ARG(name, index) ASSERT(type_code_at_index(message, index) == 's'); const char* name = args[index].s;
 
 typedef void (*RequestOverrideFunction)(struct wl_resource* resource, const struct wl_message* message, union wl_argument* args);
 void install_request_override(const struct wl_interface* interface, const char* name, RequestOverrideFunction function);
@@ -11,6 +11,10 @@
 
 #include "mock-server.h"
 #include "linux/input.h"
+#ifdef HAVE_LINUX_DMABUF
+#include <linux/magic.h>
+#include <sys/vfs.h>
+#endif
 
 typedef enum
 {
@@ -18,6 +22,7 @@ typedef enum
     SURFACE_ROLE_XDG_TOPLEVEL,
     SURFACE_ROLE_XDG_POPUP,
     SURFACE_ROLE_LAYER,
+    SURFACE_ROLE_PIP,
 } SurfaceRole;
 
 typedef struct
@@ -29,29 +34,104 @@ typedef struct
     struct wl_resource* xdg_popup;
     struct wl_resource* xdg_surface;
     struct wl_resource* layer_surface;
+    struct wl_resource* pip_surface;
     char has_pending_buffer; // If the pending buffer is non-null; same as has_committed_buffer if no pending buffer
     char has_committed_buffer; // This surface has a non-null committed buffer
+    char buffer_attached; // A non-null buffer has been attached since the last commit
+    struct wl_resource* pending_buffer; // The non-null buffer attached since the last commit, NULL if destroyed
+    struct wl_resource* committed_buffer; // Released once another buffer is committed, NULL if destroyed
+    struct wl_listener pending_buffer_destroy_listener;
+    struct wl_listener committed_buffer_destroy_listener;
+    char is_cursor; // The surface has been used as a pointer cursor
     char initial_commit_for_role; // Set to 1 when a role is created for a surface, and cleared after the first commit
     char layer_send_configure; // If to send a layer surface configure on the next commit
     int layer_set_w; // The width to configure the layer surface with
     int layer_set_h; // The height to configure the layer surface with
     uint32_t layer_anchor; // The layer surface's anchor
+    char pip_sized; // If the pip surface has been sent the size chosen by our placement policy
+    char pip_placed; // If the pip surface has been shown on the output
+    int pip_initial_width; // The size sent with xdg_pip_v1.set_initial_size, or 0 if it wasn't sent
+    int pip_initial_height;
+    uint32_t pip_acked_configures; // Configures acked before the pip was first shown
+    char* pip_app_id; // Owned copy of the last app ID set on the pip surface, or NULL
+    uint64_t pending_damage_area; // Sum of the areas of damage rects since the last commit
+    uint64_t damage_area; // Sum of the areas of damage rects in all commits with a buffer
+    uint32_t damage_commit_count; // Number of commits with a buffer and damage
+    uint64_t pip_created_us; // When the pip role was created, for measuring how long it took to become visible
+    int pip_width; // The size the pip was last configured with
+    int pip_height;
+    uint32_t pip_resize_edges; // The edges being dragged in the current interactive resize
+    int pip_resize_steps_left; // Configures still to be sent in the current interactive resize
+    uint32_t pip_resize_serial; // Serial of the last resize configure, or 0 once it has been acked
+    uint64_t pip_resize_configure_us; // When the last resize configure was sent
+    uint64_t pip_resize_latency_total_us; // Sum of configure-to-commit times in the current interactive resize
+    uint32_t pip_click_serial; // Serial of the button press sent to the pip, or 0 if it hasn't been clicked
+    uint32_t presented_frames; // Vblanks a new buffer of this surface was shown on, with a refresh rate set
+    uint64_t first_presented_vblank; // Index of the first and last of those vblanks
+    uint64_t last_presented_vblank;
+    char has_content_type; // A wp_content_type_v1 has been created for this surface
+    char has_tearing_control; // A wp_tearing_control_v1 has been created for this surface
 } SurfaceData;
 
 static struct wl_resource* seat_global = NULL;
 static struct wl_resource* pointer_global = NULL;
+static struct wl_resource* pointer_reenter_surface = NULL; // Entered by the next pointer, see PIP_TOGGLE_POINTER_APP_ID_SUFFIX
+static struct wl_resource* keyboard_global = NULL;
 static struct wl_resource* output_global = NULL;
 static uint32_t click_serial = 0;
+static uint32_t cursor_buffer_uploads = 0; // Commits of a new buffer to a cursor surface since the last pip was destroyed
+static uint32_t cursor_shapes_set = 0; // wp_cursor_shape_device_v1.set_shape requests since the last pip was destroyed
+
+// With --leak-check, the number of objects the client has is sampled whenever a pip is destroyed. The highest of the
+// first LEAK_CHECK_WARMUP_SAMPLES samples is the baseline (GTK creates some objects lazily), and a later sample more than
+// LEAK_CHECK_OBJECT_SLACK above it means objects are leaking.
+#define LEAK_CHECK_WARMUP_SAMPLES 64
+#define LEAK_CHECK_OBJECT_SLACK 32
+static uint32_t leak_check_sample_count = 0;
+static uint32_t leak_check_baseline = 0;
+static uint32_t leak_check_peak = 0;
+
+static enum wl_iterator_result leak_check_count_resource(struct wl_resource* resource, void* count)
+{
+    (*(uint32_t*)count)++;
+    return WL_ITERATOR_CONTINUE;
+}
+
+static void leak_check_sample(struct wl_client* client)
+{
+    uint32_t count = 0;
+    wl_client_for_each_resource(client, leak_check_count_resource, &count);
+    leak_check_sample_count++;
+    if (leak_check_sample_count <= LEAK_CHECK_WARMUP_SAMPLES && count > leak_check_baseline)
+        leak_check_baseline = count;
+    if (count > leak_check_peak)
+        leak_check_peak = count;
+    if (leak_check_sample_count > LEAK_CHECK_WARMUP_SAMPLES && count > leak_check_baseline + LEAK_CHECK_OBJECT_SLACK)
+    {
+        FATAL_FMT("client has %u Wayland objects after %u pips were destroyed, up from at most %u after the first %d",
+                  count, leak_check_sample_count, leak_check_baseline, LEAK_CHECK_WARMUP_SAMPLES);
+    }
+}
+
+void leak_check_report()
+{
+    if (!leak_check_mode || !leak_check_sample_count)
+        return;
+    BENCHMARK_REPORT("leak-check-pips-destroyed", "%u", leak_check_sample_count, "pips");
+    BENCHMARK_REPORT("leak-check-baseline-wayland-objects", "%u", leak_check_baseline, "objects");
+    BENCHMARK_REPORT("leak-check-peak-wayland-objects", "%u", leak_check_peak, "objects");
+}
 
 // Needs to be called before any role objects are assigned
 static void surface_data_set_role(SurfaceData* data, SurfaceRole role)
 {
     ASSERT_EQ(data->role, SURFACE_ROLE_NONE, "%u");
-    char is_xdg_role = (role == SURFACE_ROLE_XDG_TOPLEVEL || role == SURFACE_ROLE_XDG_POPUP);
+    char is_xdg_role = (role == SURFACE_ROLE_XDG_TOPLEVEL || role == SURFACE_ROLE_XDG_POPUP || role == SURFACE_ROLE_PIP);
     ASSERT_EQ(data->xdg_surface != NULL, is_xdg_role, "%d");
     ASSERT(!data->xdg_toplevel);
     ASSERT(!data->xdg_popup);
     ASSERT(!data->layer_surface);
+    ASSERT(!data->pip_surface);
     ASSERT(!data->has_committed_buffer);
     data->role = role;
     data->initial_commit_for_role = 1;
@@ -69,11 +149,137 @@ static void wl_surface_frame(struct wl_resource *resource, const struct wl_messa
         callback);
 }
 
+// Points *slot at buffer, which is tracked so *slot is cleared if it is destroyed
+static void surface_data_track_buffer(struct wl_resource** slot, struct wl_listener* listener, struct wl_resource* buffer)
+{
+    if (*slot)
+        wl_list_remove(&listener->link);
+    *slot = buffer;
+    if (buffer)
+        wl_resource_add_destroy_listener(buffer, listener);
+}
+
+static void surface_data_handle_pending_buffer_destroy(struct wl_listener* listener, void* _data)
+{
+    SurfaceData* data = wl_container_of(listener, data, pending_buffer_destroy_listener);
+    data->pending_buffer = NULL;
+}
+
+static void surface_data_handle_committed_buffer_destroy(struct wl_listener* listener, void* _data)
+{
+    SurfaceData* data = wl_container_of(listener, data, committed_buffer_destroy_listener);
+    data->committed_buffer = NULL;
+}
+
 static void wl_surface_attach(struct wl_resource *resource, const struct wl_message* message, union wl_argument* args)
 {
     RESOURCE_ARG(wl_buffer, buffer, 0);
     SurfaceData* data = wl_resource_get_user_data(resource);
     data->has_pending_buffer = (buffer != NULL);
+    data->buffer_attached = (buffer != NULL);
+    surface_data_track_buffer(&data->pending_buffer, &data->pending_buffer_destroy_listener, buffer);
+}
+
+static void surface_data_add_damage(SurfaceData* data, int32_t width, int32_t height)
+{
+    ASSERT(width >= 0);
+    ASSERT(height >= 0);
+    data->pending_damage_area += (uint64_t)width * (uint64_t)height;
+}
+
+static void wl_surface_damage(struct wl_resource *resource, const struct wl_message* message, union wl_argument* args)
+{
+    INT_ARG(width, 2);
+    INT_ARG(height, 3);
+    surface_data_add_damage(wl_resource_get_user_data(resource), width, height);
+}
+
+static void wl_surface_damage_buffer(struct wl_resource *resource, const struct wl_message* message, union wl_argument* args)
+{
+    INT_ARG(width, 2);
+    INT_ARG(height, 3);
+    surface_data_add_damage(wl_resource_get_user_data(resource), width, height);
+}
+
+static char pip_app_id_has_suffix(SurfaceData* data, const char* suffix)
+{
+    if (!data->pip_app_id)
+        return 0;
+    size_t len = strlen(data->pip_app_id);
+    size_t suffix_len = strlen(suffix);
+    return len >= suffix_len && strcmp(data->pip_app_id + len - suffix_len, suffix) == 0;
+}
+
+static char pip_wants_click(SurfaceData* data)
+{
+    return pip_app_id_has_suffix(data, PIP_CLICK_APP_ID_SUFFIX);
+}
+
+// Clicks the pip, then types on the keyboard so a client that uses the newest serial of any device gets it wrong
+static void surface_data_click_pip(SurfaceData* data)
+{
+    ASSERT(pointer_global);
+    ASSERT(keyboard_global);
+    wl_pointer_send_enter(
+        pointer_global,
+        wl_display_next_serial(display),
+        data->surface,
+        wl_fixed_from_double(5.0), wl_fixed_from_double(5.0));
+    wl_pointer_send_frame(pointer_global);
+    data->pip_click_serial = wl_display_next_serial(display);
+    // Popups opened by the click grab with its serial
+    click_serial = data->pip_click_serial;
+    wl_pointer_send_button(pointer_global, data->pip_click_serial, 0, BTN_LEFT, WL_POINTER_BUTTON_STATE_PRESSED);
+    wl_pointer_send_frame(pointer_global);
+
+    struct wl_array keys;
+    wl_array_init(&keys);
+    wl_keyboard_send_enter(keyboard_global, wl_display_next_serial(display), data->surface, &keys);
+    wl_array_release(&keys);
+    wl_keyboard_send_key(keyboard_global, wl_display_next_serial(display), 0, KEY_LEFTSHIFT, WL_KEYBOARD_KEY_STATE_PRESSED);
+    wl_keyboard_send_key(keyboard_global, wl_display_next_serial(display), 0, KEY_LEFTSHIFT, WL_KEYBOARD_KEY_STATE_RELEASED);
+
+    wl_pointer_send_button(pointer_global, wl_display_next_serial(display), 0, BTN_LEFT, WL_POINTER_BUTTON_STATE_RELEASED);
+    wl_pointer_send_frame(pointer_global);
+}
+
+// A real compositor ignores move and resize requests with the wrong seat or serial, so fail loudly instead
+static void surface_data_check_pip_grab(SurfaceData* data, struct wl_resource* seat, uint32_t serial)
+{
+    ASSERT(seat == seat_global);
+    if (data->pip_click_serial)
+        ASSERT_EQ(serial, data->pip_click_serial, "%u");
+}
+
+// Like a compositor that throttles configures to the client's frame rate, the next step of an interactive resize is
+// only sent once the previous one has been acked and committed
+static void surface_data_send_pip_resize_step(SurfaceData* data)
+{
+    if (data->pip_resize_edges & (XDG_PIP_V1_RESIZE_EDGE_LEFT | XDG_PIP_V1_RESIZE_EDGE_RIGHT))
+        data->pip_width += PIP_RESIZE_STEP_SIZE;
+    if (data->pip_resize_edges & (XDG_PIP_V1_RESIZE_EDGE_TOP | XDG_PIP_V1_RESIZE_EDGE_BOTTOM))
+        data->pip_height += PIP_RESIZE_STEP_SIZE;
+    data->pip_resize_steps_left--;
+    data->pip_resize_serial = wl_display_next_serial(display);
+    data->pip_resize_configure_us = monotonic_time_us();
+    xdg_pip_v1_send_configure(data->pip_surface, data->pip_width, data->pip_height);
+    xdg_surface_send_configure(data->xdg_surface, data->pip_resize_serial);
+}
+
+static void surface_data_finish_pip_resize_step(SurfaceData* data)
+{
+    data->pip_resize_latency_total_us += monotonic_time_us() - data->pip_resize_configure_us;
+    data->pip_resize_configure_us = 0;
+    if (data->pip_resize_steps_left > 0)
+    {
+        surface_data_send_pip_resize_step(data);
+    }
+    else if (benchmark_mode)
+    {
+        char name[256];
+        snprintf(name, sizeof(name), "%s-resize-configure-to-commit", data->pip_app_id ? data->pip_app_id : "pip");
+        BENCHMARK_REPORT(name, "%lu", (unsigned long)(data->pip_resize_latency_total_us / PIP_RESIZE_STEPS), "us");
+    }
 }
 
 static void wl_surface_commit(struct wl_resource *resource, const struct wl_message* message, union wl_argument* args)
@@ -81,16 +287,95 @@ static void wl_surface_commit(struct wl_resource *resource, const struct wl_mess
     SurfaceData* data = wl_resource_get_user_data(resource);
     data->has_committed_buffer = data->has_pending_buffer;
     // leave the contents of has_pending_buffer alone
+    if (data->has_committed_buffer && data->pending_damage_area)
+    {
+        data->damage_area += data->pending_damage_area;
+        data->damage_commit_count++;
+    }
+    data->pending_damage_area = 0;
+    if (data->is_cursor && data->buffer_attached)
+        cursor_buffer_uploads++;
+    if (data->buffer_attached || !data->has_committed_buffer)
+    {
+        // Like a compositor that is done with a buffer once it has a newer one to show
+        struct wl_resource* buffer = data->buffer_attached ? data->pending_buffer : NULL;
+        if (data->committed_buffer && data->committed_buffer != buffer)
+            vblank_release_buffer(data->committed_buffer);
+        surface_data_track_buffer(&data->committed_buffer, &data->committed_buffer_destroy_listener, buffer);
+        // Several commits before the same vblank only show the last one
+        uint64_t vblank = vblank_index(monotonic_time_us()) + 1;
+        if (buffer && vblank_enabled() && (!data->presented_frames || vblank != data->last_presented_vblank))
+        {
+            if (!data->presented_frames)
+                data->first_presented_vblank = vblank;
+            data->last_presented_vblank = vblank;
+            data->presented_frames++;
+        }
+    }
+    surface_data_track_buffer(&data->pending_buffer, &data->pending_buffer_destroy_listener, NULL);
+    data->buffer_attached = 0;
+    if (data->pip_resize_configure_us && !data->pip_resize_serial && data->has_committed_buffer)
+        surface_data_finish_pip_resize_step(data);
     if (data->pending_frame)
     {
-        wl_callback_send_done(data->pending_frame, 0);
-        wl_resource_destroy(data->pending_frame);
+        vblank_frame_done(data->pending_frame);
         data->pending_frame = NULL;
     }
     if (data->initial_commit_for_role)
     {
         ASSERT(!data->has_committed_buffer);
         data->initial_commit_for_role = 0;
+        if (data->pip_surface && data->pip_initial_width)
+        {
+            // The client told us the size it would pick, so the first configure can be final
+            xdg_pip_v1_send_configure_bounds(data->pip_surface, DEFAULT_OUTPUT_WIDTH / 2, DEFAULT_OUTPUT_HEIGHT / 2);
+            data->pip_width = DEFAULT_PIP_WIDTH;
+            data->pip_height = DEFAULT_PIP_HEIGHT;
+            xdg_pip_v1_send_configure(data->pip_surface, data->pip_width, data->pip_height);
+            xdg_surface_send_configure(data->xdg_surface, wl_display_next_serial(display));
+            data->pip_sized = 1;
+        }
+        else if (data->pip_surface)
+        {
+            // Let the client pick its own size first, like most compositors do
+            xdg_pip_v1_send_configure_bounds(data->pip_surface, DEFAULT_OUTPUT_WIDTH / 2, DEFAULT_OUTPUT_HEIGHT / 2);
+            xdg_pip_v1_send_configure(data->pip_surface, 0, 0);
+            xdg_surface_send_configure(data->xdg_surface, wl_display_next_serial(display));
+        }
+    }
+    else if (data->pip_surface && data->has_committed_buffer && !data->pip_placed)
+    {
+        if (benchmark_mode)
+        {
+            char name[256];
+            snprintf(name, sizeof(name), "%s-map-to-visible", data->pip_app_id ? data->pip_app_id : "pip");
+            BENCHMARK_REPORT(name, "%lu", (unsigned long)(monotonic_time_us() - data->pip_created_us), "us");
+            snprintf(name, sizeof(name), "%s-configures-to-visible", data->pip_app_id ? data->pip_app_id : "pip");
+            BENCHMARK_REPORT(name, "%u", data->pip_acked_configures, "configures");
+        }
+        if (data->pip_sized)
+        {
+            // The first buffer must be drawn for the first configure, as no other one has been sent
+            ASSERT_EQ(data->pip_acked_configures, 1, "%u");
+        }
+        else
+        {
+            // Once the pip is visible, resize it to fit our placement policy
+            data->pip_width = DEFAULT_PIP_WIDTH;
+            data->pip_height = DEFAULT_PIP_HEIGHT;
+            xdg_pip_v1_send_configure(data->pip_surface, data->pip_width, data->pip_height);
+            xdg_surface_send_configure(data->xdg_surface, wl_display_next_serial(display));
+            data->pip_sized = 1;
+        }
+        if (output_global)
+            wl_surface_send_enter(data->surface, output_global);
+        data->pip_placed = 1;
+        if (pip_wants_click(data))
+            surface_data_click_pip(data);
+        if (pip_app_id_has_suffix(data, PIP_DISMISS_APP_ID_SUFFIX))
+            xdg_pip_v1_send_dismissed(data->pip_surface);
+        else
+            trace_replay_begin(data->surface, data->xdg_surface, data->pip_surface, pointer_global);
     }
     if (data->layer_surface && data->layer_send_configure)
     {
@@ -138,6 +423,9 @@ static void wl_surface_destroy(struct wl_resource* resource, const struct wl_mes
     ASSERT(!data->xdg_toplevel);
     ASSERT(!data->xdg_surface);
     ASSERT(!data->layer_surface);
+    ASSERT(!data->pip_surface);
+    surface_data_track_buffer(&data->pending_buffer, &data->pending_buffer_destroy_listener, NULL);
+    surface_data_track_buffer(&data->committed_buffer, &data->committed_buffer_destroy_listener, NULL);
     free(data);
 }
 
@@ -151,6 +439,8 @@ static void wl_compositor_create_surface(struct wl_resource* resource, const str
         id);
     SurfaceData* data = ALLOC_STRUCT(SurfaceData);
     data->surface = surface;
+    data->pending_buffer_destroy_listener.notify = surface_data_handle_pending_buffer_destroy;
+    data->committed_buffer_destroy_listener.notify = surface_data_handle_committed_buffer_destroy;
     use_default_impl(surface);
     wl_resource_set_user_data(surface, data);
 }
@@ -181,6 +471,46 @@ static void wl_seat_get_pointer(struct wl_resource *resource, const struct wl_me
         wl_resource_get_version(resource),
         id);
     use_default_impl(pointer_global);
+
+    if (pointer_reenter_surface)
+    {
+        wl_pointer_send_enter(
+            pointer_global,
+            wl_display_next_serial(display),
+            pointer_reenter_surface,
+            wl_fixed_from_double(5.0), wl_fixed_from_double(5.0));
+        wl_pointer_send_frame(pointer_global);
+        pointer_reenter_surface = NULL;
+    }
+}
+
+static void wl_pointer_release(struct wl_resource *resource, const struct wl_message* message, union wl_argument* args)
+{
+    if (resource == pointer_global)
+        pointer_global = NULL;
+    wl_resource_destroy(resource);
+}
+
+static void wl_seat_get_keyboard(struct wl_resource *resource, const struct wl_message* message, union wl_argument* args)
+{
+    NEW_ID_ARG(id, 0);
+    ASSERT(!keyboard_global);
+    keyboard_global = wl_resource_create(
+        wl_resource_get_client(resource),
+        &wl_keyboard_interface,
+        wl_resource_get_version(resource),
+        id);
+    use_default_impl(keyboard_global);
+}
+
+static void wl_pointer_set_cursor(struct wl_resource *resource, const struct wl_message* message, union wl_argument* args)
+{
+    RESOURCE_ARG(wl_surface, surface, 1);
+    if (surface)
+    {
+        SurfaceData* data = wl_resource_get_user_data(surface);
+        data->is_cursor = 1;
+    }
 }
 
 static void xdg_wm_base_get_xdg_surface(struct wl_resource *resource, const struct wl_message* message, union wl_argument* args)
@@ -203,9 +533,20 @@ static void xdg_surface_destroy(struct wl_resource *resource, const struct wl_me
     SurfaceData* data = wl_resource_get_user_data(resource);
     ASSERT(!data->xdg_toplevel);
     ASSERT(!data->xdg_popup);
+    ASSERT(!data->pip_surface);
     data->xdg_surface = NULL;
 }
 
+static void xdg_surface_ack_configure(struct wl_resource *resource, const struct wl_message* message, union wl_argument* args)
+{
+    UINT_ARG(serial, 0);
+    SurfaceData* data = wl_resource_get_user_data(resource);
+    if (data->pip_resize_serial && serial == data->pip_resize_serial)
+        data->pip_resize_serial = 0;
+    if (data->pip_surface && !data->pip_placed)
+        data->pip_acked_configures++;
+}
+
 static void xdg_surface_get_toplevel(struct wl_resource *resource, const struct wl_message* message, union wl_argument* args)
 {
     NEW_ID_ARG(id, 0);
@@ -306,16 +647,387 @@ static void zwlr_layer_surface_v1_destroy(struct wl_resource *resource, const st
     data->layer_surface = NULL;
 }
 
+static void xdg_wm_pip_v1_get_xdg_pip(struct wl_resource *resource, const struct wl_message* message, union wl_argument* args)
+{
+    NEW_ID_ARG(id, 0);
+    RESOURCE_ARG(xdg_surface, xdg_surface, 1);
+    struct wl_resource* pip_surface = wl_resource_create(
+        wl_resource_get_client(resource),
+        &xdg_pip_v1_interface,
+        wl_resource_get_version(resource),
+        id);
+    use_default_impl(pip_surface);
+    SurfaceData* data = wl_resource_get_user_data(xdg_surface);
+    surface_data_set_role(data, SURFACE_ROLE_PIP);
+    wl_resource_set_user_data(pip_surface, data);
+    data->pip_surface = pip_surface;
+    data->pip_sized = 0;
+    data->pip_placed = 0;
+    data->pip_initial_width = 0;
+    data->pip_initial_height = 0;
+    data->pip_acked_configures = 0;
+    data->pip_created_us = monotonic_time_us();
+}
+
+static void xdg_pip_v1_set_app_id(struct wl_resource *resource, const struct wl_message* message, union wl_argument* args)
+{
+    STRING_ARG(app_id, 0);
+    SurfaceData* data = wl_resource_get_user_data(resource);
+    free(data->pip_app_id);
+    data->pip_app_id = strdup(app_id);
+
+    if (pip_app_id_has_suffix(data, PIP_TOGGLE_POINTER_APP_ID_SUFFIX))
+    {
+        ASSERT(seat_global);
+        ASSERT(pointer_global);
+        pointer_reenter_surface = data->surface;
+        wl_seat_send_capabilities(seat_global, WL_SEAT_CAPABILITY_KEYBOARD);
+        wl_seat_send_capabilities(seat_global, WL_SEAT_CAPABILITY_POINTER | WL_SEAT_CAPABILITY_KEYBOARD);
+    }
+}
+
+// Hints only count before the initial commit, so fail loudly if the client sends them too late to have an effect
+static void xdg_pip_v1_set_initial_size(struct wl_resource *resource, const struct wl_message* message, union wl_argument* args)
+{
+    INT_ARG(width, 0);
+    INT_ARG(height, 1);
+    SurfaceData* data = wl_resource_get_user_data(resource);
+    ASSERT(data->initial_commit_for_role);
+    ASSERT(width > 0 && height > 0);
+    data->pip_initial_width = width;
+    data->pip_initial_height = height;
+}
+
+static void xdg_pip_v1_set_preferred_corner(struct wl_resource *resource, const struct wl_message* message, union wl_argument* args)
+{
+    UINT_ARG(corner, 0);
+    SurfaceData* data = wl_resource_get_user_data(resource);
+    ASSERT(data->initial_commit_for_role);
+    // Our placement policy doesn't use it, but it must be a valid corner
+    ASSERT(corner <= XDG_PIP_V1_CORNER_BOTTOM_RIGHT);
+}
+
+static void xdg_pip_v1_move(struct wl_resource *resource, const struct wl_message* message, union wl_argument* args)
+{
+    RESOURCE_ARG(wl_seat, seat, 0);
+    UINT_ARG(serial, 1);
+    SurfaceData* data = wl_resource_get_user_data(resource);
+    ASSERT(data->pip_placed);
+    surface_data_check_pip_grab(data, seat, serial);
+}
+
+static void xdg_pip_v1_resize(struct wl_resource *resource, const struct wl_message* message, union wl_argument* args)
+{
+    RESOURCE_ARG(wl_seat, seat, 0);
+    UINT_ARG(serial, 1);
+    UINT_ARG(edges, 2);
+    SurfaceData* data = wl_resource_get_user_data(resource);
+    ASSERT(data->pip_placed);
+    surface_data_check_pip_grab(data, seat, serial);
+    ASSERT(!data->pip_resize_configure_us); // The previous resize must be over
+    data->pip_resize_edges = edges;
+    data->pip_resize_steps_left = PIP_RESIZE_STEPS;
+    data->pip_resize_latency_total_us = 0;
+    surface_data_send_pip_resize_step(data);
+}
+
+static void xdg_pip_v1_destroy(struct wl_resource *resource, const struct wl_message* message, union wl_argument* args)
+{
+    SurfaceData* data = wl_resource_get_user_data(resource);
+    ASSERT(data->xdg_surface);
+    if (leak_check_mode)
+        leak_check_sample(wl_resource_get_client(resource));
+    // Soak runs destroy far too many pips to report on each one
+    char report = benchmark_mode && !leak_check_mode;
+    if (report && data->damage_commit_count)
+    {
+        // Benchmarks tell their phases apart with the app ID
+        char name[256];
+        snprintf(name, sizeof(name), "%s-damage-per-commit", data->pip_app_id ? data->pip_app_id : "pip");
+        BENCHMARK_REPORT(name, "%lu", (unsigned long)(data->damage_area / data->damage_commit_count), "px");
+        snprintf(name, sizeof(name), "%s-damaged-commits", data->pip_app_id ? data->pip_app_id : "pip");
+        BENCHMARK_REPORT(name, "%u", data->damage_commit_count, "commits");
+    }
+    if (report && (cursor_buffer_uploads || cursor_shapes_set))
+    {
+        char name[256];
+        snprintf(name, sizeof(name), "%s-cursor-buffer-uploads", data->pip_app_id ? data->pip_app_id : "pip");
+        BENCHMARK_REPORT(name, "%u", cursor_buffer_uploads, "uploads");
+        snprintf(name, sizeof(name), "%s-cursor-shapes-set", data->pip_app_id ? data->pip_app_id : "pip");
+        BENCHMARK_REPORT(name, "%u", cursor_shapes_set, "shapes");
+    }
+    if (report && data->presented_frames > 1)
+    {
+        // Vblanks between the first and last frame that did not show a new one are where the client fell behind
+        uint64_t vblanks = data->last_presented_vblank - data->first_presented_vblank + 1;
+        double seconds = (double)(vblank_time_us(data->last_presented_vblank) - vblank_time_us(data->first_presented_vblank)) / 1000000.0;
+        char name[256];
+        snprintf(name, sizeof(name), "%s-presented-fps", data->pip_app_id ? data->pip_app_id : "pip");
+        BENCHMARK_REPORT(name, "%.1f", (data->presented_frames - 1) / seconds, "fps");
+        snprintf(name, sizeof(name), "%s-missed-vblanks", data->pip_app_id ? data->pip_app_id : "pip");
+        BENCHMARK_REPORT(name, "%lu", (unsigned long)(vblanks - data->presented_frames), "vblanks");
+        snprintf(name, sizeof(name), "%s-peak-buffers-awaiting-release", data->pip_app_id ? data->pip_app_id : "pip");
+        BENCHMARK_REPORT(name, "%u", vblank_take_releases_held_peak(), "buffers");
+    }
+    data->presented_frames = 0;
+    cursor_buffer_uploads = 0;
+    cursor_shapes_set = 0;
+    free(data->pip_app_id);
+    data->pip_app_id = NULL;
+    data->damage_area = 0;
+    data->damage_commit_count = 0;
+    data->pip_resize_steps_left = 0;
+    data->pip_resize_serial = 0;
+    data->pip_resize_configure_us = 0;
+    data->pip_click_serial = 0;
+    data->pip_surface = NULL;
+    data->role = SURFACE_ROLE_NONE;
+}
+
+#ifdef HAVE_FRACTIONAL_SCALE
+static void wp_fractional_scale_manager_v1_get_fractional_scale(struct wl_resource *resource, const struct wl_message* message, union wl_argument* args)
+{
+    NEW_ID_ARG(id, 0);
+    RESOURCE_ARG(wl_surface, surface, 1);
+    ASSERT(surface);
+    struct wl_resource* fractional_scale = wl_resource_create(
+        wl_resource_get_client(resource),
+        &wp_fractional_scale_v1_interface,
+        wl_resource_get_version(resource),
+        id);
+    use_default_impl(fractional_scale);
+    wp_fractional_scale_v1_send_preferred_scale(fractional_scale, DEFAULT_FRACTIONAL_SCALE_120);
+}
+#endif
+
+#ifdef HAVE_CURSOR_SHAPE
+static void wp_cursor_shape_manager_v1_get_pointer(struct wl_resource *resource, const struct wl_message* message, union wl_argument* args)
+{
+    NEW_ID_ARG(id, 0);
+    RESOURCE_ARG(wl_pointer, pointer, 1);
+    ASSERT(pointer);
+    struct wl_resource* device = wl_resource_create(
+        wl_resource_get_client(resource),
+        &wp_cursor_shape_device_v1_interface,
+        wl_resource_get_version(resource),
+        id);
+    use_default_impl(device);
+}
+
+static void wp_cursor_shape_device_v1_set_shape(struct wl_resource *resource, const struct wl_message* message, union wl_argument* args)
+{
+    UINT_ARG(shape, 1);
+    ASSERT(shape >= WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_DEFAULT);
+    cursor_shapes_set++;
+}
+#endif
+
+#ifdef HAVE_CONTENT_TYPE
+static void wp_content_type_manager_v1_get_surface_content_type(struct wl_resource *resource, const struct wl_message* message, union wl_argument* args)
+{
+    NEW_ID_ARG(id, 0);
+    RESOURCE_ARG(wl_surface, surface, 1);
+    ASSERT(surface);
+    SurfaceData* data = wl_resource_get_user_data(surface);
+    // Would be an already_constructed protocol error
+    ASSERT(!data->has_content_type);
+    data->has_content_type = 1;
+    struct wl_resource* content_type = wl_resource_create(
+        wl_resource_get_client(resource),
+        &wp_content_type_v1_interface,
+        wl_resource_get_version(resource),
+        id);
+    use_default_impl(content_type);
+    wl_resource_set_user_data(content_type, data);
+}
+
+static void wp_content_type_v1_set_content_type(struct wl_resource *resource, const struct wl_message* message, union wl_argument* args)
+{
+    UINT_ARG(content_type, 0);
+    ASSERT(content_type <= WP_CONTENT_TYPE_V1_TYPE_GAME);
+}
+
+static void wp_content_type_v1_destroy(struct wl_resource *resource, const struct wl_message* message, union wl_argument* args)
+{
+    SurfaceData* data = wl_resource_get_user_data(resource);
+    data->has_content_type = 0;
+    wl_resource_destroy(resource);
+}
+#endif
+
+#ifdef HAVE_TEARING_CONTROL
+static void wp_tearing_control_manager_v1_get_tearing_control(struct wl_resource *resource, const struct wl_message* message, union wl_argument* args)
+{
+    NEW_ID_ARG(id, 0);
+    RESOURCE_ARG(wl_surface, surface, 1);
+    ASSERT(surface);
+    SurfaceData* data = wl_resource_get_user_data(surface);
+    // Would be a tearing_control_exists protocol error
+    ASSERT(!data->has_tearing_control);
+    data->has_tearing_control = 1;
+    struct wl_resource* tearing_control = wl_resource_create(
+        wl_resource_get_client(resource),
+        &wp_tearing_control_v1_interface,
+        wl_resource_get_version(resource),
+        id);
+    use_default_impl(tearing_control);
+    wl_resource_set_user_data(tearing_control, data);
+}
+
+static void wp_tearing_control_v1_set_presentation_hint(struct wl_resource *resource, const struct wl_message* message, union wl_argument* args)
+{
+    UINT_ARG(hint, 0);
+    ASSERT(hint <= WP_TEARING_CONTROL_V1_PRESENTATION_HINT_ASYNC);
+}
+
+static void wp_tearing_control_v1_destroy(struct wl_resource *resource, const struct wl_message* message, union wl_argument* args)
+{
+    SurfaceData* data = wl_resource_get_user_data(resource);
+    data->has_tearing_control = 0;
+    wl_resource_destroy(resource);
+}
+#endif
+
+#ifdef HAVE_LINUX_DMABUF
+#define DMABUF_MAX_PLANES 4
+
+typedef struct
+{
+    int32_t fds[DMABUF_MAX_PLANES]; // -1 for planes that have not been added
+    uint32_t offsets[DMABUF_MAX_PLANES];
+    uint32_t strides[DMABUF_MAX_PLANES];
+    uint64_t modifier;
+    char used; // create has been called, which can only happen once
+} DmabufParams;
+
+void zwp_linux_dmabuf_v1_bind(struct wl_client* client, void* data, uint32_t version, uint32_t id)
+{
+    struct wl_resource* linux_dmabuf = wl_resource_create(client, &zwp_linux_dmabuf_v1_interface, version, id);
+    use_default_impl(linux_dmabuf);
+    zwp_linux_dmabuf_v1_send_format(linux_dmabuf, MOCK_DMABUF_FORMAT);
+    zwp_linux_dmabuf_v1_send_modifier(
+        linux_dmabuf,
+        MOCK_DMABUF_FORMAT,
+        (uint32_t)((uint64_t)MOCK_DMABUF_MODIFIER >> 32),
+        (uint32_t)((uint64_t)MOCK_DMABUF_MODIFIER & 0xffffffff));
+}
+
+static void dmabuf_params_destroy(struct wl_resource* resource)
+{
+    DmabufParams* params = wl_resource_get_user_data(resource);
+    for (int i = 0; i < DMABUF_MAX_PLANES; i++)
+    {
+        if (params->fds[i] >= 0)
+            close(params->fds[i]);
+    }
+    free(params);
+}
+
+static void zwp_linux_dmabuf_v1_create_params(struct wl_resource *resource, const struct wl_message* message, union wl_argument* args)
+{
+    NEW_ID_ARG(id, 0);
+    struct wl_resource* params_resource = wl_resource_create(
+        wl_resource_get_client(resource),
+        &zwp_linux_buffer_params_v1_interface,
+        wl_resource_get_version(resource),
+        id);
+    use_default_impl(params_resource);
+    DmabufParams* params = ALLOC_STRUCT(DmabufParams);
+    for (int i = 0; i < DMABUF_MAX_PLANES; i++)
+        params->fds[i] = -1;
+    wl_resource_set_user_data(params_resource, params);
+    wl_resource_set_destructor(params_resource, dmabuf_params_destroy);
+}
+
+static void zwp_linux_buffer_params_v1_add(struct wl_resource *resource, const struct wl_message* message, union wl_argument* args)
+{
+    FD_ARG(fd, 0);
+    UINT_ARG(plane_idx, 1);
+    UINT_ARG(offset, 2);
+    UINT_ARG(stride, 3);
+    UINT_ARG(modifier_hi, 4);
+    UINT_ARG(modifier_lo, 5);
+    DmabufParams* params = wl_resource_get_user_data(resource);
+    // Would be already_used, plane_idx and plane_set protocol errors
+    ASSERT(!params->used);
+    ASSERT(plane_idx < DMABUF_MAX_PLANES);
+    ASSERT(params->fds[plane_idx] < 0);
+    uint64_t modifier = ((uint64_t)modifier_hi << 32) | modifier_lo;
+    if (plane_idx > 0)
+        ASSERT_EQ((unsigned long)modifier, (unsigned long)params->modifier, "%lu");
+    params->fds[plane_idx] = fd;
+    params->offsets[plane_idx] = offset;
+    params->strides[plane_idx] = stride;
+    params->modifier = modifier;
+}
+
+// Like a real compositor, fails the import of anything it did not advertise or can't read
+static char dmabuf_params_can_import(DmabufParams* params, int width, int height, uint32_t format)
+{
+    if (format != MOCK_DMABUF_FORMAT || params->modifier != MOCK_DMABUF_MODIFIER)
+        return 0;
+
+    // XRGB8888 has one plane, which must be a real dmabuf big enough for the frame
+    if (params->fds[0] < 0)
+        return 0;
+    for (int i = 1; i < DMABUF_MAX_PLANES; i++)
+    {
+        if (params->fds[i] >= 0)
+            return 0;
+    }
+    struct statfs fs;
+    if (fstatfs(params->fds[0], &fs) != 0 || fs.f_type != DMA_BUF_MAGIC)
+        return 0;
+    off_t size = lseek(params->fds[0], 0, SEEK_END);
+    return size > 0 &&
+        params->strides[0] >= (uint32_t)width * 4 &&
+        (uint64_t)params->offsets[0] + (uint64_t)params->strides[0] * (uint64_t)height <= (uint64_t)size;
+}
+
+static void zwp_linux_buffer_params_v1_create(struct wl_resource *resource, const struct wl_message* message, union wl_argument* args)
+{
+    INT_ARG(width, 0);
+    INT_ARG(height, 1);
+    UINT_ARG(format, 2);
+    DmabufParams* params = wl_resource_get_user_data(resource);
+    // Would be already_used and invalid_dimensions protocol errors
+    ASSERT(!params->used);
+    params->used = 1;
+    ASSERT(width > 0);
+    ASSERT(height > 0);
+
+    if (!dmabuf_params_can_import(params, width, height, format))
+    {
+        zwp_linux_buffer_params_v1_send_failed(resource);
+        return;
+    }
+
+    struct wl_resource* buffer = wl_resource_create(
+        wl_resource_get_client(resource),
+        &wl_buffer_interface,
+        1,
+        0);
+    use_default_impl(buffer);
+    zwp_linux_buffer_params_v1_send_created(resource, buffer);
+}
+#endif
+
 void init()
 {
     OVERRIDE_REQUEST(wl_surface, commit);
     OVERRIDE_REQUEST(wl_surface, frame);
     OVERRIDE_REQUEST(wl_surface, attach);
+    OVERRIDE_REQUEST(wl_surface, damage);
+    OVERRIDE_REQUEST(wl_surface, damage_buffer);
     OVERRIDE_REQUEST(wl_surface, destroy);
     OVERRIDE_REQUEST(wl_compositor, create_surface);
     OVERRIDE_REQUEST(wl_seat, get_pointer);
+    OVERRIDE_REQUEST(wl_seat, get_keyboard);
+    OVERRIDE_REQUEST(wl_pointer, set_cursor);
+    OVERRIDE_REQUEST(wl_pointer, release);
     OVERRIDE_REQUEST(xdg_wm_base, get_xdg_surface);
     OVERRIDE_REQUEST(xdg_surface, destroy);
+    OVERRIDE_REQUEST(xdg_surface, ack_configure);
     OVERRIDE_REQUEST(xdg_surface, get_toplevel);
     OVERRIDE_REQUEST(xdg_toplevel, destroy);
     OVERRIDE_REQUEST(xdg_surface, get_popup);
@@ -325,6 +1037,35 @@ void init()
     OVERRIDE_REQUEST(zwlr_layer_surface_v1, set_anchor);
     OVERRIDE_REQUEST(zwlr_layer_surface_v1, set_size);
     OVERRIDE_REQUEST(zwlr_layer_surface_v1, destroy);
+    OVERRIDE_REQUEST(xdg_wm_pip_v1, get_xdg_pip);
+    OVERRIDE_REQUEST(xdg_pip_v1, set_app_id);
+    OVERRIDE_REQUEST(xdg_pip_v1, set_initial_size);
+    OVERRIDE_REQUEST(xdg_pip_v1, set_preferred_corner);
+    OVERRIDE_REQUEST(xdg_pip_v1, move);
+    OVERRIDE_REQUEST(xdg_pip_v1, resize);
+    OVERRIDE_REQUEST(xdg_pip_v1, destroy);
+#ifdef HAVE_FRACTIONAL_SCALE
+    OVERRIDE_REQUEST(wp_fractional_scale_manager_v1, get_fractional_scale);
+#endif
+#ifdef HAVE_CURSOR_SHAPE
+    OVERRIDE_REQUEST(wp_cursor_shape_manager_v1, get_pointer);
+    OVERRIDE_REQUEST(wp_cursor_shape_device_v1, set_shape);
+#endif
+#ifdef HAVE_CONTENT_TYPE
+    OVERRIDE_REQUEST(wp_content_type_manager_v1, get_surface_content_type);
+    OVERRIDE_REQUEST(wp_content_type_v1, set_content_type);
+    OVERRIDE_REQUEST(wp_content_type_v1, destroy);
+#endif
+#ifdef HAVE_TEARING_CONTROL
+    OVERRIDE_REQUEST(wp_tearing_control_manager_v1, get_tearing_control);
+    OVERRIDE_REQUEST(wp_tearing_control_v1, set_presentation_hint);
+    OVERRIDE_REQUEST(wp_tearing_control_v1, destroy);
+#endif
+#ifdef HAVE_LINUX_DMABUF
+    OVERRIDE_REQUEST(zwp_linux_dmabuf_v1, create_params);
+    OVERRIDE_REQUEST(zwp_linux_buffer_params_v1, add);
+    OVERRIDE_REQUEST(zwp_linux_buffer_params_v1, create);
+#endif
 
     wl_global_create(display, &wl_seat_interface, 6, NULL, wl_seat_bind);
     wl_global_create(display, &wl_output_interface, 2, NULL, wl_output_bind);
@@ -334,4 +1075,20 @@ void init()
     default_global_create(display, &wl_subcompositor_interface, 1);
     default_global_create(display, &xdg_wm_base_interface, 2);
     default_global_create(display, &zwlr_layer_shell_v1_interface, 4);
+    default_global_create(display, &xdg_wm_pip_v1_interface, 2);
+#ifdef HAVE_FRACTIONAL_SCALE
+    default_global_create(display, &wp_fractional_scale_manager_v1_interface, 1);
+#endif
+#ifdef HAVE_CURSOR_SHAPE
+    default_global_create(display, &wp_cursor_shape_manager_v1_interface, 1);
+#endif
+#ifdef HAVE_CONTENT_TYPE
+    default_global_create(display, &wp_content_type_manager_v1_interface, 1);
+#endif
+#ifdef HAVE_TEARING_CONTROL
+    default_global_create(display, &wp_tearing_control_manager_v1_interface, 1);
+#endif
+#ifdef HAVE_LINUX_DMABUF
+    wl_global_create(display, &zwp_linux_dmabuf_v1_interface, 3, NULL, zwp_linux_dmabuf_v1_bind);
+#endif
 }
@@ -0,0 +1,350 @@
+/* This entire file is licensed under MIT
+ *
+ * Copyright 2020 Sophie Winter
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "mock-server.h"
+#include <stdint.h>
+
+// Records the events the mock server sends that drive a pip client (see TRACE_MAGIC for the format), and replays a
+// recorded trace against a live client. Object and serial arguments are not recorded, as they can't mean anything in
+// another session: on replay, events go to the client's first placed pip and get fresh serials.
+
+#define TRACE_MAX_ARGS 4
+
+typedef enum
+{
+    TRACE_EVENT_UNKNOWN = 0,
+    TRACE_EVENT_PIP_CONFIGURE_BOUNDS,
+    TRACE_EVENT_PIP_CONFIGURE,
+    TRACE_EVENT_PIP_DISMISSED,
+    TRACE_EVENT_XDG_SURFACE_CONFIGURE,
+    TRACE_EVENT_POINTER_ENTER,
+    TRACE_EVENT_POINTER_LEAVE,
+    TRACE_EVENT_POINTER_MOTION,
+    TRACE_EVENT_POINTER_BUTTON,
+    TRACE_EVENT_POINTER_AXIS,
+    TRACE_EVENT_POINTER_FRAME,
+} TraceEventKind;
+
+static const char* const trace_event_names[] = {
+    [TRACE_EVENT_PIP_CONFIGURE_BOUNDS] = "xdg_pip_v1.configure_bounds",
+    [TRACE_EVENT_PIP_CONFIGURE] = "xdg_pip_v1.configure",
+    [TRACE_EVENT_PIP_DISMISSED] = "xdg_pip_v1.dismissed",
+    [TRACE_EVENT_XDG_SURFACE_CONFIGURE] = "xdg_surface.configure",
+    [TRACE_EVENT_POINTER_ENTER] = "wl_pointer.enter",
+    [TRACE_EVENT_POINTER_LEAVE] = "wl_pointer.leave",
+    [TRACE_EVENT_POINTER_MOTION] = "wl_pointer.motion",
+    [TRACE_EVENT_POINTER_BUTTON] = "wl_pointer.button",
+    [TRACE_EVENT_POINTER_AXIS] = "wl_pointer.axis",
+    [TRACE_EVENT_POINTER_FRAME] = "wl_pointer.frame",
+};
+#define TRACE_EVENT_KIND_COUNT (sizeof(trace_event_names) / sizeof(trace_event_names[0]))
+
+typedef struct
+{
+    TraceEventKind kind;
+    uint64_t time_us;
+    int32_t args[TRACE_MAX_ARGS];
+} TraceEvent;
+
+static TraceEventKind trace_event_kind_from_name(const char* name)
+{
+    for (size_t i = 1; i < TRACE_EVENT_KIND_COUNT; i++)
+    {
+        if (strcmp(name, trace_event_names[i]) == 0)
+            return (TraceEventKind)i;
+    }
+    return TRACE_EVENT_UNKNOWN;
+}
+
+// Recording
+
+static FILE* record_file = NULL;
+static uint64_t record_start_us = 0;
+// If the name of each kind has been written yet. Kinds are written with their own value as the index.
+static char record_kind_written[TRACE_EVENT_KIND_COUNT];
+
+static void record_write(const void* data, size_t size)
+{
+    if (fwrite(data, size, 1, record_file) != 1)
+        FATAL("failed to write to the event trace");
+}
+
+static void trace_protocol_logger(void* user_data, enum wl_protocol_logger_type direction, const struct wl_protocol_logger_message* message)
+{
+    if (direction != WL_PROTOCOL_LOGGER_EVENT)
+        return;
+
+    char name[256];
+    snprintf(name, sizeof(name), "%s.%s", wl_resource_get_class(message->resource), message->message->name);
+    TraceEventKind kind = trace_event_kind_from_name(name);
+    if (kind == TRACE_EVENT_UNKNOWN)
+        return;
+
+    uint16_t index = (uint16_t)kind;
+    if (!record_kind_written[kind])
+    {
+        uint8_t type = TRACE_MESSAGE_NAME;
+        uint16_t len = (uint16_t)strlen(name);
+        record_write(&type, sizeof(type));
+        record_write(&index, sizeof(index));
+        record_write(&len, sizeof(len));
+        record_write(name, len);
+        record_kind_written[kind] = 1;
+    }
+
+    int32_t args[TRACE_MAX_ARGS] = {0};
+    uint8_t arg_count = 0;
+    for (int i = 0; i < message->arguments_count && arg_count < TRACE_MAX_ARGS; i++)
+    {
+        char code = type_code_at_index(message->message, i);
+        // Integers and fixed point numbers are kept as is, anything else only has meaning in this session
+        if (code == 'i')
+            args[arg_count++] = message->arguments[i].i;
+        else if (code == 'f')
+            args[arg_count++] = message->arguments[i].f;
+        else if (code == 'u')
+            args[arg_count++] = (int32_t)message->arguments[i].u;
+        else
+            args[arg_count++] = 0;
+    }
+
+    uint8_t type = TRACE_EVENT;
+    uint64_t time_us = monotonic_time_us() - record_start_us;
+    record_write(&type, sizeof(type));
+    record_write(&index, sizeof(index));
+    record_write(&time_us, sizeof(time_us));
+    record_write(&arg_count, sizeof(arg_count));
+    record_write(args, arg_count * sizeof(int32_t));
+}
+
+void trace_record_events(const char* path)
+{
+    record_file = fopen(path, "wb");
+    if (!record_file)
+        FATAL_FMT("failed to open event trace %s", path);
+    record_write(TRACE_MAGIC, 4);
+    uint32_t version = TRACE_VERSION;
+    record_write(&version, sizeof(version));
+    record_start_us = monotonic_time_us();
+    wl_display_add_protocol_logger(display, trace_protocol_logger, NULL);
+}
+
+void trace_finish()
+{
+    if (record_file)
+        fclose(record_file);
+    record_file = NULL;
+}
+
+// Replay
+
+static TraceEvent* replay_events = NULL;
+static size_t replay_event_count = 0;
+static size_t replay_next = 0;
+static double replay_speed = 1.0;
+static uint64_t replay_start_us = 0;
+static struct wl_event_source* replay_timer = NULL;
+static struct wl_resource* replay_surface = NULL;
+static struct wl_resource* replay_xdg_surface = NULL;
+static struct wl_resource* replay_pip = NULL;
+static struct wl_resource* replay_pointer = NULL;
+static struct wl_listener replay_pip_destroy_listener;
+static char replay_loaded = 0;
+static char replay_started = 0;
+
+static void read_exact(FILE* file, void* data, size_t size, const char* path)
+{
+    if (fread(data, size, 1, file) != 1)
+        FATAL_FMT("event trace %s is truncated", path);
+}
+
+void trace_load_replay(const char* path, double speed)
+{
+    FILE* file = fopen(path, "rb");
+    if (!file)
+        FATAL_FMT("failed to open event trace %s", path);
+
+    char magic[4];
+    uint32_t version;
+    read_exact(file, magic, sizeof(magic), path);
+    read_exact(file, &version, sizeof(version), path);
+    if (memcmp(magic, TRACE_MAGIC, 4) != 0 || version != TRACE_VERSION)
+        FATAL_FMT("%s is not a version %d event trace", path, TRACE_VERSION);
+
+    // Indexes in the file are mapped to kinds as their names are read, so traces can come from other tools
+    static TraceEventKind kinds[UINT16_MAX + 1];
+    memset(kinds, 0, sizeof(kinds));
+    size_t capacity = 0;
+    int type;
+    while ((type = fgetc(file)) != EOF)
+    {
+        uint16_t index;
+        read_exact(file, &index, sizeof(index), path);
+        if (type == TRACE_MESSAGE_NAME)
+        {
+            uint16_t len;
+            char name[256];
+            read_exact(file, &len, sizeof(len), path);
+            if (len >= sizeof(name))
+                FATAL_FMT("event trace %s has a message name that is too long", path);
+            read_exact(file, name, len, path);
+            name[len] = '\0';
+            kinds[index] = trace_event_kind_from_name(name);
+        }
+        else if (type == TRACE_EVENT)
+        {
+            TraceEvent event = {.kind = kinds[index]};
+            uint8_t arg_count;
+            read_exact(file, &event.time_us, sizeof(event.time_us), path);
+            read_exact(file, &arg_count, sizeof(arg_count), path);
+            if (arg_count > TRACE_MAX_ARGS)
+                FATAL_FMT("event trace %s has an event with too many arguments", path);
+            read_exact(file, event.args, arg_count * sizeof(int32_t), path);
+            if (event.kind == TRACE_EVENT_UNKNOWN)
+                continue;
+            if (replay_event_count == capacity)
+            {
+                capacity = capacity ? capacity * 2 : 256;
+                replay_events = realloc(replay_events, capacity * sizeof(TraceEvent));
+            }
+            replay_events[replay_event_count++] = event;
+        }
+        else
+        {
+            FATAL_FMT("event trace %s has an invalid record type %d", path, type);
+        }
+    }
+    fclose(file);
+    replay_speed = speed;
+    replay_loaded = 1;
+}
+
+static void replay_send(const TraceEvent* event)
+{
+    const int32_t* a = event->args;
+    switch (event->kind)
+    {
+    case TRACE_EVENT_PIP_CONFIGURE_BOUNDS:
+        xdg_pip_v1_send_configure_bounds(replay_pip, a[0], a[1]);
+        break;
+    case TRACE_EVENT_PIP_CONFIGURE:
+        xdg_pip_v1_send_configure(replay_pip, a[0], a[1]);
+        break;
+    case TRACE_EVENT_PIP_DISMISSED:
+        xdg_pip_v1_send_dismissed(replay_pip);
+        break;
+    case TRACE_EVENT_XDG_SURFACE_CONFIGURE:
+        xdg_surface_send_configure(replay_xdg_surface, wl_display_next_serial(display));
+        break;
+    case TRACE_EVENT_POINTER_ENTER:
+        if (replay_pointer)
+            wl_pointer_send_enter(replay_pointer, wl_display_next_serial(display), replay_surface, a[2], a[3]);
+        break;
+    case TRACE_EVENT_POINTER_LEAVE:
+        if (replay_pointer)
+            wl_pointer_send_leave(replay_pointer, wl_display_next_serial(display), replay_surface);
+        break;
+    case TRACE_EVENT_POINTER_MOTION:
+        if (replay_pointer)
+            wl_pointer_send_motion(replay_pointer, a[0], a[1], a[2]);
+        break;
+    case TRACE_EVENT_POINTER_BUTTON:
+        if (replay_pointer)
+            wl_pointer_send_button(replay_pointer, wl_display_next_serial(display), a[1], a[2], a[3]);
+        break;
+    case TRACE_EVENT_POINTER_AXIS:
+        if (replay_pointer)
+            wl_pointer_send_axis(replay_pointer, a[0], a[1], a[2]);
+        break;
+    case TRACE_EVENT_POINTER_FRAME:
+        if (replay_pointer && wl_resource_get_version(replay_pointer) >= WL_POINTER_FRAME_SINCE_VERSION)
+            wl_pointer_send_frame(replay_pointer);
+        break;
+    case TRACE_EVENT_UNKNOWN:
+        break;
+    }
+}
+
+static void replay_stop()
+{
+    if (replay_timer)
+        wl_event_source_remove(replay_timer);
+    replay_timer = NULL;
+    if (replay_pip)
+        wl_list_remove(&replay_pip_destroy_listener.link);
+    replay_pip = NULL;
+}
+
+static void replay_finish()
+{
+    if (benchmark_mode)
+    {
+        BENCHMARK_REPORT("replay-events", "%zu", replay_next, "events");
+        BENCHMARK_REPORT("replay-duration", "%lu", (unsigned long)(monotonic_time_us() - replay_start_us), "us");
+    }
+    // The session ends with the pip being dismissed (whether or not the trace did), which lets the client know the
+    // replay is done
+    xdg_pip_v1_send_dismissed(replay_pip);
+    replay_stop();
+}
+
+static int replay_timer_callback(void* data)
+{
+    uint64_t elapsed_us = monotonic_time_us() - replay_start_us;
+    while (replay_next < replay_event_count)
+    {
+        const TraceEvent* event = &replay_events[replay_next];
+        uint64_t due_us = replay_speed > 0 ? (uint64_t)(event->time_us / replay_speed) : 0;
+        if (due_us > elapsed_us)
+        {
+            // The timer only has millisecond precision, round up so events are never early
+            int delay_ms = (int)((due_us - elapsed_us + 999) / 1000);
+            wl_event_source_timer_update(replay_timer, delay_ms);
+            return 0;
+        }
+        if (event->kind == TRACE_EVENT_PIP_DISMISSED)
+            break; // Nothing after a dismissal can be replayed
+        replay_send(event);
+        replay_next++;
+    }
+    replay_finish();
+    return 0;
+}
+
+static void replay_handle_pip_destroy(struct wl_listener* listener, void* data)
+{
+    // The client went away before the replay finished
+    wl_list_init(&replay_pip_destroy_listener.link); // replay_stop() removes it
+    replay_stop();
+}
+
+void trace_replay_begin(struct wl_resource* surface, struct wl_resource* xdg_surface, struct wl_resource* pip, struct wl_resource* pointer)
+{
+    if (!replay_loaded || replay_started)
+        return; // Nothing to replay, or already replaying/replayed against another pip
+    replay_started = 1;
+
+    replay_surface = surface;
+    replay_xdg_surface = xdg_surface;
+    replay_pip = pip;
+    replay_pointer = pointer;
+    replay_pip_destroy_listener.notify = replay_handle_pip_destroy;
+    wl_resource_add_destroy_listener(pip, &replay_pip_destroy_listener);
+
+    // Recorded times are relative to the recording's start, so the first event is shifted to now
+    uint64_t first_us = replay_event_count ? replay_events[0].time_us : 0;
+    for (size_t i = 0; i < replay_event_count; i++)
+        replay_events[i].time_us -= first_us;
+
+    replay_start_us = monotonic_time_us();
+    replay_timer = wl_event_loop_add_timer(wl_display_get_event_loop(display), replay_timer_callback, NULL);
+    wl_event_source_timer_update(replay_timer, 1);
+}
@@ -0,0 +1,177 @@
+/* This entire file is licensed under MIT
+ *
+ * Copyright 2020 Sophie Winter
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "mock-server.h"
+#include <stdint.h>
+
+// A virtual display refresh clock. Vblanks happen every refresh period since the server started. Frame callbacks
+// committed between two vblanks are all answered on the second one, like a compositor that repaints on vblank.
+// Replaced buffers are released after a fixed hold latency, like a compositor still sampling from them on the GPU.
+// Timers are only armed while there is something to send, so an idle server never wakes up.
+
+typedef struct
+{
+    struct wl_list link;
+    struct wl_resource* resource; // The frame callback or buffer
+    struct wl_listener destroy_listener;
+    uint64_t due_us; // When a buffer is to be released, unused for frame callbacks
+} PendingResource;
+
+static uint64_t refresh_period_us = 0;
+static uint64_t release_latency_us = 0;
+static uint64_t clock_start_us = 0;
+
+static struct wl_list pending_frames; // PendingResource, answered on the next vblank
+static struct wl_list pending_releases; // PendingResource, in the order they are due
+static struct wl_event_source* vblank_timer = NULL;
+static struct wl_event_source* release_timer = NULL;
+static uint32_t releases_held = 0;
+static uint32_t releases_held_peak = 0;
+
+static void pending_resource_free(PendingResource* pending)
+{
+    wl_list_remove(&pending->link);
+    wl_list_remove(&pending->destroy_listener.link);
+    free(pending);
+}
+
+static void pending_frame_handle_destroy(struct wl_listener* listener, void* _data)
+{
+    PendingResource* pending = wl_container_of(listener, pending, destroy_listener);
+    pending_resource_free(pending);
+}
+
+static void pending_release_handle_destroy(struct wl_listener* listener, void* _data)
+{
+    PendingResource* pending = wl_container_of(listener, pending, destroy_listener);
+    releases_held--;
+    pending_resource_free(pending);
+}
+
+static PendingResource* pending_resource_new(struct wl_list* list, struct wl_resource* resource, wl_notify_func_t on_destroy)
+{
+    PendingResource* pending = ALLOC_STRUCT(PendingResource);
+    pending->resource = resource;
+    pending->destroy_listener.notify = on_destroy;
+    wl_resource_add_destroy_listener(resource, &pending->destroy_listener);
+    wl_list_insert(list->prev, &pending->link);
+    return pending;
+}
+
+// Timers have millisecond precision, so round up to never fire before the deadline
+static void arm_timer(struct wl_event_source* timer, uint64_t deadline_us)
+{
+    uint64_t now_us = monotonic_time_us();
+    int delay_ms = deadline_us > now_us ? (int)((deadline_us - now_us + 999) / 1000) : 0;
+    // A delay of 0 would disarm the timer
+    wl_event_source_timer_update(timer, delay_ms > 0 ? delay_ms : 1);
+}
+
+// Timers never fire early, so the vblank that just happened is the last one before now
+static int vblank_timer_fired(void* _data)
+{
+    uint32_t time_ms = (uint32_t)(vblank_time_us(vblank_index(monotonic_time_us())) / 1000);
+    PendingResource* pending;
+    PendingResource* tmp;
+    wl_list_for_each_safe(pending, tmp, &pending_frames, link)
+    {
+        struct wl_resource* callback = pending->resource;
+        pending_resource_free(pending);
+        wl_callback_send_done(callback, time_ms);
+        wl_resource_destroy(callback);
+    }
+    return 0;
+}
+
+static int release_timer_fired(void* _data)
+{
+    uint64_t now_us = monotonic_time_us();
+    PendingResource* pending;
+    PendingResource* tmp;
+    wl_list_for_each_safe(pending, tmp, &pending_releases, link)
+    {
+        if (pending->due_us > now_us)
+        {
+            arm_timer(release_timer, pending->due_us);
+            break;
+        }
+        wl_buffer_send_release(pending->resource);
+        releases_held--;
+        pending_resource_free(pending);
+    }
+    return 0;
+}
+
+void vblank_init(double refresh_rate, uint64_t release_latency)
+{
+    wl_list_init(&pending_frames);
+    wl_list_init(&pending_releases);
+    clock_start_us = monotonic_time_us();
+    refresh_period_us = refresh_rate > 0 ? (uint64_t)(1000000.0 / refresh_rate) : 0;
+    release_latency_us = release_latency;
+    struct wl_event_loop* loop = wl_display_get_event_loop(display);
+    vblank_timer = wl_event_loop_add_timer(loop, vblank_timer_fired, NULL);
+    release_timer = wl_event_loop_add_timer(loop, release_timer_fired, NULL);
+}
+
+char vblank_enabled()
+{
+    return refresh_period_us != 0;
+}
+
+uint64_t vblank_index(uint64_t time_us)
+{
+    if (!refresh_period_us)
+        return 0;
+    return (time_us - clock_start_us) / refresh_period_us;
+}
+
+uint64_t vblank_time_us(uint64_t index)
+{
+    return clock_start_us + index * refresh_period_us;
+}
+
+void vblank_frame_done(struct wl_resource* callback)
+{
+    if (!refresh_period_us)
+    {
+        wl_callback_send_done(callback, 0);
+        wl_resource_destroy(callback);
+        return;
+    }
+    if (wl_list_empty(&pending_frames))
+        arm_timer(vblank_timer, vblank_time_us(vblank_index(monotonic_time_us()) + 1));
+    pending_resource_new(&pending_frames, callback, pending_frame_handle_destroy);
+}
+
+void vblank_release_buffer(struct wl_resource* buffer)
+{
+    if (!release_latency_us)
+    {
+        wl_buffer_send_release(buffer);
+        return;
+    }
+    PendingResource* pending = pending_resource_new(&pending_releases, buffer, pending_release_handle_destroy);
+    pending->due_us = monotonic_time_us() + release_latency_us;
+    // The latency is fixed, so the list is in order and the timer only has to be armed for the first one
+    if (pending_releases.next == &pending->link)
+        arm_timer(release_timer, pending->due_us);
+    releases_held++;
+    if (releases_held > releases_held_peak)
+        releases_held_peak = releases_held;
+}
+
+uint32_t vblank_take_releases_held_peak()
+{
+    uint32_t peak = releases_held_peak;
+    releases_held_peak = releases_held;
+    return peak;
+}
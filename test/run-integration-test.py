@@ -12,23 +12,30 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 '''
 
 # This script runs an integration test. See test/README.md for details
-usage = 'Usage: python3 run-test <test-binary>'
+usage = 'Usage: python3 run-test [--benchmark] [--replay <trace> [--replay-speed <speed>]] [--refresh-rate <hz>] [--release-latency <us>] [--soak <cycles>] <test-binary>'
 
 import os
 from os import path
 import sys
 import shutil
-import time
+import select
+import struct
 import subprocess
 import threading
-from typing import List, Dict, Optional, Any
+from typing import List, Dict, Tuple, Optional, Any
 
 # All callables (generally lambdas) appended to this list will be called at the end of the program
 cleanup_funcs = []
 
+# Exit code meson reports as a skipped test, see SKIP() in test-common.h
+SKIP_EXIT_CODE = 77
+
 class TestError(RuntimeError):
     pass
 
+class TestSkipped(RuntimeError):
+    pass
+
 def get_xdg_runtime_dir() -> str:
     '''
     Creates a directory to use as the XDG_RUNTIME_DIR.
@@ -47,15 +54,14 @@ def wipe_xdg_runtime_dir(p: str):
     assert 'layer-shell-test-runtime-dir' in p, 'Sanity check'
     shutil.rmtree(p)
 
-def wait_until_appears(p: str):
-    '''Waits for something to appear at the given path'''
-    sleep_time = 0.01
+def wait_until_ready(readable: int):
+    '''Blocks until the mock server writes to its ready fd, which it does once clients can connect'''
     timeout = 5.0
-    for i in range(int(timeout / sleep_time)):
-        if path.exists(p):
-            return
-        time.sleep(0.01)
-    raise TestError(p + ' did not appear in ' + str(timeout) + ' seconds')
+    ready, _, _ = select.select([readable], [], [], timeout)
+    data = os.read(readable, 1) if ready else b''
+    os.close(readable)
+    if not data:
+        raise TestError('server did not become ready in ' + str(timeout) + ' seconds')
 
 def format_stream(name: str, stream: str) -> str:
     '''
@@ -132,14 +138,14 @@ class Pipe:
 
 class Program:
     '''A program to run as a subprocess'''
-    def __init__(self, name: str, args: List[str], env: Dict[str, str]):
+    def __init__(self, name: str, args: List[str], env: Dict[str, str], pass_fds: Tuple[int, ...] = ()):
         self.name = name
         self.stdout = Pipe(name + ' stdout')
         self.stderr = Pipe(name + ' stderr')
-        self.subprocess = subprocess.Popen(args, stdout=self.stdout.fd, stderr=self.stderr.fd, env=env)
+        self.subprocess = subprocess.Popen(args, stdout=self.stdout.fd, stderr=self.stderr.fd, env=env, pass_fds=pass_fds)
         cleanup_funcs.append(lambda: self.kill())
 
-    def finish(self, timeout: float):
+    def finish(self, timeout: Optional[float]):
         try:
             self.subprocess.wait(timeout=timeout)
         except subprocess.TimeoutExpired:
@@ -169,37 +175,53 @@ class Program:
     def collect_output(self):
         return self.stdout.collect_str(), self.stderr.collect_str()
 
-def run_test(name: str, server_args: List[str], client_args: List[str], xdg_runtime: str, wayland_display: str) -> str:
+def run_test(name: str, server_args: List[str], client_args: List[str], xdg_runtime: str, wayland_display: str, debug: bool, soak: bool = False) -> Tuple[str, str]:
     '''
     Runs two processes: a mock server and the test client
+    A soaking client is allowed to run for as long as it takes, and counts GObject instances
     Does *not* check that client's message assertions pass, this must be done later using the returned output
+    Returns the client's stderr and the server's stderr
     '''
     env = os.environ.copy()
     env['XDG_RUNTIME_DIR'] = xdg_runtime
     env['WAYLAND_DISPLAY'] = wayland_display
-    env['WAYLAND_DEBUG'] = '1'
+    # Keep state the library caches (such as remembered pip sizes) out of the user's home and fresh for each test
+    env['XDG_CACHE_HOME'] = path.join(xdg_runtime, 'cache')
+    if debug:
+        env['WAYLAND_DEBUG'] = '1'
+    if soak:
+        env['GOBJECT_DEBUG'] = 'instance-count'
 
-    server = Program('server', server_args, env)
+    ready_readable, ready_writable = os.pipe()
+    server = Program('server', server_args + ['--ready-fd', str(ready_writable)], env, (ready_writable,))
+    os.close(ready_writable)
 
     try:
-        wait_until_appears(path.join(xdg_runtime, wayland_display))
+        wait_until_ready(ready_readable)
     except TestError as e:
         server.kill()
         raise TestError(server.format_output() + '\n\n' + str(e))
 
     client = Program(name, client_args, env)
-    client.finish(timeout=10)
+    client.finish(timeout=None if soak else 10)
     server.finish(timeout=1)
 
+    if client.subprocess.returncode == SKIP_EXIT_CODE:
+        server.check_returncode()
+        _, client_stderr = client.collect_output()
+        skip_lines = [line for line in client_stderr.splitlines() if line.startswith('Skipped')]
+        raise TestSkipped(skip_lines[-1] if skip_lines else 'Skipped')
+
     server.check_returncode()
     client.check_returncode()
 
     client_stdout, client_stderr = client.collect_output()
+    _, server_stderr = server.collect_output()
 
     if client_stdout.strip() != '':
         raise TestError(format_stream(name + ' stdout', client_stdout) + '\n\n' + name + ' stdout not empty')
 
-    return client_stderr
+    return client_stderr, server_stderr
 
 def line_contains(line: str, tokens: List[str]) -> bool:
     '''Returns if the given line contains a list of tokens in the given order (anything can be between tokens)'''
@@ -214,21 +236,83 @@ def line_contains(line: str, tokens: List[str]) -> bool:
 def verify_result(lines: List[str]):
     '''Runs through the output of a client and verifies that all expectations pass, see the test README.md details'''
     assertions = []
+    unexpected = []
     section_start = 0
     for i, line in enumerate(lines):
         if line.startswith('EXPECT: '):
             assertions.append(line.split()[1:])
+        elif line.startswith('UNEXPECT: '):
+            unexpected.append(line.split()[1:])
         elif line.startswith('[') and line.endswith(')') and '@' in line:
+            for tokens in unexpected:
+                if line_contains(line, tokens):
+                    section = format_stream('relevant section', '\n'.join(lines[section_start:i + 1]))
+                    raise TestError(section + '\n\nfound unexpected "' + ' '.join(tokens) + '"')
             if assertions and line_contains(line, assertions[0]):
                 assertions = assertions[1:]
         elif line == 'CHECK EXPECTATIONS COMPLETED' or i == len(lines) - 1:
             if assertions:
                 section = format_stream('relevant section', '\n'.join(lines[section_start:i]))
                 raise TestError(section + '\n\ndid not find "' + ' '.join(assertions[0]) + '"')
+            unexpected = []
             section_start = i + 1
 
-def main():
-    client_bin = sys.argv[1]
+def report_benchmarks(lines: List[str]):
+    '''Prints the measurements a benchmark reported with BENCHMARK_REPORT()'''
+    for line in lines:
+        if line.startswith('BENCHMARK: '):
+            print(line[len('BENCHMARK: '):])
+
+def read_recording(recording_path: str) -> List[Tuple[int, int, str]]:
+    '''
+    Reads a recording written by the mock server's --record option (format documented in mock-server.h)
+    Returns a list of requests in the order they were received as (microseconds since start, object ID, message name)
+    '''
+    with open(recording_path, 'rb') as f:
+        data = f.read()
+    if data[:4] != b'MSRQ' or struct.unpack_from('=I', data, 4)[0] != 1:
+        raise TestError(recording_path + ' is not a version 1 mock server recording')
+    names: Dict[int, str] = {}
+    requests = []
+    offset = 8
+    while offset < len(data):
+        record_type = data[offset]
+        offset += 1
+        if record_type == 1:
+            index, length = struct.unpack_from('=HH', data, offset)
+            offset += 4
+            names[index] = data[offset:offset + length].decode('utf-8')
+            offset += length
+        elif record_type == 2:
+            index, object_id, time_us = struct.unpack_from('=HIQ', data, offset)
+            offset += struct.calcsize('=HIQ')
+            requests.append((time_us, object_id, names[index]))
+        else:
+            raise TestError(recording_path + ' has an invalid record type ' + str(record_type))
+    return requests
+
+def report_recording(recording_path: str):
+    '''Prints how many of each request the client sent, so changes in protocol traffic show up in benchmarks'''
+    requests = read_recording(recording_path)
+    counts: Dict[str, int] = {}
+    for _, _, name in requests:
+        counts[name] = counts.get(name, 0) + 1
+    print('requests ' + str(len(requests)) + ' requests')
+    for name, count in sorted(counts.items()):
+        print(name + '-count ' + str(count) + ' requests')
+
+def prepare_replay(replay: str, xdg_runtime: str) -> str:
+    '''Returns the path of a trace the mock server can replay, converting WAYLAND_DEBUG logs (.txt files) first'''
+    if not replay.endswith('.txt'):
+        return replay
+    trace_path = path.join(xdg_runtime, 'replay.trace')
+    converter = path.join(path.dirname(path.realpath(__file__)), 'convert-wayland-debug-trace.py')
+    result = subprocess.run([sys.executable, '-B', converter, replay, trace_path], stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
+    if result.returncode != 0:
+        raise TestError('failed to convert ' + replay + ':\n' + result.stdout.decode('utf-8'))
+    return trace_path
+
+def main(client_bin: str, benchmark: bool, replay_args: List[str], clock_args: List[str], soak_cycles: Optional[str]):
     name = path.basename(client_bin)
     server_bin = path.join(path.dirname(client_bin), 'mock-server', 'mock-server')
     assert path.exists(client_bin), 'Could not find client at ' + client_bin
@@ -236,7 +320,28 @@ def main():
     wayland_display = 'wayland-test'
     xdg_runtime = get_xdg_runtime_dir()
 
-    client_stderr = run_test(name, [server_bin], [client_bin, '--auto'], xdg_runtime, wayland_display)
+    if benchmark:
+        # WAYLAND_DEBUG would dominate the measurements, and benchmarks don't set expectations
+        # The server reports what only it can measure (such as damage) as pip surfaces are destroyed
+        # Integration tests report how long each step took to settle, benchmarks ignore the argument
+        # Every request is recorded, so the runner can report what the client sent
+        recording_path = path.join(xdg_runtime, 'requests.rec')
+        server_args = [server_bin, '--benchmark', '--record', recording_path]
+        if replay_args:
+            server_args += ['--replay', prepare_replay(replay_args[0], xdg_runtime)] + replay_args[1:]
+        server_args += clock_args
+        client_args = [client_bin, '--benchmark']
+        if soak_cycles is not None:
+            # The server checks the client's Wayland objects, the client checks everything else it can see itself
+            server_args += ['--leak-check']
+            client_args += ['--soak', soak_cycles]
+        client_stderr, server_stderr = run_test(name, server_args, client_args, xdg_runtime, wayland_display, False, soak_cycles is not None)
+        report_benchmarks([line.strip() for line in client_stderr.strip().splitlines()])
+        report_benchmarks([line.strip() for line in server_stderr.strip().splitlines()])
+        report_recording(recording_path)
+        return
+
+    client_stderr, _ = run_test(name, [server_bin], [client_bin, '--auto'], xdg_runtime, wayland_display, True)
     client_lines = [line.strip() for line in client_stderr.strip().splitlines()]
 
     try:
@@ -245,11 +350,42 @@ def main():
         raise TestError(format_stream(name + ' stderr', client_stderr) + '\n\n' + str(e))
 
 if __name__ == '__main__':
-    assert len(sys.argv) == 2, 'Incorrect number of args. ' + usage
+    args = sys.argv[1:]
+    benchmark = '--benchmark' in args
+    if benchmark:
+        args.remove('--benchmark')
+    # Replaying a trace is only supported for benchmarks, as tests would have to expect every replayed event
+    replay_args = []
+    for option in ['--replay', '--replay-speed']:
+        if option in args:
+            i = args.index(option)
+            assert benchmark and i + 1 < len(args), 'Incorrect use of ' + option + '. ' + usage
+            replay_args += [args[i + 1]] if option == '--replay' else [option, args[i + 1]]
+            del args[i:i + 2]
+    assert not replay_args or not replay_args[0].startswith('--'), '--replay-speed needs --replay. ' + usage
+    # The mock server's virtual refresh clock changes when frame callbacks are answered, so it's also benchmark only
+    clock_args = []
+    for option in ['--refresh-rate', '--release-latency']:
+        if option in args:
+            i = args.index(option)
+            assert benchmark and i + 1 < len(args), 'Incorrect use of ' + option + '. ' + usage
+            clock_args += [option, args[i + 1]]
+            del args[i:i + 2]
+    soak_cycles = None
+    if '--soak' in args:
+        i = args.index('--soak')
+        assert benchmark and i + 1 < len(args), 'Incorrect use of --soak. ' + usage
+        soak_cycles = args[i + 1]
+        del args[i:i + 2]
+    assert len(args) == 1, 'Incorrect number of args. ' + usage
     fail = False
+    skip = False
     try:
-        main()
+        main(args[0], benchmark, replay_args, clock_args, soak_cycles)
         print('Passed')
+    except TestSkipped as e:
+        skip = True
+        print(e)
     except TestError as e:
         fail = True
         print(e)
@@ -258,3 +394,5 @@ if __name__ == '__main__':
             func()
     if fail:
         exit(1)
+    if skip:
+        exit(SKIP_EXIT_CODE)
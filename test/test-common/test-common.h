@@ -20,11 +20,44 @@
 #define DEFAULT_OUTPUT_WIDTH 1920
 #define DEFAULT_OUTPUT_HEIGHT 1080
 
+// The size the mock server's placement policy gives pip surfaces
+#define DEFAULT_PIP_WIDTH 320
+#define DEFAULT_PIP_HEIGHT 180
+
+// The mock server clicks pip surfaces with an app ID ending in this once they are placed, then presses and releases a
+// key so the click is not the newest input serial
+#define PIP_CLICK_APP_ID_SUFFIX "-click"
+
+// The mock server dismisses pip surfaces with an app ID ending in this once they are placed
+#define PIP_DISMISS_APP_ID_SUFFIX "-dismiss"
+
+// When a pip's app ID is set to one ending in this, the mock server takes the seat's pointer capability away and gives
+// it back, then enters the pip with the new pointer
+#define PIP_TOGGLE_POINTER_APP_ID_SUFFIX "-toggle-pointer"
+
+// An interactive pip resize in the mock server grows the dragged axes by this much per configure, this many times
+#define PIP_RESIZE_STEP_SIZE 16
+#define PIP_RESIZE_STEPS 8
+
+// The fractional scale the mock server asks surfaces to render at, in 120ths (so 1.5)
+#define DEFAULT_FRACTIONAL_SCALE_120 180
+
+// The only dmabuf format and modifier the mock server can import (DRM_FORMAT_XRGB8888 and DRM_FORMAT_MOD_LINEAR)
+#define MOCK_DMABUF_FORMAT 0x34325258
+#define MOCK_DMABUF_MODIFIER 0
+
+// Meson reports a test that exits with this code as skipped, for when the machine lacks something the test needs
+#define SKIP_EXIT_CODE 77
+#define SKIP(reason) do {fprintf(stderr, "Skipped at %s:%d: %s\n", __FILE__, __LINE__, reason); exit(SKIP_EXIT_CODE);} while (0)
+
 #define FATAL_FMT(format, ...) do {fprintf(stderr, "Fatal error at %s:%d in %s(): " format "\n", __FILE__, __LINE__, __func__, ##__VA_ARGS__); exit(1);} while (0)
 #define FATAL(message) FATAL_FMT(message"%s", "")
 #define ASSERT(assertion) do {if (!(assertion)) {FATAL_FMT("\n  assertion failed: %s", #assertion);}} while (0)
 #define ASSERT_EQ(a, b, format) do {if (!((a) == (b))) {FATAL_FMT("\n  expected: %s == %s\n  actual:   " format " != " format "\n", #a, #b, a, b);}} while (0)
 #define ASSERT_STR_EQ(a, b) do {if (strcmp(a, b)) {FATAL_FMT("\n  expected: %s ≈ %s\n  actual:   \"%s\" ≠ \"%s\"\n", #a, #b, a, b);}} while (0)
 
+// Report a single measurement, the test runner prints these when run with --benchmark
+#define BENCHMARK_REPORT(name, format, value, unit) fprintf(stderr, "BENCHMARK: %s " format " %s\n", name, value, unit)
+
 #endif // TEST_COMMON_H
 
@@ -0,0 +1,162 @@
+/* This entire file is licensed under MIT
+ *
+ * Copyright 2020 Sophie Winter
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "frame-convert.h"
+#include "test-common.h"
+
+#include <stdint.h>
+
+// Checks that every kernel this CPU supports gives exactly the same result as the scalar one, and that the scalar one
+// gives the right colors
+
+#define MAX_ROW 1031 // Not a multiple of any vector size, so the scalar tails get exercised
+#define SRC_WIDTH 101
+#define SRC_HEIGHT 57
+#define CHROMA_WIDTH ((SRC_WIDTH + 1) / 2)
+#define CHROMA_HEIGHT ((SRC_HEIGHT + 1) / 2)
+
+static uint32_t random_state = 1;
+
+// Deterministic, so failures can be reproduced
+static uint8_t random_byte()
+{
+    random_state = random_state * 1103515245 + 12345;
+    return (random_state >> 16) & 0xff;
+}
+
+static uint32_t convert_pixel(uint8_t y, uint8_t u, uint8_t v)
+{
+    uint32_t pixel;
+    frame_convert_get_supported_kernels()[0]->yuv_row_to_xrgb(&y, &u, &v, &pixel, 1);
+    return pixel;
+}
+
+static void test_known_colors()
+{
+    ASSERT_EQ(convert_pixel(16, 128, 128), 0xff000000, "%08x");
+    ASSERT_EQ(convert_pixel(235, 128, 128), 0xffffffff, "%08x");
+    ASSERT_EQ(convert_pixel(126, 128, 128), 0xff808080, "%08x");
+    // Out of range values are clamped rather than wrapped
+    ASSERT_EQ(convert_pixel(255, 255, 255), 0xffff7dff, "%08x");
+    ASSERT_EQ(convert_pixel(0, 0, 0), 0xff008700, "%08x");
+}
+
+static void test_kernels_match_scalar()
+{
+    static uint8_t y[MAX_ROW], u[MAX_ROW], v[MAX_ROW];
+    static uint32_t expected_pixels[MAX_ROW], pixels[MAX_ROW];
+    static uint8_t expected_blend[MAX_ROW], blend[MAX_ROW];
+    static uint32_t expected_sums[MAX_ROW], sums[MAX_ROW];
+
+    const FrameConvertKernels *const *kernels = frame_convert_get_supported_kernels();
+    ASSERT(kernels[0]);
+    for (int width = 1; width <= MAX_ROW; width += 37)
+    {
+        for (int i = 0; i < width; i++)
+        {
+            y[i] = random_byte();
+            u[i] = random_byte();
+            v[i] = random_byte();
+        }
+        int weight = random_byte() + 1; // Covers [1, 256]
+        kernels[0]->yuv_row_to_xrgb(y, u, v, expected_pixels, width);
+        kernels[0]->blend_rows(y, u, expected_blend, width, weight);
+        for (int i = 0; i < width; i++)
+            expected_sums[i] = i * 1000;
+        kernels[0]->accumulate_row(v, expected_sums, width);
+        for (int k = 1; kernels[k]; k++)
+        {
+            kernels[k]->yuv_row_to_xrgb(y, u, v, pixels, width);
+            kernels[k]->blend_rows(y, u, blend, width, weight);
+            for (int i = 0; i < width; i++)
+                sums[i] = i * 1000;
+            kernels[k]->accumulate_row(v, sums, width);
+            for (int i = 0; i < width; i++)
+            {
+                if (pixels[i] != expected_pixels[i] || blend[i] != expected_blend[i] || sums[i] != expected_sums[i])
+                    FATAL_FMT("%s kernel differs from scalar at %d of %d", kernels[k]->name, i, width);
+            }
+        }
+    }
+}
+
+static void test_formats_and_scaling()
+{
+    static uint8_t y_plane[SRC_WIDTH * SRC_HEIGHT];
+    static uint8_t u_plane[CHROMA_WIDTH * CHROMA_HEIGHT];
+    static uint8_t v_plane[CHROMA_WIDTH * CHROMA_HEIGHT];
+    static uint8_t uv_plane[CHROMA_WIDTH * 2 * CHROMA_HEIGHT];
+    static uint8_t expected[320 * 180 * 4], actual[320 * 180 * 4];
+    const int sizes[][2] = {{320, 180}, {50, 30}, {SRC_WIDTH, SRC_HEIGHT}, {1, 1}, {7, 170}};
+
+    for (int i = 0; i < SRC_WIDTH * SRC_HEIGHT; i++)
+        y_plane[i] = random_byte();
+    for (int i = 0; i < CHROMA_WIDTH * CHROMA_HEIGHT; i++)
+    {
+        u_plane[i] = uv_plane[2 * i] = random_byte();
+        v_plane[i] = uv_plane[2 * i + 1] = random_byte();
+    }
+    const uint8_t *i420_planes[] = {y_plane, u_plane, v_plane};
+    const int i420_strides[] = {SRC_WIDTH, CHROMA_WIDTH, CHROMA_WIDTH};
+    const uint8_t *nv12_planes[] = {y_plane, uv_plane};
+    const int nv12_strides[] = {SRC_WIDTH, CHROMA_WIDTH * 2};
+
+    const FrameConvertKernels *const *kernels = frame_convert_get_supported_kernels();
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+    {
+        int width = sizes[s][0];
+        int height = sizes[s][1];
+        for (int scale = FRAME_SCALE_BILINEAR; scale <= FRAME_SCALE_BOX; scale++)
+        {
+            ASSERT_EQ(frame_convert(kernels[0], FRAME_FORMAT_I420, i420_planes, i420_strides, SRC_WIDTH, SRC_HEIGHT,
+                                    scale, expected, width * 4, width, height), 0, "%d");
+            // NV12 holds the same samples, so every kernel should give the same image for it
+            for (int k = 0; kernels[k]; k++)
+            {
+                ASSERT_EQ(frame_convert(kernels[k], FRAME_FORMAT_NV12, nv12_planes, nv12_strides, SRC_WIDTH, SRC_HEIGHT,
+                                        scale, actual, width * 4, width, height), 0, "%d");
+                if (memcmp(expected, actual, width * height * 4) != 0)
+                    FATAL_FMT("%s kernel with scale %d gave a different %dx%d image", kernels[k]->name, scale, width, height);
+            }
+        }
+    }
+
+    // Scaling a flat color must not change it
+    memset(y_plane, 81, sizeof(y_plane));
+    memset(u_plane, 90, sizeof(u_plane));
+    memset(v_plane, 240, sizeof(v_plane));
+    uint32_t red = convert_pixel(81, 90, 240);
+    for (int scale = FRAME_SCALE_BILINEAR; scale <= FRAME_SCALE_BOX; scale++)
+    {
+        ASSERT_EQ(frame_convert(kernels[0], FRAME_FORMAT_I420, i420_planes, i420_strides, SRC_WIDTH, SRC_HEIGHT,
+                                scale, actual, 37 * 4, 37, 23), 0, "%d");
+        for (int i = 0; i < 37 * 23; i++)
+        {
+            uint32_t pixel;
+            memcpy(&pixel, actual + i * 4, sizeof(pixel));
+            ASSERT_EQ(pixel, red, "%08x");
+        }
+    }
+
+    // Invalid arguments are rejected
+    ASSERT_EQ(frame_convert(kernels[0], FRAME_FORMAT_I420, i420_planes, i420_strides, 0, SRC_HEIGHT,
+                            FRAME_SCALE_BILINEAR, actual, 4, 1, 1), -1, "%d");
+    ASSERT_EQ(frame_convert(kernels[0], FRAME_FORMAT_I420, i420_planes, i420_strides, SRC_WIDTH, SRC_HEIGHT,
+                            FRAME_SCALE_BILINEAR, actual, 3, 1, 1), -1, "%d");
+}
+
+int main()
+{
+    test_known_colors();
+    test_kernels_match_scalar();
+    test_formats_and_scaling();
+    return 0;
+}
@@ -9,7 +9,7 @@
  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
 
-#include "gtk-layer-shell.h"
+#include "gtk-pip-shell.h"
 #include "test-common.h"
 
 int main(int argc, char** argv)
@@ -20,9 +20,9 @@ int main(int argc, char** argv)
     sprintf(
         version_provided_by_gtk_layer_shell,
         "%d.%d.%d",
-        gtk_layer_get_major_version(),
-        gtk_layer_get_minor_version(),
-        gtk_layer_get_micro_version());
+        gtk_pip_get_major_version(),
+        gtk_pip_get_minor_version(),
+        gtk_pip_get_micro_version());
 
     ASSERT_STR_EQ(version_provided_by_gtk_layer_shell, argv[1]);
 